@@ -44,12 +44,21 @@ private:
 ////////// BasicTaskScheduler0 //////////
 
 BasicTaskScheduler0::BasicTaskScheduler0()
-  : fLastHandledSocketNum(-1), fTriggersAwaitingHandling(0), fLastUsedTriggerMask(1), fLastUsedTriggerNum(MAX_NUM_EVENT_TRIGGERS-1) {
+  : fLastHandledSocketNum(-1), fSomeTriggersAwaitingHandling(0), fLastUsedTriggerNum(MAX_NUM_EVENT_TRIGGERS-1) {
   fHandlers = new HandlerSet;
+  for (unsigned i = 0; i < EVENT_TRIGGER_WORDS; ++i) {
+    fTriggersAwaitingHandling[i] = 0;
+  }
   for (unsigned i = 0; i < MAX_NUM_EVENT_TRIGGERS; ++i) {
     fTriggeredEventHandlers[i] = NULL;
     fTriggeredEventClientDatas[i] = NULL;
   }
+  updateLoopTime();
+}
+
+void BasicTaskScheduler0::updateLoopTime() {
+  fLoopTime = TaskScheduler::loopTime();
+  fLoopWallClockTime = TaskScheduler::loopWallClockTime();
 }
 
 BasicTaskScheduler0::~BasicTaskScheduler0() {
@@ -83,22 +92,18 @@ void BasicTaskScheduler0::doEventLoop(char* watchVariable) {
 
 EventTriggerId BasicTaskScheduler0::createEventTrigger(TaskFunc* eventHandlerProc) {
   unsigned i = fLastUsedTriggerNum;
-  EventTriggerId mask = fLastUsedTriggerMask;
 
   do {
     i = (i+1)%MAX_NUM_EVENT_TRIGGERS;
-    mask >>= 1;
-    if (mask == 0) mask = 0x80000000;
 
     if (fTriggeredEventHandlers[i] == NULL) {
       // This trigger number is free; use it:
       fTriggeredEventHandlers[i] = eventHandlerProc;
       fTriggeredEventClientDatas[i] = NULL; // sanity
 
-      fLastUsedTriggerMask = mask;
       fLastUsedTriggerNum = i;
 
-      return mask;
+      return i + 1; // (because 0 means 'no trigger')
     }
   } while (i != fLastUsedTriggerNum);
 
@@ -107,39 +112,62 @@ EventTriggerId BasicTaskScheduler0::createEventTrigger(TaskFunc* eventHandlerPro
 }
 
 void BasicTaskScheduler0::deleteEventTrigger(EventTriggerId eventTriggerId) {
-  fTriggersAwaitingHandling &=~ eventTriggerId;
+  if (!triggerNumIsValid(eventTriggerId)) return;
+  unsigned i = eventTriggerId - 1;
 
-  if (eventTriggerId == fLastUsedTriggerMask) { // common-case optimization:
-    fTriggeredEventHandlers[fLastUsedTriggerNum] = NULL;
-    fTriggeredEventClientDatas[fLastUsedTriggerNum] = NULL;
-  } else {
-    // "eventTriggerId" should have just one bit set.
-    // However, we do the reasonable thing if the user happened to 'or' together two or more "EventTriggerId"s:
-    EventTriggerId mask = 0x80000000;
-    for (unsigned i = 0; i < MAX_NUM_EVENT_TRIGGERS; ++i) {
-      if ((eventTriggerId&mask) != 0) {
-	fTriggeredEventHandlers[i] = NULL;
-	fTriggeredEventClientDatas[i] = NULL;
-      }
-      mask >>= 1;
-    }
-  }
+  __sync_fetch_and_and(&fTriggersAwaitingHandling[i/32], ~(1u<<(i%32)));
+  fTriggeredEventHandlers[i] = NULL;
+  fTriggeredEventClientDatas[i] = NULL;
 }
 
 void BasicTaskScheduler0::triggerEvent(EventTriggerId eventTriggerId, void* clientData) {
-  // First, record the "clientData".  (Note that we allow "eventTriggerId" to be a combination of bits for multiple events.)
-  EventTriggerId mask = 0x80000000;
-  for (unsigned i = 0; i < MAX_NUM_EVENT_TRIGGERS; ++i) {
-    if ((eventTriggerId&mask) != 0) {
-      fTriggeredEventClientDatas[i] = clientData;
+  if (!triggerNumIsValid(eventTriggerId)) return;
+  unsigned i = eventTriggerId - 1;
+
+  // First, record the "clientData":
+  fTriggeredEventClientDatas[i] = clientData;
+
+  // Then, note this event as being ready to be handled.
+  // (Note that because this function (unlike others in the library) can be called from an external thread, we do this last,
+  //  and atomically, so that triggers that are set concurrently from different threads don't get lost.)
+  __sync_fetch_and_or(&fTriggersAwaitingHandling[i/32], 1u<<(i%32));
+  __sync_lock_test_and_set(&fSomeTriggersAwaitingHandling, 1);
+}
+
+void BasicTaskScheduler0::handleTriggeredEvent() {
+  if (!__sync_lock_test_and_set(&fSomeTriggersAwaitingHandling, 0)) return;
+
+  // Look for an event trigger that needs handling (making sure that we make forward progress through all possible triggers):
+  unsigned i = fLastUsedTriggerNum;
+  int handled = -1;
+  for (unsigned n = 0; n < MAX_NUM_EVENT_TRIGGERS; ) {
+    i = (i+1)%MAX_NUM_EVENT_TRIGGERS;
+    u_int32_t& word = fTriggersAwaitingHandling[i/32];
+    if (i%32 == 0 && word == 0 && i + 32 <= MAX_NUM_EVENT_TRIGGERS && n + 32 <= MAX_NUM_EVENT_TRIGGERS) {
+      // Skip a whole word of idle triggers at once:
+      i += 31;
+      n += 32;
+      continue;
+    }
+    ++n;
+
+    u_int32_t bit = 1u<<(i%32);
+    if ((word&bit) != 0) {
+      if (handled >= 0) {
+	// There's at least one more pending event; handle it next time:
+	__sync_lock_test_and_set(&fSomeTriggersAwaitingHandling, 1);
+	break;
+      }
+      __sync_fetch_and_and(&word, ~bit);
+      handled = i;
     }
-    mask >>= 1;
   }
+  if (handled < 0) return;
 
-  // Then, note this event as being ready to be handled.
-  // (Note that because this function (unlike others in the library) can be called from an external thread, we do this last, to
-  //  reduce the risk of a race condition.)
-  fTriggersAwaitingHandling |= eventTriggerId;
+  fLastUsedTriggerNum = handled;
+  if (fTriggeredEventHandlers[handled] != NULL) {
+    (*fTriggeredEventHandlers[handled])(fTriggeredEventClientDatas[handled]);
+  }
 }
 
 
@@ -20,6 +20,9 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 
 #include "DelayQueue.hh"
 #include "GroupsockHelper.hh"
+#if !defined(__WIN32__) && !defined(_WIN32)
+#include <time.h>
+#endif
 
 static const int MILLION = 1000000;
 
@@ -220,11 +223,19 @@ void DelayQueue::synchronize() {
 ///// EventTime /////
 
 EventTime TimeNow() {
+#if defined(CLOCK_MONOTONIC)
+  // Use a monotonic clock, so that delayed tasks aren't disturbed when the system's 'wall clock' time is changed:
+  struct timespec tsNow;
+  clock_gettime(CLOCK_MONOTONIC, &tsNow);
+
+  return EventTime(tsNow.tv_sec, tsNow.tv_nsec/1000);
+#else
   struct timeval tvNow;
 
   gettimeofday(&tvNow, NULL);
 
   return EventTime(tvNow.tv_sec, tvNow.tv_usec);
+#endif
 }
 
 const EventTime THE_END_OF_TIME(INT_MAX);
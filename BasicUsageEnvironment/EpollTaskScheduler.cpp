@@ -0,0 +1,184 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 2.1 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// Copyright (c) 1996-2013 Live Networks, Inc.  All rights reserved.
+// Basic Usage Environment: for a simple, non-scripted, console application
+// Implementation
+
+#include "EpollTaskScheduler.hh"
+
+#ifdef HAVE_EPOLL_TASK_SCHEDULER
+#include <sys/epoll.h>
+#include <errno.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#ifndef MILLION
+#define MILLION 1000000
+#endif
+
+#define MAX_EPOLL_EVENTS_PER_STEP 256
+
+////////// EpollTaskScheduler //////////
+
+EpollTaskScheduler* EpollTaskScheduler::createNew(unsigned maxSchedulerGranularity) {
+  int epollFd = epoll_create1(EPOLL_CLOEXEC);
+  if (epollFd < 0) return NULL;
+
+  return new EpollTaskScheduler(epollFd, maxSchedulerGranularity);
+}
+
+EpollTaskScheduler::EpollTaskScheduler(int epollFd, unsigned maxSchedulerGranularity)
+  : fMaxSchedulerGranularity(maxSchedulerGranularity), fEpollFd(epollFd),
+    fSocketHandlers(NULL), fNumSocketHandlerSlots(0) {
+  if (maxSchedulerGranularity > 0) schedulerTickTask(); // ensures that we handle events frequently
+}
+
+EpollTaskScheduler::~EpollTaskScheduler() {
+  close(fEpollFd);
+  delete[] fSocketHandlers;
+}
+
+void EpollTaskScheduler::schedulerTickTask(void* clientData) {
+  ((EpollTaskScheduler*)clientData)->schedulerTickTask();
+}
+
+void EpollTaskScheduler::schedulerTickTask() {
+  scheduleDelayedTask(fMaxSchedulerGranularity, schedulerTickTask, this);
+}
+
+void EpollTaskScheduler::SingleStep(unsigned maxDelayTime) {
+  DelayInterval const& timeToDelay = fDelayQueue.timeToNextAlarm();
+  long long usToDelay = (long long)timeToDelay.seconds()*MILLION + timeToDelay.useconds();
+  // Don't delay any more than 1 million seconds (11.5 days), as in "BasicTaskScheduler":
+  if (usToDelay > (long long)MILLION*MILLION) usToDelay = (long long)MILLION*MILLION;
+  // Also check our "maxDelayTime" parameter (if it's > 0):
+  if (maxDelayTime > 0 && usToDelay > (long long)maxDelayTime) usToDelay = maxDelayTime;
+  // ("epoll_wait()" has millisecond resolution; round up, so that we don't wake up before the next alarm:)
+  long long msToDelay = (usToDelay + 999)/1000;
+  if (msToDelay > 0x7FFFFFFF) msToDelay = 0x7FFFFFFF;
+
+  struct epoll_event events[MAX_EPOLL_EVENTS_PER_STEP];
+  int numEvents = epoll_wait(fEpollFd, events, MAX_EPOLL_EVENTS_PER_STEP, (int)msToDelay);
+  if (numEvents < 0) {
+    if (errno != EINTR) {
+      // Unexpected error - treat this as fatal:
+      perror("EpollTaskScheduler::SingleStep(): epoll_wait() fails");
+      internalError();
+    }
+    numEvents = 0;
+  }
+  updateLoopTime();
+
+  // Call the handler function for each ready socket.  (A handler may turn off - or change - the
+  // handling of another socket in this batch, so we look each one up again just before calling it.)
+  for (int i = 0; i < numEvents; ++i) {
+    int sock = events[i].data.fd;
+    if (sock < 0 || sock >= fNumSocketHandlerSlots) continue;
+    SocketHandler& handler = fSocketHandlers[sock]; // alias
+
+    int resultConditionSet = 0;
+    // (As with "select()", an error or hangup makes a socket readable and writable.)
+    if (events[i].events&(EPOLLIN|EPOLLHUP|EPOLLERR)) resultConditionSet |= SOCKET_READABLE;
+    if (events[i].events&(EPOLLOUT|EPOLLERR)) resultConditionSet |= SOCKET_WRITABLE;
+    if (events[i].events&EPOLLPRI) resultConditionSet |= SOCKET_EXCEPTION;
+    if ((resultConditionSet&handler.conditionSet) != 0 && handler.handlerProc != NULL) {
+      fLastHandledSocketNum = sock;
+      (*handler.handlerProc)(handler.clientData, resultConditionSet);
+    }
+  }
+
+  // Also handle any newly-triggered event (Note that we do this *after* calling the socket handlers,
+  // in case the triggered event handler modifies The set of readable sockets.)
+  handleTriggeredEvent();
+
+  // Also handle any delayed event that may have come due.
+  fDelayQueue.handleAlarm();
+}
+
+void EpollTaskScheduler
+  ::setBackgroundHandling(int socketNum, int conditionSet, BackgroundHandlerProc* handlerProc, void* clientData) {
+  if (socketNum < 0) return;
+  if (handlerProc == NULL) conditionSet = 0;
+  if (conditionSet == 0 && socketNum >= fNumSocketHandlerSlots) return; // nothing to turn off
+  if (!ensureSlot(socketNum)) return;
+
+  SocketHandler& handler = fSocketHandlers[socketNum]; // alias
+  updateEpoll(socketNum, handler.conditionSet, conditionSet);
+  handler.conditionSet = conditionSet;
+  handler.handlerProc = conditionSet == 0 ? NULL : handlerProc;
+  handler.clientData = conditionSet == 0 ? NULL : clientData;
+}
+
+void EpollTaskScheduler::moveSocketHandling(int oldSocketNum, int newSocketNum) {
+  if (oldSocketNum < 0 || newSocketNum < 0 || oldSocketNum >= fNumSocketHandlerSlots) return; // sanity check
+  SocketHandler handler = fSocketHandlers[oldSocketNum];
+  if (handler.conditionSet == 0) return;
+
+  setBackgroundHandling(oldSocketNum, 0, NULL, NULL);
+  setBackgroundHandling(newSocketNum, handler.conditionSet, handler.handlerProc, handler.clientData);
+}
+
+Boolean EpollTaskScheduler::ensureSlot(int socketNum) {
+  if (socketNum < fNumSocketHandlerSlots) return True;
+
+  int newNumSlots = fNumSocketHandlerSlots > 0 ? fNumSocketHandlerSlots : 64;
+  while (newNumSlots <= socketNum) newNumSlots *= 2;
+
+  SocketHandler* newSlots = new SocketHandler[newNumSlots];
+  if (newSlots == NULL) return False;
+  for (int i = 0; i < newNumSlots; ++i) {
+    if (i < fNumSocketHandlerSlots) {
+      newSlots[i] = fSocketHandlers[i];
+    } else {
+      newSlots[i].conditionSet = 0;
+      newSlots[i].handlerProc = NULL;
+      newSlots[i].clientData = NULL;
+    }
+  }
+  delete[] fSocketHandlers;
+  fSocketHandlers = newSlots;
+  fNumSocketHandlerSlots = newNumSlots;
+  return True;
+}
+
+void EpollTaskScheduler::updateEpoll(int socketNum, int oldConditionSet, int newConditionSet) {
+  struct epoll_event event;
+  event.events = 0;
+  if (newConditionSet&SOCKET_READABLE) event.events |= EPOLLIN;
+  if (newConditionSet&SOCKET_WRITABLE) event.events |= EPOLLOUT;
+  if (newConditionSet&SOCKET_EXCEPTION) event.events |= EPOLLPRI;
+  event.data.u64 = 0; // sanity
+  event.data.fd = socketNum;
+
+  if (newConditionSet == 0) {
+    if (oldConditionSet != 0) epoll_ctl(fEpollFd, EPOLL_CTL_DEL, socketNum, &event);
+    return;
+  }
+
+  // (The socket may have been closed - and its number reused - without its handling having been turned off,
+  // in which case the kernel has already forgotten it.  So fall back between "ADD" and "MOD" as necessary.)
+  if (oldConditionSet == 0) {
+    if (epoll_ctl(fEpollFd, EPOLL_CTL_ADD, socketNum, &event) != 0 && errno == EEXIST) {
+      epoll_ctl(fEpollFd, EPOLL_CTL_MOD, socketNum, &event);
+    }
+  } else {
+    if (epoll_ctl(fEpollFd, EPOLL_CTL_MOD, socketNum, &event) != 0 && errno == ENOENT) {
+      epoll_ctl(fEpollFd, EPOLL_CTL_ADD, socketNum, &event);
+    }
+  }
+}
+
+#endif
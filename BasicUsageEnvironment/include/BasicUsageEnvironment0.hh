@@ -67,7 +67,12 @@ private:
 
 class HandlerSet; // forward
 
-#define MAX_NUM_EVENT_TRIGGERS 32
+// Event triggers are numbered, rather than being single bits of a 32-bit mask, so there can be
+// more than 32 of them (e.g., for a single event loop that's shared by many streams):
+#ifndef MAX_NUM_EVENT_TRIGGERS
+#define MAX_NUM_EVENT_TRIGGERS 1024
+#endif
+#define EVENT_TRIGGER_WORDS ((MAX_NUM_EVENT_TRIGGERS+31)/32)
 
 // An abstract base class, useful for subclassing
 // (e.g., to redefine the implementation of socket event handling)
@@ -92,9 +97,14 @@ public:
   virtual void deleteEventTrigger(EventTriggerId eventTriggerId);
   virtual void triggerEvent(EventTriggerId eventTriggerId, void* clientData = NULL);
 
+  virtual struct timeval loopTime() { return fLoopTime; }
+  virtual struct timeval loopWallClockTime() { return fLoopWallClockTime; }
+
 protected:
   BasicTaskScheduler0();
 
+  void updateLoopTime(); // called by "SingleStep()", once it has finished waiting
+
 protected:
   // To implement delayed operations:
   DelayQueue fDelayQueue;
@@ -104,10 +114,20 @@ protected:
   int fLastHandledSocketNum;
 
   // To implement event triggers:
-  EventTriggerId fTriggersAwaitingHandling, fLastUsedTriggerMask; // implemented as 32-bit bitmaps
+  Boolean triggerNumIsValid(EventTriggerId eventTriggerId) const {
+    return eventTriggerId > 0 && eventTriggerId <= MAX_NUM_EVENT_TRIGGERS;
+  }
+  void handleTriggeredEvent(); // handles (at most) one pending event, making forward progress through all triggers
+
+  // A bitmap (of trigger numbers), set - atomically, because "triggerEvent()" may be called from
+  // other threads - by "triggerEvent()", and cleared by the event loop:
+  u_int32_t fTriggersAwaitingHandling[EVENT_TRIGGER_WORDS];
+  int fSomeTriggersAwaitingHandling; // a quick check, so the event loop needn't scan the bitmap
   TaskFunc* fTriggeredEventHandlers[MAX_NUM_EVENT_TRIGGERS];
   void* fTriggeredEventClientDatas[MAX_NUM_EVENT_TRIGGERS];
   unsigned fLastUsedTriggerNum; // in the range [0,MAX_NUM_EVENT_TRIGGERS)
+
+  struct timeval fLoopTime, fLoopWallClockTime;
 };
 
 #endif
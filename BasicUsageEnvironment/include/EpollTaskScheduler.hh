@@ -0,0 +1,74 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 2.1 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// Copyright (c) 1996-2013 Live Networks, Inc.  All rights reserved.
+// Basic Usage Environment: for a simple, non-scripted, console application
+// C++ header
+
+#ifndef _EPOLL_TASK_SCHEDULER_HH
+#define _EPOLL_TASK_SCHEDULER_HH
+
+#ifndef _BASIC_USAGE_ENVIRONMENT0_HH
+#include "BasicUsageEnvironment0.hh"
+#endif
+
+#if defined(__linux__)
+#define HAVE_EPOLL_TASK_SCHEDULER 1
+
+// A task scheduler that uses Linux "epoll" instead of "select()".  Unlike "BasicTaskScheduler",
+// it is not limited to socket numbers below FD_SETSIZE, and its cost per step doesn't grow with
+// the number of sockets being handled - so it suits a single event loop that's shared by
+// thousands of streams.  Each step handles every socket that's ready (rather than just one).
+
+class EpollTaskScheduler: public BasicTaskScheduler0 {
+public:
+  static EpollTaskScheduler* createNew(unsigned maxSchedulerGranularity = 10000/*microseconds*/);
+    // "maxSchedulerGranularity" has the same meaning as for "BasicTaskScheduler".
+    // Returns NULL if "epoll" isn't available.
+  virtual ~EpollTaskScheduler();
+
+protected:
+  EpollTaskScheduler(int epollFd, unsigned maxSchedulerGranularity);
+      // called only by "createNew()"
+
+  static void schedulerTickTask(void* clientData);
+  void schedulerTickTask();
+
+protected:
+  // Redefined virtual functions:
+  virtual void SingleStep(unsigned maxDelayTime);
+
+  virtual void setBackgroundHandling(int socketNum, int conditionSet, BackgroundHandlerProc* handlerProc, void* clientData);
+  virtual void moveSocketHandling(int oldSocketNum, int newSocketNum);
+
+private:
+  struct SocketHandler {
+    int conditionSet; // 0 iff the slot is unused
+    BackgroundHandlerProc* handlerProc;
+    void* clientData;
+  };
+  Boolean ensureSlot(int socketNum);
+  void updateEpoll(int socketNum, int oldConditionSet, int newConditionSet);
+
+private:
+  unsigned fMaxSchedulerGranularity;
+  int fEpollFd;
+  SocketHandler* fSocketHandlers; // indexed by socket number
+  int fNumSocketHandlerSlots;
+};
+
+#endif
+
+#endif
@@ -9,6 +9,13 @@
 
 #include "API_PullerModule.h"
 #include "PullerClient.h"
+#include "CallbackDispatcher.h"
+#include "MemoryBudget.h"
+#include "FileWriter.h"
+#include "ShmFrameWriter.h"
+
+#include <semaphore.h>
+#include <vector>
 
 #define RTSP_CLIENT_VERBOSITY_LEVEL 0 // by default, print verbose output from each "RTSPClient"
 
@@ -20,19 +27,98 @@ _API int _APICALL RTSP_Puller_GetErrcode()
 
 _API RTSP_Puller_Handler _APICALL RTSP_Puller_Create()
 {
-	TaskScheduler* scheduler = BasicTaskScheduler::createNew();
-	UsageEnvironment* env = BasicUsageEnvironment::createNew(*scheduler);
+	PullerLoop* loop = PullerLoop::createNew();
+	if (loop == NULL) return NULL;
 	
 	char const*  application = "PullerClient";
 	char const*  url  = NULL;
-	PullerClient* handler = PullerClient::createNew(*env, url, RTSP_CLIENT_VERBOSITY_LEVEL, application);
+	PullerClient* handler = PullerClient::createNew(*loop, url, RTSP_CLIENT_VERBOSITY_LEVEL, application);
 	if (handler == NULL) {
-		*env << "Failed to create a RTSP client for URL \"" << url << "\": " << env->getResultMsg() << "\n";
+		loop->envir() << "Failed to create a RTSP client for URL \"" << url << "\": " << loop->envir().getResultMsg() << "\n";
+		delete loop;
 	}
 
 	return handler;
 }
 
+_API int _APICALL RTSP_Puller_SetNumLoops(unsigned int numLoops)
+{
+	PullerLoop::setNumSharedLoops(numLoops);
+	return 0;
+}
+
+// The streams of one "RTSP_Puller_StartMany()" call that were given to the same shared loop:
+struct StartManyBatch {
+	PullerLoop* loop;
+	PullerArena* arena;
+	const PullerStreamConfig* cfgs;
+	RTSP_Puller_Handler* handles;
+	std::vector<unsigned> slots;
+	sem_t* done;
+};
+
+static void startManyCommand(void* clientData)
+{
+	StartManyBatch* batch = (StartManyBatch*)clientData;
+	for (size_t i = 0; i < batch->slots.size(); ++i) {
+		unsigned slot = batch->slots[i];
+		batch->handles[slot] = PullerClient::createNew(*batch->loop, *batch->arena, slot, batch->cfgs[slot]);
+	}
+	sem_post(batch->done);
+}
+
+_API int _APICALL RTSP_Puller_StartMany(const PullerStreamConfig* cfgs, int count, RTSP_Puller_Handler* handles)
+{
+	if (cfgs == NULL || handles == NULL || count <= 0) return -1;
+
+	PullerArena* arena = PullerArena::createNew(sizeof (PullerClient), count);
+	if (arena == NULL) return -1;
+
+	// Spread the streams over the shared loops, and create (and start) each loop's streams with a
+	// single command, so that a loop is woken once per call rather than once per stream:
+	std::vector<StartManyBatch*> batches;
+	sem_t done;
+	sem_init(&done, 0, 0);
+	for (int i = 0; i < count; ++i) {
+		handles[i] = NULL;
+		PullerLoop* loop = cfgs[i].url != NULL ? PullerLoop::sharedLoop() : NULL;
+		if (loop == NULL) {
+			arena->releaseSlot(); // (frees the arena only if there are no streams to create at all)
+			continue;
+		}
+
+		StartManyBatch* batch = NULL;
+		for (size_t j = 0; j < batches.size(); ++j) {
+			if (batches[j]->loop == loop) { batch = batches[j]; break; }
+		}
+		if (batch == NULL) {
+			batch = new StartManyBatch;
+			batch->loop = loop;
+			batch->arena = arena;
+			batch->cfgs = cfgs;
+			batch->handles = handles;
+			batch->done = &done;
+			batches.push_back(batch);
+		}
+		batch->slots.push_back(i);
+	}
+
+	for (size_t j = 0; j < batches.size(); ++j) batches[j]->loop->post(startManyCommand, batches[j]);
+
+	// Wait only until every client exists (which "cfgs" must outlive); the connections themselves
+	// are made asynchronously, by the loops:
+	int numStarted = 0;
+	for (size_t j = 0; j < batches.size(); ++j) {
+		while (sem_wait(&done) != 0) {} // (retry on EINTR)
+	}
+	for (size_t j = 0; j < batches.size(); ++j) {
+		numStarted += batches[j]->slots.size();
+		delete batches[j];
+	}
+	sem_destroy(&done);
+	return numStarted;
+}
+
 _API int _APICALL RTSP_Puller_SetCallback(RTSP_Puller_Handler handler, PullerCallback cb, void* p)
 {
 	PullerClient* puller = (PullerClient*) handler;
@@ -46,6 +132,260 @@ _API int _APICALL RTSP_Puller_StartStream(RTSP_Puller_Handler handler, const cha
 	return puller->startStream(url, connType, username, password, reconn, retRtpPkt);
 }
 
+_API int _APICALL RTSP_Puller_SetFrameFilter(RTSP_Puller_Handler handler, FrameFilterMode mode, unsigned int gopInterval)
+{
+	PullerClient* puller = (PullerClient*) handler;
+	return puller->setFrameFilter(mode, gopInterval);
+}
+
+_API int _APICALL RTSP_Puller_SetScatterDelivery(RTSP_Puller_Handler handler, int enable)
+{
+	PullerClient* puller = (PullerClient*) handler;
+	if (puller == NULL) return -1;
+	return puller->setScatterDelivery(enable != 0);
+}
+
+_API int _APICALL RTSP_Puller_SetReorderPolicy(RTSP_Puller_Handler handler, ReorderPolicy policy, \
+		unsigned int minUs, unsigned int maxUs)
+{
+	PullerClient* puller = (PullerClient*) handler;
+	if (puller == NULL) return -1;
+	if (policy != REORDER_FIXED && policy != REORDER_ADAPTIVE && policy != REORDER_LOW_LATENCY) return -1;
+	return puller->setReorderPolicy(policy, minUs, maxUs);
+}
+
+_API int _APICALL RTSP_Puller_SetRtcpFeedback(RTSP_Puller_Handler handler, unsigned int types)
+{
+	PullerClient* puller = (PullerClient*) handler;
+	if (puller == NULL) return -1;
+	return puller->setRtcpFeedback(types & (RTCP_FEEDBACK_NACK|RTCP_FEEDBACK_PLI|RTCP_FEEDBACK_FIR));
+}
+
+_API int _APICALL RTSP_Puller_SetFecRecovery(RTSP_Puller_Handler handler, int enable, int payloadType)
+{
+	PullerClient* puller = (PullerClient*) handler;
+	if (puller == NULL) return -1;
+	if (payloadType < 0 || payloadType > 127) return -1;
+	return puller->setFecRecovery(enable != 0, (unsigned char)payloadType);
+}
+
+_API int _APICALL RTSP_Puller_SetReceiveCoalescing(RTSP_Puller_Handler handler, int enable)
+{
+	PullerClient* puller = (PullerClient*) handler;
+	if (puller == NULL) return -1;
+	return puller->setReceiveCoalescing(enable != 0);
+}
+
+_API int _APICALL RTSP_Puller_SetBufferSizes(RTSP_Puller_Handler handler, unsigned int frameBufferSize, unsigned int packetBufferSize)
+{
+	PullerClient* puller = (PullerClient*) handler;
+	if (puller == NULL) return -1;
+	return puller->setBufferSizes(frameBufferSize, packetBufferSize);
+}
+
+_API int _APICALL RTSP_Puller_SetMemoryBudget(unsigned long long limitBytes)
+{
+	MemoryBudget::setLimit(limitBytes);
+	return 0;
+}
+
+_API int _APICALL RTSP_Puller_GetMemoryStats(MemoryBudgetStats* stats)
+{
+	if (stats == NULL) return -1;
+	MemoryBudget::getStats(*stats);
+	return 0;
+}
+
+_API int _APICALL RTSP_Puller_SetDispatchThreads(unsigned int numThreads)
+{
+	return CallbackDispatcher::setNumThreads(numThreads);
+}
+
+_API int _APICALL RTSP_Puller_SetAsyncDelivery(RTSP_Puller_Handler handler, unsigned int queueSize, \
+		AsyncOverflowPolicy policy)
+{
+	PullerClient* puller = (PullerClient*) handler;
+	return puller->setAsyncDelivery(queueSize, policy);
+}
+
+_API int _APICALL RTSP_Puller_GetAsyncStats(RTSP_Puller_Handler handler, AsyncDeliveryStats* stats)
+{
+	PullerClient* puller = (PullerClient*) handler;
+	if (stats == NULL) return -1;
+	puller->getAsyncStats(*stats);
+	return 0;
+}
+
+_API int _APICALL RTSP_Puller_GetReceiveStats(RTSP_Puller_Handler handler, ReceiveStats* stats)
+{
+	PullerClient* puller = (PullerClient*) handler;
+	if (puller == NULL || stats == NULL) return -1;
+	puller->getReceiveStats(*stats);
+	return 0;
+}
+
+_API int _APICALL RTSP_Puller_SetTsDemux(RTSP_Puller_Handler handler, int enable)
+{
+	PullerClient* puller = (PullerClient*) handler;
+	return puller->setTsDemux(enable != 0);
+}
+
+// The functions below, and those of the reader and of shared-memory output (further below), call the
+// stream's "FrameDistributor" directly - from the caller's thread - rather than posting a command to the
+// loop thread; the distributor is thread-safe, and doesn't use the loop's "UsageEnvironment" (see "PullerClient.h").
+
+_API int _APICALL RTSP_Puller_EnableGopCache(RTSP_Puller_Handler handler, unsigned int maxBytes)
+{
+	PullerClient* puller = (PullerClient*) handler;
+	return puller->frameDistributor().enableGopCache(maxBytes);
+}
+
+_API int _APICALL RTSP_Puller_Subscribe(RTSP_Puller_Handler handler, PullerCallback cb, void* cbParam, \
+		unsigned int queueSize, QueueDropPolicy dropPolicy)
+{
+	PullerClient* puller = (PullerClient*) handler;
+	return puller->frameDistributor().subscribe(cb, cbParam, queueSize, dropPolicy);
+}
+
+_API int _APICALL RTSP_Puller_Unsubscribe(RTSP_Puller_Handler handler, int subscriberId)
+{
+	PullerClient* puller = (PullerClient*) handler;
+	return puller->frameDistributor().unsubscribe(subscriberId);
+}
+
+_API int _APICALL RTSP_Puller_GetSubscriberStats(RTSP_Puller_Handler handler, int subscriberId, SubscriberStats* stats)
+{
+	PullerClient* puller = (PullerClient*) handler;
+	if (stats == NULL) return -1;
+	return puller->frameDistributor().getSubscriberStats(subscriberId, *stats);
+}
+
+_API int _APICALL RTSP_Puller_StartRecord(RTSP_Puller_Handler handler, const char* pathPrefix, \
+		unsigned int segmentSeconds, unsigned long long segmentMaxBytes)
+{
+	PullerClient* puller = (PullerClient*) handler;
+	return puller->frameDistributor().startRecord(pathPrefix, segmentSeconds, segmentMaxBytes);
+}
+
+_API int _APICALL RTSP_Puller_StopRecord(RTSP_Puller_Handler handler)
+{
+	PullerClient* puller = (PullerClient*) handler;
+	return puller->frameDistributor().stopRecord();
+}
+
+_API int _APICALL RTSP_Puller_EnablePreroll(RTSP_Puller_Handler handler, unsigned int maxSeconds, unsigned int maxBytes)
+{
+	PullerClient* puller = (PullerClient*) handler;
+	return puller->frameDistributor().enablePreroll(maxSeconds, maxBytes);
+}
+
+_API int _APICALL RTSP_Puller_TriggerRecord(RTSP_Puller_Handler handler, unsigned int preSeconds, \
+		unsigned int postSeconds, const char* path)
+{
+	PullerClient* puller = (PullerClient*) handler;
+	return puller->frameDistributor().triggerRecord(preSeconds, postSeconds, path);
+}
+
+_API int _APICALL RTSP_Puller_StartHls(RTSP_Puller_Handler handler, const char* pathPrefix, \
+		unsigned int segmentSeconds, unsigned int listSize)
+{
+	PullerClient* puller = (PullerClient*) handler;
+	return puller->frameDistributor().startHls(pathPrefix, segmentSeconds, listSize);
+}
+
+_API int _APICALL RTSP_Puller_StopHls(RTSP_Puller_Handler handler)
+{
+	PullerClient* puller = (PullerClient*) handler;
+	return puller->frameDistributor().stopHls();
+}
+
+_API int _APICALL RTSP_Puller_SetWriterThreads(unsigned int numThreads)
+{
+	return FileWriterPool::setNumThreads(numThreads);
+}
+
+_API int _APICALL RTSP_Puller_GetWriterStats(WriterStats* stats)
+{
+	if (stats == NULL) return -1;
+	FileWriterPool::getStats(*stats);
+	return 0;
+}
+
+_API int _APICALL RTSP_Puller_EnableRead(RTSP_Puller_Handler handler, unsigned int queueSize)
+{
+	PullerClient* puller = (PullerClient*) handler;
+	return puller->frameDistributor().enableReader(queueSize);
+}
+
+_API int _APICALL RTSP_Puller_ReadFrame(RTSP_Puller_Handler handler, PulledFrame* frame, int timeoutMs)
+{
+	PullerClient* puller = (PullerClient*) handler;
+	FrameReader* reader = puller->frameDistributor().reader();
+	if (reader == NULL || frame == NULL) return -1;
+
+	PullerFrame* pulled = reader->read(timeoutMs);
+	if (pulled == NULL) return -1;
+
+	frame->frame.dataBuf = (const char*)pulled->data();
+	frame->frame.bufLen = pulled->size();
+	frame->frame.isKeyFrame = pulled->isKeyFrame();
+	frame->frame.isCached = 0;
+	frame->frame.rtpTimestamp = pulled->rtpTimestamp();
+	frame->frame.ptsSec = pulled->presentationTime().tv_sec;
+	frame->frame.ptsUsec = pulled->presentationTime().tv_usec;
+	frame->frame.mediumName = pulled->mediumName();
+	frame->frame.codecName = pulled->codecName();
+	frame->frame.extInfo = pulled->extInfo();
+	frame->frame.extRtpTimestamp = pulled->extendedRTPTimestamp();
+	frame->frame.monoPtsUs = pulled->monoPTS();
+	frame->frame.isDiscontinuity = pulled->isDiscontinuity();
+	frame->opaque = pulled; // our reference, until "RTSP_Puller_ReleaseFrame()"
+	return 0;
+}
+
+_API int _APICALL RTSP_Puller_ReleaseFrame(PulledFrame* frame)
+{
+	if (frame == NULL || frame->opaque == NULL) return -1;
+	((PullerFrame*)frame->opaque)->release();
+	frame->opaque = NULL;
+	return 0;
+}
+
+_API int _APICALL RTSP_Puller_WaitAny(RTSP_Puller_Handler* handlers, int count, int* ready, int timeoutMs)
+{
+	if (handlers == NULL || count <= 0) return -1;
+
+	std::vector<FrameReader*> readers(count);
+	for (int i = 0; i < count; ++i)
+	{
+		PullerClient* puller = (PullerClient*) handlers[i];
+		readers[i] = puller != NULL ? puller->frameDistributor().reader() : NULL;
+	}
+	return FrameReader::waitAny(&readers[0], count, ready, timeoutMs);
+}
+
+_API int _APICALL RTSP_Puller_GetReadFd(RTSP_Puller_Handler handler)
+{
+	PullerClient* puller = (PullerClient*) handler;
+	FrameReader* reader = puller->frameDistributor().reader();
+	return reader != NULL ? reader->eventFd() : -1;
+}
+
+_API int _APICALL RTSP_Puller_EnableShmOutput(RTSP_Puller_Handler handler, unsigned int numSlots, unsigned int dataBytes)
+{
+	PullerClient* puller = (PullerClient*) handler;
+	if (puller == NULL) return -1;
+	return puller->frameDistributor().enableShmOutput(numSlots, dataBytes);
+}
+
+_API int _APICALL RTSP_Puller_GetShmFd(RTSP_Puller_Handler handler)
+{
+	PullerClient* puller = (PullerClient*) handler;
+	if (puller == NULL) return -1;
+	ShmFrameWriter* shmWriter = puller->frameDistributor().shmWriter();
+	return shmWriter != NULL ? shmWriter->fd() : -1;
+}
+
 _API int _APICALL RTSP_Puller_CloseStream(RTSP_Puller_Handler handler)
 {
 	PullerClient* puller = (PullerClient*) handler;
@@ -58,11 +398,17 @@ _API int _APICALL RTSP_Puller_Release(RTSP_Puller_Handler handler)
 	PullerClient* puller = (PullerClient*) handler;
 	if (puller != NULL)
 	{
-		UsageEnvironment& env = puller->envir(); // alias
-		TaskScheduler* scheduler = &env.taskScheduler();
-		Medium::close(puller);puller = NULL;
-		env.reclaim(); 
-		delete scheduler; 
+		PullerLoop* loop = &puller->loop();
+		if (loop->isLoopThread()) return -1; // (we'd wait for ourself, below)
+
+		if (loop->isShared()) {
+			// (Other streams are using the loop, so it keeps running:)
+			puller->releaseAndWait(); puller = NULL;
+			loop->detach();
+			return 0;
+		}
+		puller->release(); puller = NULL;
+		delete loop; // runs the "release()" command, then stops the loop thread
 	}
 	return 0;
 }
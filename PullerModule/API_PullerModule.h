@@ -26,6 +26,20 @@
 
 typedef int (_APICALL *PullerCallback)(CBDataType dataType, void* data,  void* obj);
 
+typedef struct __PULLER_STREAM_CONFIG
+{
+	const char*		url;				/* RTSP URL */
+	RTP_ConnectType	connType;			/* 网络类型 */
+	const char*		username;			/* 用户名 */
+	const char*		password;			/* 用户访问密码 */
+	int				reconn;				/* 连接次数, 同 RTSP_Puller_StartStream */
+	int				retRtpPkt;			/* 返回数据类型, 同 RTSP_Puller_StartStream */
+	PullerCallback	cb;					/* 处理回调函数 */
+	void*			cbParam;			/* 回调函数传入参数 */
+	unsigned int	frameBufferSize;	/* 帧缓冲区大小, 同 RTSP_Puller_SetBufferSizes, 0 表示自动 */
+	unsigned int	packetBufferSize;	/* RTP包缓冲区大小, 同 RTSP_Puller_SetBufferSizes, 0 表示自动 */
+} PullerStreamConfig;
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -48,6 +62,32 @@ extern "C"
 	_API RTSP_Puller_Handler _APICALL RTSP_Puller_Create();
 
 
+	/**
+	 * @brief  RTSP_Puller_SetNumLoops 
+	 *		设置 RTSP_Puller_StartMany 使用的共享接收线程数 (默认每个CPU一个), 须在第一次调用 RTSP_Puller_StartMany 之前调用
+	 * @param numLoops		线程数, 0 表示每个CPU一个
+	 *
+	 * @return  返回处理结果 
+	 */
+	_API int _APICALL RTSP_Puller_SetNumLoops(unsigned int numLoops);
+
+
+	/**
+	 * @brief  RTSP_Puller_StartMany 
+	 *		批量创建并开始拉取多路流. 所有句柄在一块连续内存中分配, 并分布到共享的接收线程上
+	 *		(每个线程以 epoll 服务多路流, 不受 FD_SETSIZE 限制); 各路的连接均为异步, 本函数在
+	 *		所有请求发出后即返回, 不等待连接建立. 返回的句柄与 RTSP_Puller_Create 创建的句柄用法相同,
+	 *		须分别调用 RTSP_Puller_Release 释放
+	 * @param cfgs			每路流的配置, 数组长度为 count
+	 * @param count			流的路数
+	 * @param handles		输出句柄, 数组长度为 count; 创建失败的流对应 NULL
+	 *
+	 * @return  返回成功创建的流的路数, 参数错误时返回-1
+	 */
+	_API int _APICALL RTSP_Puller_StartMany(const PullerStreamConfig* cfgs, int count, \
+			RTSP_Puller_Handler* handles);
+
+
 	/**
 	 * @brief  RTSP_Puller_SetCallback 
 	 *		设置数据处理回调函数, RTSP_Puller_StartStream 正常返回后触发
@@ -62,10 +102,11 @@ extern "C"
 
 	/**
 	 * @brief  RTSP_Puller_StartStream 
-	 *		开始拉取流访问
+	 *		开始拉取流访问 (在句柄的接收线程中执行, 本函数立即返回, 结果通过 CB_PULLER_STATE 回调通知)
 	 * @param handler		拉取流句柄
 	 * @param url			访问流RTSP URL
-	 * @param connType		RTP 数据访问类型:tcp or udp
+	 * @param connType		RTP 数据访问类型:tcp, udp or multicast
+	 *						(multicast: 由服务端分配组播地址, 端口以 SO_REUSEPORT 绑定, 同一主机的多个进程可同时接收同一组播)
 	 * @param username		用户名
 	 * @param password		用户访问密码
 	 * @param reconn		连接次数: 0 or nonzero, 0 表示循环重试
@@ -77,9 +118,434 @@ extern "C"
 			RTP_ConnectType connType, const char* username, const char* password, int reconn, int retRtpPkt);
 
 
+	/**
+	 * @brief  RTSP_Puller_SetFrameFilter 
+	 *		设置帧过滤策略, 被过滤的NAL单元在重组与拷贝之前即被丢弃 (目前仅对H264视频有效)
+	 * @param handler		拉取流句柄
+	 * @param mode			过滤策略
+	 * @param gopInterval	GOP间隔: N > 1 表示每N个GOP只交付一个, 0 或 1 表示每个GOP
+	 *
+	 * @return  返回处理结果 
+	 */
+	_API int _APICALL RTSP_Puller_SetFrameFilter(RTSP_Puller_Handler handler, FrameFilterMode mode, \
+			unsigned int gopInterval);
+
+
+	/**
+	 * @brief  RTSP_Puller_SetDispatchThreads 
+	 *		设置异步回调线程池的线程数 (默认2), 须在第一个开启异步回调的流开始拉取之前调用
+	 * @param numThreads	线程数, 须大于0
+	 *
+	 * @return  返回处理结果, 线程池已启动时返回-1
+	 */
+	_API int _APICALL RTSP_Puller_SetDispatchThreads(unsigned int numThreads);
+
+
+	/**
+	 * @brief  RTSP_Puller_SetScatterDelivery 
+	 *		开启分段交付, 须在 RTSP_Puller_StartStream 之前调用.
+	 *		开启后, 每帧以 CB_SCATTER_DATA 回调, 数据为直接指向RTP包载荷的分段列表, 重组时不拷贝,
+	 *		帧大小不受帧缓冲区限制, 不会被截断. 返回RTP包 (retRtpPkt) 或 TS解复用时不生效.
+	 *		异步回调与订阅者仍得到拼接后的完整帧 (拷贝一次)
+	 * @param handler	拉取流句柄
+	 * @param enable	非0表示开启
+	 *
+	 * @return  返回处理结果 
+	 */
+	_API int _APICALL RTSP_Puller_SetScatterDelivery(RTSP_Puller_Handler handler, int enable);
+
+
+	/**
+	 * @brief  RTSP_Puller_SetBufferSizes 
+	 *		设置接收缓冲区大小, 须在 RTSP_Puller_StartStream 之前调用.
+	 *		自动模式下, 帧缓冲区按SDP描述 (媒体类型, 分辨率或带宽) 选择初始大小 (至多512KB), RTP包缓冲区从2048字节开始,
+	 *		出现截断时按2倍增长 (受 RTSP_Puller_SetMemoryBudget 限制)
+	 * @param handler			拉取流句柄
+	 * @param frameBufferSize	每路子会话的帧缓冲区大小 (字节), 0 表示自动
+	 * @param packetBufferSize	每个RTP包缓冲区的大小 (字节), 0 表示自动
+	 *
+	 * @return  返回处理结果 
+	 */
+	_API int _APICALL RTSP_Puller_SetBufferSizes(RTSP_Puller_Handler handler, unsigned int frameBufferSize, \
+			unsigned int packetBufferSize);
+
+
+	/**
+	 * @brief  RTSP_Puller_SetReorderPolicy 
+	 *		设置乱序包等待策略, 须在 RTSP_Puller_StartStream 之前调用. 等待越久, 越能容忍网络乱序, 但丢包时延迟越大
+	 * @param handler	拉取流句柄
+	 * @param policy	乱序包等待策略
+	 * @param minUs		REORDER_ADAPTIVE: 等待时间下限 (微秒)
+	 * @param maxUs		REORDER_FIXED: 固定等待时间 (微秒, 0 表示默认的100ms); REORDER_ADAPTIVE: 等待时间上限 (微秒, 0 表示500ms)
+	 *
+	 * @return  返回处理结果 
+	 */
+	_API int _APICALL RTSP_Puller_SetReorderPolicy(RTSP_Puller_Handler handler, ReorderPolicy policy, \
+			unsigned int minUs, unsigned int maxUs);
+
+
+	/**
+	 * @brief  RTSP_Puller_SetRtcpFeedback 
+	 *		开启RTCP反馈 (AVPF), 须在 RTSP_Puller_StartStream 之前调用. 仅在丢包时发送, 且每路子会话限速
+	 *		(突发不超过10个反馈包, 平均每秒不超过50个; 关键帧请求间隔不小于500ms). 服务端不支持时无效果
+	 * @param handler	拉取流句柄
+	 * @param types		RtcpFeedbackType 的组合, 0 表示关闭
+	 *
+	 * @return  返回处理结果 
+	 */
+	_API int _APICALL RTSP_Puller_SetRtcpFeedback(RTSP_Puller_Handler handler, unsigned int types);
+
+
+	/**
+	 * @brief  RTSP_Puller_SetFecRecovery 
+	 *		开启前向纠错 (RFC 5109 ULPFEC), 须在 RTSP_Puller_StartStream 之前调用. 丢失的包可由服务端发送的FEC包
+	 *		直接恢复, 无需等待重传. FEC包可与媒体包共用SSRC, 也可使用独立的SSRC. 服务端不发送FEC包时无效果
+	 * @param handler		拉取流句柄
+	 * @param enable		非0 开启, 0 关闭
+	 * @param payloadType	FEC包的RTP负载类型, 0 表示取自SDP中的 "a=rtpmap:<pt> ulpfec/..."
+	 *
+	 * @return  返回处理结果 
+	 */
+	_API int _APICALL RTSP_Puller_SetFecRecovery(RTSP_Puller_Handler handler, int enable, int payloadType);
+
+
+	/**
+	 * @brief  RTSP_Puller_SetReceiveCoalescing 
+	 *		开启UDP接收合并 (Linux 5.0 以上的 UDP_GRO), 须在 RTSP_Puller_StartStream 之前调用.
+	 *		内核将同一来源的连续RTP包合并, 一次读取即可得到多个包, 适用于高码率 (如4K/8K) 的UDP流.
+	 *		每路子会话另需64KB的接收缓冲区; 系统不支持或使用TCP方式时不生效
+	 * @param handler	拉取流句柄
+	 * @param enable	非0表示开启
+	 *
+	 * @return  返回处理结果 
+	 */
+	_API int _APICALL RTSP_Puller_SetReceiveCoalescing(RTSP_Puller_Handler handler, int enable);
+
+
+	/**
+	 * @brief  RTSP_Puller_SetMemoryBudget 
+	 *		设置全部流的接收缓冲区 (帧缓冲区, RTP包缓冲区, RTSP响应缓冲区) 的内存总上限.
+	 *		超出上限时, 新的子会话无法建立 (回调 CB_PULLER_STATE, resultCode 为 -ENOMEM), 缓冲区也不再增长
+	 * @param limitBytes	内存上限 (字节), 0 表示不限 (默认)
+	 *
+	 * @return  返回处理结果 
+	 */
+	_API int _APICALL RTSP_Puller_SetMemoryBudget(unsigned long long limitBytes);
+
+
+	/**
+	 * @brief  RTSP_Puller_GetMemoryStats 
+	 *		获取接收缓冲区的内存统计信息
+	 * @param stats			输出统计信息
+	 *
+	 * @return  返回处理结果 
+	 */
+	_API int _APICALL RTSP_Puller_GetMemoryStats(MemoryBudgetStats* stats);
+
+
+	/**
+	 * @brief  RTSP_Puller_SetAsyncDelivery 
+	 *		设置异步回调, 须在 RTSP_Puller_StartStream 之前调用.
+	 *		开启后, 接收线程只将数据放入每路子会话的无锁队列, 由线程池调用 RTSP_Puller_SetCallback 设置的回调,
+	 *		回调耗时不再阻塞接收; 同一子会话的数据按序交付. 回调中不可调用 RTSP_Puller_Release
+	 * @param handler		拉取流句柄
+	 * @param queueSize		每路子会话的队列长度, 0 表示关闭 (默认, 在接收线程中同步回调)
+	 * @param policy		队列满时的处理策略
+	 *
+	 * @return  返回处理结果 
+	 */
+	_API int _APICALL RTSP_Puller_SetAsyncDelivery(RTSP_Puller_Handler handler, unsigned int queueSize, \
+			AsyncOverflowPolicy policy);
+
+
+	/**
+	 * @brief  RTSP_Puller_GetAsyncStats 
+	 *		获取异步回调的统计信息
+	 * @param handler		拉取流句柄
+	 * @param stats			输出统计信息
+	 *
+	 * @return  返回处理结果 
+	 */
+	_API int _APICALL RTSP_Puller_GetAsyncStats(RTSP_Puller_Handler handler, AsyncDeliveryStats* stats);
+
+
+	/**
+	 * @brief  RTSP_Puller_GetReceiveStats 
+	 *		获取接收统计信息. packetsLost 减去 kernelDrops 即为网络丢包, kernelDrops 增长说明本机处理不及.
+	 *		UDP方式下, RTP套接字接收缓冲区按SDP码率 (b=AS) 设定初始大小, 之后按最大帧的突发量及内核丢包自动增大
+	 *		(受系统 net.core.rmem_max 限制)
+	 * @param handler		拉取流句柄
+	 * @param stats			输出统计信息 (包计数约每秒更新一次)
+	 *
+	 * @return  返回处理结果 
+	 */
+	_API int _APICALL RTSP_Puller_GetReceiveStats(RTSP_Puller_Handler handler, ReceiveStats* stats);
+
+
+	/**
+	 * @brief  RTSP_Puller_SetTsDemux 
+	 *		设置是否对 MP2T (RTP承载的TS流) 进行解复用, 须在 RTSP_Puller_StartStream 之前调用.
+	 *		开启后回调不再交付188字节的TS包, 而是以 CB_FRAME_DATA 交付各PID的基本流帧 (H264/H265/AAC等);
+	 *		仅在帧数据模式下有效 (retRtpPkt 为 0)
+	 * @param handler		拉取流句柄
+	 * @param enable		0: 关闭(默认), 非0: 开启
+	 *
+	 * @return  返回处理结果 
+	 */
+	_API int _APICALL RTSP_Puller_SetTsDemux(RTSP_Puller_Handler handler, int enable);
+
+
+	/**
+	 * @brief  RTSP_Puller_EnableGopCache 
+	 *		开启/关闭GOP缓存: 缓存最近一个关键帧以来的所有帧, 供新订阅者立即回放 (目前仅缓存H264视频)
+	 * @param handler		拉取流句柄
+	 * @param maxBytes		缓存占用内存上限(字节), GOP超出上限时放弃该GOP; 0 表示关闭缓存
+	 *
+	 * @return  返回处理结果 
+	 */
+	_API int _APICALL RTSP_Puller_EnableGopCache(RTSP_Puller_Handler handler, unsigned int maxBytes);
+
+
+	/**
+	 * @brief  RTSP_Puller_Subscribe 
+	 *		订阅帧数据: 先立即回放GOP缓存中的帧, 然后交付实时帧. 回调数据类型为 CB_FRAME_DATA
+	 *		同一拉取流可被多个订阅者共享, 帧数据以引用计数方式共享, 不为每个订阅者拷贝;
+	 *		每个订阅者拥有独立的有界队列与回调线程, 慢速订阅者只丢弃自己的帧
+	 * @param handler		拉取流句柄
+	 * @param cb			订阅者回调函数 (在该订阅者自己的线程中调用)
+	 * @param cbParam		回调函数传入参数
+	 * @param queueSize		队列容量 (帧数)
+	 * @param dropPolicy	队列满时的丢帧策略
+	 *
+	 * @return  订阅ID (> 0), -1 表示失败 
+	 */
+	_API int _APICALL RTSP_Puller_Subscribe(RTSP_Puller_Handler handler, PullerCallback cb, void* cbParam, \
+			unsigned int queueSize, QueueDropPolicy dropPolicy);
+
+
+	/**
+	 * @brief  RTSP_Puller_Unsubscribe 
+	 *		取消订阅, 不可在该订阅者自己的回调函数中调用
+	 * @param handler		拉取流句柄
+	 * @param subscriberId	RTSP_Puller_Subscribe 返回的订阅ID
+	 *
+	 * @return  返回处理结果 
+	 */
+	_API int _APICALL RTSP_Puller_Unsubscribe(RTSP_Puller_Handler handler, int subscriberId);
+
+
+	/**
+	 * @brief  RTSP_Puller_GetSubscriberStats 
+	 *		获取订阅者的交付/丢帧统计
+	 * @param handler		拉取流句柄
+	 * @param subscriberId	订阅ID
+	 * @param stats			返回的统计信息
+	 *
+	 * @return  返回处理结果 
+	 */
+	_API int _APICALL RTSP_Puller_GetSubscriberStats(RTSP_Puller_Handler handler, int subscriberId, \
+			SubscriberStats* stats);
+
+
+	/**
+	 * @brief  RTSP_Puller_StartRecord 
+	 *		开始录像: 将H264视频写为一系列分片MP4 (fMP4/CMAF) 文件, 文件名为 "<pathPrefix>_NNNNNN.mp4".
+	 *		每个文件可独立播放, 以关键帧开始; 数据按分片 (moof+mdat) 顺序追加写入, 内存占用固定, 不随录像时长增长,
+	 *		进程异常退出时只丢失最后一个分片. 文件由写线程池异步写入 (见 RTSP_Puller_SetWriterThreads),
+	 *		磁盘缓慢时只阻塞录像线程, 不影响接收. 录像以订阅者方式运行于独立线程 (占用一个订阅ID), 开启GOP缓存时
+	 *		立即从缓存的关键帧开始录制, 否则从下一个关键帧开始; 处理不及时丢帧后从下一个关键帧继续.
+	 *		仅支持帧数据模式 (retRtpPkt 为 0) 的RTP承载H264视频, 其他媒体被忽略. 不支持含B帧的流 (文件中只有显示时间,
+	 *		没有解码时间): 发现帧乱序 (显示时间倒退) 时录像在此结束, 已写入的文件仍完整可播放
+	 * @param handler			拉取流句柄
+	 * @param pathPrefix		文件路径前缀 (目录须已存在)
+	 * @param segmentSeconds	每个文件的时长(秒), 达到后在下一个关键帧处切换文件; 0 表示不限
+	 * @param segmentMaxBytes	每个文件的大小上限(字节), 达到后在下一个关键帧处切换文件; 0 表示不限
+	 *
+	 * @return  返回处理结果, 已在录像时返回-1 (录像因B帧已结束时可重新开始)
+	 */
+	_API int _APICALL RTSP_Puller_StartRecord(RTSP_Puller_Handler handler, const char* pathPrefix, \
+			unsigned int segmentSeconds, unsigned long long segmentMaxBytes);
+
+
+	/**
+	 * @brief  RTSP_Puller_StopRecord 
+	 *		停止录像. 当前文件的剩余数据由写线程在后台写入并关闭文件
+	 * @param handler		拉取流句柄
+	 *
+	 * @return  返回处理结果, 未在录像或录像已因流含B帧而提前结束时返回-1 
+	 */
+	_API int _APICALL RTSP_Puller_StopRecord(RTSP_Puller_Handler handler);
+
+
+	/**
+	 * @brief  RTSP_Puller_EnablePreroll 
+	 *		开启/关闭预录缓冲: 在内存中保留最近若干秒的完整GOP (目前仅H264视频), 供 RTSP_Puller_TriggerRecord
+	 *		录制触发之前的画面. 缓冲以GOP为单位淘汰, 总是从关键帧开始
+	 * @param handler		拉取流句柄
+	 * @param maxSeconds	保留的时长(秒), 0 表示关闭预录缓冲
+	 * @param maxBytes		占用内存上限(字节), 超出时淘汰最旧的GOP; 0 表示不限
+	 *
+	 * @return  返回处理结果 
+	 */
+	_API int _APICALL RTSP_Puller_EnablePreroll(RTSP_Puller_Handler handler, unsigned int maxSeconds, \
+			unsigned int maxBytes);
+
+
+	/**
+	 * @brief  RTSP_Puller_TriggerRecord 
+	 *		触发事件录像 (如移动侦测, 报警输入): 将触发前 preSeconds 秒 (取自预录缓冲, 从关键帧开始; 未开启预录缓冲时
+	 *		取自GOP缓存) 与触发后 postSeconds 秒的帧写入一个分片MP4文件, 写满后自动结束. 录像在后台进行, 立即返回.
+	 *		事件录像进行中再次触发时, 延长录像至此次触发后 postSeconds 秒, path 被忽略 (若该录像恰已结束, 则以 path
+	 *		开始新的事件录像). 与 RTSP_Puller_StartRecord 的连续录像互不影响. 同样不支持含B帧的流, 见 RTSP_Puller_StartRecord
+	 * @param handler		拉取流句柄
+	 * @param preSeconds	触发前的时长(秒), 不足时录制预录缓冲中的全部内容
+	 * @param postSeconds	触发后的时长(秒), 须大于0
+	 * @param path			文件路径 (目录须已存在)
+	 *
+	 * @return  返回处理结果 
+	 */
+	_API int _APICALL RTSP_Puller_TriggerRecord(RTSP_Puller_Handler handler, unsigned int preSeconds, \
+			unsigned int postSeconds, const char* path);
+
+
+	/**
+	 * @brief  RTSP_Puller_StartHls 
+	 *		开始HLS直播切片: 将拉取的音视频重新封装为MPEG-TS切片 "<pathPrefix>N.ts", 并维护滚动的播放列表
+	 *		"<pathPrefix>.m3u8" (包含最新的 listSize 个切片), 可直接由HTTP服务器提供给浏览器播放, 无需外部ffmpeg进程.
+	 *		支持RTP承载的H264视频与AAC音频 (MPEG4-GENERIC), 以及TS解复用 (见 RTSP_Puller_SetTsDemux) 得到的
+	 *		H264/H265视频与AAC音频; 须有视频, 其他媒体被忽略. 切片以关键帧开始, 达到 segmentSeconds 后在下一个关键帧
+	 *		处切换. 切片与播放列表先写入临时文件, 完整写入后再重命名, 不会读到不完整的文件; 移出播放列表的旧切片被自动删除.
+	 *		以订阅者方式运行于独立线程 (占用一个订阅ID), 内存占用固定, 不随帧数增长; 文件由写线程池异步写入
+	 * @param handler			拉取流句柄
+	 * @param pathPrefix		切片与播放列表的路径前缀 (目录须已存在), 如 "/var/www/hls/cam1_"
+	 * @param segmentSeconds	切片时长(秒), 须大于0
+	 * @param listSize			播放列表中的切片个数, 须大于0
+	 *
+	 * @return  返回处理结果, 已在切片时返回-1 
+	 */
+	_API int _APICALL RTSP_Puller_StartHls(RTSP_Puller_Handler handler, const char* pathPrefix, \
+			unsigned int segmentSeconds, unsigned int listSize);
+
+
+	/**
+	 * @brief  RTSP_Puller_StopHls 
+	 *		停止HLS切片. 写完当前切片, 并在播放列表末尾加上 #EXT-X-ENDLIST; 已生成的文件保留
+	 * @param handler		拉取流句柄
+	 *
+	 * @return  返回处理结果 
+	 */
+	_API int _APICALL RTSP_Puller_StopHls(RTSP_Puller_Handler handler);
+
+
+	/**
+	 * @brief  RTSP_Puller_SetWriterThreads 
+	 *		设置录像写线程池的线程数 (默认1), 须在第一次开始录像之前调用. 每个文件使用两个1MB的写缓冲区,
+	 *		写满的缓冲区交由写线程写入 (可用时使用 O_DIRECT, 并用 fallocate 预分配文件空间)
+	 * @param numThreads	线程数, 须大于0
+	 *
+	 * @return  返回处理结果, 线程池已启动时返回-1
+	 */
+	_API int _APICALL RTSP_Puller_SetWriterThreads(unsigned int numThreads);
+
+
+	/**
+	 * @brief  RTSP_Puller_GetWriterStats 
+	 *		获取录像写线程池的统计信息 (全部文件之和). pendingBytes 持续增长或 blockedCount 增长说明磁盘写入不及
+	 * @param stats			输出统计信息
+	 *
+	 * @return  返回处理结果 
+	 */
+	_API int _APICALL RTSP_Puller_GetWriterStats(WriterStats* stats);
+
+
+	/**
+	 * @brief  RTSP_Puller_EnableRead 
+	 *		开启拉模式, 须在 RTSP_Puller_StartStream 之前调用. 开启后可用 RTSP_Puller_ReadFrame 主动读取帧数据,
+	 *		与回调、订阅者互不影响; 队列满时丢弃最旧的帧
+	 * @param handler		拉取流句柄
+	 * @param queueSize		队列长度 (帧数), 须大于0
+	 *
+	 * @return  返回处理结果 
+	 */
+	_API int _APICALL RTSP_Puller_EnableRead(RTSP_Puller_Handler handler, unsigned int queueSize);
+
+
+	/**
+	 * @brief  RTSP_Puller_ReadFrame 
+	 *		读取一帧数据. 同一句柄同一时刻只能有一个线程读取; 读到的帧须用 RTSP_Puller_ReleaseFrame 释放
+	 * @param handler		拉取流句柄
+	 * @param frame			输出帧
+	 * @param timeoutMs		超时时间(毫秒), 小于0表示一直等待, 0表示不等待
+	 *
+	 * @return  0: 成功, -1: 超时或未开启拉模式
+	 */
+	_API int _APICALL RTSP_Puller_ReadFrame(RTSP_Puller_Handler handler, PulledFrame* frame, int timeoutMs);
+
+
+	/**
+	 * @brief  RTSP_Puller_ReleaseFrame 
+	 *		释放 RTSP_Puller_ReadFrame 读到的帧, 可在任意线程调用
+	 * @param frame			RTSP_Puller_ReadFrame 输出的帧
+	 *
+	 * @return  返回处理结果 
+	 */
+	_API int _APICALL RTSP_Puller_ReleaseFrame(PulledFrame* frame);
+
+
+	/**
+	 * @brief  RTSP_Puller_WaitAny 
+	 *		等待多路流中任意一路有帧可读, 适合单线程服务大量流
+	 * @param handlers		拉取流句柄数组, 未开启拉模式的句柄被忽略
+	 * @param count			句柄个数
+	 * @param ready			输出数组(长度为count), 有帧可读的流置1, 否则置0
+	 * @param timeoutMs		超时时间(毫秒), 小于0表示一直等待, 0表示不等待
+	 *
+	 * @return  有帧可读的流个数, 0: 超时, -1: 错误
+	 */
+	_API int _APICALL RTSP_Puller_WaitAny(RTSP_Puller_Handler* handlers, int count, int* ready, int timeoutMs);
+
+
+	/**
+	 * @brief  RTSP_Puller_GetReadFd 
+	 *		获取拉模式的事件描述符(eventfd), 可加入应用自己的 epoll/poll; 可读时应循环调用
+	 *		RTSP_Puller_ReadFrame(超时为0) 直到返回-1
+	 * @param handler		拉取流句柄
+	 *
+	 * @return  事件描述符, 未开启拉模式时返回-1
+	 */
+	_API int _APICALL RTSP_Puller_GetReadFd(RTSP_Puller_Handler handler);
+
+
+	/**
+	 * @brief  RTSP_Puller_EnableShmOutput 
+	 *		开启共享内存输出, 须在 RTSP_Puller_StartStream 之前调用. 拉流线程将每一帧直接写入一个共享内存(memfd)
+	 *		环形缓冲区, 本机任意个进程可用 shm/ShmReader.h 只读映射并读取, 不经过回调; 写入方从不等待读取方,
+	 *		读取不及时的帧被覆盖. 仅支持Linux
+	 * @param handler		拉取流句柄
+	 * @param numSlots		帧槽个数, 即缓冲区最多容纳的帧数 (向上取整为2的幂)
+	 * @param dataBytes		帧数据区大小(字节), 应能容纳若干秒的数据; 大于此值的帧被丢弃
+	 *
+	 * @return  共享内存的描述符 (同 RTSP_Puller_GetShmFd), 失败返回-1
+	 */
+	_API int _APICALL RTSP_Puller_EnableShmOutput(RTSP_Puller_Handler handler, unsigned int numSlots, unsigned int dataBytes);
+
+
+	/**
+	 * @brief  RTSP_Puller_GetShmFd 
+	 *		获取共享内存输出的描述符. 读取进程可打开 "/proc/<拉流进程pid>/fd/<fd>", 或经 fork 继承、
+	 *		Unix 域套接字(SCM_RIGHTS)传递后使用 ShmReader_OpenFd; 描述符在 RTSP_Puller_Release 时关闭,
+	 *		已打开的读取方不受影响 (ShmReader_Next 返回 -1 即表示句柄已释放); 重新开始拉流时继续使用同一缓冲区
+	 * @param handler		拉取流句柄
+	 *
+	 * @return  描述符, 未开启共享内存输出时返回-1
+	 */
+	_API int _APICALL RTSP_Puller_GetShmFd(RTSP_Puller_Handler handler);
+
+
 	/**
 	 * @brief  RTSP_Puller_CloseStream 
-	 *		结束拉取流访问
+	 *		结束拉取流访问. 与 RTSP_Puller_StartStream 等控制接口一样, 只是向句柄的接收线程投递命令,
+	 *		立即返回, 可在任意线程(包括回调)中调用
 	 * @param handler 拉取流句柄
 	 *
 	 * @return  返回处理结果 
@@ -89,7 +555,7 @@ extern "C"
 
 	/**
 	 * @brief  RTSP_Puller_Release 
-	 *		拉取流句柄资源释放
+	 *		拉取流句柄资源释放, 等待接收线程执行完此前投递的命令后退出. 不可在回调中调用
 	 * @param handler  拉取流句柄
 	 *
 	 * @return  返回处理结果 
@@ -30,7 +30,8 @@ typedef int MC_Error;
 typedef enum __RTP_CONNECT_TYPE
 {
 	RTP_OVER_TCP	=	0x01,		/* RTP Over TCP */
-	RTP_OVER_UDP					/* RTP Over UDP */
+	RTP_OVER_UDP,					/* RTP Over UDP */
+	RTP_OVER_MULTICAST				/* RTP Over UDP 组播 (SETUP 时请求 multicast, 可多进程共享同一组播) */
 } RTP_ConnectType;
 
 
@@ -40,14 +41,172 @@ typedef enum __CB_DATA_TYPE
 	CB_RTP_DATA		     =	0x02,
 	CB_PULLER_STATE	     =	0x03,
 	CB_CONNECTION_BROKEN =  0x04,
+	CB_FRAME_DATA		 =  0x05,		/* 订阅者回调的帧数据, 见 FrameData */
+	CB_SCATTER_DATA		 =  0x06,		/* 分段交付的帧数据, 见 ScatterFrameData 及 RTSP_Puller_SetScatterDelivery */
 } CBDataType;
 
+/* 帧过滤策略 */
+typedef enum __FRAME_FILTER_MODE
+{
+	FRAME_FILTER_NONE		=	0x00,		/* 不过滤, 交付全部数据 */
+	FRAME_FILTER_KEYFRAMES,					/* 仅交付关键帧 (SPS/PPS/IDR) */
+	FRAME_FILTER_GOPS						/* 按GOP交付, 配合间隔参数每N个GOP交付一个 */
+} FrameFilterMode;
+
+/* 队列满时的丢帧策略 */
+typedef enum __QUEUE_DROP_POLICY
+{
+	QUEUE_DROP_OLDEST	=	0x00,		/* 丢弃队列中最旧的帧 */
+	QUEUE_DROP_NEWEST					/* 丢弃新到达的帧 */
+} QueueDropPolicy;
+
+/* 乱序包等待策略 (丢包后等待乱序包到达的时间) */
+typedef enum __REORDER_POLICY
+{
+	REORDER_FIXED		=	0x00,		/* 固定等待时间 (默认100ms) */
+	REORDER_ADAPTIVE,					/* 按到达抖动及实际乱序程度自动调整, 限定在上下限之内 */
+	REORDER_LOW_LATENCY					/* 低延迟: 不等待乱序包, 发现丢包立即上报 (丢弃不完整的帧) */
+} ReorderPolicy;
+
+/* RTCP 反馈类型 (可组合), 见 RTSP_Puller_SetRtcpFeedback */
+typedef enum __RTCP_FEEDBACK_TYPE
+{
+	RTCP_FEEDBACK_NACK	=	0x01,		/* 通用NACK (RFC 4585): 请求重传丢失的包, 重传包在乱序等待时间内到达即可使用 */
+	RTCP_FEEDBACK_PLI	=	0x02,		/* PLI (RFC 4585): 丢帧后请求关键帧 */
+	RTCP_FEEDBACK_FIR	=	0x04		/* FIR (RFC 5104): 丢帧后请求关键帧 (用于不支持PLI的服务端) */
+} RtcpFeedbackType;
+
+/* 异步回调队列满时的处理策略 */
+typedef enum __ASYNC_OVERFLOW_POLICY
+{
+	ASYNC_DROP_OLDEST	=	0x00,		/* 丢弃队列中最旧的帧 */
+	ASYNC_DROP_NON_KEYFRAME,				/* 丢弃新到达的非关键帧; 关键帧到达时丢弃最旧的帧 */
+	ASYNC_BLOCK								/* 阻塞接收线程直到队列有空位 (反压) */
+} AsyncOverflowPolicy;
+
+/* RTP头扩展信息中的有效字段 (可组合), 见 RtpExtInfo */
+typedef enum __RTP_EXT_FLAG
+{
+	RTP_EXT_ABS_SEND_TIME		=	0x01,	/* abs-send-time (须在SDP中以 a=extmap 声明) */
+	RTP_EXT_ABS_CAPTURE_TIME	=	0x02,	/* abs-capture-time (须在SDP中以 a=extmap 声明) */
+	RTP_EXT_ONVIF_REPLAY		=	0x04	/* ONVIF 回放扩展 (0xABAC) */
+} RtpExtFlag;
+
+/* ONVIF 回放扩展的标志位, 见 RtpExtInfo::onvifFlags */
+typedef enum __ONVIF_REPLAY_FLAG
+{
+	ONVIF_REPLAY_CLEAN_POINT	=	0x80,	/* C: 可独立解码的起点 (如关键帧) */
+	ONVIF_REPLAY_END			=	0x40,	/* E: 一段连续录像的最后一帧 */
+	ONVIF_REPLAY_DISCONTINUITY	=	0x20	/* D: 与上一帧之间录像不连续 */
+} OnvifReplayFlag;
+
+/* 帧的RTP头扩展信息 (RFC 8285 单字节/双字节扩展, 及 ONVIF 回放扩展). 帧的多个包携带同一扩展时, 取第一个包的值 */
+typedef struct __RTP_EXT_INFO
+{
+	unsigned int		flags;				/* RtpExtFlag 的组合, 表示以下哪些字段有效 */
+	unsigned int		absSendTime;		/* 发送时间, 单位 1/262144 秒 (24位, 每64秒回绕) */
+	unsigned long long	absCaptureTime;		/* 采集时间, NTP格式 (高32位为秒, 低32位为秒的小数部分) */
+	unsigned long long	onvifNtpTime;		/* 录像的绝对时间, NTP格式 */
+	unsigned char		onvifFlags;			/* OnvifReplayFlag 的组合 */
+	unsigned char		onvifCSeq;			/* 开始此次回放的PLAY请求CSeq的低8位 */
+} RtpExtInfo;
+
 typedef struct __RTP_DATA
 {
 	char*	dataBuf;
 	int		bufLen;
 } RTPData;
 
+typedef struct __FRAME_DATA
+{
+	const char*		dataBuf;			/* 帧数据, 只读, 回调返回后失效 */
+	int				bufLen;				/* 数据长度 */
+	int				isKeyFrame;			/* 是否为关键帧 (SPS/PPS/IDR) */
+	int				isCached;			/* 是否为GOP缓存中的回放帧 */
+	unsigned int	rtpTimestamp;		/* RTP时间戳 */
+	unsigned int	ptsSec;				/* 显示时间: 秒 */
+	unsigned int	ptsUsec;			/* 显示时间: 微秒 */
+	const char*		mediumName;			/* 媒体类型, 如 "video" */
+	const char*		codecName;			/* 编码名称, 如 "H264" */
+	const RtpExtInfo*	extInfo;		/* RTP头扩展信息, 无则为NULL (TS解复用的帧亦为NULL); 与帧数据同时失效 */
+	unsigned long long	extRtpTimestamp;	/* 64位RTP时间戳 (已处理32位回绕; SSRC变化时重新开始). TS解复用的帧为0 */
+	unsigned long long	monoPtsUs;		/* 单调显示时间: 自首帧起的微秒数, 仅由RTP时间戳推算 (不受回绕, SSRC变化及RTCP同步影响;
+										   时间戳跳变时接续而不回退). TS解复用的帧为0 */
+	int				isDiscontinuity;	/* 此帧处时间戳不连续 (首帧, SSRC变化或时间戳跳变超过10秒) */
+} FrameData;
+
+typedef struct __FRAME_CHUNK
+{
+	const char*		dataBuf;			/* 分段数据, 直接指向接收到的RTP包载荷, 只读 */
+	int				bufLen;				/* 分段长度 */
+} FrameChunk;
+
+typedef struct __SCATTER_FRAME_DATA
+{
+	const FrameChunk*	chunks;			/* 按顺序排列的分段, 依次拼接即为完整的帧, 回调返回后失效 */
+	int				numChunks;			/* 分段个数 */
+	int				totalLen;			/* 帧的总长度 (各分段长度之和) */
+	int				isKeyFrame;			/* 是否为关键帧 (SPS/PPS/IDR) */
+	unsigned int	rtpTimestamp;		/* RTP时间戳 */
+	unsigned int	ptsSec;				/* 显示时间: 秒 */
+	unsigned int	ptsUsec;			/* 显示时间: 微秒 */
+	const char*		mediumName;			/* 媒体类型, 如 "video" */
+	const char*		codecName;			/* 编码名称, 如 "H264" */
+	const RtpExtInfo*	extInfo;		/* RTP头扩展信息, 无则为NULL; 回调返回后失效 */
+	unsigned long long	extRtpTimestamp;	/* 64位RTP时间戳, 见 FrameData */
+	unsigned long long	monoPtsUs;		/* 单调显示时间 (微秒), 见 FrameData */
+	int				isDiscontinuity;	/* 此帧处时间戳不连续, 见 FrameData */
+} ScatterFrameData;
+
+typedef struct __PULLED_FRAME
+{
+	FrameData		frame;				/* 帧数据, 在 RTSP_Puller_ReleaseFrame 之前有效 */
+	void*			opaque;				/* 内部使用 */
+} PulledFrame;
+
+typedef struct __SUBSCRIBER_STATS
+{
+	unsigned long long framesDelivered;	/* 已交付帧数 */
+	unsigned long long framesDropped;	/* 因队列满而丢弃的帧数 */
+	unsigned int queueDepth;			/* 当前队列中的帧数 */
+	unsigned int queueCapacity;			/* 队列容量 */
+} SubscriberStats;
+
+typedef struct __ASYNC_DELIVERY_STATS
+{
+	unsigned long long framesDelivered;		/* 已交付帧数 */
+	unsigned long long droppedOldest;		/* 队列满时丢弃的最旧帧数 */
+	unsigned long long droppedNonKeyFrames;	/* 队列满时丢弃的非关键帧数 */
+	unsigned long long blockedCount;		/* 接收线程因队列满而阻塞的次数 */
+	unsigned int queueDepth;				/* 当前各队列中的帧数之和 */
+} AsyncDeliveryStats;
+
+typedef struct __RECEIVE_STATS
+{
+	unsigned long long packetsReceived;		/* 收到的RTP包数 */
+	unsigned long long packetsLost;			/* 网络丢包数 (按RTP序号推算, 含内核丢弃的包) */
+	unsigned long long kernelDrops;			/* 因套接字接收缓冲区满而被内核丢弃的包数 (主机过载, 仅UDP) */
+	unsigned int socketBufferSize;			/* 各子会话RTP套接字接收缓冲区大小之和 (字节, 内核报告值) */
+	unsigned long long fecRecovered;		/* 由FEC恢复的包数 (已计入 packetsReceived) */
+} ReceiveStats;
+
+typedef struct __MEMORY_BUDGET_STATS
+{
+	unsigned long long limitBytes;			/* 内存上限, 0 表示不限 */
+	unsigned long long usedBytes;			/* 当前各路流缓冲区占用的内存 */
+	unsigned long long peakBytes;			/* 占用内存的峰值 */
+	unsigned long long refusedReservations;	/* 因超出上限而被拒绝的分配次数 (新建子会话或扩大缓冲区) */
+} MemoryBudgetStats;
+
+typedef struct __WRITER_STATS
+{
+	unsigned long long bytesWritten;		/* 已写入磁盘的字节数 */
+	unsigned long long blockedCount;		/* 写入方因写缓冲区已满而等待的次数 (录像线程, 不含接收线程) */
+	unsigned long long writeErrors;			/* 打开或写入文件失败的次数 */
+	unsigned long long pendingBytes;		/* 已交给写线程, 尚未写入的字节数 */
+	unsigned int openFiles;					/* 当前打开的文件数 */
+} WriterStats;
+
 typedef struct __MEDIA_ATTR
 {
 	unsigned int audioCodec;			/* 音頻編碼类型*/
@@ -0,0 +1,275 @@
+/**
+ * @file CallbackDispatcher.cpp
+ * @brief  1.0
+ *		implementation of CallbackDispatcher
+ * @author lizhiyong0804319@gmail.com
+ * @version 1.0
+ * @date 2026-10-19
+ */
+
+#include "CallbackDispatcher.h"
+#include "utils/MutexLock.h"
+
+#include <sched.h>
+#include <unistd.h>
+
+#define DEFAULT_NUM_DISPATCH_THREADS 2
+#define BLOCKED_PRODUCER_SLEEP_US 1000
+
+////////// DispatchWorker //////////
+
+// A pool thread.  It sleeps only when all of its queues are empty; a producer wakes it
+// (with a single "sem_post()") only if it has announced that it's about to sleep.
+
+class DispatchWorker {
+public:
+  DispatchWorker();
+
+  int start();
+  void addQueue(DispatchQueue* queue);
+  void removeQueue(DispatchQueue* queue);
+  unsigned numQueues();
+
+  void wakeUp() {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST); // order the producer's "push()" before the check below
+    if (__atomic_exchange_n(&m_sleeping, 0, __ATOMIC_SEQ_CST)) sem_post(&m_sem);
+  }
+
+private:
+  static void* entryPoint(void* param);
+  void run();
+  Boolean deliverOne();
+
+private:
+  pthread_mutex_t m_mutex; // protects "m_queues" and "m_cursor"
+  std::vector<DispatchQueue*> m_queues;
+  unsigned m_cursor; // the queue to look at first, next time
+  DispatchQueue* m_current; // the queue whose callback is in progress, if any
+  int m_sleeping;
+  sem_t m_sem;
+  pthread_t m_tid;
+};
+
+DispatchWorker::DispatchWorker()
+  : m_cursor(0), m_current(NULL), m_sleeping(0), m_tid(0) {
+  pthread_mutex_init(&m_mutex, NULL);
+  sem_init(&m_sem, 0, 0);
+}
+
+int DispatchWorker::start() {
+  return pthread_create(&m_tid, NULL, entryPoint, this) == 0 ? 0 : -1;
+}
+
+void DispatchWorker::addQueue(DispatchQueue* queue) {
+  CMutexLock lock(&m_mutex);
+  m_queues.push_back(queue);
+}
+
+void DispatchWorker::removeQueue(DispatchQueue* queue) {
+  {
+    CMutexLock lock(&m_mutex);
+    for (std::vector<DispatchQueue*>::iterator it = m_queues.begin(); it != m_queues.end(); ++it) {
+      if (*it == queue) {
+	m_queues.erase(it);
+	break;
+      }
+    }
+  }
+
+  // The queue can no longer be picked, but its last frame may still be being delivered:
+  while (__atomic_load_n(&m_current, __ATOMIC_ACQUIRE) == queue) sched_yield();
+}
+
+unsigned DispatchWorker::numQueues() {
+  CMutexLock lock(&m_mutex);
+  return (unsigned)m_queues.size();
+}
+
+void* DispatchWorker::entryPoint(void* param) {
+  DispatchWorker* worker = (DispatchWorker*)param;
+  worker->run();
+  return NULL;
+}
+
+void DispatchWorker::run() {
+  for (;;) {
+    if (deliverOne()) continue;
+
+    // Announce that we're about to sleep, then look once more, so that a frame that was
+    // pushed just before the announcement isn't left waiting:
+    __atomic_store_n(&m_sleeping, 1, __ATOMIC_SEQ_CST);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (deliverOne()) {
+      // (If a producer has already posted, the next "sem_wait()" just returns early.)
+      __atomic_store_n(&m_sleeping, 0, __ATOMIC_SEQ_CST);
+      continue;
+    }
+    sem_wait(&m_sem);
+  }
+}
+
+Boolean DispatchWorker::deliverOne() {
+  DispatchQueue* queue = NULL;
+  PullerFrame* frame = NULL;
+  {
+    CMutexLock lock(&m_mutex);
+    unsigned numQueues = (unsigned)m_queues.size();
+    for (unsigned i = 0; i < numQueues; ++i) {
+      unsigned index = (m_cursor + i)%numQueues;
+      frame = m_queues[index]->m_ring.pop();
+      if (frame != NULL) {
+	queue = m_queues[index];
+	m_cursor = index + 1;
+	__atomic_store_n(&m_current, queue, __ATOMIC_RELEASE);
+	break;
+      }
+    }
+  }
+  if (frame == NULL) return False;
+
+  queue->deliver(frame);
+  frame->release();
+  __atomic_store_n(&m_current, (DispatchQueue*)NULL, __ATOMIC_RELEASE);
+  return True;
+}
+
+
+////////// DispatchQueue //////////
+
+DispatchQueue::DispatchQueue(CBDataType cbType, PullerCallback cb, void* cbParam,
+			     unsigned queueSize, AsyncOverflowPolicy policy, AsyncDeliveryStats& stats)
+  : m_cbType(cbType), m_callbackFunc(cb), m_cbParam(cbParam), m_policy(policy),
+    m_stats(stats), m_ring(queueSize) {
+  m_worker = CallbackDispatcher::instance().addQueue(this);
+}
+
+DispatchQueue::~DispatchQueue() {
+  if (m_worker != NULL) CallbackDispatcher::instance().removeQueue(m_worker, this);
+
+  PullerFrame* frame;
+  while ((frame = m_ring.pop()) != NULL) {
+    frame->release();
+    __sync_sub_and_fetch(&m_stats.queueDepth, 1);
+  }
+}
+
+void DispatchQueue::enqueue(PullerFrame* frame) {
+  if (m_worker == NULL) return; // the pool couldn't be started
+
+  frame->addRef();
+  if (!m_ring.push(frame)) {
+    switch (m_policy) {
+    case ASYNC_DROP_NON_KEYFRAME:
+      if (!frame->isKeyFrame()) {
+	frame->release();
+	__sync_add_and_fetch(&m_stats.droppedNonKeyFrames, 1);
+	return;
+      }
+      // A key frame is worth more than the oldest queued frame, so make room for it (below).
+      // fall through
+    case ASYNC_DROP_OLDEST: {
+      PullerFrame* oldest = m_ring.dropOldest(); // (the consumer may beat us to it, which is fine)
+      if (oldest != NULL) dropFrame(oldest, m_stats.droppedOldest);
+      m_ring.push(frame); // the consumer never adds entries, so this can't fail
+      break;
+    }
+    case ASYNC_BLOCK:
+    default:
+      // Backpressure: stall the event loop (and hence the socket reads) until there's room:
+      __sync_add_and_fetch(&m_stats.blockedCount, 1);
+      do {
+	m_worker->wakeUp();
+	usleep(BLOCKED_PRODUCER_SLEEP_US);
+      } while (!m_ring.push(frame));
+      break;
+    }
+  }
+  __sync_add_and_fetch(&m_stats.queueDepth, 1);
+  m_worker->wakeUp();
+}
+
+void DispatchQueue::dropFrame(PullerFrame* frame, unsigned long long& counter) {
+  frame->release();
+  __sync_add_and_fetch(&counter, 1);
+  __sync_sub_and_fetch(&m_stats.queueDepth, 1);
+}
+
+void DispatchQueue::deliver(PullerFrame* frame) {
+  __sync_sub_and_fetch(&m_stats.queueDepth, 1);
+
+  if (m_cbType == CB_RTP_DATA) {
+    RTPData rtpData;
+    rtpData.dataBuf = (char*)frame->data();
+    rtpData.bufLen = frame->size();
+    m_callbackFunc(CB_RTP_DATA, &rtpData, m_cbParam);
+  } else {
+    FrameData frameData;
+    frameData.dataBuf = (const char*)frame->data();
+    frameData.bufLen = frame->size();
+    frameData.isKeyFrame = frame->isKeyFrame();
+    frameData.isCached = 0;
+    frameData.rtpTimestamp = frame->rtpTimestamp();
+    frameData.ptsSec = frame->presentationTime().tv_sec;
+    frameData.ptsUsec = frame->presentationTime().tv_usec;
+    frameData.mediumName = frame->mediumName();
+    frameData.codecName = frame->codecName();
+    frameData.extInfo = frame->extInfo();
+    frameData.extRtpTimestamp = frame->extendedRTPTimestamp();
+    frameData.monoPtsUs = frame->monoPTS();
+    frameData.isDiscontinuity = frame->isDiscontinuity();
+    m_callbackFunc(CB_FRAME_DATA, &frameData, m_cbParam);
+  }
+  __sync_add_and_fetch(&m_stats.framesDelivered, 1);
+}
+
+
+////////// CallbackDispatcher //////////
+
+unsigned CallbackDispatcher::s_numThreads = DEFAULT_NUM_DISPATCH_THREADS;
+CallbackDispatcher* CallbackDispatcher::s_instance = NULL;
+pthread_mutex_t CallbackDispatcher::s_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+int CallbackDispatcher::setNumThreads(unsigned numThreads) {
+  CMutexLock lock(&s_mutex);
+  if (s_instance != NULL || numThreads == 0) return -1;
+  s_numThreads = numThreads;
+  return 0;
+}
+
+CallbackDispatcher& CallbackDispatcher::instance() {
+  CMutexLock lock(&s_mutex);
+  if (s_instance == NULL) s_instance = new CallbackDispatcher(s_numThreads);
+  return *s_instance;
+}
+
+CallbackDispatcher::CallbackDispatcher(unsigned numThreads) {
+  for (unsigned i = 0; i < numThreads; ++i) {
+    DispatchWorker* worker = new DispatchWorker();
+    if (worker->start() != 0) {
+      delete worker;
+      break;
+    }
+    m_workers.push_back(worker);
+  }
+}
+
+CallbackDispatcher::~CallbackDispatcher() {
+}
+
+DispatchWorker* CallbackDispatcher::addQueue(DispatchQueue* queue) {
+  DispatchWorker* leastLoaded = NULL;
+  unsigned leastNumQueues = 0;
+  for (unsigned i = 0; i < m_workers.size(); ++i) {
+    unsigned numQueues = m_workers[i]->numQueues();
+    if (leastLoaded == NULL || numQueues < leastNumQueues) {
+      leastLoaded = m_workers[i];
+      leastNumQueues = numQueues;
+    }
+  }
+  if (leastLoaded != NULL) leastLoaded->addQueue(queue);
+  return leastLoaded;
+}
+
+void CallbackDispatcher::removeQueue(DispatchWorker* worker, DispatchQueue* queue) {
+  worker->removeQueue(queue);
+}
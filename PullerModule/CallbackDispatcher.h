@@ -0,0 +1,71 @@
+/**
+ * @file CallbackDispatcher.h
+ * @brief  Asynchronous delivery of a stream's data callback, from a shared thread pool
+ * @author lizhiyong0804319@gmail.com
+ * @version 1.0
+ * @date 2026-10-19
+ */
+
+#ifndef CALLBACK_DISPATCHER_H
+#define CALLBACK_DISPATCHER_H
+
+#include "API_PullerModule.h"
+#include "utils/FrameRing.h"
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <vector>
+
+class DispatchWorker; // forward
+
+// One per "PullerSink" that uses asynchronous delivery.  The event loop thread is the
+// queue's only producer; the single pool thread that the queue is assigned to is its
+// only consumer, so the frames of a stream are always delivered in order.
+
+class DispatchQueue {
+public:
+  DispatchQueue(CBDataType cbType, PullerCallback cb, void* cbParam,
+		unsigned queueSize, AsyncOverflowPolicy policy, AsyncDeliveryStats& stats);
+  ~DispatchQueue(); // waits for an in-progress callback (if any) to return
+
+  void enqueue(PullerFrame* frame); // producer side; takes its own reference
+
+private:
+  friend class DispatchWorker;
+  void deliver(PullerFrame* frame); // consumer side
+  void dropFrame(PullerFrame* frame, unsigned long long& counter);
+
+private:
+  CBDataType m_cbType; // CB_RTP_DATA or CB_FRAME_DATA
+  PullerCallback m_callbackFunc;
+  void* m_cbParam;
+  AsyncOverflowPolicy m_policy;
+  AsyncDeliveryStats& m_stats; // shared by all of a stream's queues; updated atomically
+  FrameRing m_ring;
+  DispatchWorker* m_worker;
+};
+
+// The pool of consumer threads, shared by all streams.  Each queue is assigned to the
+// least-loaded thread when it's created; a thread services its queues round-robin, one
+// frame at a time, so a busy stream can't starve the others that share its thread.
+
+class CallbackDispatcher {
+public:
+  static int setNumThreads(unsigned numThreads); // fails once the pool has been started
+  static CallbackDispatcher& instance(); // starts the pool on first use
+
+  DispatchWorker* addQueue(DispatchQueue* queue);
+  void removeQueue(DispatchWorker* worker, DispatchQueue* queue);
+
+private:
+  CallbackDispatcher(unsigned numThreads);
+  ~CallbackDispatcher(); // never called; the pool lives as long as the process
+
+private:
+  static unsigned s_numThreads;
+  static CallbackDispatcher* s_instance;
+  static pthread_mutex_t s_mutex;
+  std::vector<DispatchWorker*> m_workers;
+};
+
+#endif
@@ -0,0 +1,369 @@
+/**
+ * @file FileWriter.cpp
+ * @brief  1.0
+ *		implementation of AsyncFile and FileWriterPool
+ * @author lizhiyong0804319@gmail.com
+ * @version 1.0
+ * @date 2026-10-19
+ */
+
+#include "FileWriter.h"
+#include "MemoryBudget.h"
+#include "utils/MutexLock.h"
+
+#include <deque>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define DEFAULT_NUM_WRITER_THREADS 1
+#define WRITE_BUFFER_SIZE (1024*1024) // each of a file's two buffers, by default
+#define DIRECT_IO_ALIGNMENT 4096 // of O_DIRECT buffers, offsets and sizes
+#define PREALLOCATION_SIZE (16*1024*1024) // how far ahead of the data we allocate the file's space
+
+////////// FileWriterThread //////////
+
+// A writer thread.  Its jobs - each a buffer to be written, or a file to be closed - are done in the
+// order in which they were posted, so each file's writes are done in the order in which they were made.
+
+class FileWriterThread {
+public:
+  FileWriterThread();
+
+  int start();
+  void post(AsyncFile* file, unsigned bufferIndex, Boolean isClose);
+
+public:
+  unsigned m_numFiles; // protected by "FileWriterPool::s_mutex"
+
+private:
+  static void* entryPoint(void* param);
+  void run();
+
+private:
+  struct Job {
+    AsyncFile* file;
+    unsigned bufferIndex;
+    Boolean isClose;
+  };
+
+  pthread_mutex_t m_mutex; // protects "m_jobs"
+  pthread_cond_t m_jobPosted;
+  std::deque<Job> m_jobs;
+  pthread_t m_tid;
+};
+
+FileWriterThread::FileWriterThread()
+  : m_numFiles(0), m_tid(0) {
+  pthread_mutex_init(&m_mutex, NULL);
+  pthread_cond_init(&m_jobPosted, NULL);
+}
+
+int FileWriterThread::start() {
+  return pthread_create(&m_tid, NULL, entryPoint, this) == 0 ? 0 : -1;
+}
+
+void FileWriterThread::post(AsyncFile* file, unsigned bufferIndex, Boolean isClose) {
+  Job job;
+  job.file = file;
+  job.bufferIndex = bufferIndex;
+  job.isClose = isClose;
+
+  CMutexLock lock(&m_mutex);
+  m_jobs.push_back(job);
+  pthread_cond_signal(&m_jobPosted);
+}
+
+void* FileWriterThread::entryPoint(void* param) {
+  FileWriterThread* thread = (FileWriterThread*)param;
+  thread->run();
+  return NULL;
+}
+
+void FileWriterThread::run() {
+  for (;;) {
+    Job job;
+    {
+      CMutexLock lock(&m_mutex);
+      while (m_jobs.empty()) pthread_cond_wait(&m_jobPosted, &m_mutex);
+      job = m_jobs.front();
+      m_jobs.pop_front();
+    }
+
+    if (job.isClose) {
+      job.file->doClose(job.bufferIndex); // (this deletes the file)
+    } else {
+      job.file->doWrite(job.bufferIndex);
+    }
+  }
+}
+
+
+////////// AsyncFile //////////
+
+AsyncFile* AsyncFile::open(char const* path, unsigned bufferSize,
+			  char const* renameTo, AsyncFile const* sameWriterAs) {
+  FileWriterPool* pool = FileWriterPool::instance();
+  if (pool == NULL) return NULL;
+
+  // Each buffer must hold at least a couple of (aligned) blocks:
+  if (bufferSize == 0) bufferSize = WRITE_BUFFER_SIZE;
+  bufferSize = (bufferSize + DIRECT_IO_ALIGNMENT - 1)/DIRECT_IO_ALIGNMENT*DIRECT_IO_ALIGNMENT;
+  if (bufferSize < 2*DIRECT_IO_ALIGNMENT) bufferSize = 2*DIRECT_IO_ALIGNMENT;
+
+  return new AsyncFile(path, bufferSize, renameTo,
+		       pool->addFile(sameWriterAs != NULL ? sameWriterAs->m_writer : NULL));
+}
+
+AsyncFile::AsyncFile(char const* path, unsigned bufferSize, char const* renameTo,
+		     FileWriterThread* writer)
+  : m_path(path), m_renameTo(renameTo != NULL ? renameTo : ""), m_bufferSize(bufferSize), m_writer(writer),
+    m_active(0), m_fill(0), m_carried(0), m_activeOffset(0),
+    m_fd(-1), m_openAttempted(False), m_direct(False), m_allocatedSize(0), m_failed(0) {
+  for (unsigned i = 0; i < 2; ++i) {
+    void* data = NULL;
+    if (posix_memalign(&data, DIRECT_IO_ALIGNMENT, m_bufferSize) != 0) data = NULL;
+    m_buffers[i].data = (unsigned char*)data;
+    m_buffers[i].size = 0;
+    m_buffers[i].fileOffset = 0;
+    m_buffers[i].numNewBytes = 0;
+    m_buffers[i].busy = 0;
+  }
+  if (m_buffers[0].data == NULL || m_buffers[1].data == NULL) m_failed = 1;
+  MemoryBudget::charge(2*(long long)m_bufferSize);
+  pthread_mutex_init(&m_mutex, NULL);
+  pthread_cond_init(&m_bufferFreed, NULL);
+}
+
+AsyncFile::~AsyncFile() {
+  free(m_buffers[0].data);
+  free(m_buffers[1].data);
+  MemoryBudget::charge(-2*(long long)m_bufferSize);
+  pthread_cond_destroy(&m_bufferFreed);
+  pthread_mutex_destroy(&m_mutex);
+}
+
+Boolean AsyncFile::write(void const* data, unsigned size) {
+  if (failed()) return False;
+
+  unsigned char const* bytes = (unsigned char const*)data;
+  while (size > 0) {
+    unsigned numBytes = m_bufferSize - m_fill;
+    if (numBytes > size) numBytes = size;
+    memcpy(m_buffers[m_active].data + m_fill, bytes, numBytes);
+    m_fill += numBytes;
+    bytes += numBytes;
+    size -= numBytes;
+
+    if (m_fill == m_bufferSize && !submit(True)) return False;
+  }
+  return True;
+}
+
+void AsyncFile::flush() {
+  if (m_fill > m_carried) submit(False);
+}
+
+void AsyncFile::close() {
+  Buffer& buffer = m_buffers[m_active];
+  buffer.size = m_fill;
+  buffer.fileOffset = m_activeOffset;
+  buffer.numNewBytes = m_fill - m_carried;
+  __atomic_fetch_add(&FileWriterPool::s_stats.pendingBytes, buffer.numNewBytes, __ATOMIC_RELAXED);
+  m_writer->post(this, m_active, True);
+}
+
+Boolean AsyncFile::submit(Boolean waitForBuffer) {
+  unsigned next = m_active^1;
+  if (__atomic_load_n(&m_buffers[next].busy, __ATOMIC_ACQUIRE)) {
+    if (!waitForBuffer) return False;
+
+    __atomic_fetch_add(&FileWriterPool::s_stats.blockedCount, 1, __ATOMIC_RELAXED);
+    CMutexLock lock(&m_mutex);
+    while (__atomic_load_n(&m_buffers[next].busy, __ATOMIC_ACQUIRE)) pthread_cond_wait(&m_bufferFreed, &m_mutex);
+  }
+
+  // Each write must begin at an aligned offset (for O_DIRECT), so an unaligned tail is copied to the
+  // start of the next buffer, and written again (with whatever follows it) from there:
+  Buffer& buffer = m_buffers[m_active];
+  unsigned tail = m_fill%DIRECT_IO_ALIGNMENT;
+  memcpy(m_buffers[next].data, buffer.data + m_fill - tail, tail);
+
+  buffer.size = m_fill;
+  buffer.fileOffset = m_activeOffset;
+  buffer.numNewBytes = m_fill - m_carried;
+  __atomic_fetch_add(&FileWriterPool::s_stats.pendingBytes, buffer.numNewBytes, __ATOMIC_RELAXED);
+  __atomic_store_n(&buffer.busy, 1, __ATOMIC_RELEASE);
+  m_writer->post(this, m_active, False);
+
+  m_activeOffset += m_fill - tail;
+  m_fill = m_carried = tail;
+  m_active = next;
+  return True;
+}
+
+void AsyncFile::doWrite(unsigned bufferIndex) {
+  Buffer& buffer = m_buffers[bufferIndex];
+  if (!m_openAttempted) openFile();
+  noteWritten(buffer, m_fd >= 0 && !failed() && writeFully(buffer.data, buffer.size, buffer.fileOffset));
+
+  CMutexLock lock(&m_mutex);
+  __atomic_store_n(&buffer.busy, 0, __ATOMIC_RELEASE);
+  pthread_cond_signal(&m_bufferFreed);
+}
+
+void AsyncFile::doClose(unsigned bufferIndex) {
+  Buffer& buffer = m_buffers[bufferIndex];
+  if (!m_openAttempted) openFile();
+  if (m_fd < 0) {
+    noteWritten(buffer, False);
+  } else {
+    noteWritten(buffer, !failed() && (buffer.size == 0 || writeFully(buffer.data, buffer.size, buffer.fileOffset)));
+
+    // Drop any padding (from O_DIRECT) and unused preallocated space:
+    if (ftruncate(m_fd, buffer.fileOffset + buffer.size) != 0) { /* the data is intact regardless */ }
+    ::close(m_fd);
+
+    if (!m_renameTo.empty()) {
+      // Only a complete file takes the place of the old one:
+      if (failed() || rename(m_path.c_str(), m_renameTo.c_str()) != 0) unlink(m_path.c_str());
+    }
+  }
+  FileWriterPool::instance()->removeFile(m_writer);
+  delete this;
+}
+
+Boolean AsyncFile::openFile() {
+  m_openAttempted = True;
+  m_fd = ::open(m_path.c_str(), O_WRONLY|O_CREAT|O_TRUNC|O_DIRECT, 0644);
+  m_direct = m_fd >= 0;
+  if (m_fd < 0 && errno == EINVAL) { // the filesystem doesn't support O_DIRECT (e.g., "tmpfs")
+    m_fd = ::open(m_path.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644);
+  }
+  if (m_fd < 0) {
+    noteFailure();
+    return False;
+  }
+  return True;
+}
+
+Boolean AsyncFile::writeFully(unsigned char* data, unsigned size, unsigned long long offset) {
+  unsigned writeSize = size;
+  if (m_direct) {
+    // Pad the write out to a whole number of blocks (the padding is truncated when the file is closed):
+    writeSize = (size + DIRECT_IO_ALIGNMENT - 1)/DIRECT_IO_ALIGNMENT*DIRECT_IO_ALIGNMENT;
+    memset(data + size, 0, writeSize - size);
+  }
+
+  // Allocate the file's space well ahead of the data, so that it's less fragmented:
+  if (offset + writeSize > m_allocatedSize) {
+    unsigned long long newSize = offset + writeSize + PREALLOCATION_SIZE;
+    if (fallocate(m_fd, FALLOC_FL_KEEP_SIZE, m_allocatedSize, newSize - m_allocatedSize) != 0) {
+      // (not supported by this filesystem; the space will be allocated as we write)
+    }
+    m_allocatedSize = newSize;
+  }
+
+  unsigned numWritten = 0;
+  while (numWritten < writeSize) {
+    ssize_t result = pwrite(m_fd, data + numWritten, writeSize - numWritten, offset + numWritten);
+    if (result < 0) {
+      if (errno == EINTR) continue;
+      if (errno == EINVAL && m_direct) {
+	// O_DIRECT writes aren't supported after all; continue without it:
+	fcntl(m_fd, F_SETFL, fcntl(m_fd, F_GETFL) & ~O_DIRECT);
+	m_direct = False;
+	writeSize = size;
+	continue;
+      }
+      return False;
+    }
+    numWritten += (unsigned)result;
+  }
+  return True;
+}
+
+void AsyncFile::noteWritten(Buffer& buffer, Boolean success) {
+  __atomic_fetch_sub(&FileWriterPool::s_stats.pendingBytes, buffer.numNewBytes, __ATOMIC_RELAXED);
+  if (success) {
+    __atomic_fetch_add(&FileWriterPool::s_stats.bytesWritten, buffer.numNewBytes, __ATOMIC_RELAXED);
+  } else if (m_fd >= 0 && !failed()) {
+    noteFailure();
+  }
+}
+
+void AsyncFile::noteFailure() {
+  __atomic_store_n(&m_failed, 1, __ATOMIC_RELEASE);
+  __atomic_fetch_add(&FileWriterPool::s_stats.writeErrors, 1, __ATOMIC_RELAXED);
+}
+
+
+////////// FileWriterPool //////////
+
+unsigned FileWriterPool::s_numThreads = DEFAULT_NUM_WRITER_THREADS;
+FileWriterPool* FileWriterPool::s_instance = NULL;
+pthread_mutex_t FileWriterPool::s_mutex = PTHREAD_MUTEX_INITIALIZER;
+WriterStats FileWriterPool::s_stats;
+
+int FileWriterPool::setNumThreads(unsigned numThreads) {
+  CMutexLock lock(&s_mutex);
+  if (s_instance != NULL || numThreads == 0) return -1;
+  s_numThreads = numThreads;
+  return 0;
+}
+
+FileWriterPool* FileWriterPool::instance() {
+  CMutexLock lock(&s_mutex);
+  if (s_instance == NULL) {
+    FileWriterPool* pool = new FileWriterPool(s_numThreads);
+    if (pool->m_threads.empty()) {
+      delete pool;
+      return NULL;
+    }
+    s_instance = pool;
+  }
+  return s_instance;
+}
+
+void FileWriterPool::getStats(WriterStats& stats) {
+  stats.bytesWritten = __atomic_load_n(&s_stats.bytesWritten, __ATOMIC_RELAXED);
+  stats.blockedCount = __atomic_load_n(&s_stats.blockedCount, __ATOMIC_RELAXED);
+  stats.writeErrors = __atomic_load_n(&s_stats.writeErrors, __ATOMIC_RELAXED);
+  stats.pendingBytes = __atomic_load_n(&s_stats.pendingBytes, __ATOMIC_RELAXED);
+  stats.openFiles = __atomic_load_n(&s_stats.openFiles, __ATOMIC_RELAXED);
+}
+
+FileWriterPool::FileWriterPool(unsigned numThreads) {
+  for (unsigned i = 0; i < numThreads; ++i) {
+    FileWriterThread* thread = new FileWriterThread();
+    if (thread->start() != 0) {
+      delete thread;
+      break;
+    }
+    m_threads.push_back(thread);
+  }
+}
+
+FileWriterPool::~FileWriterPool() {
+}
+
+FileWriterThread* FileWriterPool::addFile(FileWriterThread* writer) {
+  CMutexLock lock(&s_mutex);
+
+  FileWriterThread* best = writer != NULL ? writer : m_threads[0];
+  for (std::vector<FileWriterThread*>::iterator it = m_threads.begin(); writer == NULL && it != m_threads.end(); ++it) {
+    if ((*it)->m_numFiles < best->m_numFiles) best = *it;
+  }
+  ++best->m_numFiles;
+  __atomic_fetch_add(&s_stats.openFiles, 1, __ATOMIC_RELAXED);
+  return best;
+}
+
+void FileWriterPool::removeFile(FileWriterThread* writer) {
+  CMutexLock lock(&s_mutex);
+  --writer->m_numFiles;
+  __atomic_fetch_sub(&s_stats.openFiles, 1, __ATOMIC_RELAXED);
+}
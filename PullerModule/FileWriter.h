@@ -0,0 +1,119 @@
+/**
+ * @file FileWriter.h
+ * @brief  Asynchronous, buffered file output, from a shared pool of writer threads
+ * @author lizhiyong0804319@gmail.com
+ * @version 1.0
+ * @date 2026-10-19
+ */
+
+#ifndef FILE_WRITER_H
+#define FILE_WRITER_H
+
+#include "API_PullerModule.h"
+#include "Boolean.hh"
+
+#include <pthread.h>
+#include <string>
+#include <vector>
+
+class FileWriterThread; // forward
+
+// A file that's written by the writer pool.  Its single producer only ever copies data into one
+// of the file's two buffers; a full buffer is handed to the file's writer thread, and the producer
+// carries on with the other one (waiting only if that one is still being written).  Opening, writing
+// and closing all happen on the writer thread, so none of them can hold up the producer.
+// Files are opened with O_DIRECT where the filesystem supports it (the buffers are suitably
+// aligned), and their space is preallocated (with "fallocate()") ahead of the data.
+
+class AsyncFile {
+public:
+  static AsyncFile* open(char const* path, unsigned bufferSize = 0,
+			char const* renameTo = NULL, AsyncFile const* sameWriterAs = NULL);
+      // Returns NULL iff the pool couldn't be started.  "bufferSize" is that of each of the file's two
+      // buffers (0 means the default, 1 MB).  If "renameTo" is given, the file is renamed to it (replacing
+      // any file of that name) once it has been written in full, so that readers never see a partial file.
+      // If "sameWriterAs" (which mustn't have been closed yet) is given, we use its writer thread, so
+      // our I/O happens after all of the I/O that has been requested for it so far.
+
+  Boolean write(void const* data, unsigned size);
+      // Returns False if the file has failed.  (Waits if both buffers are full, so the producer must
+      // have a thread of its own - not an event loop's.)
+  void flush(); // hands over the buffered data now - unless that would mean waiting for the writer
+  void close(); // hands over the rest of the data; the writer then closes (and deletes) the file
+
+  Boolean failed() const { return __atomic_load_n(&m_failed, __ATOMIC_ACQUIRE) != 0; }
+      // the file couldn't be opened, or a write to it failed; any later data is discarded
+
+private:
+  struct Buffer {
+    unsigned char* data;
+    unsigned size; // of the data to be written
+    unsigned long long fileOffset;
+    unsigned numNewBytes; // those that weren't part of an earlier write
+    int busy; // being written; set by the producer, and cleared by the writer
+  };
+
+private:
+  friend class FileWriterThread;
+  AsyncFile(char const* path, unsigned bufferSize, char const* renameTo, FileWriterThread* writer);
+  ~AsyncFile(); // called by the writer thread, once the file has been closed
+
+  Boolean submit(Boolean waitForBuffer); // producer side: hands over the active buffer
+
+  // Writer side:
+  void doWrite(unsigned bufferIndex);
+  void doClose(unsigned bufferIndex);
+  Boolean openFile();
+  Boolean writeFully(unsigned char* data, unsigned size, unsigned long long offset); // (pads "data", for O_DIRECT)
+  void noteWritten(Buffer& buffer, Boolean success);
+  void noteFailure();
+
+private:
+  std::string m_path;
+  std::string m_renameTo; // empty if none
+  unsigned m_bufferSize;
+  FileWriterThread* m_writer;
+  Buffer m_buffers[2];
+
+  // Producer side:
+  unsigned m_active; // the buffer that's being filled
+  unsigned m_fill;
+  unsigned m_carried; // bytes at the start of the active buffer that were already handed over (see "submit()")
+  unsigned long long m_activeOffset; // the file offset of the active buffer's first byte
+  pthread_mutex_t m_mutex; // for waiting (with "m_bufferFreed") for a buffer to be written
+  pthread_cond_t m_bufferFreed;
+
+  // Writer side:
+  int m_fd; // -1 until opened
+  Boolean m_openAttempted;
+  Boolean m_direct; // opened with O_DIRECT
+  unsigned long long m_allocatedSize; // preallocated so far
+  int m_failed;
+};
+
+// The pool of writer threads, shared by all files.  Each file is assigned to the thread with
+// the fewest files when it's opened, and all of its I/O happens (in order) on that thread.
+
+class FileWriterPool {
+public:
+  static int setNumThreads(unsigned numThreads); // fails once the pool has been started
+  static FileWriterPool* instance(); // starts the pool on first use; NULL if it couldn't be started
+  static void getStats(WriterStats& stats);
+
+  FileWriterThread* addFile(FileWriterThread* writer = NULL); // the thread with the fewest files, or else "writer"
+  void removeFile(FileWriterThread* writer);
+
+private:
+  friend class AsyncFile;
+  FileWriterPool(unsigned numThreads);
+  ~FileWriterPool(); // never called; the pool lives as long as the process
+
+private:
+  static unsigned s_numThreads;
+  static FileWriterPool* s_instance;
+  static pthread_mutex_t s_mutex;
+  static WriterStats s_stats; // updated atomically
+  std::vector<FileWriterThread*> m_threads;
+};
+
+#endif
@@ -0,0 +1,582 @@
+/**
+ * @file Fmp4Recorder.cpp
+ * @brief  1.0
+ *		implementation of Fmp4Recorder
+ * @author lizhiyong0804319@gmail.com
+ * @version 1.0
+ * @date 2026-10-19
+ */
+
+#include "Fmp4Recorder.h"
+#include "FrameDistributor.h"
+#include "FileWriter.h"
+#include "MemoryBudget.h"
+#include "liveMedia.hh"
+#include "BitVector.hh"
+
+#include <stdio.h>
+#include <string.h>
+
+#define TIMESCALE 90000
+#define EVENT_ENDED (~(u_int64_t)0) // in "m_retriggerDuration", once our thread has decided to finish the event
+#define DEFAULT_SAMPLE_DURATION (TIMESCALE/25) // until we've seen two samples
+#define MAX_FRAGMENT_DURATION TIMESCALE // also bounds the number of samples in a fragment
+#define MAX_FRAGMENT_SAMPLES 256
+#define MAX_FRAGMENT_BYTES (2*1024*1024)
+#define MAX_SPS_SIZE 256 // for parsing only; larger SPSs are still recorded
+
+#define SAMPLE_FLAGS_SYNC 0x02000000 // "sample_depends_on" 2 (an I picture)
+#define SAMPLE_FLAGS_NON_SYNC 0x01010000 // "sample_depends_on" 1, "sample_is_non_sync_sample"
+
+////////// SPS parsing //////////
+
+struct SPSInfo {
+  unsigned profileIdc;
+  unsigned chromaFormatIdc;
+  unsigned bitDepthLumaMinus8, bitDepthChromaMinus8;
+  unsigned width, height;
+};
+
+static int signedExpGolomb(BitVector& bv) {
+  unsigned codeNum = bv.get_expGolomb();
+  return (codeNum&1) ? (int)((codeNum+1)/2) : -(int)(codeNum/2);
+}
+
+static void skipScalingList(BitVector& bv, unsigned sizeOfScalingList) {
+  int lastScale = 8, nextScale = 8;
+  for (unsigned j = 0; j < sizeOfScalingList; ++j) {
+    if (nextScale != 0) {
+      int deltaScale = signedExpGolomb(bv);
+      nextScale = (lastScale + deltaScale + 256)%256;
+    }
+    lastScale = nextScale == 0 ? lastScale : nextScale;
+  }
+}
+
+static Boolean parseSPS(std::string const& sps, SPSInfo& info) {
+  // Remove 'emulation prevention' bytes before parsing:
+  unsigned char rbsp[MAX_SPS_SIZE];
+  unsigned rbspSize = 0;
+  for (unsigned i = 1/*skip the NAL header*/; i < sps.size() && rbspSize < sizeof rbsp; ++i) {
+    if (i >= 3 && (unsigned char)sps[i] == 3 && sps[i-1] == 0 && sps[i-2] == 0) continue;
+    rbsp[rbspSize++] = (unsigned char)sps[i];
+  }
+  if (rbspSize < 4) return False;
+
+  BitVector bv(rbsp, 0, 8*rbspSize);
+  info.profileIdc = bv.getBits(8);
+  bv.skipBits(16); // constraint_set flags, level_idc
+  (void)bv.get_expGolomb(); // seq_parameter_set_id
+  info.chromaFormatIdc = 1;
+  info.bitDepthLumaMinus8 = info.bitDepthChromaMinus8 = 0;
+  unsigned p = info.profileIdc;
+  if (p == 100 || p == 110 || p == 122 || p == 244 || p == 44 || p == 83 || p == 86 || p == 118
+      || p == 128 || p == 138 || p == 139 || p == 134 || p == 135) {
+    info.chromaFormatIdc = bv.get_expGolomb();
+    if (info.chromaFormatIdc == 3) bv.skipBits(1); // separate_colour_plane_flag
+    info.bitDepthLumaMinus8 = bv.get_expGolomb();
+    info.bitDepthChromaMinus8 = bv.get_expGolomb();
+    bv.skipBits(1); // qpprime_y_zero_transform_bypass_flag
+    if (bv.get1BitBoolean()) { // seq_scaling_matrix_present_flag
+      unsigned numLists = info.chromaFormatIdc != 3 ? 8 : 12;
+      for (unsigned i = 0; i < numLists; ++i) {
+	if (bv.get1BitBoolean()) skipScalingList(bv, i < 6 ? 16 : 64);
+      }
+    }
+  }
+  (void)bv.get_expGolomb(); // log2_max_frame_num_minus4
+  unsigned picOrderCntType = bv.get_expGolomb();
+  if (picOrderCntType == 0) {
+    (void)bv.get_expGolomb(); // log2_max_pic_order_cnt_lsb_minus4
+  } else if (picOrderCntType == 1) {
+    bv.skipBits(1); // delta_pic_order_always_zero_flag
+    (void)signedExpGolomb(bv); // offset_for_non_ref_pic
+    (void)signedExpGolomb(bv); // offset_for_top_to_bottom_field
+    unsigned numRefFramesInCycle = bv.get_expGolomb();
+    for (unsigned i = 0; i < numRefFramesInCycle && bv.numBitsRemaining() > 0; ++i) (void)signedExpGolomb(bv);
+  }
+  (void)bv.get_expGolomb(); // max_num_ref_frames
+  bv.skipBits(1); // gaps_in_frame_num_value_allowed_flag
+  unsigned picWidthInMbsMinus1 = bv.get_expGolomb();
+  unsigned picHeightInMapUnitsMinus1 = bv.get_expGolomb();
+  unsigned frameMbsOnly = bv.get1Bit();
+  if (!frameMbsOnly) bv.skipBits(1); // mb_adaptive_frame_field_flag
+  bv.skipBits(1); // direct_8x8_inference_flag
+
+  unsigned cropLeft = 0, cropRight = 0, cropTop = 0, cropBottom = 0;
+  if (bv.get1BitBoolean()) { // frame_cropping_flag
+    cropLeft = bv.get_expGolomb();
+    cropRight = bv.get_expGolomb();
+    cropTop = bv.get_expGolomb();
+    cropBottom = bv.get_expGolomb();
+  }
+  if (bv.curBitIndex() > bv.totNumBits()) return False; // the SPS was truncated
+
+  unsigned cropUnitX = info.chromaFormatIdc == 0 || info.chromaFormatIdc == 3 ? 1 : 2;
+  unsigned cropUnitY = (info.chromaFormatIdc == 1 ? 2 : 1)*(2 - frameMbsOnly);
+  info.width = (picWidthInMbsMinus1 + 1)*16 - cropUnitX*(cropLeft + cropRight);
+  info.height = (2 - frameMbsOnly)*(picHeightInMapUnitsMinus1 + 1)*16 - cropUnitY*(cropTop + cropBottom);
+  return True;
+}
+
+////////// Fmp4Recorder //////////
+
+Fmp4Recorder::Fmp4Recorder(FrameDistributor& distributor, char const* pathPrefix,
+    unsigned segmentSeconds, unsigned long long segmentMaxBytes, unsigned postSeconds)
+  : m_distributor(distributor), m_subscriberId(0), m_framesDropped(0), m_pathPrefix(pathPrefix),
+    m_segmentMaxDuration((u_int64_t)segmentSeconds*TIMESCALE), m_segmentMaxBytes(segmentMaxBytes),
+    m_isEvent(postSeconds > 0), m_postDuration((u_int64_t)postSeconds*TIMESCALE), m_retriggerDuration(0),
+    m_haveEndPTS(False), m_endPTS(0), m_finished(0),
+    m_file(NULL), m_segmentIndex(0), m_segmentStartPTS(0), m_segmentBytes(0), m_fragmentSequenceNumber(0),
+    m_width(0), m_height(0), m_fragmentBytes(0), m_fragmentStartPTS(0),
+    m_waitingForKeyFrame(True), m_haveCurSample(False), m_curRTPTimestamp(0), m_curPTS(0), m_curIsSync(False),
+    m_lastDuration(DEFAULT_SAMPLE_DURATION), m_chargedBytes(0) {
+}
+
+Fmp4Recorder::~Fmp4Recorder() {
+  if (!finished()) finish();
+
+  // Release our buffers' memory before we give it back to the budget:
+  std::vector<Sample>().swap(m_samples);
+  std::vector<unsigned char>().swap(m_mdat);
+  std::vector<unsigned char>().swap(m_boxes);
+  accountMemory();
+}
+
+int _APICALL Fmp4Recorder::onFrame(CBDataType dataType, void* data, void* obj) {
+  if (dataType == CB_FRAME_DATA && data != NULL) {
+    Fmp4Recorder* recorder = (Fmp4Recorder*)obj;
+    recorder->handleFrame(*(FrameData*)data);
+    recorder->accountMemory();
+  }
+  return 0;
+}
+
+Boolean Fmp4Recorder::retrigger(unsigned postSeconds) {
+  u_int64_t duration = (u_int64_t)postSeconds*TIMESCALE;
+  u_int64_t current = __atomic_load_n(&m_retriggerDuration, __ATOMIC_ACQUIRE);
+  do {
+    if (current == EVENT_ENDED) return False; // too late
+  } while (!__atomic_compare_exchange_n(&m_retriggerDuration, &current, duration, False,
+					__ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+  return True;
+}
+
+void Fmp4Recorder::handleFrame(FrameData const& frame) {
+  if (frame.codecName == NULL || strcmp(frame.codecName, "H264") != 0 || frame.bufLen <= 0) return;
+  if (finished()) return;
+
+  // If frames were dropped from our queue (because we couldn't keep up), there's now a gap in the
+  // stream; skip everything up to the next key frame:
+  if (m_subscriberId != 0) {
+    SubscriberStats stats;
+    if (m_distributor.getSubscriberStats(m_subscriberId, stats) == 0 && stats.framesDropped != m_framesDropped) {
+      m_framesDropped = stats.framesDropped;
+      discardCurSample();
+      m_waitingForKeyFrame = True;
+    }
+  }
+
+  // (Each frame is a single NAL unit.  Whole RTP packets - "retRtpPkt" streams - and demultiplexed
+  // Transport Stream frames - which begin with a start code - can't be recorded, and are ignored here.)
+  unsigned char const* nal = (unsigned char const*)frame.dataBuf;
+  unsigned char nalUnitType = nal[0]&0x1F;
+  if ((nal[0]&0x80) != 0 || nalUnitType == 0 || nalUnitType > 23) return;
+
+  u_int64_t pts = frame.monoPtsUs*TIMESCALE/1000000;
+  if (m_isEvent && eventHasEnded(frame, pts)) {
+    finish();
+    return;
+  }
+  if (m_haveCurSample && frame.rtpTimestamp != m_curRTPTimestamp) {
+    if (pts < m_curPTS) {
+      // The presentation time went backwards, so the pictures are being sent out of order - i.e., the stream
+      // has B-frames.  We'd need decode times (and composition offsets) for these, but we have only
+      // presentation times, so stop here; what we've recorded so far is still timed correctly:
+      finish();
+      return;
+    }
+    finishSample(pts);
+    beginSample(frame.rtpTimestamp, pts);
+  } else if (!m_haveCurSample && !m_waitingForKeyFrame) {
+    beginSample(frame.rtpTimestamp, pts);
+  }
+  handleNALUnit(nal, (unsigned)frame.bufLen, frame.rtpTimestamp, pts);
+}
+
+void Fmp4Recorder::handleNALUnit(unsigned char const* nal, unsigned size, u_int32_t rtpTimestamp, u_int64_t pts) {
+  unsigned char nalUnitType = nal[0]&0x1F;
+  switch (nalUnitType) {
+    case 7: { m_newSps.assign((char const*)nal, size); return; } // (these go in the "moov")
+    case 8: { m_newPps.assign((char const*)nal, size); return; }
+    case 9: { return; } // access unit delimiters aren't needed
+    case 5: {
+      if (m_waitingForKeyFrame) {
+	if (m_newSps.empty() || m_newPps.empty()) {
+	  if (!useSDPParameterSets()) return; // we can't describe the stream yet
+	}
+	m_waitingForKeyFrame = False;
+	beginSample(rtpTimestamp, pts);
+      }
+      if (!m_curIsSync) beginSyncSample();
+      break;
+    }
+    default: {
+      if (m_waitingForKeyFrame) return;
+      break;
+    }
+  }
+
+  // Append the NAL unit to the current sample, with a 4-byte length:
+  m_mdat.push_back((unsigned char)(size>>24)); m_mdat.push_back((unsigned char)(size>>16));
+  m_mdat.push_back((unsigned char)(size>>8)); m_mdat.push_back((unsigned char)size);
+  m_mdat.insert(m_mdat.end(), nal, nal + size);
+}
+
+void Fmp4Recorder::beginSample(u_int32_t rtpTimestamp, u_int64_t pts) {
+  m_haveCurSample = True;
+  m_curRTPTimestamp = rtpTimestamp;
+  m_curPTS = pts;
+  m_curIsSync = False;
+  if (m_samples.empty()) m_fragmentStartPTS = pts;
+}
+
+void Fmp4Recorder::finishSample(u_int64_t nextPTS) {
+  m_haveCurSample = False;
+  unsigned sampleSize = (unsigned)m_mdat.size() - m_fragmentBytes;
+  if (sampleSize == 0) return; // it had nothing that we record (e.g., just parameter sets)
+
+  if (nextPTS > m_curPTS && nextPTS - m_curPTS < 0xFFFFFFFF) m_lastDuration = (u_int32_t)(nextPTS - m_curPTS);
+  Sample sample;
+  sample.size = sampleSize;
+  sample.duration = m_lastDuration;
+  sample.isSync = m_curIsSync;
+  m_samples.push_back(sample);
+  m_fragmentBytes += sampleSize;
+
+  if (m_fragmentBytes >= MAX_FRAGMENT_BYTES || m_samples.size() >= MAX_FRAGMENT_SAMPLES
+      || m_curPTS + m_lastDuration - m_fragmentStartPTS >= MAX_FRAGMENT_DURATION) {
+    flushFragment();
+  }
+}
+
+void Fmp4Recorder::beginSyncSample() {
+  m_curIsSync = True;
+
+  // A key frame always begins a new fragment:
+  flushFragment();
+  m_fragmentStartPTS = m_curPTS;
+
+  // ... and, if it's time, a new segment:
+  Boolean parameterSetsChanged = m_newSps != m_sps || m_newPps != m_pps;
+  if (m_file != NULL) {
+    u_int64_t segmentDuration = m_curPTS - m_segmentStartPTS;
+    if (parameterSetsChanged || (m_segmentMaxDuration > 0 && segmentDuration >= m_segmentMaxDuration)
+	|| (m_segmentMaxBytes > 0 && m_segmentBytes >= m_segmentMaxBytes)) {
+      closeSegment();
+    }
+  }
+  if (parameterSetsChanged && m_file == NULL) {
+    m_sps = m_newSps;
+    m_pps = m_newPps;
+    SPSInfo info;
+    if (parseSPS(m_sps, info)) {
+      m_width = info.width;
+      m_height = info.height;
+    }
+  }
+}
+
+Boolean Fmp4Recorder::eventHasEnded(FrameData const& frame, u_int64_t pts) {
+  if (frame.isCached) return False; // it's from before the event
+
+  // The event began at the first live frame; a retrigger extends it:
+  if (!m_haveEndPTS) {
+    m_haveEndPTS = True;
+    m_endPTS = pts + m_postDuration;
+  }
+  u_int64_t retriggerDuration = __atomic_exchange_n(&m_retriggerDuration, (u_int64_t)0, __ATOMIC_ACQ_REL);
+  if (pts + retriggerDuration > m_endPTS) m_endPTS = pts + retriggerDuration;
+
+  // End with a complete sample, i.e., at the first NAL unit of a new one:
+  if (pts < m_endPTS || (m_haveCurSample && frame.rtpTimestamp == m_curRTPTimestamp)) return False;
+
+  // Mark the event as ended, so that any later "retrigger()" fails (and starts a new event) rather than being
+  // lost.  But if a retrigger has arrived since we looked, it extends the event instead:
+  u_int64_t expected = 0;
+  if (__atomic_compare_exchange_n(&m_retriggerDuration, &expected, EVENT_ENDED, False,
+				  __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) return True;
+  retriggerDuration = __atomic_exchange_n(&m_retriggerDuration, (u_int64_t)0, __ATOMIC_ACQ_REL);
+  if (pts + retriggerDuration > m_endPTS) m_endPTS = pts + retriggerDuration;
+  return False;
+}
+
+void Fmp4Recorder::finish() {
+  // The sample being collected is complete (as far as we'll ever know), so give it the usual duration:
+  if (m_haveCurSample) finishSample(m_curPTS + m_lastDuration);
+  flushFragment();
+  closeSegment();
+  __atomic_store_n(&m_retriggerDuration, EVENT_ENDED, __ATOMIC_RELEASE); // (in case we've ended early)
+  __atomic_store_n(&m_finished, 1, __ATOMIC_RELEASE);
+}
+
+void Fmp4Recorder::discardCurSample() {
+  m_mdat.resize(m_fragmentBytes);
+  m_haveCurSample = False;
+}
+
+Boolean Fmp4Recorder::useSDPParameterSets() {
+  std::string sprop;
+  m_distributor.getH264ParameterSets(sprop);
+  if (sprop.empty()) return False;
+
+  unsigned numRecords;
+  SPropRecord* records = parseSPropParameterSets(sprop.c_str(), numRecords);
+  for (unsigned i = 0; i < numRecords; ++i) {
+    if (records[i].sPropLength == 0) continue;
+    unsigned char nalUnitType = records[i].sPropBytes[0]&0x1F;
+    if (nalUnitType == 7 && m_newSps.empty()) m_newSps.assign((char const*)records[i].sPropBytes, records[i].sPropLength);
+    else if (nalUnitType == 8 && m_newPps.empty()) m_newPps.assign((char const*)records[i].sPropBytes, records[i].sPropLength);
+  }
+  delete[] records;
+  return !m_newSps.empty() && !m_newPps.empty();
+}
+
+void Fmp4Recorder::flushFragment() {
+  if (m_samples.empty()) return;
+
+  // If the segment's file has failed (e.g., the disk is full), we'll try again with a new segment,
+  // at the next key frame:
+  if (m_file != NULL && m_file->failed()) closeSegment();
+
+  if (m_file != NULL || (m_samples[0].isSync && openSegment())) {
+    buildMoof(m_fragmentStartPTS - m_segmentStartPTS);
+    put32(8 + m_fragmentBytes); // the "mdat" header
+    putBytes((unsigned char const*)"mdat", 4);
+    if (writeBoxes()) {
+      if (!m_file->write(&m_mdat[0], m_fragmentBytes)) {
+	closeSegment();
+      } else {
+	m_file->flush(); // so that the fragment survives a crash of the process (unless it's still writing the last one)
+	m_segmentBytes += m_fragmentBytes;
+      }
+    }
+  }
+
+  // Keep the sample being collected (if any), at the start of the buffer:
+  m_mdat.erase(m_mdat.begin(), m_mdat.begin() + m_fragmentBytes);
+  m_samples.clear();
+  m_fragmentBytes = 0;
+  m_fragmentStartPTS = m_curPTS;
+}
+
+Boolean Fmp4Recorder::openSegment() {
+  if (m_sps.empty() || m_pps.empty()) return False;
+
+  // (An event recording is a single file - unless its SPS or PPS changes, in which case it continues
+  // in further, numbered, files.)
+  char fileName[32];
+  snprintf(fileName, sizeof fileName, "_%06u.mp4", m_segmentIndex);
+  std::string path = m_isEvent && m_segmentIndex == 0 ? m_pathPrefix : m_pathPrefix + fileName;
+  ++m_segmentIndex;
+  m_file = AsyncFile::open(path.c_str());
+  if (m_file == NULL) return False;
+
+  m_segmentStartPTS = m_fragmentStartPTS;
+  m_segmentBytes = 0;
+  m_fragmentSequenceNumber = 0;
+  buildInitSegment();
+  return writeBoxes();
+}
+
+void Fmp4Recorder::closeSegment() {
+  if (m_file != NULL) {
+    m_file->close(); // (the writer thread finishes writing the file, then closes it)
+    m_file = NULL;
+  }
+}
+
+Boolean Fmp4Recorder::writeBoxes() {
+  unsigned numBytes = (unsigned)m_boxes.size();
+  Boolean success = m_file->write(&m_boxes[0], numBytes);
+  m_boxes.clear();
+  if (!success) {
+    closeSegment();
+    return False;
+  }
+  m_segmentBytes += numBytes;
+  return True;
+}
+
+static u_int32_t const unityMatrix[9] = { 0x00010000, 0, 0, 0, 0x00010000, 0, 0, 0, 0x40000000 };
+
+void Fmp4Recorder::buildInitSegment() {
+  unsigned ftyp = beginBox("ftyp");
+  putBytes((unsigned char const*)"iso6", 4); put32(0); // major brand, minor version
+  putBytes((unsigned char const*)"iso6cmfcisomavc1mp41", 20); // compatible brands
+  endBox(ftyp);
+
+  unsigned moov = beginBox("moov");
+  unsigned mvhd = beginBox("mvhd");
+  put32(0); // version, flags
+  put32(0); put32(0); // creation, modification times
+  put32(1000); put32(0); // timescale, duration (unknown; it's in the fragments)
+  put32(0x00010000); put16(0x0100); putZeros(10); // rate, volume, reserved
+  for (unsigned i = 0; i < 9; ++i) put32(unityMatrix[i]);
+  putZeros(24); // pre_defined
+  put32(2); // next_track_ID
+  endBox(mvhd);
+
+  unsigned trak = beginBox("trak");
+  unsigned tkhd = beginBox("tkhd");
+  put32(0x00000003); // version 0, flags "track_enabled | track_in_movie"
+  put32(0); put32(0); // creation, modification times
+  put32(1); put32(0); put32(0); // track_ID, reserved, duration
+  putZeros(8); put16(0); put16(0); put16(0); put16(0); // reserved, layer, alternate_group, volume, reserved
+  for (unsigned i = 0; i < 9; ++i) put32(unityMatrix[i]);
+  put32(m_width<<16); put32(m_height<<16);
+  endBox(tkhd);
+
+  unsigned mdia = beginBox("mdia");
+  unsigned mdhd = beginBox("mdhd");
+  put32(0); put32(0); put32(0);
+  put32(TIMESCALE); put32(0);
+  put16(0x55C4); put16(0); // language "und", pre_defined
+  endBox(mdhd);
+  unsigned hdlr = beginBox("hdlr");
+  put32(0); put32(0); putBytes((unsigned char const*)"vide", 4); putZeros(12);
+  putBytes((unsigned char const*)"VideoHandler", 13);
+  endBox(hdlr);
+
+  unsigned minf = beginBox("minf");
+  unsigned vmhd = beginBox("vmhd");
+  put32(0x00000001); putZeros(8); // graphicsmode, opcolor
+  endBox(vmhd);
+  unsigned dinf = beginBox("dinf");
+  unsigned dref = beginBox("dref");
+  put32(0); put32(1);
+  unsigned url = beginBox("url ");
+  put32(0x00000001); // the media data is in this file
+  endBox(url);
+  endBox(dref);
+  endBox(dinf);
+
+  unsigned stbl = beginBox("stbl");
+  unsigned stsd = beginBox("stsd");
+  put32(0); put32(1);
+  unsigned avc1 = beginBox("avc1");
+  putZeros(6); put16(1); // reserved, data_reference_index
+  putZeros(16); // pre_defined, reserved
+  put16(m_width); put16(m_height);
+  put32(0x00480000); put32(0x00480000); put32(0); put16(1); // resolutions, reserved, frame_count
+  putZeros(32); // compressorname
+  put16(0x0018); put16(0xFFFF); // depth, pre_defined
+  unsigned avcC = beginBox("avcC");
+  put8(1); // configurationVersion
+  put8((unsigned char)m_sps[1]); put8((unsigned char)m_sps[2]); put8((unsigned char)m_sps[3]); // profile, compatibility, level
+  put8(0xFF); // lengthSizeMinusOne: 3
+  put8(0xE1); put16((unsigned)m_sps.size()); putBytes((unsigned char const*)m_sps.data(), (unsigned)m_sps.size());
+  put8(1); put16((unsigned)m_pps.size()); putBytes((unsigned char const*)m_pps.data(), (unsigned)m_pps.size());
+  SPSInfo info;
+  if (parseSPS(m_sps, info) && info.profileIdc != 66 && info.profileIdc != 77 && info.profileIdc != 88) {
+    put8(0xFC | info.chromaFormatIdc);
+    put8(0xF8 | info.bitDepthLumaMinus8);
+    put8(0xF8 | info.bitDepthChromaMinus8);
+    put8(0); // numOfSequenceParameterSetExt
+  }
+  endBox(avcC);
+  endBox(avc1);
+  endBox(stsd);
+  // The sample tables are empty; the samples are described by the fragments:
+  unsigned stts = beginBox("stts"); put32(0); put32(0); endBox(stts);
+  unsigned stsc = beginBox("stsc"); put32(0); put32(0); endBox(stsc);
+  unsigned stsz = beginBox("stsz"); put32(0); put32(0); put32(0); endBox(stsz);
+  unsigned stco = beginBox("stco"); put32(0); put32(0); endBox(stco);
+  endBox(stbl);
+  endBox(minf);
+  endBox(mdia);
+  endBox(trak);
+
+  unsigned mvex = beginBox("mvex");
+  unsigned trex = beginBox("trex");
+  put32(0); put32(1); put32(1); // track_ID, default_sample_description_index
+  put32(0); put32(0); put32(0); // default sample duration, size, flags
+  endBox(trex);
+  endBox(mvex);
+  endBox(moov);
+}
+
+void Fmp4Recorder::buildMoof(u_int64_t baseMediaDecodeTime) {
+  unsigned moof = beginBox("moof");
+  unsigned mfhd = beginBox("mfhd");
+  put32(0); put32(++m_fragmentSequenceNumber);
+  endBox(mfhd);
+
+  unsigned traf = beginBox("traf");
+  unsigned tfhd = beginBox("tfhd");
+  put32(0x00020000); put32(1); // "default-base-is-moof"; track_ID
+  endBox(tfhd);
+  unsigned tfdt = beginBox("tfdt");
+  put32(0x01000000); put64(baseMediaDecodeTime); // version 1
+  endBox(tfdt);
+  unsigned trun = beginBox("trun");
+  put32(0x00000701); // "data-offset", "sample-duration", "sample-size" and "sample-flags" present
+  put32((u_int32_t)m_samples.size());
+  unsigned dataOffsetPos = (unsigned)m_boxes.size();
+  put32(0); // data_offset (set below)
+  for (std::vector<Sample>::const_iterator it = m_samples.begin(); it != m_samples.end(); ++it) {
+    put32(it->duration);
+    put32(it->size);
+    put32(it->isSync ? SAMPLE_FLAGS_SYNC : SAMPLE_FLAGS_NON_SYNC);
+  }
+  endBox(trun);
+  endBox(traf);
+  endBox(moof);
+
+  // The samples begin just after the "moof" and the "mdat" header:
+  u_int32_t dataOffset = (u_int32_t)(m_boxes.size() - moof) + 8;
+  m_boxes[dataOffsetPos] = (unsigned char)(dataOffset>>24); m_boxes[dataOffsetPos+1] = (unsigned char)(dataOffset>>16);
+  m_boxes[dataOffsetPos+2] = (unsigned char)(dataOffset>>8); m_boxes[dataOffsetPos+3] = (unsigned char)dataOffset;
+}
+
+void Fmp4Recorder::accountMemory() {
+  long long numBytes = (long long)(m_mdat.capacity() + m_boxes.capacity() + m_samples.capacity()*sizeof (Sample));
+  if (numBytes != m_chargedBytes) {
+    MemoryBudget::charge(numBytes - m_chargedBytes);
+    m_chargedBytes = numBytes;
+  }
+}
+
+unsigned Fmp4Recorder::beginBox(char const* type) {
+  unsigned boxStart = (unsigned)m_boxes.size();
+  put32(0); // the size (set by "endBox()")
+  putBytes((unsigned char const*)type, 4);
+  return boxStart;
+}
+
+void Fmp4Recorder::endBox(unsigned boxStart) {
+  u_int32_t size = (u_int32_t)(m_boxes.size() - boxStart);
+  m_boxes[boxStart] = (unsigned char)(size>>24); m_boxes[boxStart+1] = (unsigned char)(size>>16);
+  m_boxes[boxStart+2] = (unsigned char)(size>>8); m_boxes[boxStart+3] = (unsigned char)size;
+}
+
+void Fmp4Recorder::putBytes(unsigned char const* bytes, unsigned numBytes) {
+  m_boxes.insert(m_boxes.end(), bytes, bytes + numBytes);
+}
+
+void Fmp4Recorder::put16(unsigned value) {
+  put8((unsigned char)(value>>8)); put8((unsigned char)value);
+}
+
+void Fmp4Recorder::put32(u_int32_t value) {
+  put8((unsigned char)(value>>24)); put8((unsigned char)(value>>16));
+  put8((unsigned char)(value>>8)); put8((unsigned char)value);
+}
+
+void Fmp4Recorder::put64(u_int64_t value) {
+  put32((u_int32_t)(value>>32)); put32((u_int32_t)value);
+}
+
+void Fmp4Recorder::putZeros(unsigned numBytes) {
+  m_boxes.insert(m_boxes.end(), numBytes, 0);
+}
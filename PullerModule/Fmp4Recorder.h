@@ -0,0 +1,131 @@
+/**
+ * @file Fmp4Recorder.h
+ * @brief  Records a stream's H.264 video as a series of fragmented-MP4 (CMAF) segment files
+ * @author lizhiyong0804319@gmail.com
+ * @version 1.0
+ * @date 2026-10-19
+ */
+
+#ifndef FMP4_RECORDER_H
+#define FMP4_RECORDER_H
+
+#include "API_PullerModule.h"
+#include "Boolean.hh"
+#include "NetCommon.h"
+
+#include <string>
+#include <vector>
+
+class FrameDistributor; // forward
+class AsyncFile; // forward
+
+// A subscriber of a "FrameDistributor" (so it runs on its own thread, and begins with the GOP cache).
+// Each segment file is complete in itself - "ftyp" and "moov", then "moof"+"mdat" fragments - and is
+// written strictly in order (by the writer pool, so a slow disk holds up only our own thread), so
+// there's no index to keep in memory, and a crash loses only the fragment that was being collected.
+// A fragment ends at each key frame, or once it reaches a (small) size or duration limit, so the
+// memory that we use doesn't depend on the length of the recording.
+// Segments begin with a key frame: a new segment is started at the first key frame after the
+// segment duration (or size) limit has been reached, or at which the SPS or PPS changes.
+// Samples are timed by their presentation times alone (there are no composition offsets), so only
+// streams without B-frames are supported: if the pictures arrive out of presentation order, we
+// finish the recording there.
+
+class Fmp4Recorder {
+public:
+  Fmp4Recorder(FrameDistributor& distributor, char const* pathPrefix,
+	       unsigned segmentSeconds, unsigned long long segmentMaxBytes, unsigned postSeconds = 0);
+      // Segments are named "<pathPrefix>_NNNNNN.mp4".  A limit of 0 means "no limit".
+      // If "postSeconds" is non-zero, this is an event recording instead: a single file, named "pathPrefix",
+      // holding the frames that we're given from before the event (flagged "isCached"), and then
+      // "postSeconds" of live frames, after which we finish the file and ignore any more frames.
+  ~Fmp4Recorder(); // writes out what's left of the current segment; the recorder must be unsubscribed first
+
+  void setSubscriberId(int subscriberId) { m_subscriberId = subscriberId; } // for noticing dropped frames
+  Boolean retrigger(unsigned postSeconds);
+      // (event recordings only) records "postSeconds" more from now, if that's later.  Returns False (and does
+      // nothing) if the event has already ended, in which case the file is (being) finished.
+  Boolean finished() const { return __atomic_load_n(&m_finished, __ATOMIC_ACQUIRE) != 0; }
+      // True once the event has ended - or once we've stopped because the stream has B-frames
+
+  static int _APICALL onFrame(CBDataType dataType, void* data, void* obj); // our "PullerCallback"
+
+private:
+  struct Sample {
+    u_int32_t size;
+    u_int32_t duration; // 90 kHz
+    Boolean isSync;
+  };
+
+  void handleFrame(FrameData const& frame);
+  void handleNALUnit(unsigned char const* nal, unsigned size, u_int32_t rtpTimestamp, u_int64_t pts);
+  void beginSample(u_int32_t rtpTimestamp, u_int64_t pts);
+  void finishSample(u_int64_t nextPTS);
+  void beginSyncSample(); // called at the sample's first IDR slice
+  void discardCurSample();
+  Boolean eventHasEnded(FrameData const& frame, u_int64_t pts);
+  void finish();
+  Boolean useSDPParameterSets();
+
+  void flushFragment(); // writes out our completed samples
+  Boolean openSegment();
+  void closeSegment();
+  Boolean writeBoxes(); // writes (then empties) "m_boxes"
+  void buildInitSegment();
+  void buildMoof(u_int64_t baseMediaDecodeTime);
+  void accountMemory();
+
+  unsigned beginBox(char const* type);
+  void endBox(unsigned boxStart);
+  void putBytes(unsigned char const* bytes, unsigned numBytes);
+  void put8(unsigned char value) { m_boxes.push_back(value); }
+  void put16(unsigned value);
+  void put32(u_int32_t value);
+  void put64(u_int64_t value);
+  void putZeros(unsigned numBytes);
+
+private:
+  FrameDistributor& m_distributor;
+  volatile int m_subscriberId; // 0 until our subscription has been made
+  unsigned long long m_framesDropped; // by our subscriber queue, the last time we looked
+  std::string m_pathPrefix;
+  u_int64_t m_segmentMaxDuration; // 90 kHz; 0 means "no limit"
+  unsigned long long m_segmentMaxBytes; // 0 means "no limit"
+
+  // For event recordings:
+  Boolean m_isEvent;
+  u_int64_t m_postDuration; // 90 kHz
+  u_int64_t m_retriggerDuration; // 90 kHz; set by "retrigger()", and taken by our thread - or EVENT_ENDED
+  Boolean m_haveEndPTS; // once we've seen the first live frame
+  u_int64_t m_endPTS;
+  int m_finished;
+
+  // The current segment:
+  AsyncFile* m_file; // NULL between segments
+  unsigned m_segmentIndex;
+  u_int64_t m_segmentStartPTS; // 90 kHz
+  unsigned long long m_segmentBytes;
+  u_int32_t m_fragmentSequenceNumber;
+
+  // Parameter sets: those in the current segment's "moov", and those seen since:
+  std::string m_sps, m_pps;
+  std::string m_newSps, m_newPps;
+  unsigned m_width, m_height;
+
+  // The current fragment: its completed samples, then (at the end of "m_mdat") the sample being collected:
+  std::vector<Sample> m_samples;
+  std::vector<unsigned char> m_mdat;
+  unsigned m_fragmentBytes; // of the completed samples
+  u_int64_t m_fragmentStartPTS;
+  Boolean m_waitingForKeyFrame; // at the start, and after a gap in the stream
+  Boolean m_haveCurSample;
+  u_int32_t m_curRTPTimestamp; // identifies the current sample's NAL units
+  u_int64_t m_curPTS; // 90 kHz
+  Boolean m_curIsSync;
+  u_int32_t m_lastDuration;
+
+  std::vector<unsigned char> m_boxes; // the boxes being built
+  long long m_chargedBytes; // as charged to the memory budget
+};
+
+#endif
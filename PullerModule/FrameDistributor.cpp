@@ -0,0 +1,298 @@
+/**
+ * @file FrameDistributor.cpp
+ * @brief  1.0
+ *		implementation of FrameDistributor
+ * @author lizhiyong0804319@gmail.com
+ * @version 1.0
+ * @date 2026-10-19
+ */
+
+#include "FrameDistributor.h"
+#include "Fmp4Recorder.h"
+#include "HlsSegmenter.h"
+#include "ShmFrameWriter.h"
+#include "utils/MutexLock.h"
+
+#define RECORD_QUEUE_SIZE 512 // frames; enough to ride out a slow disk write (in addition to any pre-roll)
+
+FrameDistributor::FrameDistributor()
+  : m_gopCache(NULL), m_preroll(NULL), m_nextSubscriberId(1), m_reader(NULL), m_shmWriter(NULL),
+    m_recorder(NULL), m_recorderSubscriberId(0), m_eventRecorder(NULL), m_eventRecorderSubscriberId(0),
+    m_hlsSegmenter(NULL), m_hlsSubscriberId(0),
+    m_wantsFrames(False) {
+  pthread_mutex_init(&m_mutex, NULL);
+  pthread_mutex_init(&m_recordMutex, NULL);
+}
+
+FrameDistributor::~FrameDistributor() {
+  for (std::vector<FrameSubscriber*>::iterator it = m_subscribers.begin(); it != m_subscribers.end(); ++it) {
+    delete *it;
+  }
+  delete m_recorder; // (after its subscriber, above, has stopped)
+  delete m_eventRecorder;
+  delete m_hlsSegmenter;
+  delete m_gopCache;
+  delete m_preroll;
+  delete m_reader;
+  delete m_shmWriter;
+  pthread_mutex_destroy(&m_recordMutex);
+  pthread_mutex_destroy(&m_mutex);
+}
+
+int FrameDistributor::enableGopCache(unsigned maxBytes) {
+  CMutexLock lock(&m_mutex);
+
+  delete m_gopCache;
+  m_gopCache = maxBytes > 0 ? new GopCache(maxBytes) : NULL;
+  updateWantsFrames();
+  return 0;
+}
+
+int FrameDistributor::enableReader(unsigned queueSize) {
+  CMutexLock lock(&m_mutex);
+
+  if (m_reader != NULL || queueSize == 0) return -1;
+  FrameReader* reader = new FrameReader(queueSize);
+  if (reader->eventFd() < 0) {
+    delete reader;
+    return -1;
+  }
+  // "deliverFrame()" reads this without our lock, so publish it only once it's fully constructed:
+  __atomic_store_n(&m_reader, reader, __ATOMIC_RELEASE);
+  updateWantsFrames();
+  return 0;
+}
+
+int FrameDistributor::enableShmOutput(unsigned numSlots, unsigned dataSize) {
+  CMutexLock lock(&m_mutex);
+
+  if (m_shmWriter != NULL) return -1;
+  ShmFrameWriter* shmWriter = ShmFrameWriter::createNew(numSlots, dataSize);
+  if (shmWriter == NULL) return -1;
+  // The sink reads this without our lock (as "deliverFrame()" does "m_reader"), so publish it only once it's ready:
+  __atomic_store_n(&m_shmWriter, shmWriter, __ATOMIC_RELEASE);
+  return shmWriter->fd();
+}
+
+int FrameDistributor::subscribe(PullerCallback cb, void* cbParam, unsigned queueSize, QueueDropPolicy dropPolicy) {
+  if (cb == NULL || queueSize == 0) return -1;
+
+  // The GOP replay is queued with our lock held, so that no live frame can overtake it:
+  CMutexLock lock(&m_mutex);
+
+  std::vector<PullerFrame*> cached;
+  if (m_gopCache != NULL) m_gopCache->copyFrames(cached);
+  return addSubscriber(cb, cbParam, queueSize, dropPolicy, cached);
+}
+
+int FrameDistributor::addSubscriber(PullerCallback cb, void* cbParam, unsigned queueSize, QueueDropPolicy dropPolicy,
+    std::vector<PullerFrame*>& initialFrames) {
+  // Leave room for the replay, in addition to the requested queue size:
+  FrameSubscriber* subscriber
+    = new FrameSubscriber(m_nextSubscriberId++, cb, cbParam, queueSize + (unsigned)initialFrames.size(), dropPolicy);
+  for (std::vector<PullerFrame*>::iterator it = initialFrames.begin(); it != initialFrames.end(); ++it) {
+    subscriber->enqueue(*it, True);
+    (*it)->release();
+  }
+  initialFrames.clear();
+  if (subscriber->start() != 0) {
+    delete subscriber;
+    return -1;
+  }
+
+  m_subscribers.push_back(subscriber);
+  updateWantsFrames();
+  return subscriber->id();
+}
+
+int FrameDistributor::unsubscribe(int subscriberId) {
+  FrameSubscriber* subscriber = NULL;
+  {
+    CMutexLock lock(&m_mutex);
+    for (std::vector<FrameSubscriber*>::iterator it = m_subscribers.begin(); it != m_subscribers.end(); ++it) {
+      if ((*it)->id() == subscriberId) {
+	subscriber = *it;
+	m_subscribers.erase(it);
+	updateWantsFrames();
+	break;
+      }
+    }
+  }
+  if (subscriber == NULL) return -1;
+
+  // Stop the subscriber's thread without holding our lock, so that frame delivery isn't held up:
+  delete subscriber;
+  return 0;
+}
+
+int FrameDistributor::startRecord(char const* pathPrefix, unsigned segmentSeconds, unsigned long long segmentMaxBytes) {
+  if (pathPrefix == NULL || pathPrefix[0] == '\0') return -1;
+  CMutexLock lock(&m_recordMutex);
+  if (m_recorder != NULL) {
+    if (!m_recorder->finished()) return -1;
+    releaseRecorder(); // it stopped by itself
+  }
+
+  // Drop the newest frames if the recorder falls behind (it then resumes at the next key frame):
+  Fmp4Recorder* recorder = new Fmp4Recorder(*this, pathPrefix, segmentSeconds, segmentMaxBytes);
+  int subscriberId = subscribe(Fmp4Recorder::onFrame, recorder, RECORD_QUEUE_SIZE, QUEUE_DROP_NEWEST);
+  if (subscriberId < 0) {
+    delete recorder;
+    return -1;
+  }
+  recorder->setSubscriberId(subscriberId);
+  m_recorder = recorder;
+  m_recorderSubscriberId = subscriberId;
+  return 0;
+}
+
+int FrameDistributor::stopRecord() {
+  CMutexLock lock(&m_recordMutex);
+  reapEventRecorder(); // (while we're here)
+  if (m_recorder == NULL) return -1;
+
+  Boolean stoppedEarly = m_recorder->finished();
+  releaseRecorder();
+  return stoppedEarly ? -1 : 0;
+}
+
+int FrameDistributor::enablePreroll(unsigned maxSeconds, unsigned maxBytes) {
+  CMutexLock lock(&m_mutex);
+
+  delete m_preroll;
+  m_preroll = maxSeconds > 0 ? new PrerollBuffer(maxSeconds, maxBytes) : NULL;
+  updateWantsFrames();
+  return 0;
+}
+
+int FrameDistributor::triggerRecord(unsigned preSeconds, unsigned postSeconds, char const* path) {
+  if (postSeconds == 0) return -1;
+  CMutexLock lock(&m_recordMutex);
+
+  reapEventRecorder();
+  if (m_eventRecorder != NULL) {
+    if (m_eventRecorder->retrigger(postSeconds)) return 0;
+
+    // The recorder ended its event after we looked, so this trigger starts a new one:
+    releaseEventRecorder();
+  }
+  if (path == NULL || path[0] == '\0') return -1;
+
+  Fmp4Recorder* recorder = new Fmp4Recorder(*this, path, 0, 0, postSeconds);
+  int subscriberId;
+  {
+    // The pre-roll is queued with our lock held, so that no live frame can overtake it:
+    CMutexLock frameLock(&m_mutex);
+    std::vector<PullerFrame*> preroll;
+    if (m_preroll != NULL) {
+      m_preroll->copyFrames(preroll, preSeconds);
+    } else if (m_gopCache != NULL) {
+      m_gopCache->copyFrames(preroll);
+    }
+    subscriberId = addSubscriber(Fmp4Recorder::onFrame, recorder, RECORD_QUEUE_SIZE, QUEUE_DROP_NEWEST, preroll);
+  }
+  if (subscriberId < 0) {
+    delete recorder;
+    return -1;
+  }
+  recorder->setSubscriberId(subscriberId);
+  m_eventRecorder = recorder;
+  m_eventRecorderSubscriberId = subscriberId;
+  return 0;
+}
+
+void FrameDistributor::reapEventRecorder() {
+  // An event recorder that has finished its file no longer needs its subscription:
+  if (m_eventRecorder == NULL || !m_eventRecorder->finished()) return;
+
+  releaseEventRecorder();
+}
+
+void FrameDistributor::releaseEventRecorder() {
+  unsubscribe(m_eventRecorderSubscriberId); // (also waits for its thread to be done with it)
+  delete m_eventRecorder;
+  m_eventRecorder = NULL;
+  m_eventRecorderSubscriberId = 0;
+}
+
+void FrameDistributor::releaseRecorder() {
+  unsubscribe(m_recorderSubscriberId);
+  delete m_recorder;
+  m_recorder = NULL;
+  m_recorderSubscriberId = 0;
+}
+
+int FrameDistributor::startHls(char const* pathPrefix, unsigned segmentSeconds, unsigned listSize) {
+  if (pathPrefix == NULL || pathPrefix[0] == '\0' || segmentSeconds == 0 || listSize == 0) return -1;
+  CMutexLock lock(&m_recordMutex);
+  if (m_hlsSegmenter != NULL) return -1;
+
+  // Like the recorder, the segmenter resumes at the next key frame if it falls behind:
+  HlsSegmenter* segmenter = new HlsSegmenter(*this, pathPrefix, segmentSeconds, listSize);
+  int subscriberId = subscribe(HlsSegmenter::onFrame, segmenter, RECORD_QUEUE_SIZE, QUEUE_DROP_NEWEST);
+  if (subscriberId < 0) {
+    delete segmenter;
+    return -1;
+  }
+  segmenter->setSubscriberId(subscriberId);
+  m_hlsSegmenter = segmenter;
+  m_hlsSubscriberId = subscriberId;
+  return 0;
+}
+
+int FrameDistributor::stopHls() {
+  CMutexLock lock(&m_recordMutex);
+  if (m_hlsSegmenter == NULL) return -1;
+
+  unsubscribe(m_hlsSubscriberId);
+  delete m_hlsSegmenter;
+  m_hlsSegmenter = NULL;
+  m_hlsSubscriberId = 0;
+  return 0;
+}
+
+void FrameDistributor::setH264ParameterSets(char const* sPropParameterSets) {
+  CMutexLock lock(&m_mutex);
+  m_h264ParameterSets = sPropParameterSets != NULL ? sPropParameterSets : "";
+}
+
+void FrameDistributor::getH264ParameterSets(std::string& sPropParameterSets) {
+  CMutexLock lock(&m_mutex);
+  sPropParameterSets = m_h264ParameterSets;
+}
+
+void FrameDistributor::setAACConfig(char const* config) {
+  CMutexLock lock(&m_mutex);
+  m_aacConfig = config != NULL ? config : "";
+}
+
+void FrameDistributor::getAACConfig(std::string& config) {
+  CMutexLock lock(&m_mutex);
+  config = m_aacConfig;
+}
+
+int FrameDistributor::getSubscriberStats(int subscriberId, SubscriberStats& stats) {
+  CMutexLock lock(&m_mutex);
+
+  for (std::vector<FrameSubscriber*>::iterator it = m_subscribers.begin(); it != m_subscribers.end(); ++it) {
+    if ((*it)->id() == subscriberId) {
+      (*it)->getStats(stats);
+      return 0;
+    }
+  }
+  return -1;
+}
+
+void FrameDistributor::deliverFrame(PullerFrame* frame, Boolean cacheable) {
+  FrameReader* reader = __atomic_load_n(&m_reader, __ATOMIC_ACQUIRE);
+  if (reader != NULL) reader->enqueue(frame);
+
+  CMutexLock lock(&m_mutex);
+
+  if (cacheable && m_gopCache != NULL) m_gopCache->addFrame(frame);
+  if (cacheable && m_preroll != NULL) m_preroll->addFrame(frame);
+
+  for (std::vector<FrameSubscriber*>::iterator it = m_subscribers.begin(); it != m_subscribers.end(); ++it) {
+    (*it)->enqueue(frame, False);
+  }
+}
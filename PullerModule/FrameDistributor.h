@@ -0,0 +1,99 @@
+/**
+ * @file FrameDistributor.h
+ * @brief  Distributes a stream's frames to the GOP cache and to subscribers
+ * @author lizhiyong0804319@gmail.com
+ * @version 1.0
+ * @date 2026-10-19
+ */
+
+#ifndef FRAME_DISTRIBUTOR_H
+#define FRAME_DISTRIBUTOR_H
+
+#include "API_PullerModule.h"
+#include "GopCache.h"
+#include "PrerollBuffer.h"
+#include "FrameSubscriber.h"
+#include "FrameReader.h"
+
+#include <pthread.h>
+#include <string>
+#include <vector>
+
+class Fmp4Recorder; // forward
+class HlsSegmenter; // forward
+class ShmFrameWriter; // forward
+
+// One per "PullerClient".  Frames arrive (on the event loop thread) from each of the
+// stream's "PullerSink"s; everything else (subscribers, recorders, etc.) may be set up and
+// torn down from any thread, directly - not via the loop's command queue (see "PullerClient.h").
+// Each frame is fanned out by reference: N subscribers cost N queue entries, not N copies.
+
+class FrameDistributor {
+public:
+  FrameDistributor();
+  ~FrameDistributor();
+
+  int enableGopCache(unsigned maxBytes); // 0 disables the cache
+  int subscribe(PullerCallback cb, void* cbParam, unsigned queueSize, QueueDropPolicy dropPolicy);
+      // Replays the GOP cache (if any) to the new subscriber, then delivers live frames.
+      // Returns a (positive) subscriber id, or -1 on error.
+  int unsubscribe(int subscriberId);
+  int getSubscriberStats(int subscriberId, SubscriberStats& stats);
+
+  int startRecord(char const* pathPrefix, unsigned segmentSeconds, unsigned long long segmentMaxBytes);
+  int stopRecord(); // hands the rest of the last segment to the writer pool
+      // Returns -1 if we weren't recording - or if the recording had already stopped (because the stream has B-frames).
+  int enablePreroll(unsigned maxSeconds, unsigned maxBytes); // 0 "maxSeconds" disables the pre-roll buffer
+  int triggerRecord(unsigned preSeconds, unsigned postSeconds, char const* path);
+      // Records an event to "path": "preSeconds" (or as much as we have) from the pre-roll buffer (or,
+      // failing that, the GOP cache), then "postSeconds" of live frames.  If an event is being recorded
+      // already, it's extended instead (to "postSeconds" from now), and "path" is ignored.
+  int startHls(char const* pathPrefix, unsigned segmentSeconds, unsigned listSize);
+  int stopHls(); // finishes the last segment, and ends the playlist
+  void setH264ParameterSets(char const* sPropParameterSets); // from the SDP description, for the recorder
+  void getH264ParameterSets(std::string& sPropParameterSets);
+  void setAACConfig(char const* config); // likewise, the (hex) "config" of "MPEG4-GENERIC" audio
+  void getAACConfig(std::string& config);
+
+  int enableReader(unsigned queueSize); // for "RTSP_Puller_ReadFrame()"; only before the stream is started
+  FrameReader* reader() const { return __atomic_load_n(&m_reader, __ATOMIC_ACQUIRE); }
+
+  int enableShmOutput(unsigned numSlots, unsigned dataSize); // returns the ring's fd; only before the stream is started
+  // (The ring is written by the sink directly; it's not a "wantsFrames()" consumer.)
+  ShmFrameWriter* shmWriter() const { return __atomic_load_n(&m_shmWriter, __ATOMIC_ACQUIRE); }
+
+  // Cheap check, made by the sink before it bothers to create a "PullerFrame":
+  Boolean wantsFrames() const { return m_wantsFrames; }
+  void deliverFrame(PullerFrame* frame, Boolean cacheable);
+
+private:
+  void updateWantsFrames() {
+    m_wantsFrames = m_gopCache != NULL || m_preroll != NULL || !m_subscribers.empty() || m_reader != NULL;
+  }
+  int addSubscriber(PullerCallback cb, void* cbParam, unsigned queueSize, QueueDropPolicy dropPolicy,
+		    std::vector<PullerFrame*>& initialFrames); // called with "m_mutex" held; takes over "initialFrames"
+  void reapEventRecorder(); // called with "m_recordMutex" held
+  void releaseEventRecorder(); // likewise; unsubscribes and deletes "m_eventRecorder"
+  void releaseRecorder(); // likewise, for "m_recorder"
+
+private:
+  pthread_mutex_t m_mutex; // protects everything below
+  GopCache* m_gopCache;
+  PrerollBuffer* m_preroll;
+  std::vector<FrameSubscriber*> m_subscribers;
+  int m_nextSubscriberId;
+  std::string m_h264ParameterSets;
+  std::string m_aacConfig;
+  FrameReader* m_reader; // lock-free, so not protected by "m_mutex"; set once, and read atomically
+  ShmFrameWriter* m_shmWriter; // likewise
+  pthread_mutex_t m_recordMutex; // serializes the starting and stopping of recorders (and of the HLS segmenter)
+  Fmp4Recorder* m_recorder; // a subscriber, like any other
+  int m_recorderSubscriberId;
+  Fmp4Recorder* m_eventRecorder; // likewise
+  int m_eventRecorderSubscriberId;
+  HlsSegmenter* m_hlsSegmenter; // likewise
+  int m_hlsSubscriberId;
+  volatile Boolean m_wantsFrames;
+};
+
+#endif
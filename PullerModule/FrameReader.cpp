@@ -0,0 +1,138 @@
+/**
+ * @file FrameReader.cpp
+ * @brief  1.0
+ *		implementation of FrameReader
+ * @author lizhiyong0804319@gmail.com
+ * @version 1.0
+ * @date 2026-10-19
+ */
+
+#include "FrameReader.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdint.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+// Returns the number of milliseconds left until "deadline", or -1 if "timeoutMs" is infinite:
+static int remainingMs(int timeoutMs, struct timespec const& deadline) {
+  if (timeoutMs < 0) return -1;
+
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  long long ms = (deadline.tv_sec - now.tv_sec)*1000LL + (deadline.tv_nsec - now.tv_nsec)/1000000;
+  return ms > 0 ? (int)ms : 0;
+}
+
+static void computeDeadline(int timeoutMs, struct timespec& deadline) {
+  clock_gettime(CLOCK_MONOTONIC, &deadline);
+  if (timeoutMs <= 0) return;
+  deadline.tv_sec += timeoutMs/1000;
+  deadline.tv_nsec += (timeoutMs%1000)*1000000L;
+  if (deadline.tv_nsec >= 1000000000L) {
+    ++deadline.tv_sec;
+    deadline.tv_nsec -= 1000000000L;
+  }
+}
+
+FrameReader::FrameReader(unsigned queueSize)
+  : m_ring(queueSize), m_framesDropped(0) {
+  m_eventFd = eventfd(0, EFD_NONBLOCK|EFD_CLOEXEC);
+}
+
+FrameReader::~FrameReader() {
+  if (m_eventFd >= 0) close(m_eventFd);
+}
+
+void FrameReader::enqueue(PullerFrame* frame) {
+  frame->addRef();
+  if (!m_ring.push(frame)) {
+    PullerFrame* oldest = m_ring.dropOldest(); // (the consumer may beat us to it, which is fine)
+    if (oldest != NULL) {
+      oldest->release();
+      __sync_add_and_fetch(&m_framesDropped, 1);
+    }
+    m_ring.push(frame); // the consumer never adds entries, so this can't fail
+  }
+
+  // Signal only the empty -> non-empty transition.  (If the consumer emptied the queue
+  // just after our "push()", the size is 0 and it has already seen our frame.)  This applies
+  // after a drop, too: the consumer may have drained the queue (and reset the event) meanwhile.
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  if (m_ring.size() == 1) {
+    uint64_t one = 1;
+    (void)write(m_eventFd, &one, sizeof one);
+  }
+}
+
+void FrameReader::clearEvent() {
+  uint64_t count;
+  (void)::read(m_eventFd, &count, sizeof count); // (non-blocking)
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+PullerFrame* FrameReader::read(int timeoutMs) {
+  struct timespec deadline;
+  computeDeadline(timeoutMs, deadline);
+
+  for (;;) {
+    PullerFrame* frame = m_ring.pop();
+    if (frame != NULL || timeoutMs == 0) return frame;
+
+    // Reset the event, then look again before blocking, so that a frame that arrived in
+    // between isn't missed:
+    clearEvent();
+    if ((frame = m_ring.pop()) != NULL) return frame;
+
+    int waitMs = remainingMs(timeoutMs, deadline);
+    if (waitMs == 0) return NULL;
+    struct pollfd pfd;
+    pfd.fd = m_eventFd;
+    pfd.events = POLLIN;
+    if (poll(&pfd, 1, waitMs) < 0 && errno != EINTR) return NULL;
+  }
+}
+
+int FrameReader::waitAny(FrameReader* const* readers, int numReaders, int* ready, int timeoutMs) {
+  if (readers == NULL || ready == NULL || numReaders <= 0) return -1;
+
+  struct timespec deadline;
+  computeDeadline(timeoutMs, deadline);
+  std::vector<struct pollfd> pfds;
+
+  for (Boolean eventsCleared = False; ; ) {
+    int numReady = 0;
+    for (int i = 0; i < numReaders; ++i) {
+      ready[i] = readers[i] != NULL && readers[i]->isReadable();
+      numReady += ready[i];
+    }
+    if (numReady > 0 || timeoutMs == 0) return numReady;
+
+    if (!eventsCleared) {
+      // As in "read()": reset every event, then look once more before blocking:
+      for (int i = 0; i < numReaders; ++i) {
+	if (readers[i] != NULL) readers[i]->clearEvent();
+      }
+      eventsCleared = True;
+      continue;
+    }
+
+    int waitMs = remainingMs(timeoutMs, deadline);
+    if (waitMs == 0) return 0;
+    pfds.clear();
+    for (int i = 0; i < numReaders; ++i) {
+      if (readers[i] == NULL) continue;
+      struct pollfd pfd;
+      pfd.fd = readers[i]->eventFd();
+      pfd.events = POLLIN;
+      pfd.revents = 0;
+      pfds.push_back(pfd);
+    }
+    if (pfds.empty()) return -1;
+    if (poll(&pfds[0], pfds.size(), waitMs) < 0 && errno != EINTR) return -1;
+    eventsCleared = False;
+  }
+}
@@ -0,0 +1,49 @@
+/**
+ * @file FrameReader.h
+ * @brief  Pull-style access to a stream's frames
+ * @author lizhiyong0804319@gmail.com
+ * @version 1.0
+ * @date 2026-10-19
+ */
+
+#ifndef FRAME_READER_H
+#define FRAME_READER_H
+
+#include "utils/FrameRing.h"
+
+// A bounded queue that the event loop thread fills, and that the application drains
+// (from a single thread at a time) with "RTSP_Puller_ReadFrame()".  Readiness is signalled
+// on an eventfd, which is written only when the queue goes from empty to non-empty, so
+// a steady stream costs no system calls on the producer side.
+
+class FrameReader {
+public:
+  FrameReader(unsigned queueSize);
+  ~FrameReader();
+
+  int eventFd() const { return m_eventFd; }
+  void enqueue(PullerFrame* frame); // producer side; takes its own reference; drops the oldest frame if full
+
+  // Consumer side.  "timeoutMs" < 0 waits forever; 0 doesn't wait.  Returns NULL on timeout;
+  // otherwise the caller owns the returned reference:
+  PullerFrame* read(int timeoutMs);
+  Boolean isReadable() const { return !m_ring.isEmpty(); }
+  void clearEvent(); // resets the eventfd; call before blocking on it, then check "isReadable()" again
+
+  unsigned long long framesDropped() const { return m_framesDropped; }
+
+  // Waits until at least one of the "numReaders" readers is readable (NULL entries are ignored).
+  // Sets "ready[i]" accordingly, and returns the number of readable readers (0 on timeout), or -1 on error:
+  static int waitAny(FrameReader* const* readers, int numReaders, int* ready, int timeoutMs);
+
+private:
+  FrameReader(const FrameReader&);
+  FrameReader& operator=(const FrameReader&);
+
+private:
+  FrameRing m_ring;
+  int m_eventFd;
+  volatile unsigned long long m_framesDropped;
+};
+
+#endif
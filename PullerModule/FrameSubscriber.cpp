@@ -0,0 +1,118 @@
+/**
+ * @file FrameSubscriber.cpp
+ * @brief  1.0
+ *		implementation of FrameSubscriber
+ * @author lizhiyong0804319@gmail.com
+ * @version 1.0
+ * @date 2026-10-19
+ */
+
+#include "FrameSubscriber.h"
+
+#include <sched.h>
+
+FrameSubscriber::FrameSubscriber(int id, PullerCallback cb, void* cbParam,
+				 unsigned queueSize, QueueDropPolicy dropPolicy)
+  : m_id(id), m_callbackFunc(cb), m_cbParam(cbParam), m_dropPolicy(dropPolicy),
+    m_ring(queueSize), m_numCachedFrames(0), m_tid(0), m_running(0),
+    m_framesDelivered(0), m_framesDropped(0) {
+  sem_init(&m_sem, 0, 0);
+}
+
+FrameSubscriber::~FrameSubscriber() {
+  if (m_running) {
+    m_running = 0;
+    sem_post(&m_sem);
+    pthread_join(m_tid, NULL);
+  }
+  sem_destroy(&m_sem);
+}
+
+int FrameSubscriber::start() {
+  m_running = 1;
+  if (pthread_create(&m_tid, NULL, entryPoint, this) != 0) {
+    m_running = 0;
+    return -1;
+  }
+  return 0;
+}
+
+void FrameSubscriber::enqueue(PullerFrame* frame, Boolean isCached) {
+  frame->addRef();
+  if (isCached) ++m_numCachedFrames; // (cached frames are enqueued before the thread starts)
+
+  if (!m_ring.push(frame)) {
+    if (m_dropPolicy == QUEUE_DROP_NEWEST) {
+      if (isCached) --m_numCachedFrames; // it never made it into the queue
+      frame->release();
+      __sync_add_and_fetch(&m_framesDropped, 1);
+      return;
+    }
+
+    // QUEUE_DROP_OLDEST: make room (the consumer may beat us to it, which is fine):
+    PullerFrame* oldest = m_ring.dropOldest();
+    if (oldest != NULL) {
+      oldest->release();
+      __sync_add_and_fetch(&m_framesDropped, 1);
+      m_ring.push(frame); // the consumer never adds entries, so this can't fail
+      return; // the slot's semaphore count was already posted by the dropped frame
+    }
+    m_ring.push(frame);
+  }
+  sem_post(&m_sem);
+}
+
+void FrameSubscriber::getStats(SubscriberStats& stats) const {
+  stats.framesDelivered = m_framesDelivered;
+  stats.framesDropped = m_framesDropped;
+  stats.queueDepth = m_ring.size();
+  stats.queueCapacity = m_ring.capacity();
+}
+
+void* FrameSubscriber::entryPoint(void* param) {
+  FrameSubscriber* subscriber = (FrameSubscriber*)param;
+  subscriber->run();
+  return NULL;
+}
+
+void FrameSubscriber::run() {
+  while (m_running) {
+    sem_wait(&m_sem);
+
+    // The ring can be briefly empty despite the count: the producer may be between
+    // a "dropOldest()" and the "push()" that replaces the dropped frame.
+    PullerFrame* frame;
+    unsigned seqNum;
+    while ((frame = m_ring.pop(&seqNum)) == NULL) {
+      if (!m_running) return;
+      sched_yield();
+    }
+
+    // Tell cached frames by their position in the queue, rather than by counting the ones that we
+    // dequeue, because the producer may have dropped some of them (with QUEUE_DROP_OLDEST):
+    Boolean isCached = seqNum < m_numCachedFrames;
+    if (!isCached) m_numCachedFrames = 0; // (so that a wrapped-around "seqNum" can't match)
+    deliver(frame, isCached);
+    frame->release();
+  }
+}
+
+void FrameSubscriber::deliver(PullerFrame* frame, Boolean isCached) {
+  FrameData frameData;
+  frameData.dataBuf = (const char*)frame->data();
+  frameData.bufLen = frame->size();
+  frameData.isKeyFrame = frame->isKeyFrame();
+  frameData.isCached = isCached;
+  frameData.rtpTimestamp = frame->rtpTimestamp();
+  frameData.ptsSec = frame->presentationTime().tv_sec;
+  frameData.ptsUsec = frame->presentationTime().tv_usec;
+  frameData.mediumName = frame->mediumName();
+  frameData.codecName = frame->codecName();
+  frameData.extInfo = frame->extInfo();
+  frameData.extRtpTimestamp = frame->extendedRTPTimestamp();
+  frameData.monoPtsUs = frame->monoPTS();
+  frameData.isDiscontinuity = frame->isDiscontinuity();
+
+  m_callbackFunc(CB_FRAME_DATA, &frameData, m_cbParam);
+  __sync_add_and_fetch(&m_framesDelivered, 1);
+}
@@ -0,0 +1,53 @@
+/**
+ * @file FrameSubscriber.h
+ * @brief  A subscriber to a stream's frames, with its own bounded queue and thread
+ * @author lizhiyong0804319@gmail.com
+ * @version 1.0
+ * @date 2026-10-19
+ */
+
+#ifndef FRAME_SUBSCRIBER_H
+#define FRAME_SUBSCRIBER_H
+
+#include "API_PullerModule.h"
+#include "utils/FrameRing.h"
+
+#include <pthread.h>
+#include <semaphore.h>
+
+// The event loop thread only ever enqueues a reference to each frame (it never copies
+// the frame, and never calls the subscriber's callback); the subscriber's own thread
+// dequeues and delivers.  A slow subscriber therefore only loses its own frames.
+
+class FrameSubscriber {
+public:
+  FrameSubscriber(int id, PullerCallback cb, void* cbParam,
+		  unsigned queueSize, QueueDropPolicy dropPolicy);
+  ~FrameSubscriber(); // stops the thread; must not be called from the subscriber's callback
+
+  int start();
+
+  int id() const { return m_id; }
+  void enqueue(PullerFrame* frame, Boolean isCached); // producer side
+  void getStats(SubscriberStats& stats) const;
+
+private:
+  static void* entryPoint(void* param);
+  void run();
+  void deliver(PullerFrame* frame, Boolean isCached);
+
+private:
+  int m_id;
+  PullerCallback m_callbackFunc;
+  void* m_cbParam;
+  QueueDropPolicy m_dropPolicy;
+  FrameRing m_ring;
+  unsigned m_numCachedFrames; // the first this many enqueued frames came from the GOP cache (0 once they're past)
+  sem_t m_sem; // posted once per enqueued frame
+  pthread_t m_tid;
+  volatile char m_running;
+  volatile unsigned long long m_framesDelivered;
+  volatile unsigned long long m_framesDropped;
+};
+
+#endif
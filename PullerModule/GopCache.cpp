@@ -0,0 +1,53 @@
+/**
+ * @file GopCache.cpp
+ * @brief  1.0
+ *		implementation of GopCache
+ * @author lizhiyong0804319@gmail.com
+ * @version 1.0
+ * @date 2026-10-19
+ */
+
+#include "GopCache.h"
+
+GopCache::GopCache(unsigned maxBytes)
+  : m_maxBytes(maxBytes), m_numBytes(0), m_haveGOPStart(False) {
+}
+
+GopCache::~GopCache() {
+  clear();
+}
+
+void GopCache::addFrame(PullerFrame* frame) {
+  // (A GOP begins with its parameter sets, if any, rather than at its IDR picture; see "H264GOPBoundaryDetector".)
+  if (frame->beginsH264GOP(m_gopBoundaryDetector)) {
+    clear();
+    m_haveGOPStart = True;
+  }
+  if (!m_haveGOPStart) return; // we're still waiting for the next GOP
+
+  if (m_numBytes + frame->size() > m_maxBytes) {
+    // This GOP is too big for us; give up on it:
+    clear();
+    return;
+  }
+
+  frame->addRef();
+  m_frames.push_back(frame);
+  m_numBytes += frame->size();
+}
+
+void GopCache::clear() {
+  for (std::deque<PullerFrame*>::iterator it = m_frames.begin(); it != m_frames.end(); ++it) {
+    (*it)->release();
+  }
+  m_frames.clear();
+  m_numBytes = 0;
+  m_haveGOPStart = False;
+}
+
+void GopCache::copyFrames(std::vector<PullerFrame*>& frames) const {
+  for (std::deque<PullerFrame*>::const_iterator it = m_frames.begin(); it != m_frames.end(); ++it) {
+    (*it)->addRef();
+    frames.push_back(*it);
+  }
+}
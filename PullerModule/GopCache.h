@@ -0,0 +1,46 @@
+/**
+ * @file GopCache.h
+ * @brief  Cache of the frames since the last key frame
+ * @author lizhiyong0804319@gmail.com
+ * @version 1.0
+ * @date 2026-10-19
+ */
+
+#ifndef GOP_CACHE_H
+#define GOP_CACHE_H
+
+#include "PullerFrame.h"
+#include "H264VideoRTPSource.hh"
+
+#include <deque>
+#include <vector>
+
+// Holds references to every frame since (and including) the start of the current GOP,
+// so that a consumer that attaches late can begin decoding immediately.
+// If the GOP outgrows "maxBytes", the cache is emptied until the next GOP begins,
+// because a partial GOP without its key frame is of no use.
+
+class GopCache {
+public:
+  GopCache(unsigned maxBytes);
+  ~GopCache();
+
+  void addFrame(PullerFrame* frame); // takes its own reference to "frame"
+  void clear();
+
+  // Appends (new references to) the cached frames, oldest first:
+  void copyFrames(std::vector<PullerFrame*>& frames) const;
+
+  unsigned maxBytes() const { return m_maxBytes; }
+  unsigned numBytes() const { return m_numBytes; }
+  unsigned numFrames() const { return (unsigned)m_frames.size(); }
+
+private:
+  unsigned m_maxBytes;
+  unsigned m_numBytes;
+  Boolean m_haveGOPStart;
+  H264GOPBoundaryDetector m_gopBoundaryDetector;
+  std::deque<PullerFrame*> m_frames;
+};
+
+#endif
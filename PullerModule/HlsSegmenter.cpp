@@ -0,0 +1,550 @@
+/**
+ * @file HlsSegmenter.cpp
+ * @brief  1.0
+ *		implementation of HlsSegmenter
+ * @author lizhiyong0804319@gmail.com
+ * @version 1.0
+ * @date 2026-10-19
+ */
+
+#include "HlsSegmenter.h"
+#include "FrameDistributor.h"
+#include "FileWriter.h"
+#include "MemoryBudget.h"
+#include "liveMedia.hh"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TIMESCALE 90000
+#define PTS_BASE TIMESCALE // our PTSs begin at 1 s, leaving room for tracks that begin a little earlier
+#define PCR_DELAY (TIMESCALE/2) // how far the PCR runs behind the video PTS
+#define DEFAULT_AU_DURATION (TIMESCALE/25) // until we've seen two access units
+#define SPARE_SEGMENTS 2 // kept after leaving the playlist
+#define SEGMENT_WRITE_BUFFER_SIZE (128*1024) // much smaller than the default; we may have thousands of streams
+#define PLAYLIST_WRITE_BUFFER_SIZE (8*1024)
+
+#define TS_PACKET_SIZE 188
+#define PAT_PID 0x0000
+#define PMT_PID 0x1000
+#define VIDEO_PID 0x0100
+#define AUDIO_PID 0x0101
+#define STREAM_TYPE_AAC 0x0F // ADTS
+#define STREAM_TYPE_H264 0x1B
+#define STREAM_TYPE_H265 0x24
+
+static unsigned char const h264AUD[] = { 0, 0, 0, 1, 0x09, 0xF0 }; // primary_pic_type 7 (any)
+static unsigned char const h265AUD[] = { 0, 0, 0, 1, 0x46, 0x01, 0x50 }; // pic_type 2 (any)
+
+static u_int32_t crc32(unsigned char const* data, unsigned size) {
+  // The MPEG-2 CRC (not reflected), as used by PSI sections:
+  u_int32_t crc = 0xFFFFFFFF;
+  for (unsigned i = 0; i < size; ++i) {
+    crc ^= (u_int32_t)data[i]<<24;
+    for (unsigned bit = 0; bit < 8; ++bit) crc = (crc&0x80000000) != 0 ? (crc<<1)^0x04C11DB7 : crc<<1;
+  }
+  return crc;
+}
+
+static unsigned char const* findStartCode(unsigned char const* p, unsigned char const* end) {
+  // Returns the first "00 00 01" at or after "p" (or "end", if there's none):
+  for (; p + 3 <= end; ++p) {
+    if (p[2] > 1) { p += 2; continue; }
+    if (p[0] == 0 && p[1] == 0 && p[2] == 1) return p;
+  }
+  return end;
+}
+
+HlsSegmenter::HlsSegmenter(FrameDistributor& distributor, char const* pathPrefix, unsigned segmentSeconds, unsigned listSize)
+  : m_distributor(distributor), m_subscriberId(0), m_framesDropped(0), m_pathPrefix(pathPrefix),
+    m_segmentDuration((u_int64_t)segmentSeconds*TIMESCALE), m_listSize(listSize),
+    m_videoCodec(VIDEO_NONE), m_waitingForKeyFrame(True), m_haveCurAU(False), m_curTimestamp(0), m_curPTS(0),
+    m_curIsKey(False), m_curHasParameterSets(False), m_lastDuration(DEFAULT_AU_DURATION),
+    m_audioIsRTP(False), m_haveAudio(False), m_audioInSegment(False),
+    m_haveBase(False), m_basePresentationTime(0), m_haveDemuxOffset(False), m_demuxOffset(0),
+    m_file(NULL), m_segmentStartPTS(0), m_nextSequenceNumber(0), m_nextIsDiscontinuity(False),
+    m_targetDuration(segmentSeconds), m_outSize(0), m_chargedBytes(0) {
+  char const* slash = strrchr(pathPrefix, '/');
+  m_uriPrefix = slash != NULL ? slash + 1 : pathPrefix;
+  memset(&m_videoTimeline, 0, sizeof m_videoTimeline);
+  memset(&m_audioTimeline, 0, sizeof m_audioTimeline);
+  memset(m_adtsHeader, 0, sizeof m_adtsHeader);
+  memset(m_continuityCounters, 0, sizeof m_continuityCounters);
+}
+
+HlsSegmenter::~HlsSegmenter() {
+  finish();
+
+  // Release our buffers' memory before we give it back to the budget:
+  std::vector<unsigned char>().swap(m_au);
+  std::string().swap(m_playlist);
+  accountMemory();
+}
+
+int _APICALL HlsSegmenter::onFrame(CBDataType dataType, void* data, void* obj) {
+  if (dataType == CB_FRAME_DATA && data != NULL) {
+    HlsSegmenter* segmenter = (HlsSegmenter*)obj;
+    segmenter->handleFrame(*(FrameData*)data);
+    segmenter->accountMemory();
+  }
+  return 0;
+}
+
+void HlsSegmenter::handleFrame(FrameData const& frame) {
+  if (frame.codecName == NULL || frame.bufLen <= 0) return;
+
+  // If frames were dropped from our queue (because we couldn't keep up), there's now a gap in the
+  // stream; skip everything up to the next key frame:
+  if (m_subscriberId != 0) {
+    SubscriberStats stats;
+    if (m_distributor.getSubscriberStats(m_subscriberId, stats) == 0 && stats.framesDropped != m_framesDropped) {
+      m_framesDropped = stats.framesDropped;
+      m_haveCurAU = False;
+      m_waitingForKeyFrame = True;
+    }
+  }
+
+  if (strcmp(frame.codecName, "H264") == 0) {
+    handleVideo(frame, VIDEO_H264);
+  } else if (strcmp(frame.codecName, "H265") == 0) {
+    handleVideo(frame, VIDEO_H265);
+  } else if (strcmp(frame.codecName, "MPEG4-GENERIC") == 0 || strcmp(frame.codecName, "AAC") == 0) {
+    handleAudio(frame);
+  }
+}
+
+void HlsSegmenter::handleVideo(FrameData const& frame, VideoCodec codec) {
+  if (m_videoCodec == VIDEO_NONE) m_videoCodec = codec;
+  else if (codec != m_videoCodec) return;
+
+  // Demultiplexed frames are whole access units, in Annex B form; RTP frames are single NAL units.
+  // (Whole RTP packets - "retRtpPkt" streams - can't be remuxed, and are ignored here.  H.265 arrives
+  // only demultiplexed: we have no RTP depacketizer for it.)
+  unsigned char const* data = (unsigned char const*)frame.dataBuf;
+  unsigned char const* end = data + frame.bufLen;
+  Boolean isAnnexB = data[0] == 0;
+  if (!isAnnexB && (codec != VIDEO_H264 || (data[0]&0x80) != 0 || (data[0]&0x1F) == 0 || (data[0]&0x1F) > 23)) return;
+
+  u_int64_t pts = ptsOf(frame, m_videoTimeline, isAnnexB);
+  if (m_haveCurAU && frame.rtpTimestamp != m_curTimestamp) finishAccessUnit(pts);
+
+  if (!isAnnexB) {
+    handleNALUnit(data, (unsigned)frame.bufLen, frame.rtpTimestamp, pts);
+    return;
+  }
+  for (unsigned char const* startCode = findStartCode(data, end); startCode < end; ) {
+    unsigned char const* nal = startCode + 3;
+    unsigned char const* next = findStartCode(nal, end);
+    unsigned char const* nalEnd = next;
+    while (nalEnd > nal && nalEnd[-1] == 0) --nalEnd; // (the leading zero of a 4-byte start code, or trailing zeros)
+    if (nalEnd > nal) handleNALUnit(nal, (unsigned)(nalEnd - nal), frame.rtpTimestamp, pts);
+    startCode = next;
+  }
+}
+
+void HlsSegmenter::handleNALUnit(unsigned char const* nal, unsigned size, u_int32_t timestamp, u_int64_t pts) {
+  if (!m_haveCurAU) beginAccessUnit(timestamp, pts);
+
+  Boolean isAUD, isKey;
+  int parameterSet = -1; // our index for it, if it's one
+  if (m_videoCodec == VIDEO_H264) {
+    unsigned char nalUnitType = nal[0]&0x1F;
+    isAUD = nalUnitType == 9;
+    isKey = nalUnitType == 5;
+    if (nalUnitType == 7 || nalUnitType == 8) parameterSet = nalUnitType - 6;
+  } else {
+    unsigned char nalUnitType = (nal[0]>>1)&0x3F;
+    isAUD = nalUnitType == 35;
+    isKey = nalUnitType >= 16 && nalUnitType <= 21; // an IRAP picture
+    if (nalUnitType >= 32 && nalUnitType <= 34) parameterSet = nalUnitType - 32;
+  }
+  if (isAUD) return; // (each access unit begins with one of our own)
+
+  if (parameterSet >= 0) {
+    m_parameterSets[parameterSet].assign((char const*)nal, size);
+    m_curHasParameterSets = True;
+  } else if (isKey && !m_curIsKey) {
+    // A key frame can begin a segment, so must carry its parameter sets (e.g., those from the SDP description):
+    if (!m_curHasParameterSets && haveParameterSets()) appendParameterSets();
+    m_curIsKey = m_curHasParameterSets;
+  }
+  appendNALUnit(nal, size);
+}
+
+void HlsSegmenter::handleAudio(FrameData const& frame) {
+  // RTP frames are raw AAC frames (which we give ADTS headers, from the SDP's "config"); demultiplexed
+  // frames are ADTS frames already:
+  Boolean isRTP = strcmp(frame.codecName, "MPEG4-GENERIC") == 0;
+  if (!m_haveAudio) {
+    if (isRTP && !setUpRTPAudio()) return;
+    m_haveAudio = True;
+    m_audioIsRTP = isRTP;
+  } else if (isRTP != m_audioIsRTP) {
+    return;
+  }
+  if (m_file == NULL || !m_audioInSegment) return; // (the segment's PMT has no audio stream)
+
+  u_int64_t pts = ptsOf(frame, m_audioTimeline, !isRTP);
+  unsigned char const* data = (unsigned char const*)frame.dataBuf;
+  unsigned size = (unsigned)frame.bufLen;
+  if (!isRTP) {
+    writePES(AUDIO_PID, 0xC0, pts, False, NULL, 0, data, size);
+    return;
+  }
+
+  unsigned frameLength = sizeof m_adtsHeader + size;
+  if (frameLength > 0x1FFF) return; // too large for an ADTS header
+  unsigned char header[sizeof m_adtsHeader];
+  memcpy(header, m_adtsHeader, sizeof header);
+  header[3] |= frameLength>>11;
+  header[4] = (unsigned char)(frameLength>>3);
+  header[5] |= (frameLength&0x07)<<5;
+  writePES(AUDIO_PID, 0xC0, pts, False, header, sizeof header, data, size);
+}
+
+Boolean HlsSegmenter::setUpRTPAudio() {
+  std::string config;
+  m_distributor.getAACConfig(config);
+  if (config.empty()) return False;
+
+  // The "AudioSpecificConfig" gives us the ADTS header's fixed fields:
+  unsigned configSize;
+  unsigned char* audioSpecificConfig = parseGeneralConfigStr(config.c_str(), configSize);
+  if (audioSpecificConfig == NULL) return False;
+  unsigned audioObjectType = configSize >= 2 ? audioSpecificConfig[0]>>3 : 0;
+  unsigned samplingFrequencyIndex = configSize >= 2 ? ((audioSpecificConfig[0]&0x07)<<1)|(audioSpecificConfig[1]>>7) : 0;
+  unsigned channelConfiguration = configSize >= 2 ? (audioSpecificConfig[1]>>3)&0x0F : 0;
+  delete[] audioSpecificConfig;
+  if (audioObjectType == 0 || audioObjectType > 4 || samplingFrequencyIndex > 12) return False; // not expressible in ADTS
+
+  m_adtsHeader[0] = 0xFF;
+  m_adtsHeader[1] = 0xF1; // MPEG-4, no CRC
+  m_adtsHeader[2] = (unsigned char)(((audioObjectType - 1)<<6)|(samplingFrequencyIndex<<2)|(channelConfiguration>>2));
+  m_adtsHeader[3] = (unsigned char)((channelConfiguration&0x03)<<6); // (then the frame length)
+  m_adtsHeader[4] = 0x00;
+  m_adtsHeader[5] = 0x1F; // buffer fullness 0x7FF ("variable")
+  m_adtsHeader[6] = 0xFC; // one raw data block
+  return True;
+}
+
+u_int64_t HlsSegmenter::ptsOf(FrameData const& frame, Timeline& timeline, Boolean isDemuxed) {
+  // A track's own timestamps: those from RTP (made monotonic for us), or the 32-bit PTSs of demultiplexed frames:
+  u_int64_t timestamp;
+  if (isDemuxed) {
+    timeline.extTimestamp = timeline.started
+      ? timeline.extTimestamp + (int32_t)(frame.rtpTimestamp - timeline.lastTimestamp) : frame.rtpTimestamp;
+    timeline.lastTimestamp = frame.rtpTimestamp;
+    timestamp = timeline.extTimestamp;
+  } else {
+    timestamp = frame.monoPtsUs*TIMESCALE/1000000;
+  }
+
+  if (!timeline.started) {
+    // Our PTSs begin at "PTS_BASE".  RTP tracks are aligned with each other by their first frames'
+    // presentation times (these are RTCP-synchronized, once RTCP has been received); demultiplexed
+    // tracks are aligned already:
+    timeline.started = True;
+    u_int64_t presentationTime = (u_int64_t)frame.ptsSec*1000000 + frame.ptsUsec;
+    if (!m_haveBase) {
+      m_haveBase = True;
+      m_basePresentationTime = presentationTime;
+    }
+    if (isDemuxed) {
+      if (!m_haveDemuxOffset) {
+	m_haveDemuxOffset = True;
+	m_demuxOffset = PTS_BASE - timestamp;
+      }
+      timeline.offset = m_demuxOffset;
+    } else {
+      long long start = PTS_BASE + (long long)(presentationTime - m_basePresentationTime)*9/100;
+      timeline.offset = (u_int64_t)(start > 0 ? start : 0) - timestamp;
+    }
+  }
+  u_int64_t pts = timestamp + timeline.offset;
+  return (long long)pts > 0 ? pts : 0;
+}
+
+Boolean HlsSegmenter::haveParameterSets() const {
+  return !m_parameterSets[1].empty() && !m_parameterSets[2].empty()
+    && (m_videoCodec != VIDEO_H265 || !m_parameterSets[0].empty());
+}
+
+void HlsSegmenter::appendParameterSets() {
+  if (m_parameterSets[1].empty()) {
+    // We've seen none in the stream; use those from the SDP description:
+    std::string sprop;
+    m_distributor.getH264ParameterSets(sprop);
+    if (m_videoCodec == VIDEO_H264 && !sprop.empty()) {
+      unsigned numRecords;
+      SPropRecord* records = parseSPropParameterSets(sprop.c_str(), numRecords);
+      for (unsigned i = 0; i < numRecords; ++i) {
+	if (records[i].sPropLength == 0) continue;
+	unsigned char nalUnitType = records[i].sPropBytes[0]&0x1F;
+	if (nalUnitType == 7 || nalUnitType == 8) {
+	  m_parameterSets[nalUnitType - 6].assign((char const*)records[i].sPropBytes, records[i].sPropLength);
+	}
+      }
+      delete[] records;
+    }
+    if (!haveParameterSets()) return;
+  }
+
+  for (unsigned i = 0; i < 3; ++i) {
+    if (!m_parameterSets[i].empty()) {
+      appendNALUnit((unsigned char const*)m_parameterSets[i].data(), (unsigned)m_parameterSets[i].size());
+    }
+  }
+  m_curHasParameterSets = True;
+}
+
+void HlsSegmenter::appendNALUnit(unsigned char const* nal, unsigned size) {
+  static unsigned char const startCode[] = { 0, 0, 0, 1 };
+  m_au.insert(m_au.end(), startCode, startCode + sizeof startCode);
+  m_au.insert(m_au.end(), nal, nal + size);
+}
+
+void HlsSegmenter::beginAccessUnit(u_int32_t timestamp, u_int64_t pts) {
+  m_haveCurAU = True;
+  m_curTimestamp = timestamp;
+  m_curPTS = pts;
+  m_curIsKey = False;
+  m_curHasParameterSets = False;
+  m_au.clear(); // (keeping its capacity)
+  if (m_videoCodec == VIDEO_H264) m_au.insert(m_au.end(), h264AUD, h264AUD + sizeof h264AUD);
+  else m_au.insert(m_au.end(), h265AUD, h265AUD + sizeof h265AUD);
+}
+
+void HlsSegmenter::finishAccessUnit(u_int64_t nextPTS) {
+  m_haveCurAU = False;
+  if (nextPTS > m_curPTS && nextPTS - m_curPTS < 10*TIMESCALE) m_lastDuration = nextPTS - m_curPTS;
+
+  if (m_waitingForKeyFrame) {
+    if (!m_curIsKey) return;
+    m_waitingForKeyFrame = False;
+  }
+  if (m_au.size() <= sizeof h265AUD) return; // it had nothing but (perhaps) an AUD
+
+  // A new segment begins at the first key frame after the segment duration (or if the current
+  // segment's file has failed):
+  if (m_curIsKey && (m_file == NULL || m_file->failed()
+		     || (m_curPTS >= m_segmentStartPTS && m_curPTS - m_segmentStartPTS >= m_segmentDuration))) {
+    closeSegment(m_curPTS, False);
+    openSegment(m_curPTS);
+  }
+  if (m_file == NULL) {
+    m_waitingForKeyFrame = True;
+    return;
+  }
+  writePES(VIDEO_PID, 0xE0, m_curPTS, m_curIsKey, NULL, 0, &m_au[0], (unsigned)m_au.size());
+}
+
+void HlsSegmenter::finish() {
+  // The access unit being collected is complete (as far as we'll ever know), so give it the usual duration:
+  if (m_haveCurAU) finishAccessUnit(m_curPTS + m_lastDuration);
+  closeSegment(m_curPTS + m_lastDuration, True);
+}
+
+void HlsSegmenter::openSegment(u_int64_t pts) {
+  if (!m_haveAudio && setUpRTPAudio()) { // (the SDP description may have been parsed since we started)
+    m_haveAudio = True;
+    m_audioIsRTP = True;
+  }
+
+  char fileName[32];
+  snprintf(fileName, sizeof fileName, "%u.ts", m_nextSequenceNumber);
+  std::string path = m_pathPrefix + fileName;
+  m_file = AsyncFile::open((path + ".tmp").c_str(), SEGMENT_WRITE_BUFFER_SIZE, path.c_str());
+  if (m_file == NULL) return;
+
+  m_segmentStartPTS = pts;
+  m_audioInSegment = m_haveAudio;
+  writePATAndPMT();
+}
+
+void HlsSegmenter::closeSegment(u_int64_t endPTS, Boolean isLast) {
+  if (m_file == NULL) {
+    if (isLast && !m_segments.empty()) writePlaylist(AsyncFile::open((m_pathPrefix + ".m3u8.tmp").c_str(),
+	PLAYLIST_WRITE_BUFFER_SIZE, (m_pathPrefix + ".m3u8").c_str()), True);
+    return;
+  }
+
+  flushPackets();
+  if (m_file->failed()) {
+    // The segment is lost (and its temporary file removed), so isn't listed:
+    m_nextIsDiscontinuity = True;
+  } else {
+    Segment segment;
+    segment.sequenceNumber = m_nextSequenceNumber;
+    segment.duration = endPTS > m_segmentStartPTS ? (double)(endPTS - m_segmentStartPTS)/TIMESCALE : 0.0;
+    segment.discontinuity = m_nextIsDiscontinuity;
+    m_nextIsDiscontinuity = False;
+    unsigned roundedDuration = (unsigned)(segment.duration + 0.5);
+    if (roundedDuration > m_targetDuration) m_targetDuration = roundedDuration;
+    m_segments.push_back(segment);
+    if (m_segments.size() > m_listSize) m_segments.pop_front();
+
+    // Delete the segment that left the playlist "SPARE_SEGMENTS" segments ago:
+    if (segment.sequenceNumber >= m_listSize + SPARE_SEGMENTS) {
+      char fileName[32];
+      snprintf(fileName, sizeof fileName, "%u.ts", segment.sequenceNumber - m_listSize - SPARE_SEGMENTS);
+      unlink((m_pathPrefix + fileName).c_str());
+    }
+  }
+  ++m_nextSequenceNumber;
+
+  // The playlist is written by the segment's writer thread, after the segment, so that it never lists
+  // a segment that isn't complete:
+  AsyncFile* playlist = AsyncFile::open((m_pathPrefix + ".m3u8.tmp").c_str(), PLAYLIST_WRITE_BUFFER_SIZE,
+					(m_pathPrefix + ".m3u8").c_str(), m_file);
+  m_file->close();
+  m_file = NULL;
+  writePlaylist(playlist, isLast);
+}
+
+void HlsSegmenter::writePlaylist(AsyncFile* file, Boolean isLast) {
+  if (file == NULL) return;
+
+  char line[128];
+  m_playlist.clear(); // (keeping its capacity)
+  m_playlist += "#EXTM3U\n#EXT-X-VERSION:3\n";
+  snprintf(line, sizeof line, "#EXT-X-TARGETDURATION:%u\n#EXT-X-MEDIA-SEQUENCE:%u\n",
+	   m_targetDuration, m_segments.empty() ? m_nextSequenceNumber : m_segments.front().sequenceNumber);
+  m_playlist += line;
+  for (std::deque<Segment>::const_iterator it = m_segments.begin(); it != m_segments.end(); ++it) {
+    if (it->discontinuity) m_playlist += "#EXT-X-DISCONTINUITY\n";
+    snprintf(line, sizeof line, "#EXTINF:%.3f,\n", it->duration);
+    m_playlist += line;
+    m_playlist += m_uriPrefix;
+    snprintf(line, sizeof line, "%u.ts\n", it->sequenceNumber);
+    m_playlist += line;
+  }
+  if (isLast) m_playlist += "#EXT-X-ENDLIST\n";
+
+  file->write(m_playlist.data(), (unsigned)m_playlist.size());
+  file->close();
+}
+
+void HlsSegmenter::writePATAndPMT() {
+  unsigned char const pat[] = {
+    0x00, 0xB0, 0x0D, 0x00, 0x01, 0xC1, 0x00, 0x00, // table_id, section_length 13, transport_stream_id 1, version 0
+    0x00, 0x01, 0xE0|(PMT_PID>>8), PMT_PID&0xFF // program 1
+  };
+  writeSection(PAT_PID, pat, sizeof pat);
+
+  unsigned char pmt[32];
+  unsigned size = 0;
+  pmt[size++] = 0x02; pmt[size++] = 0xB0; pmt[size++] = 0; // table_id, section_length (set below)
+  pmt[size++] = 0x00; pmt[size++] = 0x01; pmt[size++] = 0xC1; pmt[size++] = 0x00; pmt[size++] = 0x00; // program 1
+  pmt[size++] = 0xE0|(VIDEO_PID>>8); pmt[size++] = VIDEO_PID&0xFF; // PCR_PID
+  pmt[size++] = 0xF0; pmt[size++] = 0x00; // program_info_length
+  pmt[size++] = m_videoCodec == VIDEO_H265 ? STREAM_TYPE_H265 : STREAM_TYPE_H264;
+  pmt[size++] = 0xE0|(VIDEO_PID>>8); pmt[size++] = VIDEO_PID&0xFF; pmt[size++] = 0xF0; pmt[size++] = 0x00;
+  if (m_audioInSegment) {
+    pmt[size++] = STREAM_TYPE_AAC;
+    pmt[size++] = 0xE0|(AUDIO_PID>>8); pmt[size++] = AUDIO_PID&0xFF; pmt[size++] = 0xF0; pmt[size++] = 0x00;
+  }
+  pmt[2] = (unsigned char)(size - 3 + 4); // (including the CRC)
+  writeSection(PMT_PID, pmt, size);
+}
+
+static unsigned char& continuityCounter(unsigned char* counters, unsigned pid) {
+  return counters[pid == PAT_PID ? 0 : pid == PMT_PID ? 1 : pid == VIDEO_PID ? 2 : 3];
+}
+
+void HlsSegmenter::writeSection(unsigned pid, unsigned char const* section, unsigned size) {
+  unsigned char* packet = newPacket();
+  packet[0] = 0x47;
+  packet[1] = 0x40|(pid>>8); // payload_unit_start_indicator
+  packet[2] = pid&0xFF;
+  packet[3] = 0x10|(continuityCounter(m_continuityCounters, pid)++&0x0F);
+  packet[4] = 0; // pointer_field
+  memcpy(&packet[5], section, size);
+  u_int32_t crc = crc32(section, size);
+  packet[5+size] = crc>>24; packet[6+size] = crc>>16; packet[7+size] = crc>>8; packet[8+size] = crc;
+  memset(&packet[9+size], 0xFF, TS_PACKET_SIZE - 9 - size);
+}
+
+void HlsSegmenter::writePES(unsigned pid, unsigned char streamId, u_int64_t pts, Boolean isKey,
+			    unsigned char const* prefix, unsigned prefixSize, unsigned char const* data, unsigned size) {
+  pts &= 0x1FFFFFFFFULL; // 33 bits
+  unsigned char header[14];
+  unsigned pesPacketLength = 8 + prefixSize + size;
+  if (streamId == 0xE0 || pesPacketLength > 0xFFFF) pesPacketLength = 0; // "unbounded" (allowed for video)
+  header[0] = 0; header[1] = 0; header[2] = 1; header[3] = streamId;
+  header[4] = pesPacketLength>>8; header[5] = pesPacketLength&0xFF;
+  header[6] = 0x80; header[7] = 0x80; header[8] = 5; // PTS only
+  header[9] = 0x21|((pts>>29)&0x0E);
+  header[10] = (pts>>22)&0xFF; header[11] = ((pts>>14)&0xFE)|1;
+  header[12] = (pts>>7)&0xFF; header[13] = ((pts<<1)&0xFE)|1;
+
+  // The PES packet is the concatenation of these:
+  unsigned char const* parts[3] = { header, prefix, data };
+  unsigned partSizes[3] = { sizeof header, prefixSize, size };
+  unsigned part = 0, partOffset = 0;
+  unsigned remaining = sizeof header + prefixSize + size;
+
+  for (Boolean first = True; remaining > 0; first = False) {
+    unsigned char* packet = newPacket();
+    packet[0] = 0x47;
+    packet[1] = (first ? 0x40 : 0x00)|(pid>>8);
+    packet[2] = pid&0xFF;
+
+    // Each video PES begins with an adaptation field, carrying the PCR (and, for a key frame, the
+    // random access indicator).  The last packet is filled out with an adaptation field's stuffing:
+    Boolean withPCR = first && pid == VIDEO_PID;
+    unsigned adaptationFieldSize = withPCR ? 8 : 0; // (including its length byte)
+    if (remaining < TS_PACKET_SIZE - 4 - adaptationFieldSize) adaptationFieldSize = TS_PACKET_SIZE - 4 - remaining;
+    packet[3] = (adaptationFieldSize > 0 ? 0x30 : 0x10)|(continuityCounter(m_continuityCounters, pid)++&0x0F);
+    if (adaptationFieldSize > 0) {
+      packet[4] = (unsigned char)(adaptationFieldSize - 1);
+      if (adaptationFieldSize > 1) {
+	unsigned char* p = &packet[5];
+	*p++ = withPCR ? ((isKey ? 0x40 : 0x00)|0x10) : 0x00;
+	if (withPCR) {
+	  u_int64_t pcrBase = pts > PCR_DELAY ? pts - PCR_DELAY : 0;
+	  *p++ = (unsigned char)(pcrBase>>25); *p++ = (unsigned char)(pcrBase>>17);
+	  *p++ = (unsigned char)(pcrBase>>9); *p++ = (unsigned char)(pcrBase>>1);
+	  *p++ = (unsigned char)(((pcrBase&1)<<7)|0x7E); *p++ = 0x00; // (PCR extension 0)
+	}
+	memset(p, 0xFF, &packet[4 + adaptationFieldSize] - p);
+      }
+    }
+
+    unsigned char* payload = &packet[4 + adaptationFieldSize];
+    unsigned payloadSize = TS_PACKET_SIZE - 4 - adaptationFieldSize;
+    remaining -= payloadSize;
+    while (payloadSize > 0) {
+      unsigned numBytes = partSizes[part] - partOffset;
+      if (numBytes > payloadSize) numBytes = payloadSize;
+      memcpy(payload, parts[part] + partOffset, numBytes);
+      payload += numBytes;
+      payloadSize -= numBytes;
+      partOffset += numBytes;
+      if (partOffset == partSizes[part]) {
+	++part;
+	partOffset = 0;
+      }
+    }
+  }
+}
+
+unsigned char* HlsSegmenter::newPacket() {
+  if (m_outSize + TS_PACKET_SIZE > sizeof m_out) flushPackets();
+  unsigned char* packet = &m_out[m_outSize];
+  m_outSize += TS_PACKET_SIZE;
+  return packet;
+}
+
+void HlsSegmenter::flushPackets() {
+  if (m_outSize > 0 && m_file != NULL) m_file->write(m_out, m_outSize); // (a failure shows in "failed()")
+  m_outSize = 0;
+}
+
+void HlsSegmenter::accountMemory() {
+  long long numBytes = (long long)(m_au.capacity() + m_playlist.capacity());
+  if (numBytes != m_chargedBytes) {
+    MemoryBudget::charge(numBytes - m_chargedBytes);
+    m_chargedBytes = numBytes;
+  }
+}
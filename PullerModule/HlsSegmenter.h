@@ -0,0 +1,134 @@
+/**
+ * @file HlsSegmenter.h
+ * @brief  Remuxes a stream's frames into MPEG Transport Stream segments, with a rolling HLS playlist
+ * @author lizhiyong0804319@gmail.com
+ * @version 1.0
+ * @date 2026-10-19
+ */
+
+#ifndef HLS_SEGMENTER_H
+#define HLS_SEGMENTER_H
+
+#include "API_PullerModule.h"
+#include "Boolean.hh"
+#include "NetCommon.h"
+
+#include <deque>
+#include <string>
+#include <vector>
+
+class FrameDistributor; // forward
+class AsyncFile; // forward
+
+// A subscriber of a "FrameDistributor", like "Fmp4Recorder".  We take H.264 video (NAL units from RTP,
+// or Annex B access units demultiplexed from a Transport Stream), H.265 video (demultiplexed only) and
+// AAC audio (from "MPEG4-GENERIC" RTP, given an ADTS header here; or demultiplexed ADTS), and packetize
+// them straight into 188-byte Transport Stream packets - each access unit is collected once, in a buffer
+// that's reused, so there's no allocation per frame.  Segments "<pathPrefix>N.ts" begin with a
+// PAT, a PMT and a key frame; a new one is begun at the first key frame after "segmentSeconds".  Each
+// segment, and then the playlist "<pathPrefix>.m3u8" that lists it (the newest "listSize" segments),
+// is written by the writer pool under a temporary name and renamed once complete, so an HTTP server
+// can serve the directory as it is.  Segments that have left the playlist (and a few spare, for
+// clients that are still fetching them) are deleted.
+
+class HlsSegmenter {
+public:
+  HlsSegmenter(FrameDistributor& distributor, char const* pathPrefix, unsigned segmentSeconds, unsigned listSize);
+  ~HlsSegmenter(); // finishes the current segment, and ends the playlist; we must be unsubscribed first
+
+  void setSubscriberId(int subscriberId) { m_subscriberId = subscriberId; } // for noticing dropped frames
+
+  static int _APICALL onFrame(CBDataType dataType, void* data, void* obj); // our "PullerCallback"
+
+private:
+  enum VideoCodec { VIDEO_NONE, VIDEO_H264, VIDEO_H265 };
+
+  struct Timeline { // maps a track's own timestamps to our (90 kHz) PTSs
+    Boolean started;
+    u_int32_t lastTimestamp; // for demultiplexed frames, whose timestamps are 32-bit PTSs
+    u_int64_t extTimestamp;
+    u_int64_t offset;
+  };
+
+  struct Segment {
+    unsigned sequenceNumber;
+    double duration; // seconds
+    Boolean discontinuity; // follows a segment that was lost
+  };
+
+  void handleFrame(FrameData const& frame);
+  void handleVideo(FrameData const& frame, VideoCodec codec);
+  void handleNALUnit(unsigned char const* nal, unsigned size, u_int32_t timestamp, u_int64_t pts);
+  void handleAudio(FrameData const& frame);
+  Boolean setUpRTPAudio(); // from the SDP description's "config"
+  u_int64_t ptsOf(FrameData const& frame, Timeline& timeline, Boolean isDemuxed);
+  Boolean haveParameterSets() const;
+  void appendParameterSets();
+  void appendNALUnit(unsigned char const* nal, unsigned size);
+  void beginAccessUnit(u_int32_t timestamp, u_int64_t pts);
+  void finishAccessUnit(u_int64_t nextPTS);
+  void finish();
+
+  void openSegment(u_int64_t pts);
+  void closeSegment(u_int64_t endPTS, Boolean isLast);
+  void writePlaylist(AsyncFile* file, Boolean isLast); // (then closes "file")
+
+  void writePATAndPMT();
+  void writePES(unsigned pid, unsigned char streamId, u_int64_t pts, Boolean isKey,
+		unsigned char const* prefix, unsigned prefixSize, unsigned char const* data, unsigned size);
+  void writeSection(unsigned pid, unsigned char const* section, unsigned size); // adds the CRC
+  unsigned char* newPacket(); // in "m_out"
+  void flushPackets();
+  void accountMemory();
+
+private:
+  FrameDistributor& m_distributor;
+  volatile int m_subscriberId; // 0 until our subscription has been made
+  unsigned long long m_framesDropped; // by our subscriber queue, the last time we looked
+  std::string m_pathPrefix;
+  std::string m_uriPrefix; // the file name part of "m_pathPrefix", for the playlist's URIs
+  u_int64_t m_segmentDuration; // 90 kHz
+  unsigned m_listSize;
+
+  // Video:
+  VideoCodec m_videoCodec; // that of the first video frame; others are ignored
+  Timeline m_videoTimeline;
+  std::string m_parameterSets[3]; // the latest VPS (H.265 only), SPS and PPS, for key frames that lack them
+  Boolean m_waitingForKeyFrame; // at the start, and after a gap in the stream
+  Boolean m_haveCurAU;
+  u_int32_t m_curTimestamp; // identifies the current access unit's NAL units
+  u_int64_t m_curPTS; // 90 kHz
+  Boolean m_curIsKey;
+  Boolean m_curHasParameterSets;
+  u_int64_t m_lastDuration; // of an access unit
+  std::vector<unsigned char> m_au; // the access unit being collected, in Annex B form
+
+  // Audio:
+  Boolean m_audioIsRTP; // "MPEG4-GENERIC", which we give ADTS headers
+  Boolean m_haveAudio; // listed in the PMT of each segment from the next one on
+  Boolean m_audioInSegment; // in the current segment's PMT
+  unsigned char m_adtsHeader[7]; // (for RTP audio) all but the frame length
+  Timeline m_audioTimeline;
+
+  // For aligning tracks:
+  Boolean m_haveBase;
+  u_int64_t m_basePresentationTime; // uSeconds; that of the first frame
+  Boolean m_haveDemuxOffset;
+  u_int64_t m_demuxOffset; // demultiplexed tracks share a clock, so they share an offset
+
+  // The current segment, and the playlist:
+  AsyncFile* m_file; // NULL between segments
+  u_int64_t m_segmentStartPTS;
+  unsigned m_nextSequenceNumber;
+  Boolean m_nextIsDiscontinuity;
+  unsigned m_targetDuration; // seconds; never decreases
+  std::deque<Segment> m_segments; // those in the playlist
+  std::string m_playlist; // built here, then written
+  unsigned char m_continuityCounters[4]; // PAT, PMT, video, audio
+
+  unsigned char m_out[64*188]; // Transport Stream packets, waiting to be written
+  unsigned m_outSize;
+  long long m_chargedBytes; // as charged to the memory budget
+};
+
+#endif
@@ -0,0 +1,58 @@
+/**
+ * @file MemoryBudget.cpp
+ * @brief  1.0
+ *		implementation of MemoryBudget
+ * @author lizhiyong0804319@gmail.com
+ * @version 1.0
+ * @date 2026-10-19
+ */
+
+#include "MemoryBudget.h"
+
+static unsigned long long s_limitBytes = 0;
+static long long s_usedBytes = 0; // signed, so that a release that races ahead of its charge can't wrap
+static long long s_peakBytes = 0;
+static unsigned long long s_refusedReservations = 0;
+
+static void notePeak(long long usedBytes) {
+  long long peak = __atomic_load_n(&s_peakBytes, __ATOMIC_RELAXED);
+  while (usedBytes > peak
+	 && !__atomic_compare_exchange_n(&s_peakBytes, &peak, usedBytes, True, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {}
+}
+
+void MemoryBudget::setLimit(unsigned long long limitBytes) {
+  __atomic_store_n(&s_limitBytes, limitBytes, __ATOMIC_RELAXED);
+}
+
+Boolean MemoryBudget::reserve(unsigned long long numBytes) {
+  unsigned long long limit = __atomic_load_n(&s_limitBytes, __ATOMIC_RELAXED);
+  long long used = __atomic_load_n(&s_usedBytes, __ATOMIC_RELAXED);
+  long long newUsed;
+  do {
+    newUsed = used + (long long)numBytes;
+    if (limit != 0 && newUsed > (long long)limit) {
+      __sync_fetch_and_add(&s_refusedReservations, 1);
+      return False;
+    }
+  } while (!__atomic_compare_exchange_n(&s_usedBytes, &used, newUsed, True, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+  notePeak(newUsed);
+  return True;
+}
+
+void MemoryBudget::charge(long long numBytesDelta) {
+  long long newUsed = __atomic_add_fetch(&s_usedBytes, numBytesDelta, __ATOMIC_RELAXED);
+  if (numBytesDelta > 0) notePeak(newUsed);
+}
+
+void MemoryBudget::getStats(MemoryBudgetStats& stats) {
+  long long used = __atomic_load_n(&s_usedBytes, __ATOMIC_RELAXED);
+  stats.limitBytes = __atomic_load_n(&s_limitBytes, __ATOMIC_RELAXED);
+  stats.usedBytes = used > 0 ? (unsigned long long)used : 0;
+  stats.peakBytes = (unsigned long long)__atomic_load_n(&s_peakBytes, __ATOMIC_RELAXED);
+  stats.refusedReservations = __atomic_load_n(&s_refusedReservations, __ATOMIC_RELAXED);
+}
+
+void MemoryBudget::packetMemoryFunc(void* /*clientData*/, int numBytesDelta) {
+  charge(numBytesDelta);
+}
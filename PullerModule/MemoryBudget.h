@@ -0,0 +1,32 @@
+/**
+ * @file MemoryBudget.h
+ * @brief  Process-wide accounting of the memory used for stream buffers
+ * @author lizhiyong0804319@gmail.com
+ * @version 1.0
+ * @date 2026-10-19
+ */
+
+#ifndef MEMORY_BUDGET_H
+#define MEMORY_BUDGET_H
+
+#include "liveMedia.hh"
+#include "API_PullerTypes.h"
+
+// Every stream buffer (sink receive buffers, RTP packet buffers and RTSP response buffers) is
+// counted here.  Buffers that are optional - a new sink, or a larger buffer for an existing
+// one - are "reserve()"d, and refused if they'd take us over the limit; buffers that can't be
+// refused (e.g., a packet buffer that's needed to receive the next packet) are just "charge()"d.
+// All updates are lock-free, so this may be used from every event loop thread at once.
+
+class MemoryBudget {
+public:
+  static void setLimit(unsigned long long limitBytes); // 0 means "no limit" (the default)
+  static Boolean reserve(unsigned long long numBytes);
+  static void charge(long long numBytesDelta); // negative "numBytesDelta" releases memory
+  static void getStats(MemoryBudgetStats& stats);
+
+  // An "RTPSource::BufferMemoryFunc", for charging packet buffers:
+  static void packetMemoryFunc(void* clientData, int numBytesDelta);
+};
+
+#endif
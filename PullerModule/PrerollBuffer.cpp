@@ -0,0 +1,85 @@
+/**
+ * @file PrerollBuffer.cpp
+ * @brief  1.0
+ *		implementation of PrerollBuffer
+ * @author lizhiyong0804319@gmail.com
+ * @version 1.0
+ * @date 2026-10-19
+ */
+
+#include "PrerollBuffer.h"
+
+PrerollBuffer::PrerollBuffer(unsigned maxSeconds, unsigned maxBytes)
+  : m_maxDuration((u_int64_t)maxSeconds*1000000), m_maxBytes(maxBytes), m_numBytes(0) {
+}
+
+PrerollBuffer::~PrerollBuffer() {
+  clear();
+}
+
+void PrerollBuffer::addFrame(PullerFrame* frame) {
+  // (A GOP begins with its parameter sets, if any, rather than at its IDR picture; see "H264GOPBoundaryDetector".)
+  if (frame->beginsH264GOP(m_gopBoundaryDetector)) {
+    Gop gop;
+    gop.numFrames = 0;
+    gop.numBytes = 0;
+    gop.startPTS = frame->monoPTS();
+    m_gops.push_back(gop);
+  }
+  if (m_gops.empty()) return; // we're still waiting for the first GOP
+
+  frame->addRef();
+  m_frames.push_back(frame);
+  m_numBytes += frame->size();
+  ++m_gops.back().numFrames;
+  m_gops.back().numBytes += frame->size();
+
+  // Discard old GOPs that we no longer need (or can't afford):
+  u_int64_t newestPTS = frame->monoPTS();
+  while (m_gops.size() > 1
+	 && (m_gops[1].startPTS + m_maxDuration <= newestPTS || (m_maxBytes > 0 && m_numBytes > m_maxBytes))) {
+    discardOldestGop();
+  }
+  if (m_maxBytes > 0 && m_numBytes > m_maxBytes) {
+    // The current GOP is too big for us by itself; give up on it:
+    clear();
+  }
+}
+
+void PrerollBuffer::discardOldestGop() {
+  Gop& oldest = m_gops.front();
+  for (unsigned i = 0; i < oldest.numFrames; ++i) {
+    m_frames.front()->release();
+    m_frames.pop_front();
+  }
+  m_numBytes -= oldest.numBytes;
+  m_gops.pop_front();
+}
+
+void PrerollBuffer::clear() {
+  for (std::deque<PullerFrame*>::iterator it = m_frames.begin(); it != m_frames.end(); ++it) {
+    (*it)->release();
+  }
+  m_frames.clear();
+  m_gops.clear();
+  m_numBytes = 0;
+}
+
+void PrerollBuffer::copyFrames(std::vector<PullerFrame*>& frames, unsigned seconds) const {
+  if (m_frames.empty()) return;
+
+  // Find the GOP to begin with, and the index of its first frame:
+  u_int64_t newestPTS = m_frames.back()->monoPTS();
+  u_int64_t duration = (u_int64_t)seconds*1000000;
+  unsigned firstFrame = 0, gopStart = 0;
+  for (std::deque<Gop>::const_iterator it = m_gops.begin(); it != m_gops.end(); ++it) {
+    if (it->startPTS + duration > newestPTS) break; // this GOP (and those after it) began too recently
+    firstFrame = gopStart;
+    gopStart += it->numFrames;
+  }
+
+  for (std::deque<PullerFrame*>::const_iterator it = m_frames.begin() + firstFrame; it != m_frames.end(); ++it) {
+    (*it)->addRef();
+    frames.push_back(*it);
+  }
+}
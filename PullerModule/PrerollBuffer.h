@@ -0,0 +1,57 @@
+/**
+ * @file PrerollBuffer.h
+ * @brief  The last few seconds of a stream's frames, kept for event-triggered recording
+ * @author lizhiyong0804319@gmail.com
+ * @version 1.0
+ * @date 2026-10-19
+ */
+
+#ifndef PREROLL_BUFFER_H
+#define PREROLL_BUFFER_H
+
+#include "PullerFrame.h"
+#include "H264VideoRTPSource.hh"
+
+#include <deque>
+#include <vector>
+
+// Like "GopCache", but holds whole GOPs going back (at least) "maxSeconds" from the newest
+// frame, so that a recording that's triggered now can begin some seconds in the past, at a key frame.
+// The oldest GOP is discarded once the GOPs after it cover "maxSeconds" by themselves, or
+// whenever the buffer holds more than "maxBytes" (0 means "no limit").  A single GOP that's larger
+// than "maxBytes" empties the buffer until the next GOP begins.
+
+class PrerollBuffer {
+public:
+  PrerollBuffer(unsigned maxSeconds, unsigned maxBytes);
+  ~PrerollBuffer();
+
+  void addFrame(PullerFrame* frame); // takes its own reference to "frame"
+  void clear();
+
+  // Appends (new references to) the frames from the newest GOP that begins at least "seconds"
+  // before the newest frame (or else from the oldest GOP), oldest first:
+  void copyFrames(std::vector<PullerFrame*>& frames, unsigned seconds) const;
+
+  unsigned numBytes() const { return m_numBytes; }
+  unsigned numFrames() const { return (unsigned)m_frames.size(); }
+
+private:
+  struct Gop {
+    unsigned numFrames;
+    unsigned numBytes;
+    u_int64_t startPTS; // uSeconds
+  };
+
+  void discardOldestGop();
+
+private:
+  u_int64_t m_maxDuration; // uSeconds
+  unsigned m_maxBytes;
+  unsigned m_numBytes;
+  H264GOPBoundaryDetector m_gopBoundaryDetector; // as used by "GopCache"
+  std::deque<PullerFrame*> m_frames;
+  std::deque<Gop> m_gops;
+};
+
+#endif
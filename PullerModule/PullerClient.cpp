@@ -1,8 +1,10 @@
 #include "PullerClient.h"
 #include "PullerSink.h"
+#include "MemoryBudget.h"
 
 #include "RTPSource.hh"
 
+#include <errno.h>
 #include <string>
 using namespace std;
 
@@ -31,6 +33,7 @@ void PullerClient::processAfterDescribe(RTSPClient* rtspClient, int resultCode,
     }
 
 	PullerClient* client = dynamic_cast<PullerClient*>(rtspClient);
+	client->accountResponseBuffer(); // (a large SDP description may have grown it)
 	client->parseMediaAttr(resultString);
 	client->resetUrl();
     
@@ -84,7 +87,13 @@ void PullerClient::setupNextSubsession(RTSPClient* rtspClient) {
 #endif
       // Continue setting up this subsession, by sending a RTSP "SETUP" command:
 	  PullerClient* client = dynamic_cast<PullerClient*>(rtspClient);
-      rtspClient->sendSetupCommand(*scs.subsession, processAfterSetup, false, client->usingTcpData());//tcp or udp
+	  client->applyPacketBufferSize(*scs.subsession); // (before any packet arrives)
+	  client->applyReorderPolicy(*scs.subsession);
+	  client->applyRtcpFeedback(*scs.subsession);
+	  client->applyFecRecovery(*scs.subsession);
+	  client->applyReceiveCoalescing(*scs.subsession);
+      rtspClient->sendSetupCommand(*scs.subsession, processAfterSetup, false, client->usingTcpData(),
+				   client->usingMulticastData());//tcp, udp or multicast
     }
     return;
   }
@@ -120,27 +129,44 @@ void PullerClient::processAfterSetup(RTSPClient* rtspClient, int resultCode, cha
     // (This will prepare the data sink to receive data; the actual flow of data from the client won't start happening until later,
     // after we've sent a RTSP "PLAY" command.)
 
-    scs.subsession->sink = PullerSink::createNew(env, *scs.subsession, rtspClient->url());
+	PullerClient* client = dynamic_cast<PullerClient*>(rtspClient);
+    scs.subsession->sink = PullerSink::createNew(env, *scs.subsession, rtspClient->url(), client->frameBufferSize());
       // perhaps use your own custom "MediaSink" subclass instead
     if (scs.subsession->sink == NULL) {
 #ifdef DEBUG_PRINT
       env << *rtspClient << "Failed to create a data sink for the \"" << *scs.subsession
 	  << "\" subsession: " << env.getResultMsg() << "\n";
 #endif
+	  client->reportState(-ENOMEM, env.getResultMsg()); // (the memory budget is exhausted)
 	  break;
     }
 	PullerSink* sink = dynamic_cast<PullerSink*>(scs.subsession->sink);
-	PullerClient* client = dynamic_cast<PullerClient*>(rtspClient);
 	sink->setCallbackFunc(client->getCallbackFunc(), client->getCallbackFuncParam());
+	sink->setFrameDistributor(&client->frameDistributor(), client->retRtpPkt());
+	if (strcmp(scs.subsession->codecName(), "H264") == 0) {
+		client->frameDistributor().setH264ParameterSets(scs.subsession->fmtp_spropparametersets());
+	} else if (strcmp(scs.subsession->codecName(), "MPEG4-GENERIC") == 0) {
+		client->frameDistributor().setAACConfig(scs.subsession->fmtp_config());
+	}
 
-	RTPSource* source = dynamic_cast<RTPSource*>(scs.subsession->readSource());
-	source->curPacketMarkerBit(client->retRtpPkt());
+	// (For some codecs - e.g. "MP2T" - the read source is a framer that's fed by the RTP source.)
+	RTPSource* rtpSource = scs.subsession->rtpSource();
+	if (rtpSource != NULL) rtpSource->curPacketMarkerBit(client->retRtpPkt());
+	client->applyFrameFilter(*scs.subsession);
+	if (client->tsDemux() && !client->retRtpPkt() && strcmp(scs.subsession->codecName(), "MP2T") == 0) {
+		sink->enableTsDemux();
+	}
+	// (Whole RTP packets, and TS packets that are to be demultiplexed, are still copied into the sink's buffer.)
+	if (client->scatterDelivery() && !client->retRtpPkt()) sink->enableScatterDelivery(*scs.subsession->readSource());
+	client->applyAsyncDelivery(*sink); // (after "enableTsDemux()", which changes what the sink delivers)
+	sink->setReceiveStats(client->m_receiveStats);
+	if (!client->usingTcpData()) sink->enableSocketBufferTuning();
 
 #ifdef DEBUG_PRINT
     env << *rtspClient << "Created a data sink for the \"" << *scs.subsession << "\" subsession\n";
 #endif
 	scs.subsession->miscPtr = rtspClient; // a hack to let subsession handle functions get the "RTSPClient" from the subsession 
-    scs.subsession->sink->startPlaying(*source,
+    scs.subsession->sink->startPlaying(*scs.subsession->readSource(),
 				       subsessionAfterPlaying, scs.subsession);
     // Also set a handler to be called if a RTCP "BYE" arrives for this subsession:
     if (scs.subsession->rtcpInstance() != NULL) {
@@ -237,51 +263,436 @@ void PullerClient::streamTimerHandler(void* clientData) {
 
 // Implementation of "PullerClient":
 
-PullerClient* PullerClient::createNew(UsageEnvironment& env, char const* rtspURL,
+#define PULLER_RESPONSE_BUFFER_SIZE 4096
+#define PULLER_MAX_RESPONSE_BUFFER_SIZE 65536
+#define AUTO_PACKET_BUFFER_SIZE 2048 // enough for any packet on a 1500-byte MTU
+#define AUTO_MAX_PACKET_BUFFER_SIZE 65536
+#define DEFAULT_REORDER_TIME 100000 // uSeconds (as in "MultiFramedRTPSource")
+#define DEFAULT_MAX_REORDER_TIME 500000 // uSeconds
+
+// The arguments of "createNew()", when it's called from outside the loop thread:
+struct CreateArgs {
+	PullerLoop* loop;
+	char const* rtspURL;
+	int verbosityLevel;
+	char const* applicationName;
+	portNumBits tunnelOverHTTPPortNum;
+	PullerClient* client; // the result
+};
+
+PullerClient* PullerClient::createNew(PullerLoop& loop, char const* rtspURL,
 					int verbosityLevel, char const* applicationName, portNumBits tunnelOverHTTPPortNum) {
-  return new PullerClient(env, rtspURL, verbosityLevel, applicationName, tunnelOverHTTPPortNum);
+  if (loop.isLoopThread()) return new PullerClient(loop, rtspURL, verbosityLevel, applicationName, tunnelOverHTTPPortNum);
+
+  // Constructing a "RTSPClient" uses the loop's "UsageEnvironment" (which the loop thread is using
+  // at the same time), so have the loop thread do it:
+  CreateArgs args;
+  args.loop = &loop;
+  args.rtspURL = rtspURL;
+  args.verbosityLevel = verbosityLevel;
+  args.applicationName = applicationName;
+  args.tunnelOverHTTPPortNum = tunnelOverHTTPPortNum;
+  args.client = NULL;
+  if (loop.postAndWait(createCommand, &args) != 0) return NULL;
+  return args.client;
+}
+
+void PullerClient::createCommand(void* clientData) {
+  CreateArgs* args = (CreateArgs*)clientData;
+  args->client = new PullerClient(*args->loop, args->rtspURL, args->verbosityLevel, args->applicationName,
+				  args->tunnelOverHTTPPortNum);
+}
+
+PullerClient* PullerClient::createNew(PullerLoop& loop, PullerArena& arena, unsigned slot,
+					PullerStreamConfig const& config) {
+  PullerClient* client = new (arena, slot) PullerClient(loop, NULL, 0, "PullerClient", 0);
+  client->m_callbackFunc = config.cb;
+  client->m_cbParam = config.cbParam;
+  client->m_frameBufferSize = config.frameBufferSize;
+  client->m_packetBufferSize = config.packetBufferSize;
+  // (We're already running in the loop thread, so there's no need to post a command:)
+  client->doStartStream(config.url, config.connType, config.username != NULL ? config.username : "",
+			config.password != NULL ? config.password : "", config.retRtpPkt);
+  return client;
 }
 
-PullerClient::PullerClient(UsageEnvironment& env, char const* rtspURL,
+PullerClient::PullerClient(PullerLoop& loop, char const* rtspURL,
 			     int verbosityLevel, char const* applicationName, portNumBits tunnelOverHTTPPortNum)
-  : RTSPClient(env,rtspURL, verbosityLevel, applicationName, tunnelOverHTTPPortNum), m_running(0), m_tid(0), m_callbackFunc(NULL), m_cbParam(NULL), m_retRtpPkt(false), m_url(""), m_connType(RTP_OVER_TCP) {
+  : RTSPClient(loop.envir(),rtspURL, verbosityLevel, applicationName, tunnelOverHTTPPortNum), m_loop(loop), m_callbackFunc(NULL), m_cbParam(NULL), m_retRtpPkt(false), m_url(""), m_connType(RTP_OVER_TCP),
+    m_filterMode(FRAME_FILTER_NONE), m_gopInterval(1), m_tsDemux(False), m_scatterDelivery(False),
+    m_asyncQueueSize(0), m_asyncPolicy(ASYNC_DROP_OLDEST),
+    m_frameBufferSize(0), m_packetBufferSize(0),
+    m_reorderPolicy(REORDER_FIXED), m_reorderMinTime(0), m_reorderMaxTime(0), m_rtcpFeedback(0), m_fecRecovery(False), m_fecPayloadFormat(0), m_receiveCoalescing(False), m_responseBufferBytes(0) {
+  memset(&m_asyncStats, 0, sizeof m_asyncStats);
+  memset(&m_receiveStats, 0, sizeof m_receiveStats);
+
+  // Most RTSP responses are small, so start with a small response buffer, and let it grow as needed:
+  setResponseBufferSize(PULLER_RESPONSE_BUFFER_SIZE, PULLER_MAX_RESPONSE_BUFFER_SIZE);
+  accountResponseBuffer();
 }
 
 PullerClient::~PullerClient() {
+  MemoryBudget::charge(-(long long)m_responseBufferBytes);
 }
 
+void PullerClient::accountResponseBuffer() {
+  unsigned bufferBytes = curResponseBufferSize();
+  MemoryBudget::charge((long long)bufferBytes - (long long)m_responseBufferBytes);
+  m_responseBufferBytes = bufferBytes;
+}
+
+// The arguments of the commands that are posted to the event loop thread:
+
+struct CallbackArgs {
+	PullerClient* client;
+	PullerCallback cbFunc;
+	void* cbParam;
+};
+
+struct FrameFilterArgs {
+	PullerClient* client;
+	FrameFilterMode mode;
+	unsigned gopInterval;
+};
+
+struct TsDemuxArgs {
+	PullerClient* client;
+	Boolean tsDemux;
+};
+
+struct ScatterDeliveryArgs {
+	PullerClient* client;
+	Boolean scatterDelivery;
+};
+
+struct AsyncDeliveryArgs {
+	PullerClient* client;
+	unsigned queueSize;
+	AsyncOverflowPolicy policy;
+};
+
+struct BufferSizesArgs {
+	PullerClient* client;
+	unsigned frameBufferSize;
+	unsigned packetBufferSize;
+};
+
+struct ReorderPolicyArgs {
+	PullerClient* client;
+	ReorderPolicy policy;
+	unsigned minUSeconds, maxUSeconds;
+};
+
+struct RtcpFeedbackArgs {
+	PullerClient* client;
+	unsigned feedbackTypes;
+};
+
+struct FecRecoveryArgs {
+	PullerClient* client;
+	Boolean fecRecovery;
+	unsigned char fecPayloadFormat;
+};
+
+struct ReceiveCoalescingArgs {
+	PullerClient* client;
+	Boolean receiveCoalescing;
+};
+
+struct StartStreamArgs {
+	PullerClient* client;
+	std::string url;
+	int connType;
+	std::string username;
+	std::string password;
+	Boolean retRtpPkt;
+};
+
 int PullerClient::setCallbackFunc(PullerCallback cbFunc, void* cbParam)
 {
-	m_callbackFunc = cbFunc;
-	m_cbParam = cbParam;
-	return 0;
+	CallbackArgs* args = new CallbackArgs;
+	args->client = this;
+	args->cbFunc = cbFunc;
+	args->cbParam = cbParam;
+	return m_loop.post(setCallbackCommand, args);
+}
+
+void PullerClient::setCallbackCommand(void* clientData)
+{
+	CallbackArgs* args = (CallbackArgs*)clientData;
+	args->client->m_callbackFunc = args->cbFunc;
+	args->client->m_cbParam = args->cbParam;
+	delete args;
+}
+
+int PullerClient::setFrameFilter(FrameFilterMode mode, unsigned gopInterval)
+{
+	FrameFilterArgs* args = new FrameFilterArgs;
+	args->client = this;
+	args->mode = mode;
+	args->gopInterval = gopInterval;
+	return m_loop.post(setFrameFilterCommand, args);
+}
+
+void PullerClient::setFrameFilterCommand(void* clientData)
+{
+	FrameFilterArgs* args = (FrameFilterArgs*)clientData;
+	PullerClient* client = args->client;
+	client->m_filterMode = args->mode;
+	client->m_gopInterval = args->gopInterval;
+	delete args;
+
+	// Also apply the new policy to any subsession that's already playing:
+	if (client->fScs.session != NULL) {
+		MediaSubsessionIterator iter(*client->fScs.session);
+		MediaSubsession* subsession;
+		while ((subsession = iter.next()) != NULL) {
+			if (subsession->sink != NULL) client->applyFrameFilter(*subsession);
+		}
+	}
+}
+
+int PullerClient::setTsDemux(Boolean tsDemux)
+{
+	TsDemuxArgs* args = new TsDemuxArgs;
+	args->client = this;
+	args->tsDemux = tsDemux;
+	return m_loop.post(setTsDemuxCommand, args);
+}
+
+void PullerClient::setTsDemuxCommand(void* clientData)
+{
+	TsDemuxArgs* args = (TsDemuxArgs*)clientData;
+	args->client->m_tsDemux = args->tsDemux;
+	delete args;
+}
+
+int PullerClient::setScatterDelivery(Boolean scatterDelivery)
+{
+	ScatterDeliveryArgs* args = new ScatterDeliveryArgs;
+	args->client = this;
+	args->scatterDelivery = scatterDelivery;
+	return m_loop.post(setScatterDeliveryCommand, args);
+}
+
+void PullerClient::setScatterDeliveryCommand(void* clientData)
+{
+	ScatterDeliveryArgs* args = (ScatterDeliveryArgs*)clientData;
+	args->client->m_scatterDelivery = args->scatterDelivery;
+	delete args;
+}
+
+int PullerClient::setBufferSizes(unsigned frameBufferSize, unsigned packetBufferSize)
+{
+	BufferSizesArgs* args = new BufferSizesArgs;
+	args->client = this;
+	args->frameBufferSize = frameBufferSize;
+	args->packetBufferSize = packetBufferSize;
+	return m_loop.post(setBufferSizesCommand, args);
+}
+
+void PullerClient::setBufferSizesCommand(void* clientData)
+{
+	BufferSizesArgs* args = (BufferSizesArgs*)clientData;
+	args->client->m_frameBufferSize = args->frameBufferSize;
+	args->client->m_packetBufferSize = args->packetBufferSize;
+	delete args;
+}
+
+void PullerClient::applyPacketBufferSize(MediaSubsession& subsession) const
+{
+	RTPSource* rtpSource = subsession.rtpSource();
+	if (rtpSource == NULL) return;
+
+	// A fixed size is used as given; the automatic size starts at a (large) MTU, and doubles whenever a packet fills it:
+	if (m_packetBufferSize != 0) {
+		rtpSource->setPacketBufferSize(m_packetBufferSize, m_packetBufferSize);
+	} else {
+		rtpSource->setPacketBufferSize(AUTO_PACKET_BUFFER_SIZE, AUTO_MAX_PACKET_BUFFER_SIZE);
+	}
+	rtpSource->setBufferMemoryFunc(MemoryBudget::packetMemoryFunc, NULL);
+}
+
+int PullerClient::setReorderPolicy(ReorderPolicy policy, unsigned minUSeconds, unsigned maxUSeconds)
+{
+	ReorderPolicyArgs* args = new ReorderPolicyArgs;
+	args->client = this;
+	args->policy = policy;
+	args->minUSeconds = minUSeconds;
+	args->maxUSeconds = maxUSeconds;
+	return m_loop.post(setReorderPolicyCommand, args);
+}
+
+void PullerClient::setReorderPolicyCommand(void* clientData)
+{
+	ReorderPolicyArgs* args = (ReorderPolicyArgs*)clientData;
+	args->client->m_reorderPolicy = args->policy;
+	args->client->m_reorderMinTime = args->minUSeconds;
+	args->client->m_reorderMaxTime = args->maxUSeconds;
+	delete args;
+}
+
+void PullerClient::applyReorderPolicy(MediaSubsession& subsession) const
+{
+	RTPSource* rtpSource = subsession.rtpSource();
+	if (rtpSource == NULL) return;
+
+	MultiFramedRTPSource* multiFramedSource = dynamic_cast<MultiFramedRTPSource*>(rtpSource);
+	if (m_reorderPolicy == REORDER_ADAPTIVE && multiFramedSource != NULL) {
+		multiFramedSource->setAdaptivePacketReorderingThreshold(m_reorderMinTime,
+			m_reorderMaxTime != 0 ? m_reorderMaxTime : DEFAULT_MAX_REORDER_TIME);
+	} else if (m_reorderPolicy == REORDER_LOW_LATENCY) {
+		rtpSource->setPacketReorderingThresholdTime(0); // don't wait for out-of-order packets at all
+	} else if (m_reorderPolicy == REORDER_FIXED) {
+		rtpSource->setPacketReorderingThresholdTime(m_reorderMaxTime != 0 ? m_reorderMaxTime : DEFAULT_REORDER_TIME);
+	}
+	// (Otherwise, the source can't adapt, so it keeps its default threshold.)
+}
+
+int PullerClient::setRtcpFeedback(unsigned feedbackTypes)
+{
+	RtcpFeedbackArgs* args = new RtcpFeedbackArgs;
+	args->client = this;
+	args->feedbackTypes = feedbackTypes;
+	return m_loop.post(setRtcpFeedbackCommand, args);
+}
+
+void PullerClient::setRtcpFeedbackCommand(void* clientData)
+{
+	RtcpFeedbackArgs* args = (RtcpFeedbackArgs*)clientData;
+	args->client->m_rtcpFeedback = args->feedbackTypes;
+	delete args;
+}
+
+void PullerClient::applyRtcpFeedback(MediaSubsession& subsession) const
+{
+	RTCPInstance* rtcpInstance = subsession.rtcpInstance();
+	if (rtcpInstance == NULL || m_rtcpFeedback == 0) return;
+
+	unsigned feedbackTypes = 0;
+	if (m_rtcpFeedback & RTCP_FEEDBACK_NACK) feedbackTypes |= RTCPInstance::FEEDBACK_NACK;
+	if (m_rtcpFeedback & RTCP_FEEDBACK_PLI) feedbackTypes |= RTCPInstance::FEEDBACK_PLI;
+	if (m_rtcpFeedback & RTCP_FEEDBACK_FIR) feedbackTypes |= RTCPInstance::FEEDBACK_FIR;
+	rtcpInstance->enableFeedback(feedbackTypes);
 }
 
-int PullerClient::startStream(const char* url, int connType, const char* username, const char* password, int reconn, Boolean retRtpPkt) 
+int PullerClient::setFecRecovery(Boolean fecRecovery, unsigned char fecPayloadFormat)
+{
+	FecRecoveryArgs* args = new FecRecoveryArgs;
+	args->client = this;
+	args->fecRecovery = fecRecovery;
+	args->fecPayloadFormat = fecPayloadFormat;
+	return m_loop.post(setFecRecoveryCommand, args);
+}
+
+void PullerClient::setFecRecoveryCommand(void* clientData)
+{
+	FecRecoveryArgs* args = (FecRecoveryArgs*)clientData;
+	args->client->m_fecRecovery = args->fecRecovery;
+	args->client->m_fecPayloadFormat = args->fecPayloadFormat;
+	delete args;
+}
+
+void PullerClient::applyFecRecovery(MediaSubsession& subsession) const
+{
+	if (!m_fecRecovery) return;
+	MultiFramedRTPSource* rtpSource = dynamic_cast<MultiFramedRTPSource*>(subsession.rtpSource());
+	if (rtpSource == NULL) return;
+
+	unsigned char fecPayloadFormat = m_fecPayloadFormat != 0 ? m_fecPayloadFormat : subsession.fecPayloadFormat();
+	if (fecPayloadFormat > 127 || fecPayloadFormat == subsession.rtpPayloadFormat()) return; // no FEC stream
+	rtpSource->enableFEC(fecPayloadFormat);
+}
+
+int PullerClient::setReceiveCoalescing(Boolean receiveCoalescing)
+{
+	ReceiveCoalescingArgs* args = new ReceiveCoalescingArgs;
+	args->client = this;
+	args->receiveCoalescing = receiveCoalescing;
+	return m_loop.post(setReceiveCoalescingCommand, args);
+}
+
+void PullerClient::setReceiveCoalescingCommand(void* clientData)
+{
+	ReceiveCoalescingArgs* args = (ReceiveCoalescingArgs*)clientData;
+	args->client->m_receiveCoalescing = args->receiveCoalescing;
+	delete args;
+}
+
+void PullerClient::applyReceiveCoalescing(MediaSubsession& subsession) const
+{
+	if (!m_receiveCoalescing || usingTcpData()) return;
+
+	// (After "applyPacketBufferSize()", so that the coalescing buffer is charged to the memory budget.)
+	MultiFramedRTPSource* rtpSource = dynamic_cast<MultiFramedRTPSource*>(subsession.rtpSource());
+	if (rtpSource != NULL) rtpSource->enableReceiveCoalescing();
+}
+
+void PullerClient::applyFrameFilter(MediaSubsession& subsession) const
+{
+	// The filter is evaluated per RTP packet, inside the payload format's source:
+	H264VideoRTPSource* source = dynamic_cast<H264VideoRTPSource*>(subsession.readSource());
+	if (source == NULL) return;
+
+	H264VideoRTPSource::FrameFilterMode mode = H264VideoRTPSource::FILTER_NONE;
+	if (m_filterMode == FRAME_FILTER_KEYFRAMES) mode = H264VideoRTPSource::FILTER_KEYFRAMES;
+	else if (m_filterMode == FRAME_FILTER_GOPS) mode = H264VideoRTPSource::FILTER_GOPS;
+	source->setFrameFilter(mode, m_gopInterval);
+}
+
+int PullerClient::startStream(const char* url, int connType, const char* username, const char* password, int /*reconn*/, Boolean retRtpPkt) 
+{
+	if (url == NULL) return -1;
+
+	StartStreamArgs* args = new StartStreamArgs;
+	args->client = this;
+	args->url = url;
+	args->connType = connType;
+	args->username = username != NULL ? username : "";
+	args->password = password != NULL ? password : "";
+	args->retRtpPkt = retRtpPkt;
+	return m_loop.post(startStreamCommand, args);
+}
+
+void PullerClient::startStreamCommand(void* clientData)
+{
+	StartStreamArgs* args = (StartStreamArgs*)clientData;
+	args->client->doStartStream(args->url.c_str(), args->connType, args->username.c_str(), args->password.c_str(), args->retRtpPkt);
+	delete args;
+}
+
+void PullerClient::doStartStream(const char* url, int connType, const char* username, const char* password, Boolean retRtpPkt)
 {
-  m_running = 0x00;
   m_retRtpPkt = retRtpPkt;
   m_url = url;
   m_connType = connType;
   Authenticator auth(username, password);
 
   char authUrl[1024] = {0};
-  ::sprintf(authUrl, "%s&token=%s", url, username);
+  ::snprintf(authUrl, sizeof authUrl, "%s&token=%s", url, username);
   setBaseURL(authUrl);
 
   sendDescribeCommand(processAfterDescribe, &auth); 
-
-  return pthread_create(&m_tid, NULL, entryPoint, this);
 }
 
 int PullerClient::closeStream() {
-	
-	teardownStream(0, NULL);
+	return m_loop.post(closeStreamCommand, this);
+}
+
+void PullerClient::closeStreamCommand(void* clientData) {
+	((PullerClient*)clientData)->teardownStream(0, NULL);
+}
+
+int PullerClient::release() {
+	return m_loop.post(releaseCommand, this);
+}
 
-	m_running = 0xFF;
-	pthread_join(m_tid, NULL);
+int PullerClient::releaseAndWait() {
+	return m_loop.postAndWait(releaseCommand, this);
+}
 
-	return 0;
+void PullerClient::releaseCommand(void* clientData) {
+	Medium::close((PullerClient*)clientData);
 }
 
 void PullerClient::teardownStream(int resultCode, char* resultString)
@@ -313,21 +724,17 @@ void PullerClient::teardownStream(int resultCode, char* resultString)
 		
 	 }
 		
-	if (m_callbackFunc != NULL && resultCode != 0)
-	{
-		PullerState pullerState;
-		pullerState.resultCode = resultCode;
-		pullerState.resultString = resultString;
-		m_callbackFunc(CB_PULLER_STATE, &pullerState, m_cbParam);
-	}
-	
+	if (resultCode != 0) reportState(resultCode, resultString);
 }
 
-void* PullerClient::entryPoint(void* param){	PullerClient* thd = (PullerClient *)param;	thd->run();}
-
-void PullerClient::run()
+void PullerClient::reportState(int resultCode, char const* resultString)
 {
-	envir().taskScheduler().doEventLoop(&m_running);
+	if (m_callbackFunc == NULL) return;
+
+	PullerState pullerState;
+	pullerState.resultCode = resultCode;
+	pullerState.resultString = (char*)resultString;
+	m_callbackFunc(CB_PULLER_STATE, &pullerState, m_cbParam);
 }
 
 void PullerClient::parseMediaAttr(char* sdpString) const
@@ -369,6 +776,14 @@ void StreamClientState::release()
 	    UsageEnvironment& env = session->envir(); // alias
 
 	    env.taskScheduler().unscheduleDelayedTask(streamTimerTask);
+
+	    // Close any sinks that are still open (if the stream was never closed), before their sources:
+	    MediaSubsessionIterator sessionIter(*session);
+	    MediaSubsession* subsession;
+	    while ((subsession = sessionIter.next()) != NULL) {
+	      Medium::close(subsession->sink);
+	      subsession->sink = NULL;
+	    }
 	    Medium::close(session);
 	}
 
@@ -378,3 +793,45 @@ void StreamClientState::release()
 StreamClientState::~StreamClientState() {
 	release();
 }
+
+int PullerClient::setAsyncDelivery(unsigned queueSize, AsyncOverflowPolicy policy)
+{
+	AsyncDeliveryArgs* args = new AsyncDeliveryArgs;
+	args->client = this;
+	args->queueSize = queueSize;
+	args->policy = policy;
+	return m_loop.post(setAsyncDeliveryCommand, args);
+}
+
+void PullerClient::setAsyncDeliveryCommand(void* clientData)
+{
+	AsyncDeliveryArgs* args = (AsyncDeliveryArgs*)clientData;
+	args->client->m_asyncQueueSize = args->queueSize;
+	args->client->m_asyncPolicy = args->policy;
+	delete args;
+}
+
+void PullerClient::applyAsyncDelivery(PullerSink& sink)
+{
+	if (m_asyncQueueSize > 0 && m_callbackFunc != NULL) {
+		sink.setAsyncDelivery(m_asyncQueueSize, m_asyncPolicy, m_asyncStats);
+	}
+}
+
+void PullerClient::getReceiveStats(ReceiveStats& stats) const
+{
+	stats.packetsReceived = __atomic_load_n(&m_receiveStats.packetsReceived, __ATOMIC_RELAXED);
+	stats.packetsLost = __atomic_load_n(&m_receiveStats.packetsLost, __ATOMIC_RELAXED);
+	stats.kernelDrops = __atomic_load_n(&m_receiveStats.kernelDrops, __ATOMIC_RELAXED);
+	stats.socketBufferSize = __atomic_load_n(&m_receiveStats.socketBufferSize, __ATOMIC_RELAXED);
+	stats.fecRecovered = __atomic_load_n(&m_receiveStats.fecRecovered, __ATOMIC_RELAXED);
+}
+
+void PullerClient::getAsyncStats(AsyncDeliveryStats& stats) const
+{
+	stats.framesDelivered = __atomic_load_n(&m_asyncStats.framesDelivered, __ATOMIC_RELAXED);
+	stats.droppedOldest = __atomic_load_n(&m_asyncStats.droppedOldest, __ATOMIC_RELAXED);
+	stats.droppedNonKeyFrames = __atomic_load_n(&m_asyncStats.droppedNonKeyFrames, __ATOMIC_RELAXED);
+	stats.blockedCount = __atomic_load_n(&m_asyncStats.blockedCount, __ATOMIC_RELAXED);
+	stats.queueDepth = __atomic_load_n(&m_asyncStats.queueDepth, __ATOMIC_RELAXED);
+}
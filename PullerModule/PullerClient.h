@@ -12,6 +12,11 @@
 #include "liveMedia.hh"
 #include "BasicUsageEnvironment.hh"
 #include "API_PullerModule.h"
+#include "FrameDistributor.h"
+#include "PullerLoop.h"
+#include "utils/PullerArena.h"
+
+class PullerSink; // forward
 
 // Define a class to hold per-stream state that we maintain throughout each stream's lifetime:
 
@@ -34,30 +39,80 @@ public:
 // showing how to play multiple streams, concurrently, we can't do that.  Instead, we have to have a separate "StreamClientState"
 // structure for each "RTSPClient".  To do this, we subclass "RTSPClient", and add a "StreamClientState" field to the subclass:
 
-#include <pthread.h>
 #include <string>
 
+// The public control functions below may be called from any thread: each of them just posts a
+// command to the client's event loop thread, which owns all of the client's state.
+// The exception is our "FrameDistributor" (the GOP cache, pre-roll buffer, subscribers, reader,
+// recorders, HLS segmenter and shared-memory output), whose functions are called directly, from
+// any thread: it never touches the "UsageEnvironment", and it guards its own state (with its own
+// mutexes, or - for the reader and shared-memory output, which the loop thread uses without
+// locking - with pointers that are set once and read atomically).  Calling it directly also lets
+// these functions return their results, and lets "unsubscribe()" wait for a subscriber's thread
+// without holding up the loop.
+
 class PullerClient: public RTSPClient {
 public:
-  static PullerClient* createNew(UsageEnvironment& env, char const* rtspURL,
+  static PullerClient* createNew(PullerLoop& loop, char const* rtspURL,
 				  int verbosityLevel = 0,
 				  char const* applicationName = NULL,
 				  portNumBits tunnelOverHTTPPortNum = 0);
+      // (if called from another thread, this has "loop"s thread construct the client, and waits for it)
+  static PullerClient* createNew(PullerLoop& loop, PullerArena& arena, unsigned slot,
+				  PullerStreamConfig const& config);
+      // creates the client in "arena"s "slot", and starts its stream; must be called from "loop"s thread
+  PullerLoop& loop() const { return m_loop; }
+
+  // Clients that were created in an arena give their slot back to it, rather than to the heap:
+  static void* operator new(size_t size) { return PullerArena::allocateStandalone(size); }
+  static void* operator new(size_t, PullerArena& arena, unsigned slot) { return arena.slot(slot); }
+  static void operator delete(void* p) { PullerArena::deallocate(p); }
+  static void operator delete(void* p, PullerArena&, unsigned) { PullerArena::deallocate(p); }
 
   int setCallbackFunc(PullerCallback cbFunc, void* cbParam);
   PullerCallback getCallbackFunc() const {return m_callbackFunc;}
   void* getCallbackFuncParam() const {return m_cbParam;}
   Boolean retRtpPkt() const {return m_retRtpPkt;}
   Boolean usingTcpData() const { return m_connType == RTP_OVER_TCP ? true:false; }
+  Boolean usingMulticastData() const { return m_connType == RTP_OVER_MULTICAST ? true:false; }
+
+  int setFrameFilter(FrameFilterMode mode, unsigned gopInterval);
+  void applyFrameFilter(MediaSubsession& subsession) const;
+
+  FrameDistributor& frameDistributor() { return m_distributor; }
+  int setTsDemux(Boolean tsDemux);
+  Boolean tsDemux() const { return m_tsDemux; }
+  int setScatterDelivery(Boolean scatterDelivery);
+  Boolean scatterDelivery() const { return m_scatterDelivery; }
+
+  int setBufferSizes(unsigned frameBufferSize, unsigned packetBufferSize); // 0: automatic
+  void applyPacketBufferSize(MediaSubsession& subsession) const;
+  unsigned frameBufferSize() const { return m_frameBufferSize; }
+
+  int setReorderPolicy(ReorderPolicy policy, unsigned minUSeconds, unsigned maxUSeconds);
+  void applyReorderPolicy(MediaSubsession& subsession) const;
+  int setRtcpFeedback(unsigned feedbackTypes); // a "RtcpFeedbackType" bitmask
+  void applyRtcpFeedback(MediaSubsession& subsession) const;
+  int setFecRecovery(Boolean fecRecovery, unsigned char fecPayloadFormat); // 0: from the SDP description
+  void applyFecRecovery(MediaSubsession& subsession) const;
+  int setReceiveCoalescing(Boolean receiveCoalescing);
+  void applyReceiveCoalescing(MediaSubsession& subsession) const;
+
+  int setAsyncDelivery(unsigned queueSize, AsyncOverflowPolicy policy);
+  void applyAsyncDelivery(PullerSink& sink);
+  void getAsyncStats(AsyncDeliveryStats& stats) const;
+  void getReceiveStats(ReceiveStats& stats) const;
 
   int startStream(const char* url, int connType, const char* username, const char* password, int reconn, Boolean retRtpPkt);
   int closeStream();
+  int release(); // closes the client from its event loop thread; "this" must not be used afterwards
+  int releaseAndWait(); // likewise, but returns only once the client has been closed
 
   void resetUrl() { setBaseURL(m_url.data()); }
   void parseMediaAttr(char* sdpString) const;
 
 protected:
-  PullerClient(UsageEnvironment& env, char const* rtspURL,
+  PullerClient(PullerLoop& loop, char const* rtspURL,
 		int verbosityLevel, char const* applicationName, portNumBits tunnelOverHTTPPortNum);
     // called only by createNew();
   virtual ~PullerClient();
@@ -71,21 +126,55 @@ protected:
   static void subsessionByeHandler(void* clientData);
   static void streamTimerHandler(void* clietData);
 
-  static void* entryPoint(void* param);
-  virtual void run();
+  // Commands, run by the event loop thread:
+  static void createCommand(void* clientData);
+  static void setCallbackCommand(void* clientData);
+  static void setFrameFilterCommand(void* clientData);
+  static void setTsDemuxCommand(void* clientData);
+  static void setScatterDeliveryCommand(void* clientData);
+  static void setAsyncDeliveryCommand(void* clientData);
+  static void setBufferSizesCommand(void* clientData);
+  static void setReorderPolicyCommand(void* clientData);
+  static void setRtcpFeedbackCommand(void* clientData);
+  static void setFecRecoveryCommand(void* clientData);
+  static void setReceiveCoalescingCommand(void* clientData);
+  static void startStreamCommand(void* clientData);
+  static void closeStreamCommand(void* clientData);
+  static void releaseCommand(void* clientData);
+
+  void doStartStream(const char* url, int connType, const char* username, const char* password, Boolean retRtpPkt);
 
   void teardownStream(int resultCode, char* resultString);
+  void reportState(int resultCode, char const* resultString);
+  void accountResponseBuffer();
 public:
   StreamClientState fScs;
 
 private:
-  char m_running;
-  pthread_t m_tid;
+  PullerLoop& m_loop;
   PullerCallback m_callbackFunc;
   void* m_cbParam;
   Boolean m_retRtpPkt;
   std::string m_url;
   int m_connType;
+  FrameFilterMode m_filterMode;
+  unsigned m_gopInterval;
+  FrameDistributor m_distributor;
+  Boolean m_tsDemux;
+  Boolean m_scatterDelivery;
+  unsigned m_asyncQueueSize; // 0 means synchronous delivery
+  AsyncOverflowPolicy m_asyncPolicy;
+  AsyncDeliveryStats m_asyncStats; // shared by the dispatch queues of all of our sinks
+  ReceiveStats m_receiveStats; // updated by all of our sinks
+  unsigned m_frameBufferSize; // 0 means automatic
+  unsigned m_packetBufferSize; // 0 means automatic
+  ReorderPolicy m_reorderPolicy;
+  unsigned m_reorderMinTime, m_reorderMaxTime; // uSeconds
+  unsigned m_rtcpFeedback;
+  Boolean m_fecRecovery;
+  unsigned char m_fecPayloadFormat; // 0 means "from the SDP description"
+  Boolean m_receiveCoalescing; // (for RTP over UDP)
+  unsigned m_responseBufferBytes; // as charged to the memory budget
 };
 
 #endif
@@ -0,0 +1,155 @@
+/**
+ * @file PullerFrame.cpp
+ * @brief  1.0
+ *		implementation of PullerFrame
+ * @author lizhiyong0804319@gmail.com
+ * @version 1.0
+ * @date 2026-10-19
+ */
+
+#include "PullerFrame.h"
+#include "StartCodeScanner.hh"
+#include "H264VideoRTPSource.hh"
+
+#include <new>
+#include <string.h>
+
+PullerFrame* PullerFrame::createNew(unsigned char const* data, unsigned size,
+				    struct timeval presentationTime, unsigned rtpTimestamp,
+				    Boolean isKeyFrame, char const* mediumName, char const* codecName,
+				    RtpExtInfo const* extInfo) {
+  void* mem = ::operator new(sizeof(PullerFrame) + size, std::nothrow);
+  if (mem == NULL) return NULL;
+
+  PullerFrame* frame = new (mem) PullerFrame(size, presentationTime, rtpTimestamp,
+					     isKeyFrame, mediumName, codecName, extInfo);
+  memcpy((void*)(frame + 1), data, size);
+  return frame;
+}
+
+PullerFrame* PullerFrame::createNew(FrameChunk const* chunks, unsigned numChunks, unsigned size,
+				    struct timeval presentationTime, unsigned rtpTimestamp,
+				    Boolean isKeyFrame, char const* mediumName, char const* codecName,
+				    RtpExtInfo const* extInfo) {
+  void* mem = ::operator new(sizeof(PullerFrame) + size, std::nothrow);
+  if (mem == NULL) return NULL;
+
+  PullerFrame* frame = new (mem) PullerFrame(size, presentationTime, rtpTimestamp,
+					     isKeyFrame, mediumName, codecName, extInfo);
+  unsigned char* to = (unsigned char*)(frame + 1);
+  for (unsigned i = 0; i < numChunks && size > 0; ++i) {
+    unsigned chunkSize = (unsigned)chunks[i].bufLen;
+    if (chunkSize > size) chunkSize = size; // sanity check
+    memcpy(to, chunks[i].dataBuf, chunkSize);
+    to += chunkSize; size -= chunkSize;
+  }
+  return frame;
+}
+
+PullerFrame::PullerFrame(unsigned size, struct timeval presentationTime, unsigned rtpTimestamp,
+			 Boolean isKeyFrame, char const* mediumName, char const* codecName, RtpExtInfo const* extInfo)
+  : m_refCount(1), m_size(size), m_presentationTime(presentationTime),
+    m_rtpTimestamp(rtpTimestamp), m_isKeyFrame(isKeyFrame),
+    m_mediumName(mediumName), m_codecName(codecName),
+    m_extendedRTPTimestamp(0), m_monoPTS(0), m_isDiscontinuity(False) {
+  if (extInfo != NULL) m_extInfo = *extInfo; else m_extInfo.flags = 0;
+}
+
+void PullerFrame::setTiming(u_int64_t extendedRTPTimestamp, u_int64_t monoPTS, Boolean isDiscontinuity) {
+  m_extendedRTPTimestamp = extendedRTPTimestamp;
+  m_monoPTS = monoPTS;
+  m_isDiscontinuity = isDiscontinuity;
+}
+
+void PullerFrame::addRef() {
+  __sync_add_and_fetch(&m_refCount, 1);
+}
+
+void PullerFrame::release() {
+  if (__sync_sub_and_fetch(&m_refCount, 1) == 0) {
+    this->~PullerFrame();
+    ::operator delete(this);
+  }
+}
+
+// Skips over a RTP packet's header (including any CSRCs and header extension); returns False if there's no payload:
+static Boolean skipRTPHeader(unsigned char const*& data, unsigned& size) {
+  if (size < 12) return False;
+  unsigned headerSize = 12 + 4*(data[0]&0x0F);
+  if ((data[0]&0x10) && size >= headerSize + 4) {
+    headerSize += 4 + 4*((data[headerSize+2]<<8)|data[headerSize+3]);
+  }
+  if (size <= headerSize) return False;
+  data += headerSize; size -= headerSize;
+  return True;
+}
+
+Boolean PullerFrame::isH264KeyFrame(unsigned char const* data, unsigned size, Boolean isRTPPacket) {
+  if (isRTPPacket && !skipRTPHeader(data, size)) return False;
+  if (size == 0) return False;
+
+  unsigned char nalUnitType = data[0]&0x1F;
+  if (isRTPPacket) {
+    if (nalUnitType == 24 && size > 3) { // STAP-A: look at the first aggregated NAL unit
+      nalUnitType = data[3]&0x1F;
+    } else if (nalUnitType == 28 || nalUnitType == 29) { // FU-A/FU-B: only a start fragment begins a frame
+      if (size < 2 || (data[1]&0x80) == 0) return False;
+      nalUnitType = data[1]&0x1F;
+    }
+  }
+  return nalUnitType == 5 || nalUnitType == 7 || nalUnitType == 8;
+}
+
+Boolean PullerFrame::isAnnexBH264KeyFrame(unsigned char const* data, unsigned size) {
+  // Look at the type of each NAL unit in the access unit:
+  unsigned offset = 0;
+  while (offset < size) {
+    unsigned startCode = offset + findStartCode(data + offset, size - offset);
+    if (startCode + 3 >= size) break;
+
+    unsigned char nalUnitType = data[startCode + 3]&0x1F;
+    if (nalUnitType == 5 || nalUnitType == 7 || nalUnitType == 8) return True;
+    offset = startCode + 3;
+  }
+  return False;
+}
+
+Boolean PullerFrame::beginsH264GOP(H264GOPBoundaryDetector& detector) const {
+  unsigned char const* data = this->data();
+  unsigned size = m_size;
+  Boolean beginsGOP = False;
+
+  if (size >= 4 && data[0] == 0 && data[1] == 0 && (data[2] == 1 || (data[2] == 0 && data[3] == 1))) {
+    // An access unit in Annex-B format (from the TS demuxer):
+    unsigned offset = 0;
+    while (offset < size) {
+      unsigned startCode = offset + findStartCode(data + offset, size - offset);
+      if (startCode + 3 >= size) break;
+
+      if (detector.beginsGOP(data[startCode + 3]&0x1F, m_rtpTimestamp)) beginsGOP = True;
+      offset = startCode + 3;
+    }
+    return beginsGOP;
+  }
+
+  if (size > 0 && (data[0]&0x80) != 0) {
+    // A complete RTP packet (whereas a NAL unit header's "forbidden_zero_bit" is 0):
+    if (!skipRTPHeader(data, size)) return False;
+
+    unsigned char nalUnitType = data[0]&0x1F;
+    if (nalUnitType == 24) { // STAP-A: each aggregated NAL unit
+      for (unsigned i = 1; i + 2 < size; ) {
+	unsigned naluSize = (data[i]<<8)|data[i+1];
+	if (detector.beginsGOP(data[i+2]&0x1F, m_rtpTimestamp)) beginsGOP = True;
+	i += 2 + naluSize;
+      }
+      return beginsGOP;
+    }
+    if (nalUnitType == 28 || nalUnitType == 29) { // FU-A/FU-B: only a start fragment begins a NAL unit
+      if (size < 2 || (data[1]&0x80) == 0) return False;
+      return detector.beginsGOP(data[1]&0x1F, m_rtpTimestamp);
+    }
+  }
+
+  return size > 0 && detector.beginsGOP(data[0]&0x1F, m_rtpTimestamp);
+}
@@ -0,0 +1,86 @@
+/**
+ * @file PullerFrame.h
+ * @brief  Ref-counted, immutable media frame
+ * @author lizhiyong0804319@gmail.com
+ * @version 1.0
+ * @date 2026-10-19
+ */
+
+#ifndef PULLER_FRAME_H
+#define PULLER_FRAME_H
+
+#include "Boolean.hh"
+#include "NetCommon.h"
+#include "API_PullerTypes.h"
+#include <sys/time.h>
+#include <stddef.h>
+
+class H264GOPBoundaryDetector; // forward
+
+// A frame is copied out of the sink's receive buffer exactly once, and is then shared
+// (by reference) between the GOP cache and any number of subscribers.  Its payload
+// is stored in the same allocation as the frame object itself.
+
+class PullerFrame {
+public:
+  static PullerFrame* createNew(unsigned char const* data, unsigned size,
+				struct timeval presentationTime, unsigned rtpTimestamp,
+				Boolean isKeyFrame, char const* mediumName, char const* codecName,
+				RtpExtInfo const* extInfo = NULL);
+  // As above, but gathers the frame from "numChunks" pieces (of "size" bytes in total):
+  static PullerFrame* createNew(FrameChunk const* chunks, unsigned numChunks, unsigned size,
+				struct timeval presentationTime, unsigned rtpTimestamp,
+				Boolean isKeyFrame, char const* mediumName, char const* codecName,
+				RtpExtInfo const* extInfo = NULL);
+
+  // Sets the frame's RTP-derived timing (see "MultiFramedRTPSource::curFramePTS()"); called only by the frame's
+  // creator, before the frame is shared:
+  void setTiming(u_int64_t extendedRTPTimestamp, u_int64_t monoPTS, Boolean isDiscontinuity);
+
+  void addRef();
+  void release(); // deletes the frame when the last reference goes away
+
+  unsigned char const* data() const { return (unsigned char const*)(this + 1); }
+  unsigned size() const { return m_size; }
+  struct timeval const& presentationTime() const { return m_presentationTime; }
+  unsigned rtpTimestamp() const { return m_rtpTimestamp; }
+  Boolean isKeyFrame() const { return m_isKeyFrame; }
+  char const* mediumName() const { return m_mediumName; }
+  char const* codecName() const { return m_codecName; }
+  RtpExtInfo const* extInfo() const { return m_extInfo.flags != 0 ? &m_extInfo : NULL; }
+  u_int64_t extendedRTPTimestamp() const { return m_extendedRTPTimestamp; }
+  u_int64_t monoPTS() const { return m_monoPTS; } // in microseconds
+  Boolean isDiscontinuity() const { return m_isDiscontinuity; }
+
+  // Returns True iff the data begins a H.264 key frame (a SPS, PPS or IDR NAL unit).
+  // "isRTPPacket" tells whether the data is a complete RTP packet rather than a NAL unit.
+  static Boolean isH264KeyFrame(unsigned char const* data, unsigned size, Boolean isRTPPacket);
+  // As above, but for an access unit in Annex-B format (NAL units preceded by start codes):
+  static Boolean isAnnexBH264KeyFrame(unsigned char const* data, unsigned size);
+
+  // Returns True iff this H.264 frame begins a new GOP, by passing each NAL unit that it begins to "detector",
+  // in order.  (The frame may be a NAL unit, a complete RTP packet, or an access unit in Annex-B format.)
+  Boolean beginsH264GOP(H264GOPBoundaryDetector& detector) const;
+
+private:
+  PullerFrame(unsigned size, struct timeval presentationTime, unsigned rtpTimestamp,
+	      Boolean isKeyFrame, char const* mediumName, char const* codecName, RtpExtInfo const* extInfo);
+  ~PullerFrame() {}
+  PullerFrame(const PullerFrame&);
+  PullerFrame& operator=(const PullerFrame&);
+
+private:
+  volatile int m_refCount;
+  unsigned m_size;
+  struct timeval m_presentationTime;
+  unsigned m_rtpTimestamp;
+  Boolean m_isKeyFrame;
+  char const* m_mediumName; // static strings, owned by the "MediaSubsession"
+  char const* m_codecName;
+  RtpExtInfo m_extInfo; // "flags" is 0 if the frame had none
+  u_int64_t m_extendedRTPTimestamp;
+  u_int64_t m_monoPTS;
+  Boolean m_isDiscontinuity;
+};
+
+#endif
@@ -0,0 +1,193 @@
+/**
+ * @file PullerLoop.cpp
+ * @brief  1.0
+ *		implementation of PullerLoop
+ * @author lizhiyong0804319@gmail.com
+ * @version 1.0
+ * @date 2026-10-19
+ */
+
+#include "PullerLoop.h"
+
+#include "EpollTaskScheduler.hh"
+
+#include <semaphore.h>
+#include <stdint.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+static unsigned s_numSharedLoops = 0; // 0 means "one per CPU"
+static PullerLoop** s_sharedLoops = NULL;
+static unsigned s_numSharedLoopsCreated = 0;
+static pthread_once_t s_sharedLoopsOnce = PTHREAD_ONCE_INIT;
+
+PullerLoop* PullerLoop::createNew() {
+  PullerLoop* loop = new PullerLoop();
+  if (loop->m_eventFd < 0 || loop->start() != 0) {
+    delete loop;
+    return NULL;
+  }
+  return loop;
+}
+
+PullerLoop::PullerLoop()
+  : m_commands(NULL), m_tid(0), m_started(False), m_stopRequested(0),
+    m_shared(False), m_numClients(0) {
+  m_scheduler = NULL;
+#ifdef HAVE_EPOLL_TASK_SCHEDULER
+  // (Not limited to FD_SETSIZE sockets, which matters for a loop that's shared by many streams:)
+  m_scheduler = EpollTaskScheduler::createNew();
+#endif
+  if (m_scheduler == NULL) m_scheduler = BasicTaskScheduler::createNew();
+  m_env = BasicUsageEnvironment::createNew(*m_scheduler);
+  m_eventFd = eventfd(0, EFD_NONBLOCK|EFD_CLOEXEC);
+  if (m_eventFd >= 0) {
+    m_scheduler->turnOnBackgroundReadHandling(m_eventFd, incomingCommandsHandler, this);
+  }
+}
+
+PullerLoop::~PullerLoop() {
+  if (m_started) {
+    // The stop command runs after every command that's already been posted:
+    post(stopCommand, this);
+    pthread_join(m_tid, NULL);
+  }
+
+  // Discard any commands that were posted too late to be run:
+  Command* command = __atomic_exchange_n(&m_commands, (Command*)NULL, __ATOMIC_ACQUIRE);
+  while (command != NULL) {
+    Command* next = command->next;
+    delete command;
+    command = next;
+  }
+
+  if (m_eventFd >= 0) {
+    m_scheduler->turnOffBackgroundReadHandling(m_eventFd);
+    close(m_eventFd);
+  }
+  m_env->reclaim();
+  delete m_scheduler;
+}
+
+int PullerLoop::start() {
+  if (pthread_create(&m_tid, NULL, entryPoint, this) != 0) return -1;
+  m_started = True;
+  return 0;
+}
+
+int PullerLoop::post(CommandFunc* func, void* clientData) {
+  Command* command = new Command;
+  command->func = func;
+  command->clientData = clientData;
+
+  Command* head = __atomic_load_n(&m_commands, __ATOMIC_RELAXED);
+  do {
+    command->next = head;
+  } while (!__atomic_compare_exchange_n(&m_commands, &head, command, True, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+  // Wake the loop only if it may have already taken (or be about to take) every earlier command:
+  if (head == NULL) {
+    uint64_t one = 1;
+    (void)write(m_eventFd, &one, sizeof one);
+  }
+  return 0;
+}
+
+struct WaitedCommand {
+  PullerLoop::CommandFunc* func;
+  void* clientData;
+  sem_t done;
+};
+
+int PullerLoop::postAndWait(CommandFunc* func, void* clientData) {
+  WaitedCommand command;
+  command.func = func;
+  command.clientData = clientData;
+  sem_init(&command.done, 0, 0);
+
+  int result = post(waitedCommand, &command);
+  if (result == 0) {
+    while (sem_wait(&command.done) != 0) {} // (retry on EINTR)
+  }
+  sem_destroy(&command.done);
+  return result;
+}
+
+void PullerLoop::waitedCommand(void* clientData) {
+  WaitedCommand* command = (WaitedCommand*)clientData;
+  (*command->func)(command->clientData);
+  sem_post(&command->done);
+}
+
+void PullerLoop::setNumSharedLoops(unsigned numLoops) {
+  s_numSharedLoops = numLoops;
+}
+
+void PullerLoop::createSharedLoops() {
+  unsigned numLoops = s_numSharedLoops;
+  if (numLoops == 0) {
+    long numCPUs = sysconf(_SC_NPROCESSORS_ONLN);
+    numLoops = numCPUs > 0 ? (unsigned)numCPUs : 1;
+  }
+
+  s_sharedLoops = new PullerLoop*[numLoops];
+  for (unsigned i = 0; i < numLoops; ++i) {
+    PullerLoop* loop = createNew();
+    if (loop == NULL) break;
+    loop->m_shared = True;
+    s_sharedLoops[s_numSharedLoopsCreated++] = loop;
+  }
+}
+
+PullerLoop* PullerLoop::sharedLoop() {
+  pthread_once(&s_sharedLoopsOnce, createSharedLoops);
+  if (s_numSharedLoopsCreated == 0) return NULL;
+
+  PullerLoop* leastLoaded = s_sharedLoops[0];
+  for (unsigned i = 1; i < s_numSharedLoopsCreated; ++i) {
+    if (s_sharedLoops[i]->m_numClients < leastLoaded->m_numClients) leastLoaded = s_sharedLoops[i];
+  }
+  __sync_fetch_and_add(&leastLoaded->m_numClients, 1);
+  return leastLoaded;
+}
+
+void* PullerLoop::entryPoint(void* param) {
+  PullerLoop* loop = (PullerLoop*)param;
+  loop->m_scheduler->doEventLoop(&loop->m_stopRequested);
+  return NULL;
+}
+
+void PullerLoop::incomingCommandsHandler(void* clientData, int /*mask*/) {
+  PullerLoop* loop = (PullerLoop*)clientData;
+
+  // Reset the eventfd before taking the commands, so that a command that's posted after we've
+  // taken the stack will wake us again:
+  uint64_t count;
+  (void)read(loop->m_eventFd, &count, sizeof count);
+  loop->runCommands();
+}
+
+void PullerLoop::stopCommand(void* clientData) {
+  PullerLoop* loop = (PullerLoop*)clientData;
+  loop->m_stopRequested = 1;
+}
+
+void PullerLoop::runCommands() {
+  Command* command = __atomic_exchange_n(&m_commands, (Command*)NULL, __ATOMIC_ACQUIRE);
+
+  // The stack is newest-first; reverse it, to run the commands in the order they were posted:
+  Command* oldestFirst = NULL;
+  while (command != NULL) {
+    Command* next = command->next;
+    command->next = oldestFirst;
+    oldestFirst = command;
+    command = next;
+  }
+
+  while (oldestFirst != NULL) {
+    Command* next = oldestFirst->next;
+    (*oldestFirst->func)(oldestFirst->clientData);
+    delete oldestFirst;
+    oldestFirst = next;
+  }
+}
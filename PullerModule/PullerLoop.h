@@ -0,0 +1,75 @@
+/**
+ * @file PullerLoop.h
+ * @brief  An event loop thread, and the command queue that's used to control it
+ * @author lizhiyong0804319@gmail.com
+ * @version 1.0
+ * @date 2026-10-19
+ */
+
+#ifndef PULLER_LOOP_H
+#define PULLER_LOOP_H
+
+#include "liveMedia.hh"
+#include "BasicUsageEnvironment.hh"
+
+#include <pthread.h>
+
+// All of a "PullerClient"s state (its "MediaSession", sinks and sockets) belongs to its event
+// loop thread.  Other threads never touch it directly; instead they "post()" a command, which
+// the loop thread runs (in order) at its next opportunity.  Posting is lock-free (commands are
+// pushed onto a stack that the loop thread takes over in one go), and the loop is woken via an
+// eventfd only when the stack was empty, so a burst of commands costs a single wakeup.
+
+class PullerLoop {
+public:
+  typedef void (CommandFunc)(void* clientData);
+
+  static PullerLoop* createNew(); // also starts the loop thread; returns NULL on failure
+  ~PullerLoop(); // runs the commands that were posted before it, then stops the thread (and must
+      // therefore not be called from the loop thread itself)
+
+  UsageEnvironment& envir() { return *m_env; }
+  Boolean isLoopThread() const { return pthread_equal(pthread_self(), m_tid); }
+
+  int post(CommandFunc* func, void* clientData); // may be called from any thread, including the loop thread
+  int postAndWait(CommandFunc* func, void* clientData); // posts, then waits until the command has run
+      // (and must therefore not be called from the loop thread)
+
+  // Shared loops: a fixed pool of loops (one per CPU, by default), each of which serves many
+  // streams.  "sharedLoop()" returns the loop that's serving the fewest streams, and counts the
+  // caller as one more of them; "detach()" undoes that.  Shared loops live until the process exits.
+  static void setNumSharedLoops(unsigned numLoops); // takes effect only before the first "sharedLoop()"
+  static PullerLoop* sharedLoop();
+  Boolean isShared() const { return m_shared; }
+  void detach() { __sync_fetch_and_sub(&m_numClients, 1); }
+
+private:
+  PullerLoop();
+  int start();
+
+  static void* entryPoint(void* param);
+  static void incomingCommandsHandler(void* clientData, int mask);
+  static void stopCommand(void* clientData);
+  static void waitedCommand(void* clientData);
+  void runCommands();
+  static void createSharedLoops();
+
+private:
+  struct Command {
+    CommandFunc* func;
+    void* clientData;
+    Command* next;
+  };
+
+  TaskScheduler* m_scheduler;
+  UsageEnvironment* m_env;
+  int m_eventFd;
+  Command* m_commands; // newest first; pushed (by CAS) by any thread, taken by the loop thread
+  pthread_t m_tid;
+  Boolean m_started;
+  char m_stopRequested; // the event loop's watch variable
+  Boolean m_shared;
+  volatile unsigned m_numClients; // shared loops only
+};
+
+#endif
@@ -9,25 +9,94 @@
 
 #include "PullerSink.h"
 #include "API_PullerTypes.h"
+#include "FrameDistributor.h"
+#include "TsDemuxer.h"
+#include "CallbackDispatcher.h"
+#include "MemoryBudget.h"
+#include "ShmFrameWriter.h"
+#include "GroupsockHelper.hh"
 
-#define DUMMY_SINK_RECEIVE_BUFFER_SIZE 100000
+#define DUMMY_SINK_RECEIVE_BUFFER_SIZE 100000 // when there's nothing better to go on
+#define MIN_AUTO_RECEIVE_BUFFER_SIZE 2048
+#define MAX_AUTO_RECEIVE_BUFFER_SIZE (8*1024*1024)
+#define MAX_INITIAL_RECEIVE_BUFFER_SIZE (512*1024) // (even for 4K video; larger frames make it grow)
+#define MIN_SOCKET_RECEIVE_BUFFER_SIZE (128*1024)
+#define MAX_SOCKET_RECEIVE_BUFFER_SIZE (16*1024*1024)
+#define RECEIVE_STATS_INTERVAL 1 // seconds
 
-PullerSink* PullerSink::createNew(UsageEnvironment& env, MediaSubsession& subsession, char const* streamId) {
-  return new PullerSink(env, subsession, streamId);
+static unsigned roundUpToPowerOf2(unsigned size) {
+  unsigned result = MIN_AUTO_RECEIVE_BUFFER_SIZE;
+  while (result < size && result < MAX_AUTO_RECEIVE_BUFFER_SIZE) result <<= 1;
+  return result;
 }
 
-PullerSink::PullerSink(UsageEnvironment& env, MediaSubsession& subsession, char const* streamId)
+PullerSink* PullerSink::createNew(UsageEnvironment& env, MediaSubsession& subsession, char const* streamId,
+    unsigned receiveBufferSize) {
+  Boolean autoGrow = receiveBufferSize == 0;
+  if (autoGrow) receiveBufferSize = autoReceiveBufferSize(subsession);
+
+  if (!MemoryBudget::reserve(receiveBufferSize)) {
+    env.setResultMsg("The memory budget can't afford another receive buffer");
+    return NULL;
+  }
+  return new PullerSink(env, subsession, streamId, receiveBufferSize, autoGrow);
+}
+
+unsigned PullerSink::autoReceiveBufferSize(MediaSubsession& subsession) {
+  // Frames of these are at most a packet (or a few packets) in size:
+  if (strcmp(subsession.mediumName(), "audio") == 0 || strcmp(subsession.codecName(), "MP2T") == 0) {
+    return 8192;
+  }
+
+  // Otherwise, allow for a key frame of about half of the picture's luma samples (or, failing that,
+  // half a second's worth of the stream's bandwidth) - within reason.  Larger frames make the buffer grow:
+  unsigned size = DUMMY_SINK_RECEIVE_BUFFER_SIZE;
+  if (subsession.videoWidth() != 0 && subsession.videoHeight() != 0) {
+    size = (unsigned)subsession.videoWidth()*subsession.videoHeight()/2;
+  } else if (subsession.bandwidth() != 0) {
+    size = subsession.bandwidth()*1000/8/2;
+  }
+  if (size > MAX_INITIAL_RECEIVE_BUFFER_SIZE) size = MAX_INITIAL_RECEIVE_BUFFER_SIZE;
+  return roundUpToPowerOf2(size);
+}
+
+PullerSink::PullerSink(UsageEnvironment& env, MediaSubsession& subsession, char const* streamId,
+    unsigned receiveBufferSize, Boolean autoGrow)
   : MediaSink(env),
-    fSubsession(subsession), m_callbackFunc(NULL) {
+    m_receiveBufferSize(receiveBufferSize), m_growReceiveBuffer(autoGrow),
+    fSubsession(subsession), m_callbackFunc(NULL), m_distributor(NULL), m_retRtpPkt(False), m_tsDemuxer(NULL), m_dispatchQueue(NULL),
+    m_scatterSource(NULL), m_chunks(NULL), m_maxNumChunks(0),
+    m_receiveStats(NULL), m_tunedGroupsock(NULL), m_socketBufferRequest(0), m_socketBufferLimited(False), m_lastKernelDrops(0) {
+  m_multiFramedSource = dynamic_cast<MultiFramedRTPSource*>(subsession.rtpSource());
+  memset(&m_publishedStats, 0, sizeof m_publishedStats);
+  m_lastStatsTime.tv_sec = m_lastStatsTime.tv_usec = 0;
+  m_isH264 = strcmp(subsession.codecName(), "H264") == 0;
   fStreamId = strDup(streamId);
-  fReceiveBuffer = new u_int8_t[DUMMY_SINK_RECEIVE_BUFFER_SIZE];
+  fReceiveBuffer = new u_int8_t[m_receiveBufferSize];
 }
 
 PullerSink::~PullerSink() {
+  delete m_dispatchQueue;
+  delete m_tsDemuxer;
   delete[] fReceiveBuffer;
+  MemoryBudget::charge(-(long long)m_receiveBufferSize);
+  delete[] m_chunks;
+  // (Our packet counts remain part of the stream's totals, but our socket buffer goes away:)
+  if (m_receiveStats != NULL) __atomic_fetch_sub(&m_receiveStats->socketBufferSize, m_publishedStats.socketBufferSize, __ATOMIC_RELAXED);
   delete[] fStreamId;
 }
 
+void PullerSink::growReceiveBuffer(unsigned minSize)
+{
+  unsigned newSize = roundUpToPowerOf2(minSize);
+  if (newSize <= m_receiveBufferSize) return; // we're already at our maximum size
+  if (!MemoryBudget::reserve(newSize - m_receiveBufferSize)) return; // keep truncating, rather than exceed the budget
+
+  delete[] fReceiveBuffer; // (the frame that it holds has already been delivered)
+  fReceiveBuffer = new u_int8_t[newSize];
+  m_receiveBufferSize = newSize;
+}
+
 int PullerSink::setCallbackFunc(PullerCallback cbFunc, void* cbParam)
 {
 	m_callbackFunc = cbFunc;
@@ -35,6 +104,136 @@ int PullerSink::setCallbackFunc(PullerCallback cbFunc, void* cbParam)
 	return 0;
 }
 
+void PullerSink::enableTsDemux()
+{
+  if (m_tsDemuxer == NULL) m_tsDemuxer = new TsDemuxer(onDemuxedFrame, this);
+}
+
+void PullerSink::setAsyncDelivery(unsigned queueSize, AsyncOverflowPolicy policy, AsyncDeliveryStats& stats)
+{
+  if (m_dispatchQueue != NULL) return;
+  m_dispatchQueue = new DispatchQueue(m_tsDemuxer != NULL ? CB_FRAME_DATA : CB_RTP_DATA,
+      m_callbackFunc, m_cbParam, queueSize, policy, stats);
+}
+
+void PullerSink::setReceiveStats(ReceiveStats& stats)
+{
+  m_receiveStats = &stats;
+}
+
+void PullerSink::enableSocketBufferTuning()
+{
+  RTPSource* rtpSource = fSubsession.rtpSource();
+  if (rtpSource == NULL || rtpSource->RTPgs() == NULL) return;
+
+  m_tunedGroupsock = rtpSource->RTPgs();
+  m_tunedGroupsock->enableKernelDropCounting();
+  m_lastKernelDrops = m_tunedGroupsock->numKernelDrops();
+
+  // Start with a quarter of a second's worth of the stream's bitrate ("b=AS:", in kbps), if it's known:
+  growSocketBuffer(fSubsession.bandwidth()*1000/8/4);
+}
+
+void PullerSink::growSocketBuffer(unsigned requestedSize)
+{
+  if (m_tunedGroupsock == NULL || m_socketBufferLimited) return;
+  if (requestedSize < MIN_SOCKET_RECEIVE_BUFFER_SIZE) requestedSize = MIN_SOCKET_RECEIVE_BUFFER_SIZE;
+  if (requestedSize > MAX_SOCKET_RECEIVE_BUFFER_SIZE) requestedSize = MAX_SOCKET_RECEIVE_BUFFER_SIZE;
+  if (requestedSize <= m_socketBufferRequest) return;
+
+  int socketNum = m_tunedGroupsock->socketNum();
+  increaseReceiveBufferTo(envir(), socketNum, requestedSize);
+  unsigned newSize = getReceiveBufferSize(envir(), socketNum);
+  m_socketBufferRequest = requestedSize;
+  // The OS may silently cap the size - e.g., at Linux's "net.core.rmem_max" - in which case, stop asking.
+  // (Compare with what we asked for, not with the old size: Linux reports double the size that was set, so a
+  // request that's no bigger than that is left alone - and isn't a sign of a cap.)
+  if (newSize < requestedSize) m_socketBufferLimited = True;
+
+  if (m_receiveStats != NULL) {
+    __atomic_fetch_add(&m_receiveStats->socketBufferSize, newSize - m_publishedStats.socketBufferSize, __ATOMIC_RELAXED);
+  }
+  m_publishedStats.socketBufferSize = newSize;
+}
+
+void PullerSink::updateReceiveStats(unsigned frameSize)
+{
+  if (m_tunedGroupsock != NULL)
+  {
+    // A frame's packets arrive in a burst, so the socket buffer must be able to hold (at least) a whole frame.
+    // (Allow for the kernel's per-packet overhead, which roughly doubles the space that each packet takes up.)
+    growSocketBuffer(4*frameSize);
+
+    u_int32_t numKernelDrops = m_tunedGroupsock->numKernelDrops();
+    if (numKernelDrops != m_lastKernelDrops)
+    {
+      // The buffer overflowed (we didn't read it quickly enough); double it:
+      if (m_receiveStats != NULL) {
+	__atomic_fetch_add(&m_receiveStats->kernelDrops, (u_int32_t)(numKernelDrops - m_lastKernelDrops), __ATOMIC_RELAXED);
+      }
+      m_lastKernelDrops = numKernelDrops;
+      growSocketBuffer(2*m_socketBufferRequest);
+    }
+  }
+
+  // The packet counts are recomputed only occasionally, because that means iterating over the stream's sources:
+  RTPSource* rtpSource = fSubsession.rtpSource();
+  if (m_receiveStats == NULL || rtpSource == NULL) return;
+  struct timeval timeNow = envir().taskScheduler().loopTime();
+  if (timeNow.tv_sec < m_lastStatsTime.tv_sec + RECEIVE_STATS_INTERVAL) return;
+  m_lastStatsTime = timeNow;
+
+  unsigned long long packetsReceived = 0, packetsLost = 0;
+  RTPReceptionStatsDB::Iterator iter(rtpSource->receptionStatsDB());
+  RTPReceptionStats* stats;
+  while ((stats = iter.next(True)) != NULL)
+  {
+    unsigned received = stats->totNumPacketsReceived();
+    unsigned expected = stats->totNumPacketsExpected();
+    packetsReceived += received;
+    if (expected > received) packetsLost += expected - received;
+  }
+  // (Publish the changes, as deltas, because the totals are shared with the stream's other sinks:)
+  __atomic_fetch_add(&m_receiveStats->packetsReceived, packetsReceived - m_publishedStats.packetsReceived, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&m_receiveStats->packetsLost, packetsLost - m_publishedStats.packetsLost, __ATOMIC_RELAXED);
+  m_publishedStats.packetsReceived = packetsReceived;
+  m_publishedStats.packetsLost = packetsLost;
+
+  MultiFramedRTPSource* multiFramedSource = dynamic_cast<MultiFramedRTPSource*>(rtpSource);
+  if (multiFramedSource != NULL)
+  {
+    unsigned long long fecRecovered = multiFramedSource->numFECRecoveredPackets();
+    __atomic_fetch_add(&m_receiveStats->fecRecovered, fecRecovered - m_publishedStats.fecRecovered, __ATOMIC_RELAXED);
+    m_publishedStats.fecRecovered = fecRecovered;
+  }
+}
+
+Boolean PullerSink::enableScatterDelivery(FramedSource& source)
+{
+  MultiFramedRTPSource* rtpSource = dynamic_cast<MultiFramedRTPSource*>(&source);
+  if (rtpSource == NULL || m_tsDemuxer != NULL) return False;
+
+  rtpSource->setScatterDelivery(True);
+  m_scatterSource = rtpSource;
+
+  // Frames no longer pass through our receive buffer, so there's no point in it being big:
+  if (m_receiveBufferSize > MIN_AUTO_RECEIVE_BUFFER_SIZE)
+  {
+    delete[] fReceiveBuffer;
+    fReceiveBuffer = new u_int8_t[MIN_AUTO_RECEIVE_BUFFER_SIZE];
+    MemoryBudget::charge(-(long long)(m_receiveBufferSize - MIN_AUTO_RECEIVE_BUFFER_SIZE));
+    m_receiveBufferSize = MIN_AUTO_RECEIVE_BUFFER_SIZE;
+  }
+  m_growReceiveBuffer = False;
+  return True;
+}
+
+void PullerSink::setFrameDistributor(FrameDistributor* distributor, Boolean retRtpPkt)
+{
+	m_distributor = distributor;
+	m_retRtpPkt = retRtpPkt;
+}
+
 void PullerSink::afterGettingFrame(void* clientData, unsigned frameSize, unsigned numTruncatedBytes,
 				  struct timeval presentationTime, unsigned durationInMicroseconds) {
   PullerSink* sink = (PullerSink*)clientData;
@@ -65,17 +264,233 @@ void PullerSink::afterGettingFrame(unsigned frameSize, unsigned numTruncatedByte
 
   if (frameSize != 0)
   {
-    RTPData rtpData;
-    rtpData.dataBuf = (char*)fReceiveBuffer;
-    rtpData.bufLen = frameSize;
+    updateReceiveStats(frameSize);
+    if (m_scatterSource != NULL)
+    {
+      deliverScatteredFrame(frameSize, presentationTime);
+    }
+    else if (m_tsDemuxer != NULL)
+    {
+      // Demultiplex the Transport Stream; "onDemuxedFrame()" delivers each elementary-stream frame:
+      m_curPresentationTime = presentationTime;
+      m_tsDemuxer->feed(fReceiveBuffer, frameSize);
+    }
+    else
+    {
+      RTPData rtpData;
+      rtpData.dataBuf = (char*)fReceiveBuffer;
+      rtpData.bufLen = frameSize;
 
-    m_callbackFunc(CB_RTP_DATA, &rtpData, m_cbParam); 
-    // Then continue, to request the next frame of data:
+      if (m_dispatchQueue == NULL && m_callbackFunc != NULL) m_callbackFunc(CB_RTP_DATA, &rtpData, m_cbParam); 
+
+      Boolean wantsFrame = m_dispatchQueue != NULL || (m_distributor != NULL && m_distributor->wantsFrames());
+      ShmFrameWriter* shmWriter = m_distributor != NULL ? m_distributor->shmWriter() : NULL;
+      if (wantsFrame || shmWriter != NULL)
+      {
+        Boolean isKeyFrame = m_isH264 && PullerFrame::isH264KeyFrame(fReceiveBuffer, frameSize, m_retRtpPkt);
+        unsigned rtpTimestamp = fSubsession.rtpSource() != NULL ? fSubsession.rtpSource()->curPacketRTPTimestamp() : 0;
+        if (shmWriter != NULL)
+        {
+          FrameChunk chunk;
+          chunk.dataBuf = (const char*)fReceiveBuffer;
+          chunk.bufLen = frameSize;
+          writeShmFrame(*shmWriter, &chunk, 1, frameSize, presentationTime, rtpTimestamp, isKeyFrame,
+              fSubsession.mediumName(), fSubsession.codecName(), True);
+        }
+        // Copy the frame once; the dispatch queue, the GOP cache and every subscriber share this copy:
+        if (wantsFrame) distributeFrame(setFrameTiming(PullerFrame::createNew(fReceiveBuffer, frameSize, presentationTime,
+            rtpTimestamp, isKeyFrame, fSubsession.mediumName(), fSubsession.codecName(), curExtInfo())), m_isH264);
+      }
+    }
+    // If the frame didn't fit, make room for the next one like it.  Then continue, to request the next frame of data:
+    if (numTruncatedBytes > 0 && m_growReceiveBuffer) growReceiveBuffer(frameSize + numTruncatedBytes);
     continuePlaying();  
   }
   else
   {
-    m_callbackFunc(CB_CONNECTION_BROKEN, 0, m_cbParam); 
+    if (m_callbackFunc != NULL) m_callbackFunc(CB_CONNECTION_BROKEN, 0, m_cbParam); 
+  }
+}
+
+void PullerSink::deliverScatteredFrame(unsigned frameSize, struct timeval presentationTime)
+{
+  unsigned numChunks;
+  MultiFramedRTPSource::Chunk const* chunks = m_scatterSource->curFrameChunks(numChunks);
+  if (numChunks > m_maxNumChunks)
+  {
+    delete[] m_chunks;
+    m_maxNumChunks = numChunks < 16 ? 16 : numChunks;
+    m_chunks = new FrameChunk[m_maxNumChunks];
+  }
+  for (unsigned i = 0; i < numChunks; ++i)
+  {
+    m_chunks[i].dataBuf = (const char*)chunks[i].data;
+    m_chunks[i].bufLen = chunks[i].size;
+  }
+
+  // (The NAL unit header is at the start of the first chunk:)
+  Boolean isKeyFrame = m_isH264 && numChunks > 0 && PullerFrame::isH264KeyFrame(chunks[0].data, chunks[0].size, False);
+  unsigned rtpTimestamp = m_scatterSource->curPacketRTPTimestamp();
+
+  if (m_dispatchQueue == NULL && m_callbackFunc != NULL)
+  {
+    ScatterFrameData frameData;
+    frameData.chunks = m_chunks;
+    frameData.numChunks = numChunks;
+    frameData.totalLen = frameSize;
+    frameData.isKeyFrame = isKeyFrame;
+    frameData.rtpTimestamp = rtpTimestamp;
+    frameData.ptsSec = presentationTime.tv_sec;
+    frameData.ptsUsec = presentationTime.tv_usec;
+    frameData.mediumName = fSubsession.mediumName();
+    frameData.codecName = fSubsession.codecName();
+    frameData.extInfo = curExtInfo();
+    frameData.extRtpTimestamp = m_scatterSource->curFrameExtendedRTPTimestamp();
+    frameData.monoPtsUs = m_scatterSource->curFramePTS();
+    frameData.isDiscontinuity = m_scatterSource->curFrameIsDiscontinuity();
+    m_callbackFunc(CB_SCATTER_DATA, &frameData, m_cbParam);
+  }
+
+  // The shared-memory ring takes the chunks as they are (gathering them is its only copy):
+  ShmFrameWriter* shmWriter = m_distributor != NULL ? m_distributor->shmWriter() : NULL;
+  if (shmWriter != NULL)
+  {
+    writeShmFrame(*shmWriter, m_chunks, numChunks, frameSize, presentationTime, rtpTimestamp, isKeyFrame,
+        fSubsession.mediumName(), fSubsession.codecName(), True);
+  }
+
+  if (m_dispatchQueue != NULL || (m_distributor != NULL && m_distributor->wantsFrames()))
+  {
+    // Anything that keeps the frame beyond this call needs it in one piece; gather it (this is its only copy):
+    distributeFrame(setFrameTiming(PullerFrame::createNew(m_chunks, numChunks, frameSize, presentationTime, rtpTimestamp,
+        isKeyFrame, fSubsession.mediumName(), fSubsession.codecName(), curExtInfo())), m_isH264);
+  }
+}
+
+void PullerSink::distributeFrame(unsigned char const* data, unsigned size, struct timeval presentationTime,
+    unsigned rtpTimestamp, Boolean isKeyFrame, char const* mediumName, char const* codecName, Boolean cacheable)
+{
+  // Copy the frame once; the dispatch queue, the GOP cache and every subscriber share this copy:
+  distributeFrame(PullerFrame::createNew(data, size, presentationTime, rtpTimestamp,
+      isKeyFrame, mediumName, codecName), cacheable);
+}
+
+void PullerSink::writeShmFrame(ShmFrameWriter& shmWriter, FrameChunk const* chunks, unsigned numChunks, unsigned size,
+    struct timeval presentationTime, unsigned rtpTimestamp, Boolean isKeyFrame, char const* mediumName,
+    char const* codecName, Boolean isSourceFrame)
+{
+  ShmFrameInfo info;
+  info.rtpTimestamp = rtpTimestamp;
+  info.presentationTime = presentationTime;
+  info.isKeyFrame = isKeyFrame;
+  info.mediumName = mediumName;
+  info.codecName = codecName;
+  if (isSourceFrame && m_multiFramedSource != NULL)
+  {
+    info.extRtpTimestamp = m_multiFramedSource->curFrameExtendedRTPTimestamp();
+    info.monoPtsUs = m_multiFramedSource->curFramePTS();
+    info.isDiscontinuity = m_multiFramedSource->curFrameIsDiscontinuity();
+  }
+  else
+  {
+    info.extRtpTimestamp = 0;
+    info.monoPtsUs = 0;
+    info.isDiscontinuity = False;
+  }
+  shmWriter.write(chunks, numChunks, size, info);
+}
+
+PullerFrame* PullerSink::setFrameTiming(PullerFrame* frame)
+{
+  if (frame != NULL && m_multiFramedSource != NULL)
+  {
+    frame->setTiming(m_multiFramedSource->curFrameExtendedRTPTimestamp(), m_multiFramedSource->curFramePTS(),
+        m_multiFramedSource->curFrameIsDiscontinuity());
+  }
+  return frame;
+}
+
+RtpExtInfo const* PullerSink::curExtInfo()
+{
+  if (m_multiFramedSource == NULL) return NULL;
+  RTPHeaderExtensions const& extensions = m_multiFramedSource->curFrameHeaderExtensions();
+  if (extensions.fPresent == 0) return NULL; // the common case
+
+  m_extInfo.flags = 0;
+  if (extensions.has(RTPHeaderExtensions::ABS_SEND_TIME))
+  {
+    m_extInfo.flags |= RTP_EXT_ABS_SEND_TIME;
+    m_extInfo.absSendTime = extensions.absSendTime;
+  }
+  if (extensions.has(RTPHeaderExtensions::ABS_CAPTURE_TIME))
+  {
+    m_extInfo.flags |= RTP_EXT_ABS_CAPTURE_TIME;
+    m_extInfo.absCaptureTime = extensions.absCaptureTime;
+  }
+  if (extensions.has(RTPHeaderExtensions::ONVIF_REPLAY))
+  {
+    m_extInfo.flags |= RTP_EXT_ONVIF_REPLAY;
+    m_extInfo.onvifNtpTime = extensions.onvifNTPTime;
+    m_extInfo.onvifFlags = extensions.onvifFlags;
+    m_extInfo.onvifCSeq = extensions.onvifCSeq;
+  }
+  return &m_extInfo;
+}
+
+void PullerSink::distributeFrame(PullerFrame* frame, Boolean cacheable)
+{
+  if (frame != NULL)
+  {
+    if (m_dispatchQueue != NULL) m_dispatchQueue->enqueue(frame);
+    if (m_distributor != NULL && m_distributor->wantsFrames()) m_distributor->deliverFrame(frame, cacheable);
+    frame->release();
+  }
+}
+
+void PullerSink::onDemuxedFrame(void* clientData, unsigned /*pid*/, unsigned char streamType,
+    unsigned char const* data, unsigned size, Boolean hasPTS, u_int64_t pts90kHz)
+{
+  PullerSink* sink = (PullerSink*)clientData;
+  char const* codecName = TsDemuxer::codecName(streamType);
+  char const* mediumName = TsDemuxer::mediumName(streamType);
+  Boolean isH264 = streamType == 0x1B;
+  Boolean isKeyFrame = isH264 && PullerFrame::isAnnexBH264KeyFrame(data, size);
+  // For demultiplexed frames, the "RTP timestamp" is the (low 32 bits of the) PES PTS, if any:
+  unsigned timestamp = hasPTS ? (unsigned)pts90kHz : 0;
+
+  if (sink->m_dispatchQueue == NULL && sink->m_callbackFunc != NULL)
+  {
+    FrameData frameData;
+    frameData.dataBuf = (const char*)data;
+    frameData.bufLen = size;
+    frameData.isKeyFrame = isKeyFrame;
+    frameData.isCached = 0;
+    frameData.rtpTimestamp = timestamp;
+    frameData.ptsSec = sink->m_curPresentationTime.tv_sec;
+    frameData.ptsUsec = sink->m_curPresentationTime.tv_usec;
+    frameData.mediumName = mediumName;
+    frameData.codecName = codecName;
+    frameData.extInfo = NULL;
+    frameData.extRtpTimestamp = 0;
+    frameData.monoPtsUs = 0;
+    frameData.isDiscontinuity = 0;
+    sink->m_callbackFunc(CB_FRAME_DATA, &frameData, sink->m_cbParam);
+  }
+
+  ShmFrameWriter* shmWriter = sink->m_distributor != NULL ? sink->m_distributor->shmWriter() : NULL;
+  if (shmWriter != NULL)
+  {
+    FrameChunk chunk;
+    chunk.dataBuf = (const char*)data;
+    chunk.bufLen = size;
+    sink->writeShmFrame(*shmWriter, &chunk, 1, size, sink->m_curPresentationTime, timestamp, isKeyFrame,
+        mediumName, codecName, False);
+  }
+
+  if (sink->m_dispatchQueue != NULL || (sink->m_distributor != NULL && sink->m_distributor->wantsFrames()))
+  {
+    sink->distributeFrame(data, size, sink->m_curPresentationTime, timestamp,
+        isKeyFrame, mediumName, codecName, isH264);
   }
 }
 
@@ -83,7 +498,7 @@ Boolean PullerSink::continuePlaying() {
   if (fSource == NULL) return False; // sanity check (should not happen)
 
   // Request the next frame of data from our input source.  "afterGettingFrame()" will get called later, when it arrives:
-  fSource->getNextFrame(fReceiveBuffer, DUMMY_SINK_RECEIVE_BUFFER_SIZE,
+  fSource->getNextFrame(fReceiveBuffer, m_receiveBufferSize,
                         afterGettingFrame, this,
                         onSourceClosure, this);
   return True;
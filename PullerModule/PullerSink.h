@@ -13,15 +13,38 @@
 #include "BasicUsageEnvironment.hh"
 #include "API_PullerModule.h"
 
+class FrameDistributor; // forward
+class TsDemuxer; // forward
+class DispatchQueue; // forward
+class PullerFrame; // forward
+class ShmFrameWriter; // forward
+
 class PullerSink: public MediaSink {
 public:
   static PullerSink* createNew(UsageEnvironment& env,
 			      MediaSubsession& subsession, // identifies the kind of data that's being received
-			      char const* streamId = NULL); // identifies the stream itself (optional)
+			      char const* streamId = NULL, // identifies the stream itself (optional)
+			      unsigned receiveBufferSize = 0);
+      // "receiveBufferSize" 0 means "automatic": the size is chosen from the SDP description, and then
+      // grows whenever a frame is truncated.  Returns NULL if the process's memory budget can't afford the buffer.
+
+  static unsigned autoReceiveBufferSize(MediaSubsession& subsession);
 
   int setCallbackFunc(PullerCallback cbFunc, void* cbParam);
+  void setFrameDistributor(FrameDistributor* distributor, Boolean retRtpPkt);
+  void enableTsDemux(); // for "MP2T" subsessions: deliver elementary-stream frames instead of TS packets
+  void setAsyncDelivery(unsigned queueSize, AsyncOverflowPolicy policy, AsyncDeliveryStats& stats);
+      // the callback is then called from the dispatcher's thread pool, rather than from the event loop
+  void setReceiveStats(ReceiveStats& stats); // which we then keep up to date (shared with the client's other sinks)
+  void enableSocketBufferTuning();
+      // (for RTP over UDP) sizes the RTP socket's receive buffer from the stream's bitrate, then grows it to hold
+      // the largest burst (i.e., frame) seen so far, and whenever the kernel has to drop packets
+  Boolean enableScatterDelivery(FramedSource& source);
+      // frames are then delivered as lists of chunks of the source's packets (via "CB_SCATTER_DATA"),
+      // rather than being copied into our receive buffer.  Returns False if "source" can't do this.
 private:
-  PullerSink(UsageEnvironment& env, MediaSubsession& subsession, char const* streamId);
+  PullerSink(UsageEnvironment& env, MediaSubsession& subsession, char const* streamId,
+	     unsigned receiveBufferSize, Boolean autoGrow);
     // called only by "createNew()"
   virtual ~PullerSink();
 
@@ -32,16 +55,53 @@ private:
   void afterGettingFrame(unsigned frameSize, unsigned numTruncatedBytes,
 			 struct timeval presentationTime, unsigned durationInMicroseconds);
 
+  void growReceiveBuffer(unsigned minSize);
+  void deliverScatteredFrame(unsigned frameSize, struct timeval presentationTime);
+  void updateReceiveStats(unsigned frameSize);
+  void growSocketBuffer(unsigned requestedSize);
+  RtpExtInfo const* curExtInfo(); // the current frame's RTP header extensions (NULL if none)
+  PullerFrame* setFrameTiming(PullerFrame* frame); // from our RTP source's current frame; returns "frame"
+
+  static void onDemuxedFrame(void* clientData, unsigned pid, unsigned char streamType,
+			     unsigned char const* data, unsigned size, Boolean hasPTS, u_int64_t pts90kHz);
+  void distributeFrame(unsigned char const* data, unsigned size, struct timeval presentationTime,
+		       unsigned rtpTimestamp, Boolean isKeyFrame, char const* mediumName,
+		       char const* codecName, Boolean cacheable); // (for frames that aren't RTP source frames)
+  void distributeFrame(PullerFrame* frame, Boolean cacheable); // takes over our reference to "frame"
+  void writeShmFrame(ShmFrameWriter& shmWriter, FrameChunk const* chunks, unsigned numChunks, unsigned size,
+		     struct timeval presentationTime, unsigned rtpTimestamp, Boolean isKeyFrame, char const* mediumName,
+		     char const* codecName, Boolean isSourceFrame); // (timing comes from our RTP source iff "isSourceFrame")
+
 private:
   // redefined virtual functions:
   virtual Boolean continuePlaying();
 
 private:
   u_int8_t* fReceiveBuffer;
+  unsigned m_receiveBufferSize;
+  Boolean m_growReceiveBuffer;
   MediaSubsession& fSubsession;
   char* fStreamId;
   PullerCallback m_callbackFunc;
   void* m_cbParam;
+  FrameDistributor* m_distributor;
+  Boolean m_retRtpPkt;
+  Boolean m_isH264;
+  TsDemuxer* m_tsDemuxer;
+  DispatchQueue* m_dispatchQueue;
+  struct timeval m_curPresentationTime; // of the TS packets being demultiplexed
+  MultiFramedRTPSource* m_scatterSource; // non-NULL iff frames are delivered as chunks
+  FrameChunk* m_chunks;
+  unsigned m_maxNumChunks;
+  ReceiveStats* m_receiveStats; // if any
+  ReceiveStats m_publishedStats; // our contribution to "*m_receiveStats"
+  struct timeval m_lastStatsTime;
+  Groupsock* m_tunedGroupsock; // non-NULL iff we're tuning its receive buffer
+  unsigned m_socketBufferRequest;
+  Boolean m_socketBufferLimited; // the OS won't let the buffer grow any more
+  u_int32_t m_lastKernelDrops;
+  MultiFramedRTPSource* m_multiFramedSource; // if our subsession's RTP source is one (for header extensions)
+  RtpExtInfo m_extInfo; // what "curExtInfo()" returns
 };
 
 
@@ -0,0 +1,146 @@
+/**
+ * @file ShmFrameWriter.cpp
+ * @brief  1.0
+ *		implementation of ShmFrameWriter
+ * @author lizhiyong0804319@gmail.com
+ * @version 1.0
+ * @date 2026-10-19
+ */
+
+#include "ShmFrameWriter.h"
+#include "MemoryBudget.h"
+
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SLOTS_OFFSET (2*SHM_RING_PAGE_SIZE) // after the control page and the header
+
+static size_t roundUpToPage(size_t size) {
+  return (size + SHM_RING_PAGE_SIZE - 1)/SHM_RING_PAGE_SIZE*SHM_RING_PAGE_SIZE;
+}
+
+ShmFrameWriter* ShmFrameWriter::createNew(unsigned numSlots, unsigned dataSize) {
+  if (numSlots == 0 || dataSize == 0) return NULL;
+  unsigned powerOfTwo = 1;
+  while (powerOfTwo < numSlots && powerOfTwo < 0x80000000) powerOfTwo <<= 1;
+  numSlots = powerOfTwo;
+
+  size_t slotsSize = roundUpToPage((size_t)numSlots*sizeof (ShmSlot));
+  size_t dataAreaSize = roundUpToPage(dataSize);
+  size_t totalSize = SLOTS_OFFSET + slotsSize + dataAreaSize;
+  if (!MemoryBudget::reserve(totalSize)) return NULL;
+
+  // Seal the size, so that no reader can shrink the memfd under us (which would make our writes fault):
+  int fd = (int)syscall(SYS_memfd_create, "RTSPPuller-frames", MFD_CLOEXEC|MFD_ALLOW_SEALING);
+  unsigned char* base = NULL;
+  if (fd >= 0 && ftruncate(fd, totalSize) == 0 && fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK|F_SEAL_GROW|F_SEAL_SEAL) == 0) {
+    void* p = mmap(NULL, totalSize, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p != MAP_FAILED) base = (unsigned char*)p;
+  }
+  if (base == NULL) {
+    if (fd >= 0) close(fd);
+    MemoryBudget::charge(-(long long)totalSize);
+    return NULL;
+  }
+
+  ShmFrameWriter* writer = new ShmFrameWriter(fd, base, totalSize);
+  ShmRingHeader* header = writer->m_header;
+  header->numSlots = numSlots;
+  header->slotSize = sizeof (ShmSlot);
+  header->slotsOffset = SLOTS_OFFSET;
+  header->dataOffset = SLOTS_OFFSET + slotsSize;
+  header->dataSize = dataAreaSize;
+  header->writerPid = (uint32_t)getpid();
+  header->version = SHM_RING_VERSION;
+  __atomic_store_n(&header->magic, (uint32_t)SHM_RING_MAGIC, __ATOMIC_RELEASE); // (the ring is now valid)
+  writer->m_slots = (ShmSlot*)(base + header->slotsOffset);
+  writer->m_data = base + header->dataOffset;
+  return writer;
+}
+
+ShmFrameWriter::ShmFrameWriter(int fd, unsigned char* base, size_t mappedSize)
+  : m_fd(fd), m_base(base), m_mappedSize(mappedSize),
+    m_control((ShmRingControl*)base), m_header((ShmRingHeader*)(base + SHM_RING_PAGE_SIZE)),
+    m_slots(NULL), m_data(NULL), m_writeSeq(0), m_dataHead(0) {
+}
+
+ShmFrameWriter::~ShmFrameWriter() {
+  __atomic_store_n(&m_header->closed, 1, __ATOMIC_RELEASE);
+  __atomic_add_fetch(&m_control->futexWord, 1, __ATOMIC_SEQ_CST);
+  syscall(SYS_futex, &m_control->futexWord, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+
+  munmap(m_base, m_mappedSize);
+  close(m_fd);
+  MemoryBudget::charge(-(long long)m_mappedSize);
+}
+
+void ShmFrameWriter::write(unsigned char const* data, unsigned size, ShmFrameInfo const& info) {
+  FrameChunk chunk;
+  chunk.dataBuf = (char const*)data;
+  chunk.bufLen = (int)size;
+  write(&chunk, 1, size, info);
+}
+
+void ShmFrameWriter::write(FrameChunk const* chunks, unsigned numChunks, unsigned size, ShmFrameInfo const& info) {
+  u_int64_t dataSize = m_header->dataSize;
+  if (size > dataSize) {
+    __atomic_add_fetch(&m_header->framesTooLarge, 1, __ATOMIC_RELAXED);
+    return;
+  }
+
+  // A frame's data is contiguous, so if it doesn't fit before the end of the data area, it begins at the start:
+  u_int64_t position = m_dataHead%dataSize;
+  if (position + size > dataSize) {
+    m_dataHead += dataSize - position;
+    position = 0;
+  }
+  u_int64_t dataOffset = m_dataHead;
+  m_dataHead += (size + SHM_RING_DATA_ALIGNMENT - 1)/SHM_RING_DATA_ALIGNMENT*SHM_RING_DATA_ALIGNMENT;
+
+  // Mark the slot, and the data that we're about to overwrite, as invalid, before we touch them:
+  u_int64_t n = m_writeSeq;
+  ShmSlot* slot = &m_slots[n&(m_header->numSlots - 1)];
+  __atomic_store_n(&slot->seq, 2*n + 1, __ATOMIC_RELAXED);
+  __atomic_store_n(&m_header->dataHead, m_dataHead, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+
+  slot->dataOffset = dataOffset;
+  slot->size = size;
+  slot->flags = (info.isKeyFrame ? SHM_FRAME_KEY : 0)|(info.isDiscontinuity ? SHM_FRAME_DISCONTINUITY : 0);
+  slot->rtpTimestamp = info.rtpTimestamp;
+  slot->ptsSec = (uint32_t)info.presentationTime.tv_sec;
+  slot->ptsUsec = (uint32_t)info.presentationTime.tv_usec;
+  slot->extRtpTimestamp = info.extRtpTimestamp;
+  slot->monoPtsUs = info.monoPtsUs;
+  strncpy(slot->mediumName, info.mediumName != NULL ? info.mediumName : "", sizeof slot->mediumName - 1);
+  slot->mediumName[sizeof slot->mediumName - 1] = '\0';
+  strncpy(slot->codecName, info.codecName != NULL ? info.codecName : "", sizeof slot->codecName - 1);
+  slot->codecName[sizeof slot->codecName - 1] = '\0';
+  unsigned char* to = m_data + position;
+  for (unsigned i = 0; i < numChunks; ++i) {
+    memcpy(to, chunks[i].dataBuf, chunks[i].bufLen);
+    to += chunks[i].bufLen;
+  }
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  slot->writeTimeNs = (u_int64_t)now.tv_sec*1000000000 + now.tv_nsec;
+
+  // Publish the frame:
+  __atomic_store_n(&slot->seq, 2*n + 2, __ATOMIC_RELEASE);
+  m_writeSeq = n + 1;
+  __atomic_store_n(&m_header->writeSeq, m_writeSeq, __ATOMIC_RELEASE);
+
+  // Wake any waiting readers.  (The full fence orders our "writeSeq" store before our "numWaiters" load,
+  // so a reader that's about to wait either sees the new frame, or is seen by us.)
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&m_control->numWaiters, __ATOMIC_RELAXED) != 0) {
+    __atomic_add_fetch(&m_control->futexWord, 1, __ATOMIC_RELEASE);
+    syscall(SYS_futex, &m_control->futexWord, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+  }
+}
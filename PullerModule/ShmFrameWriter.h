@@ -0,0 +1,64 @@
+/**
+ * @file ShmFrameWriter.h
+ * @brief  Writes a stream's frames into a shared-memory ring, for reader processes
+ * @author lizhiyong0804319@gmail.com
+ * @version 1.0
+ * @date 2026-10-19
+ */
+
+#ifndef SHM_FRAME_WRITER_H
+#define SHM_FRAME_WRITER_H
+
+#include "API_PullerModule.h"
+#include "Boolean.hh"
+#include "NetCommon.h"
+#include "shm/ShmFrameRing.h"
+
+#include <sys/time.h>
+
+// The writer side of "shm/ShmFrameRing.h": a memfd that any number of local processes can map
+// (read-only, but for the control page), and read with "shm/ShmReader.h".  The sink writes each
+// frame straight from its receive buffer (or from the RTP packets, for scatter delivery) into the
+// ring - a single copy, and no system call unless a reader is waiting for it.  We never wait for
+// readers; one that falls behind loses (and counts) frames.
+
+struct ShmFrameInfo {
+  unsigned rtpTimestamp;
+  struct timeval presentationTime;
+  Boolean isKeyFrame;
+  Boolean isDiscontinuity;
+  u_int64_t extRtpTimestamp;
+  u_int64_t monoPtsUs;
+  char const* mediumName;
+  char const* codecName;
+};
+
+class ShmFrameWriter {
+public:
+  static ShmFrameWriter* createNew(unsigned numSlots, unsigned dataSize);
+      // "numSlots" is rounded up to a power of two, and "dataSize" to a whole number of pages.
+      // Returns NULL if the memfd couldn't be created (or the memory budget can't afford it).
+  ~ShmFrameWriter(); // marks the ring as closed (waking any waiting readers); readers keep their mappings
+
+  int fd() const { return m_fd; } // for passing to readers (or they may open "/proc/<pid>/fd/<fd>")
+
+  // Writes a frame (given as a list of chunks, or as a single buffer); called only from the stream's event loop thread:
+  void write(FrameChunk const* chunks, unsigned numChunks, unsigned size, ShmFrameInfo const& info);
+  void write(unsigned char const* data, unsigned size, ShmFrameInfo const& info);
+
+private:
+  ShmFrameWriter(int fd, unsigned char* base, size_t mappedSize);
+
+private:
+  int m_fd;
+  unsigned char* m_base;
+  size_t m_mappedSize;
+  ShmRingControl* m_control;
+  ShmRingHeader* m_header;
+  ShmSlot* m_slots;
+  unsigned char* m_data;
+  u_int64_t m_writeSeq; // our copies of the header's fields
+  u_int64_t m_dataHead;
+};
+
+#endif
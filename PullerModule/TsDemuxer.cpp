@@ -0,0 +1,325 @@
+/**
+ * @file TsDemuxer.cpp
+ * @brief  1.0
+ *		implementation of TsDemuxer
+ * @author lizhiyong0804319@gmail.com
+ * @version 1.0
+ * @date 2026-10-19
+ */
+
+#include "TsDemuxer.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define TS_DEMUXER_USE_SIMD 1
+#include <immintrin.h>
+#endif
+
+#define TRANSPORT_SYNC_BYTE 0x47
+#define PAT_PID 0x0000
+
+////////// Packet filter //////////
+
+// Examines up to 32 consecutive TS packets.  Returns a mask in which bit i is set iff packet i has
+// a sync byte and one of the "numPIDs" wanted PIDs.  Packets without a sync byte are flagged in "badSync".
+typedef u_int32_t (PacketFilterFunc)(unsigned char const* pkts, unsigned numPackets,
+				     u_int16_t const* pids, unsigned numPIDs, u_int32_t& badSync);
+
+static u_int32_t filterPacketsScalar(unsigned char const* pkts, unsigned numPackets,
+				     u_int16_t const* pids, unsigned numPIDs, u_int32_t& badSync) {
+  u_int32_t wanted = 0;
+  badSync = 0;
+  for (unsigned i = 0; i < numPackets; ++i, pkts += TS_PACKET_SIZE) {
+    if (pkts[0] != TRANSPORT_SYNC_BYTE) {
+      badSync |= 1u<<i;
+      continue;
+    }
+    u_int16_t pid = ((pkts[1]&0x1F)<<8)|pkts[2];
+    for (unsigned j = 0; j < numPIDs; ++j) {
+      if (pid == pids[j]) {
+	wanted |= 1u<<i;
+	break;
+      }
+    }
+  }
+  return wanted;
+}
+
+#ifdef TS_DEMUXER_USE_SIMD
+// Gathers the 4-byte headers of 8 packets at a time, and tests their sync bytes and PIDs in parallel:
+__attribute__((target("avx2")))
+static u_int32_t filterPacketsAVX2(unsigned char const* pkts, unsigned numPackets,
+				   u_int16_t const* pids, unsigned numPIDs, u_int32_t& badSync) {
+  __m256i const offsets = _mm256_setr_epi32(0, TS_PACKET_SIZE, 2*TS_PACKET_SIZE, 3*TS_PACKET_SIZE,
+					    4*TS_PACKET_SIZE, 5*TS_PACKET_SIZE, 6*TS_PACKET_SIZE, 7*TS_PACKET_SIZE);
+  __m256i const byteMask = _mm256_set1_epi32(0xFF);
+  __m256i const syncByte = _mm256_set1_epi32(TRANSPORT_SYNC_BYTE);
+
+  u_int32_t wanted = 0;
+  badSync = 0;
+  unsigned i = 0;
+  for (; i + 8 <= numPackets; i += 8) {
+    __m256i header = _mm256_i32gather_epi32((int const*)(pkts + i*TS_PACKET_SIZE), offsets, 1);
+    __m256i syncOK = _mm256_cmpeq_epi32(_mm256_and_si256(header, byteMask), syncByte);
+    __m256i pid = _mm256_or_si256(_mm256_slli_epi32(_mm256_and_si256(_mm256_srli_epi32(header, 8), _mm256_set1_epi32(0x1F)), 8),
+				  _mm256_and_si256(_mm256_srli_epi32(header, 16), byteMask));
+    __m256i match = _mm256_setzero_si256();
+    for (unsigned j = 0; j < numPIDs; ++j) {
+      match = _mm256_or_si256(match, _mm256_cmpeq_epi32(pid, _mm256_set1_epi32(pids[j])));
+    }
+    match = _mm256_and_si256(match, syncOK);
+
+    wanted |= (u_int32_t)_mm256_movemask_ps(_mm256_castsi256_ps(match)) << i;
+    badSync |= (u_int32_t)(~_mm256_movemask_ps(_mm256_castsi256_ps(syncOK)) & 0xFF) << i;
+  }
+  if (i < numPackets) {
+    u_int32_t tailBadSync;
+    wanted |= filterPacketsScalar(pkts + i*TS_PACKET_SIZE, numPackets - i, pids, numPIDs, tailBadSync) << i;
+    badSync |= tailBadSync << i;
+  }
+  return wanted;
+}
+#endif
+
+static PacketFilterFunc* choosePacketFilter() {
+#ifdef TS_DEMUXER_USE_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return filterPacketsAVX2;
+#endif
+  return filterPacketsScalar;
+}
+
+static u_int32_t filterPackets(unsigned char const* pkts, unsigned numPackets,
+			       u_int16_t const* pids, unsigned numPIDs, u_int32_t& badSync) {
+  static PacketFilterFunc* filterPacketsImpl = choosePacketFilter();
+  return (*filterPacketsImpl)(pkts, numPackets, pids, numPIDs, badSync);
+}
+
+
+////////// TsDemuxer implementation //////////
+
+TsDemuxer::TsDemuxer(FrameHandler* handler, void* clientData)
+  : m_handler(handler), m_clientData(clientData), m_pmtPID(-1), m_numStreams(0),
+    m_numFilterPIDs(0), m_filterChanged(False), m_numSyncErrors(0), m_numContinuityErrors(0),
+    m_numOversizedPESPackets(0) {
+  rebuildPIDFilter();
+}
+
+TsDemuxer::~TsDemuxer() {
+}
+
+char const* TsDemuxer::codecName(unsigned char streamType) {
+  switch (streamType) {
+  case 0x01: case 0x02: return "MPV";
+  case 0x03: case 0x04: return "MPA";
+  case 0x0F: return "AAC"; // ADTS
+  case 0x10: return "MP4V-ES";
+  case 0x1B: return "H264";
+  case 0x24: return "H265";
+  case 0x81: return "AC3";
+  default: return NULL;
+  }
+}
+
+char const* TsDemuxer::mediumName(unsigned char streamType) {
+  switch (streamType) {
+  case 0x01: case 0x02: case 0x10: case 0x1B: case 0x24: return "video";
+  case 0x03: case 0x04: case 0x0F: case 0x81: return "audio";
+  default: return NULL;
+  }
+}
+
+void TsDemuxer::feed(unsigned char const* data, unsigned size) {
+  unsigned numPackets = size/TS_PACKET_SIZE;
+
+  for (unsigned first = 0; first < numPackets; first += 32) {
+    unsigned count = numPackets - first < 32 ? numPackets - first : 32;
+    unsigned char const* pkts = data + first*TS_PACKET_SIZE;
+
+    u_int32_t badSync;
+    u_int32_t wanted = filterPackets(pkts, count, m_filterPIDs, m_numFilterPIDs, badSync);
+    m_numSyncErrors += __builtin_popcount(badSync);
+
+    while (wanted != 0) {
+      unsigned i = __builtin_ctz(wanted);
+      wanted &= wanted - 1;
+      m_filterChanged = False;
+      handlePacket(pkts + i*TS_PACKET_SIZE);
+
+      if (m_filterChanged && i + 1 < count) {
+	// A new PAT or PMT changed the set of wanted PIDs, so re-filter the rest of this batch:
+	u_int32_t restBadSync;
+	wanted = filterPackets(pkts + (i+1)*TS_PACKET_SIZE, count - (i+1),
+			       m_filterPIDs, m_numFilterPIDs, restBadSync) << (i+1);
+      }
+    }
+  }
+}
+
+void TsDemuxer::handlePacket(unsigned char const* pkt) {
+  if (pkt[1]&0x80) return; // transport_error_indicator
+
+  Boolean payloadUnitStart = (pkt[1]&0x40) != 0;
+  u_int16_t pid = ((pkt[1]&0x1F)<<8)|pkt[2];
+  unsigned char adaptationFieldControl = (pkt[3]&0x30)>>4;
+  if ((adaptationFieldControl&0x1) == 0) return; // no payload
+
+  unsigned payloadOffset = 4;
+  if (adaptationFieldControl&0x2) payloadOffset += 1 + pkt[4];
+  if (payloadOffset >= TS_PACKET_SIZE) return;
+  unsigned char const* payload = &pkt[payloadOffset];
+  unsigned payloadSize = TS_PACKET_SIZE - payloadOffset;
+
+  if (pid == PAT_PID || (int)pid == m_pmtPID) {
+    if (!payloadUnitStart) return; // (we assume that each section fits within one packet)
+    unsigned pointerField = payload[0];
+    if (1 + pointerField >= payloadSize) return;
+    if (pid == PAT_PID) {
+      handlePAT(payload + 1 + pointerField, payloadSize - 1 - pointerField);
+    } else {
+      handlePMT(payload + 1 + pointerField, payloadSize - 1 - pointerField);
+    }
+    return;
+  }
+
+  for (unsigned i = 0; i < m_numStreams; ++i) {
+    if (m_streams[i].pid == pid) {
+      handlePayload(m_streams[i], pkt, payload, payloadSize, payloadUnitStart);
+      return;
+    }
+  }
+}
+
+void TsDemuxer::handlePAT(unsigned char const* section, unsigned size) {
+  if (size < 8 || section[0] != 0x00) return; // table_id must be "program_association_section"
+  unsigned sectionLength = ((section[1]&0x0F)<<8)|section[2];
+  if (sectionLength < 9 || 3 + sectionLength > size) return;
+
+  // Use the first program (i.e., the first entry that's not the network PID):
+  unsigned char const* end = section + 3 + sectionLength - 4; // excluding the CRC
+  for (unsigned char const* p = section + 8; p + 4 <= end; p += 4) {
+    u_int16_t programNumber = (p[0]<<8)|p[1];
+    if (programNumber == 0) continue;
+
+    int pmtPID = ((p[2]&0x1F)<<8)|p[3];
+    if (pmtPID != m_pmtPID) {
+      m_pmtPID = pmtPID;
+      m_numStreams = 0; // until we see the new PMT
+      rebuildPIDFilter();
+    }
+    return;
+  }
+}
+
+void TsDemuxer::handlePMT(unsigned char const* section, unsigned size) {
+  if (size < 12 || section[0] != 0x02) return; // table_id must be "TS_program_map_section"
+  unsigned sectionLength = ((section[1]&0x0F)<<8)|section[2];
+  if (sectionLength < 13 || 3 + sectionLength > size) return;
+  unsigned programInfoLength = ((section[10]&0x0F)<<8)|section[11];
+
+  // Collect the elementary streams whose types we know:
+  u_int16_t pids[TS_MAX_ELEMENTARY_STREAMS];
+  unsigned char streamTypes[TS_MAX_ELEMENTARY_STREAMS];
+  unsigned numStreams = 0;
+  unsigned char const* end = section + 3 + sectionLength - 4; // excluding the CRC
+  for (unsigned char const* p = section + 12 + programInfoLength;
+       p + 5 <= end && numStreams < TS_MAX_ELEMENTARY_STREAMS;
+       p += 5 + (((p[3]&0x0F)<<8)|p[4])) {
+    if (codecName(p[0]) == NULL) continue;
+    streamTypes[numStreams] = p[0];
+    pids[numStreams] = ((p[1]&0x1F)<<8)|p[2];
+    ++numStreams;
+  }
+
+  // The PMT is repeated often; only reset our state if it has actually changed:
+  Boolean changed = numStreams != m_numStreams;
+  for (unsigned i = 0; !changed && i < numStreams; ++i) {
+    changed = pids[i] != m_streams[i].pid || streamTypes[i] != m_streams[i].streamType;
+  }
+  if (!changed) return;
+
+  for (unsigned i = 0; i < numStreams; ++i) {
+    ElementaryStream& es = m_streams[i];
+    es.pid = pids[i];
+    es.streamType = streamTypes[i];
+    es.haveContinuityCounter = False;
+    es.havePESStart = False;
+    es.pesBuffer.clear();
+  }
+  m_numStreams = numStreams;
+  rebuildPIDFilter();
+}
+
+void TsDemuxer::handlePayload(ElementaryStream& es, unsigned char const* pkt,
+			      unsigned char const* payload, unsigned size, Boolean payloadUnitStart) {
+  // Check the continuity counter; on a gap, the PES packet that's in progress is unusable:
+  unsigned char continuityCounter = pkt[3]&0x0F;
+  if (es.haveContinuityCounter) {
+    if (continuityCounter == es.lastContinuityCounter) return; // a duplicate packet
+    if (continuityCounter != ((es.lastContinuityCounter + 1)&0x0F)) {
+      ++m_numContinuityErrors;
+      es.havePESStart = False;
+      es.pesBuffer.clear();
+    }
+  }
+  es.lastContinuityCounter = continuityCounter;
+  es.haveContinuityCounter = True;
+
+  if (payloadUnitStart) {
+    // A new PES packet begins, so the previous one (if any) is complete:
+    if (es.havePESStart) deliverPES(es);
+    es.havePESStart = True;
+    es.pesBuffer.clear();
+  }
+  if (!es.havePESStart) return; // we're waiting for the start of a PES packet
+
+  // A PES packet of unbounded length (as video often is) ends only when the next one starts; if that
+  // doesn't happen for too long, discard what we have (and free its memory) rather than grow without limit:
+  if (es.pesBuffer.size() + size > TS_MAX_PES_PACKET_SIZE) {
+    ++m_numOversizedPESPackets;
+    es.havePESStart = False;
+    std::vector<unsigned char>().swap(es.pesBuffer);
+    return;
+  }
+  es.pesBuffer.insert(es.pesBuffer.end(), payload, payload + size);
+
+  // If the PES packet has an explicit length (as audio usually does), deliver it as soon as it's complete:
+  if (es.pesBuffer.size() >= 6) {
+    unsigned pesPacketLength = (es.pesBuffer[4]<<8)|es.pesBuffer[5];
+    if (pesPacketLength > 0 && es.pesBuffer.size() >= 6 + pesPacketLength) {
+      deliverPES(es);
+      es.havePESStart = False;
+    }
+  }
+}
+
+void TsDemuxer::deliverPES(ElementaryStream& es) {
+  unsigned char const* pes = es.pesBuffer.empty() ? NULL : &es.pesBuffer[0];
+  unsigned size = (unsigned)es.pesBuffer.size();
+  if (size < 9 || pes[0] != 0x00 || pes[1] != 0x00 || pes[2] != 0x01) return;
+
+  unsigned pesPacketLength = (pes[4]<<8)|pes[5];
+  if (pesPacketLength > 0 && 6 + pesPacketLength < size) size = 6 + pesPacketLength;
+  unsigned headerSize = 9 + pes[8];
+  if (headerSize > size) return;
+
+  Boolean hasPTS = (pes[7]&0x80) != 0 && headerSize >= 14;
+  u_int64_t pts = 0;
+  if (hasPTS) {
+    pts = ((u_int64_t)((pes[9]>>1)&0x07)<<30) | (pes[10]<<22) | ((pes[11]>>1)<<15)
+      | (pes[12]<<7) | (pes[13]>>1);
+  }
+
+  if (size > headerSize) {
+    (*m_handler)(m_clientData, es.pid, es.streamType, pes + headerSize, size - headerSize, hasPTS, pts);
+  }
+}
+
+void TsDemuxer::rebuildPIDFilter() {
+  m_filterChanged = True;
+  m_numFilterPIDs = 0;
+  m_filterPIDs[m_numFilterPIDs++] = PAT_PID;
+  if (m_pmtPID >= 0) m_filterPIDs[m_numFilterPIDs++] = (u_int16_t)m_pmtPID;
+  for (unsigned i = 0; i < m_numStreams; ++i) {
+    m_filterPIDs[m_numFilterPIDs++] = m_streams[i].pid;
+  }
+}
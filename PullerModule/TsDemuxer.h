@@ -0,0 +1,78 @@
+/**
+ * @file TsDemuxer.h
+ * @brief  MPEG-2 Transport Stream demultiplexer (TS packets in, elementary-stream frames out)
+ * @author lizhiyong0804319@gmail.com
+ * @version 1.0
+ * @date 2026-10-19
+ */
+
+#ifndef TS_DEMUXER_H
+#define TS_DEMUXER_H
+
+#include "Boolean.hh"
+#include "NetCommon.h"
+
+#include <vector>
+
+#define TS_PACKET_SIZE 188
+#define TS_MAX_ELEMENTARY_STREAMS 16
+#define TS_MAX_PES_PACKET_SIZE (8*1024*1024) // larger PES packets (of unbounded length) are discarded
+
+// Fed with the sync-aligned TS packets that "MPEG2TransportStreamFramer" delivers for a "MP2T"
+// subsession.  Follows the PAT and PMT to find the elementary stream PIDs, reassembles each PES
+// packet, and hands the PES payload (one access unit, for the usual encoders) to a handler.
+// PSI sections are assumed to fit within a single TS packet, as they do for single-program streams.
+
+class TsDemuxer {
+public:
+  typedef void (FrameHandler)(void* clientData, unsigned pid, unsigned char streamType,
+			      unsigned char const* data, unsigned size,
+			      Boolean hasPTS, u_int64_t pts90kHz);
+
+  TsDemuxer(FrameHandler* handler, void* clientData);
+  ~TsDemuxer();
+
+  void feed(unsigned char const* data, unsigned size); // an integral number of TS packets
+
+  unsigned numSyncErrors() const { return m_numSyncErrors; }
+  unsigned numContinuityErrors() const { return m_numContinuityErrors; }
+  unsigned numOversizedPESPackets() const { return m_numOversizedPESPackets; }
+
+  // Codec and medium names (as used in SDP) for a PMT "stream_type", or NULL if not supported:
+  static char const* codecName(unsigned char streamType);
+  static char const* mediumName(unsigned char streamType);
+
+private:
+  struct ElementaryStream {
+    u_int16_t pid;
+    unsigned char streamType;
+    unsigned char lastContinuityCounter;
+    Boolean haveContinuityCounter;
+    Boolean havePESStart;
+    std::vector<unsigned char> pesBuffer;
+  };
+
+  void handlePacket(unsigned char const* pkt);
+  void handlePAT(unsigned char const* section, unsigned size);
+  void handlePMT(unsigned char const* section, unsigned size);
+  void handlePayload(ElementaryStream& es, unsigned char const* pkt,
+		     unsigned char const* payload, unsigned size, Boolean payloadUnitStart);
+  void deliverPES(ElementaryStream& es);
+  void rebuildPIDFilter();
+
+private:
+  FrameHandler* m_handler;
+  void* m_clientData;
+  int m_pmtPID; // -1 until the PAT has been seen
+  unsigned m_numStreams;
+  ElementaryStream m_streams[TS_MAX_ELEMENTARY_STREAMS];
+  // The PIDs that we care about (PAT, PMT, then the elementary streams), for the packet filter:
+  u_int16_t m_filterPIDs[TS_MAX_ELEMENTARY_STREAMS + 2];
+  unsigned m_numFilterPIDs;
+  Boolean m_filterChanged; // set by "rebuildPIDFilter()"
+  unsigned m_numSyncErrors;
+  unsigned m_numContinuityErrors;
+  unsigned m_numOversizedPESPackets;
+};
+
+#endif
@@ -0,0 +1,175 @@
+/**
+ * @file ShmBench.cpp
+ * @brief  1.0
+ *		benchmark of the shared-memory frame ring: one writer (this process), and reader child processes
+ *		that check every frame they get, and report their latency and losses
+ * @author lizhiyong0804319@gmail.com
+ * @version 1.0
+ * @date 2026-10-19
+ */
+
+#include "ShmFrameWriter.h"
+#include "shm/ShmReader.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+static u_int64_t nowNs() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (u_int64_t)now.tv_sec*1000000000 + now.tv_nsec;
+}
+
+// Frame sizes vary (from half to one and a half times "frameSize"), so that the data area wraps at odd places:
+static unsigned frameSizeOf(u_int64_t seq, unsigned frameSize) {
+  return frameSize/2 + (unsigned)((seq*7919)%(frameSize + 1));
+}
+
+static unsigned char patternByte(unsigned i) {
+  return (unsigned char)(i*31 + 7);
+}
+
+// Each frame begins and ends with its sequence number; the rest is a fixed pattern:
+static Boolean frameIsValid(ShmFrame const& frame, unsigned frameSize) {
+  u_int64_t head, tail;
+  if (frame.size != frameSizeOf(frame.seq, frameSize)) return False;
+  memcpy(&head, frame.data, sizeof head);
+  memcpy(&tail, frame.data + frame.size - sizeof tail, sizeof tail);
+  if (head != frame.seq || tail != frame.seq) return False;
+  unsigned mid = frame.size/2;
+  return frame.data[mid] == patternByte(mid);
+}
+
+static void runReader(int fd, int readyFd, unsigned index, unsigned frameSize, unsigned numFrames) {
+  ShmReader* reader = ShmReader_OpenFd(fd);
+  char ready = reader != NULL ? 1 : 0;
+  if (write(readyFd, &ready, 1) != 1 || reader == NULL) _exit(1);
+
+  std::vector<u_int64_t> latencies;
+  latencies.reserve(numFrames);
+  u_int64_t received = 0, overwritten = 0, corrupt = 0;
+  ShmFrame frame;
+  while (ShmReader_Next(reader, &frame, -1) == 1) {
+    u_int64_t latency = nowNs() - frame.writeTimeNs;
+    Boolean isValid = frameIsValid(frame, frameSize);
+    if (!ShmReader_Check(reader, &frame)) {
+      ++overwritten; // while we were reading it; not an error
+      continue;
+    }
+    if (!isValid) ++corrupt; // intact, but wrong: a protocol error
+    ++received;
+    latencies.push_back(latency);
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+  u_int64_t p50 = 0, p99 = 0, p999 = 0, max = 0;
+  if (!latencies.empty()) {
+    p50 = latencies[latencies.size()*50/100];
+    p99 = latencies[latencies.size()*99/100];
+    p999 = latencies[latencies.size()*999/1000];
+    max = latencies.back();
+  }
+  printf("reader %u: %llu frames, %llu lost, %llu overwritten, %llu corrupt; latency p50 %.1f us, p99 %.1f us, p99.9 %.1f us, max %.1f us\n",
+	 index, (unsigned long long)received, (unsigned long long)ShmReader_FramesLost(reader),
+	 (unsigned long long)overwritten, (unsigned long long)corrupt,
+	 p50/1000.0, p99/1000.0, p999/1000.0, max/1000.0);
+  fflush(stdout);
+  ShmReader_Close(reader);
+  _exit(corrupt == 0 ? 0 : 2);
+}
+
+static void usage(char const* progName) {
+  fprintf(stderr, "usage: %s [-r readers] [-s frameSize] [-n numFrames] [-k numSlots] [-m dataMB] [-f framesPerSecond (0: unpaced)]\n",
+	  progName);
+  exit(1);
+}
+
+int main(int argc, char** argv) {
+  unsigned numReaders = 2, frameSize = 64*1024, numFrames = 200000, numSlots = 1024, dataMB = 64, rate = 0;
+  int opt;
+  while ((opt = getopt(argc, argv, "r:s:n:k:m:f:")) != -1) {
+    switch (opt) {
+    case 'r': numReaders = atoi(optarg); break;
+    case 's': frameSize = atoi(optarg); break;
+    case 'n': numFrames = atoi(optarg); break;
+    case 'k': numSlots = atoi(optarg); break;
+    case 'm': dataMB = atoi(optarg); break;
+    case 'f': rate = atoi(optarg); break;
+    default: usage(argv[0]);
+    }
+  }
+  if (frameSize < 64) usage(argv[0]);
+
+  ShmFrameWriter* writer = ShmFrameWriter::createNew(numSlots, dataMB*1024*1024);
+  if (writer == NULL) {
+    fprintf(stderr, "failed to create the ring\n");
+    return 1;
+  }
+
+  int readyPipe[2];
+  if (pipe(readyPipe) != 0) return 1;
+  std::vector<pid_t> readers;
+  for (unsigned i = 0; i < numReaders; ++i) {
+    pid_t pid = fork();
+    if (pid == 0) {
+      close(readyPipe[0]);
+      runReader(writer->fd(), readyPipe[1], i, frameSize, numFrames); // (the memfd is inherited across "fork()")
+    }
+    if (pid > 0) readers.push_back(pid);
+  }
+  close(readyPipe[1]);
+  for (unsigned i = 0; i < readers.size(); ++i) {
+    char ready;
+    if (read(readyPipe[0], &ready, 1) != 1 || !ready) {
+      fprintf(stderr, "a reader failed to open the ring\n");
+      return 1;
+    }
+  }
+  close(readyPipe[0]);
+
+  std::vector<unsigned char> buffer(frameSize*3/2 + 1);
+  for (unsigned i = 0; i < buffer.size(); ++i) buffer[i] = patternByte(i);
+  ShmFrameInfo info;
+  memset(&info, 0, sizeof info);
+  info.mediumName = "video";
+  info.codecName = "H264";
+
+  u_int64_t bytes = 0;
+  u_int64_t start = nowNs();
+  for (u_int64_t seq = 0; seq < numFrames; ++seq) {
+    if (rate > 0) {
+      u_int64_t due = start + seq*1000000000/rate;
+      struct timespec dueTime;
+      dueTime.tv_sec = due/1000000000;
+      dueTime.tv_nsec = due%1000000000;
+      clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &dueTime, NULL);
+    }
+    unsigned size = frameSizeOf(seq, frameSize);
+    memcpy(&buffer[0], &seq, sizeof seq);
+    memcpy(&buffer[size - sizeof seq], &seq, sizeof seq);
+    info.rtpTimestamp = (unsigned)(seq*3000);
+    info.isKeyFrame = seq%25 == 0;
+    writer->write(&buffer[0], size, info);
+    // Restore the pattern where the sequence number went (the head is overwritten by the next one anyway):
+    for (unsigned i = size - sizeof seq; i < size; ++i) buffer[i] = patternByte(i);
+    bytes += size;
+  }
+  double seconds = (nowNs() - start)/1e9;
+  printf("writer: %u frames, %.1f MB in %.3f s: %.0f frames/s, %.2f GB/s\n",
+	 numFrames, bytes/1e6, seconds, numFrames/seconds, bytes/seconds/1e9);
+  fflush(stdout);
+  delete writer; // closes the ring, so the readers finish
+
+  int failures = 0;
+  for (unsigned i = 0; i < readers.size(); ++i) {
+    int status;
+    if (waitpid(readers[i], &status, 0) != readers[i] || !WIFEXITED(status) || WEXITSTATUS(status) != 0) ++failures;
+  }
+  return failures == 0 ? 0 : 1;
+}
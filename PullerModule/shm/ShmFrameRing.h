@@ -0,0 +1,87 @@
+/**
+ * @file ShmFrameRing.h
+ * @brief  The layout of a stream's shared-memory frame ring, as written by the puller and read by "ShmReader"
+ * @author lizhiyong0804319@gmail.com
+ * @version 1.0
+ * @date 2026-10-19
+ */
+
+#ifndef SHM_FRAME_RING_H
+#define SHM_FRAME_RING_H
+
+#include <stdint.h>
+
+/*
+ * The ring is a (sealed) memfd, laid out as:
+ *   page 0:  ShmRingControl - the only part that readers map writable
+ *   page 1:  ShmRingHeader
+ *   then:    "numSlots" ShmSlots (a power of two; frame n is in slot n%numSlots)
+ *   then:    the data area, "dataSize" bytes, holding each frame's data contiguously
+ *
+ * There's one writer (the stream's event loop thread), which never waits for readers: a reader
+ * that falls behind loses frames.  To write frame n, the writer
+ *   1. sets its slot's "seq" to 2n+1 (odd: being written), and advances "dataHead" past the data it's
+ *      about to overwrite (data offsets are logical - they only ever increase - and a frame's data is
+ *      at "dataOffset % dataSize"), then issues a release fence;
+ *   2. fills in the slot and the data;
+ *   3. sets "seq" to 2n+2 (complete), then "writeSeq" to n+1 (both release stores);
+ *   4. if "numWaiters" is non-zero, increments "futexWord" and FUTEX_WAKEs it.
+ * A reader that wants frame n (< "writeSeq") loads its slot's "seq" (acquire); if that's 2n+2, it reads
+ * the frame, then issues an acquire fence and checks that "seq" is unchanged, and that the data is intact,
+ * i.e. "dataHead - dataOffset <= dataSize" (a seqlock).  Otherwise, the frame has been overwritten.
+ * To wait, a reader loads "futexWord", increments "numWaiters", re-checks "writeSeq", FUTEX_WAITs on
+ * "futexWord" (a shared - not private - futex) and then decrements "numWaiters".
+ */
+
+#define SHM_RING_MAGIC 0x4D485352 /* "RSHM" */
+#define SHM_RING_VERSION 1
+#define SHM_RING_PAGE_SIZE 4096
+#define SHM_RING_DATA_ALIGNMENT 64 /* of each frame's data */
+
+#define SHM_FRAME_KEY 0x01 /* a key frame (SPS, PPS or IDR) */
+#define SHM_FRAME_DISCONTINUITY 0x02 /* a timestamp discontinuity, as for "FrameData" */
+
+typedef struct ShmRingControl {
+  uint32_t futexWord; /* incremented (by the writer) to wake readers */
+  uint32_t numWaiters; /* readers that are waiting, or about to */
+} ShmRingControl;
+
+typedef struct ShmRingHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t numSlots;
+  uint32_t slotSize; /* sizeof (ShmSlot) */
+  uint64_t slotsOffset; /* from the start of the ring */
+  uint64_t dataOffset; /* likewise */
+  uint64_t dataSize;
+  uint32_t closed; /* set once the writer has gone */
+  uint32_t writerPid;
+  uint8_t pad0[64 - 48];
+
+  uint64_t writeSeq; /* the number of frames written */
+  uint8_t pad1[64 - 8];
+
+  uint64_t dataHead; /* the logical data offset up to which data may have been (over)written */
+  uint8_t pad2[64 - 8];
+
+  uint64_t framesTooLarge; /* for the data area, so not written */
+} ShmRingHeader;
+
+typedef struct ShmSlot {
+  uint64_t seq; /* 2n+1 while frame n is being written; 2n+2 once it's complete */
+  uint64_t dataOffset; /* logical */
+  uint32_t size;
+  uint32_t flags; /* SHM_FRAME_* */
+  uint32_t rtpTimestamp;
+  uint32_t ptsSec; /* presentation time */
+  uint32_t ptsUsec;
+  uint32_t reserved;
+  uint64_t extRtpTimestamp; /* as for "FrameData" */
+  uint64_t monoPtsUs; /* likewise */
+  uint64_t writeTimeNs; /* CLOCK_MONOTONIC, when the frame was written */
+  char mediumName[16]; /* e.g. "video" */
+  char codecName[16]; /* e.g. "H264" */
+  uint8_t pad[128 - 96];
+} ShmSlot;
+
+#endif
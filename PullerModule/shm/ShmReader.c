@@ -0,0 +1,189 @@
+/**
+ * @file ShmReader.c
+ * @brief  1.0
+ *		implementation of the shared-memory frame ring reader
+ * @author lizhiyong0804319@gmail.com
+ * @version 1.0
+ * @date 2026-10-19
+ */
+
+#define _GNU_SOURCE
+#include "ShmReader.h"
+#include "ShmFrameRing.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+struct ShmReader {
+  unsigned char* base;
+  size_t mappedSize;
+  ShmRingControl* control; /* writable, if the fd was */
+  int canWait; /* we can count ourselves in "numWaiters" (so the writer will wake us) */
+  const ShmRingHeader* header;
+  const ShmSlot* slots;
+  const unsigned char* data;
+  uint64_t nextSeq;
+  uint64_t framesLost;
+};
+
+#define POLL_INTERVAL_MS 1 /* for waiting, if we can't be woken */
+
+ShmReader* ShmReader_Open(const char* path) {
+  int fd = open(path, O_RDWR|O_CLOEXEC);
+  if (fd < 0) fd = open(path, O_RDONLY|O_CLOEXEC);
+  if (fd < 0) return NULL;
+
+  ShmReader* reader = ShmReader_OpenFd(fd);
+  close(fd);
+  return reader;
+}
+
+ShmReader* ShmReader_OpenFd(int fd) {
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < 2*SHM_RING_PAGE_SIZE) return NULL;
+  size_t size = (size_t)st.st_size;
+
+  /* Map everything read-only, then (if we may) the control page writable over it: */
+  void* base = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+  if (base == MAP_FAILED) return NULL;
+  int canWait = (fcntl(fd, F_GETFL) & O_ACCMODE) == O_RDWR
+    && mmap(base, SHM_RING_PAGE_SIZE, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_FIXED, fd, 0) != MAP_FAILED;
+
+  const ShmRingHeader* header = (const ShmRingHeader*)((unsigned char*)base + SHM_RING_PAGE_SIZE);
+  if (__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != SHM_RING_MAGIC || header->version != SHM_RING_VERSION
+      || header->slotSize != sizeof (ShmSlot) || header->numSlots == 0 || (header->numSlots & (header->numSlots - 1)) != 0
+      || header->slotsOffset + (uint64_t)header->numSlots*sizeof (ShmSlot) > header->dataOffset
+      || header->dataOffset + header->dataSize > size) {
+    munmap(base, size);
+    return NULL;
+  }
+
+  ShmReader* reader = (ShmReader*)calloc(1, sizeof (ShmReader));
+  if (reader == NULL) {
+    munmap(base, size);
+    return NULL;
+  }
+  reader->base = (unsigned char*)base;
+  reader->mappedSize = size;
+  reader->control = (ShmRingControl*)base;
+  reader->canWait = canWait;
+  reader->header = header;
+  reader->slots = (const ShmSlot*)(reader->base + header->slotsOffset);
+  reader->data = reader->base + header->dataOffset;
+  reader->nextSeq = __atomic_load_n(&header->writeSeq, __ATOMIC_ACQUIRE);
+  return reader;
+}
+
+void ShmReader_Close(ShmReader* reader) {
+  if (reader == NULL) return;
+  munmap(reader->base, reader->mappedSize);
+  free(reader);
+}
+
+uint64_t ShmReader_FramesLost(const ShmReader* reader) {
+  return reader->framesLost;
+}
+
+static int dataIsIntact(const ShmReader* reader, uint64_t dataOffset) {
+  /* (Called after an acquire fence.)  The writer advances "dataHead" before overwriting anything: */
+  uint64_t dataHead = __atomic_load_n(&reader->header->dataHead, __ATOMIC_RELAXED);
+  return dataHead - dataOffset <= reader->header->dataSize;
+}
+
+int ShmReader_Check(ShmReader* reader, const ShmFrame* frame) {
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  return dataIsIntact(reader, frame->dataOffset);
+}
+
+/* Tries to read frame "nextSeq" (which has been written); returns 0 (having counted it as lost) if it has been overwritten: */
+static int readFrame(ShmReader* reader, uint64_t writeSeq, ShmFrame* frame) {
+  uint32_t numSlots = reader->header->numSlots;
+  uint64_t n = reader->nextSeq;
+  if (writeSeq - n > numSlots) { /* the frames before the newest "numSlots" are gone */
+    reader->framesLost += writeSeq - numSlots - n;
+    n = writeSeq - numSlots;
+  }
+  reader->nextSeq = n + 1;
+
+  const ShmSlot* slot = &reader->slots[n & (numSlots - 1)];
+  uint64_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+  if (seq != 2*n + 2) {
+    ++reader->framesLost;
+    return 0;
+  }
+  frame->seq = n;
+  frame->dataOffset = slot->dataOffset;
+  frame->size = slot->size;
+  frame->flags = slot->flags;
+  frame->rtpTimestamp = slot->rtpTimestamp;
+  frame->ptsSec = slot->ptsSec;
+  frame->ptsUsec = slot->ptsUsec;
+  frame->extRtpTimestamp = slot->extRtpTimestamp;
+  frame->monoPtsUs = slot->monoPtsUs;
+  frame->writeTimeNs = slot->writeTimeNs;
+  memcpy(frame->mediumName, slot->mediumName, sizeof frame->mediumName);
+  memcpy(frame->codecName, slot->codecName, sizeof frame->codecName);
+  frame->mediumName[sizeof frame->mediumName - 1] = '\0';
+  frame->codecName[sizeof frame->codecName - 1] = '\0';
+
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != seq || frame->size > reader->header->dataSize
+      || !dataIsIntact(reader, frame->dataOffset)) {
+    ++reader->framesLost;
+    return 0;
+  }
+  frame->data = reader->data + frame->dataOffset % reader->header->dataSize;
+  return 1;
+}
+
+static uint64_t nowMs(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec*1000 + now.tv_nsec/1000000;
+}
+
+/* Waits (for at most "timeoutMs", if >= 0) until a frame after "nextSeq" may have been written, or the ring is closed: */
+static void waitForFrame(ShmReader* reader, int timeoutMs) {
+  struct timespec timeout;
+  if (!reader->canWait && (timeoutMs < 0 || timeoutMs > POLL_INTERVAL_MS)) timeoutMs = POLL_INTERVAL_MS;
+  timeout.tv_sec = timeoutMs/1000;
+  timeout.tv_nsec = (long)(timeoutMs%1000)*1000000;
+
+  uint32_t word = __atomic_load_n(&reader->control->futexWord, __ATOMIC_ACQUIRE);
+  if (reader->canWait) __atomic_add_fetch(&reader->control->numWaiters, 1, __ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&reader->header->writeSeq, __ATOMIC_SEQ_CST) == reader->nextSeq
+      && !__atomic_load_n(&reader->header->closed, __ATOMIC_ACQUIRE)) {
+    syscall(SYS_futex, &reader->control->futexWord, FUTEX_WAIT, word, timeoutMs >= 0 ? &timeout : NULL, NULL, 0);
+  }
+  if (reader->canWait) __atomic_sub_fetch(&reader->control->numWaiters, 1, __ATOMIC_RELEASE);
+}
+
+int ShmReader_Next(ShmReader* reader, ShmFrame* frame, int timeoutMs) {
+  uint64_t deadline = timeoutMs > 0 ? nowMs() + (uint64_t)timeoutMs : 0;
+  for (;;) {
+    uint64_t writeSeq = __atomic_load_n(&reader->header->writeSeq, __ATOMIC_ACQUIRE);
+    if (writeSeq != reader->nextSeq) {
+      if (readFrame(reader, writeSeq, frame)) return 1;
+      continue;
+    }
+    if (__atomic_load_n(&reader->header->closed, __ATOMIC_ACQUIRE)) return -1;
+
+    int remainingMs = -1;
+    if (timeoutMs == 0) return 0;
+    if (timeoutMs > 0) {
+      uint64_t now = nowMs();
+      if (now >= deadline) return 0;
+      remainingMs = (int)(deadline - now);
+    }
+    waitForFrame(reader, remainingMs);
+  }
+}
@@ -0,0 +1,91 @@
+/**
+ * @file ShmReader.h
+ * @brief  A small C library for reading a stream's frames from its shared-memory ring (see RTSP_Puller_EnableShmOutput)
+ * @author lizhiyong0804319@gmail.com
+ * @version 1.0
+ * @date 2026-10-19
+ */
+
+#ifndef SHM_READER_H
+#define SHM_READER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct ShmReader ShmReader;
+
+typedef struct ShmFrame
+{
+	const unsigned char*	data;			/* 帧数据, 直接指向共享内存 (只读); 使用后须以 ShmReader_Check 确认未被覆盖 */
+	uint32_t		size;				/* 数据长度 */
+	uint32_t		flags;				/* SHM_FRAME_KEY, SHM_FRAME_DISCONTINUITY 的组合 (见 ShmFrameRing.h) */
+	uint64_t		seq;				/* 帧序号, 自0开始连续递增; 不连续说明有帧丢失 */
+	uint32_t		rtpTimestamp;		/* RTP时间戳 */
+	uint32_t		ptsSec;				/* 显示时间: 秒 */
+	uint32_t		ptsUsec;			/* 显示时间: 微秒 */
+	uint64_t		extRtpTimestamp;	/* 64位RTP时间戳, 同 FrameData */
+	uint64_t		monoPtsUs;			/* 单调显示时间(微秒), 同 FrameData */
+	uint64_t		writeTimeNs;		/* 写入时间 (CLOCK_MONOTONIC, 纳秒), 可用于计算延迟 */
+	char			mediumName[16];		/* 媒体类型, 如 "video" */
+	char			codecName[16];		/* 编码名称, 如 "H264" */
+	uint64_t		dataOffset;			/* 内部使用 */
+} ShmFrame;
+
+/**
+ * @brief  ShmReader_Open
+ *		打开帧环形缓冲区. 同一用户的本机进程可直接打开拉流进程的 "/proc/<pid>/fd/<fd>" (fd 见 RTSP_Puller_GetShmFd),
+ *		也可通过 fork 继承或 Unix 域套接字 (SCM_RIGHTS) 获得 fd 后使用 ShmReader_OpenFd. 除一个控制页外均以只读方式映射.
+ *		从打开时最新的帧开始读取
+ * @param path		路径
+ *
+ * @return  返回读取器, 失败返回NULL
+ */
+ShmReader* ShmReader_Open(const char* path);
+
+/**
+ * @brief  ShmReader_OpenFd
+ *		同 ShmReader_Open, 使用已有的 fd (读取器不接管此 fd, 调用者可随即关闭)
+ */
+ShmReader* ShmReader_OpenFd(int fd);
+
+/**
+ * @brief  ShmReader_Next
+ *		取下一帧. 写入方从不等待读取方: 读取不及时被覆盖的帧会被跳过, 计入 ShmReader_FramesLost.
+ *		返回的数据指向共享内存, 不复制; 处理完毕后以 ShmReader_Check 确认期间未被覆盖
+ * @param reader		读取器
+ * @param frame			输出帧信息
+ * @param timeoutMs		无新帧时的等待时间(毫秒), <0 表示一直等待, 0 表示不等待
+ *
+ * @return  1: 取得一帧; 0: 超时; -1: 写入方已关闭 (拉流句柄已释放), 且已读完全部帧
+ */
+int ShmReader_Next(ShmReader* reader, ShmFrame* frame, int timeoutMs);
+
+/**
+ * @brief  ShmReader_Check
+ *		检查 ShmReader_Next 返回的帧数据是否仍然完整 (未被写入方覆盖). 在使用 (或复制) 数据之后调用;
+ *		返回0时, 此前读到的数据可能已损坏, 应丢弃
+ *
+ * @return  1: 完整; 0: 已被覆盖
+ */
+int ShmReader_Check(ShmReader* reader, const ShmFrame* frame);
+
+/**
+ * @brief  ShmReader_FramesLost
+ *		获取因读取不及时而丢失 (被覆盖) 的帧数
+ */
+uint64_t ShmReader_FramesLost(const ShmReader* reader);
+
+/**
+ * @brief  ShmReader_Close
+ *		关闭读取器, 解除映射
+ */
+void ShmReader_Close(ShmReader* reader);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
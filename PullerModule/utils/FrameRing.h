@@ -0,0 +1,78 @@
+/**
+ * @file FrameRing.h
+ * @brief  Bounded lock-free ring of frame references
+ * @author lizhiyong0804319@gmail.com
+ * @version 1.0
+ * @date 2026-10-19
+ */
+
+#ifndef FRAME_RING_H
+#define FRAME_RING_H
+
+#include "../PullerFrame.h"
+
+#include <stddef.h>
+
+// A single-producer/single-consumer ring of "PullerFrame*".  Each slot owns one reference.
+// In addition to the usual "push()"/"pop()", the producer may steal the oldest entry with
+// "dropOldest()"; the consumer and the producer then race on "m_head" with a CAS, and only
+// the winner takes the slot's reference.  The producer only ever writes into a slot after
+// "m_head" has moved past it, so a consumer that loses the race never uses a stale value.
+
+class FrameRing {
+public:
+  FrameRing(unsigned capacity) : m_head(0), m_tail(0) {
+    unsigned size = 2;
+    while (size < capacity) size <<= 1;
+    m_mask = size - 1;
+    m_slots = new PullerFrame*[size];
+  }
+  ~FrameRing() {
+    PullerFrame* frame;
+    while ((frame = pop()) != NULL) frame->release();
+    delete[] m_slots;
+  }
+
+  unsigned capacity() const { return m_mask + 1; }
+  unsigned size() const {
+    return __atomic_load_n(&m_tail, __ATOMIC_ACQUIRE) - __atomic_load_n(&m_head, __ATOMIC_ACQUIRE);
+  }
+  Boolean isEmpty() const { return size() == 0; }
+
+  // Producer side.  Takes over the caller's reference on success; returns False if full:
+  Boolean push(PullerFrame* frame) {
+    unsigned tail = m_tail;
+    if (tail - __atomic_load_n(&m_head, __ATOMIC_ACQUIRE) > m_mask) return False;
+    __atomic_store_n(&m_slots[tail & m_mask], frame, __ATOMIC_RELAXED);
+    __atomic_store_n(&m_tail, tail + 1, __ATOMIC_RELEASE);
+    return True;
+  }
+
+  // Consumer side (the producer may also call this, via "dropOldest()").
+  // Returns NULL if empty; otherwise the caller owns the returned reference.  If "seqNum" is given,
+  // it's set to the entry's position in the order of "push()"es (starting from 0, modulo 2^32):
+  PullerFrame* pop(unsigned* seqNum = NULL) {
+    for (;;) {
+      unsigned head = __atomic_load_n(&m_head, __ATOMIC_ACQUIRE);
+      if (head == __atomic_load_n(&m_tail, __ATOMIC_ACQUIRE)) return NULL;
+      PullerFrame* frame = __atomic_load_n(&m_slots[head & m_mask], __ATOMIC_RELAXED);
+      if (__sync_bool_compare_and_swap(&m_head, head, head + 1)) {
+	if (seqNum != NULL) *seqNum = head;
+	return frame;
+      }
+    }
+  }
+  PullerFrame* dropOldest() { return pop(); }
+
+private:
+  FrameRing(const FrameRing&);
+  FrameRing& operator=(const FrameRing&);
+
+private:
+  PullerFrame** m_slots;
+  unsigned m_mask;
+  unsigned m_head; // next slot to be read; advanced (by CAS) by either side
+  unsigned m_tail; // next slot to be written; advanced only by the producer
+};
+
+#endif
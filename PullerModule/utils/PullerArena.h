@@ -0,0 +1,80 @@
+/**
+ * @file PullerArena.h
+ * @brief  One contiguous allocation for the objects of many streams
+ * @author lizhiyong0804319@gmail.com
+ * @version 1.0
+ * @date 2026-10-19
+ */
+
+#ifndef PULLER_ARENA_H
+#define PULLER_ARENA_H
+
+#include <stddef.h>
+#include <stdlib.h>
+
+// A block of "numSlots" equally-sized slots, each big enough for one object of "objectSize"
+// bytes, plus a header that records which arena (if any) the object came from.  Slots are
+// cache-line aligned, so that objects that are used by different threads don't share lines.
+// The block is freed when the last slot is released (the slots may be released in any order,
+// and from any thread).
+
+class PullerArena;
+
+struct PullerArenaSlotHeader {
+  PullerArena* arena; // NULL for an object that was allocated on its own
+  char pad[64 - sizeof(PullerArena*)];
+};
+
+class PullerArena {
+public:
+  static PullerArena* createNew(size_t objectSize, unsigned numSlots) {
+    size_t slotSize = (sizeof(PullerArenaSlotHeader) + objectSize + 63) & ~(size_t)63;
+    void* block = NULL;
+    if (numSlots == 0 || posix_memalign(&block, 64, slotSize*numSlots) != 0) return NULL;
+    return new PullerArena((char*)block, slotSize, numSlots);
+  }
+
+  // Returns the memory for the object in slot "index":
+  void* slot(unsigned index) {
+    PullerArenaSlotHeader* header = (PullerArenaSlotHeader*)(m_block + index*m_slotSize);
+    header->arena = this;
+    return header + 1;
+  }
+
+  // Releases one slot (whether or not an object was ever placed in it).
+  // The arena deletes itself when every slot has been released:
+  void releaseSlot() {
+    if (__sync_sub_and_fetch(&m_numLiveSlots, 1) == 0) delete this;
+  }
+
+  // For an object's "operator new"/"operator delete" (for objects that aren't in an arena):
+  static void* allocateStandalone(size_t objectSize) {
+    PullerArenaSlotHeader* header = (PullerArenaSlotHeader*)malloc(sizeof(PullerArenaSlotHeader) + objectSize);
+    if (header == NULL) return NULL;
+    header->arena = NULL;
+    return header + 1;
+  }
+  static void deallocate(void* object) {
+    if (object == NULL) return;
+    PullerArenaSlotHeader* header = (PullerArenaSlotHeader*)object - 1;
+    if (header->arena != NULL) {
+      header->arena->releaseSlot();
+    } else {
+      free(header);
+    }
+  }
+
+private:
+  PullerArena(char* block, size_t slotSize, unsigned numSlots)
+    : m_block(block), m_slotSize(slotSize), m_numLiveSlots(numSlots) {}
+  ~PullerArena() { free(m_block); }
+  PullerArena(const PullerArena&);
+  PullerArena& operator=(const PullerArena&);
+
+private:
+  char* m_block;
+  size_t m_slotSize;
+  volatile unsigned m_numLiveSlots;
+};
+
+#endif
@@ -18,6 +18,9 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 // Implementation
 
 #include "UsageEnvironment.hh"
+#if !defined(__WIN32__) && !defined(_WIN32)
+#include <time.h>
+#endif
 
 void UsageEnvironment::reclaim() {
   // We delete ourselves only if we have no remainining state:
@@ -51,6 +54,25 @@ void TaskScheduler::rescheduleDelayedTask(TaskToken& task,
   task = scheduleDelayedTask(microseconds, proc, clientData);
 }
 
+struct timeval TaskScheduler::loopTime() {
+  struct timeval result;
+#if defined(CLOCK_MONOTONIC)
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  result.tv_sec = ts.tv_sec;
+  result.tv_usec = ts.tv_nsec/1000;
+#else
+  gettimeofday(&result, NULL); // there's no monotonic clock to be had
+#endif
+  return result;
+}
+
+struct timeval TaskScheduler::loopWallClockTime() {
+  struct timeval result;
+  gettimeofday(&result, NULL);
+  return result;
+}
+
 // By default, we handle 'should not occur'-type library errors by calling abort().  Subclasses can redefine this, if desired.
 void TaskScheduler::internalError() {
   abort();
@@ -144,6 +144,7 @@ public:
   virtual EventTriggerId createEventTrigger(TaskFunc* eventHandlerProc) = 0;
       // Creates a 'trigger' for an event, which - if it occurs - will be handled (from the event loop) using "eventHandlerProc".
       // (Returns 0 iff no such trigger can be created (e.g., because of implementation limits on the number of triggers).)
+      // Note: An "EventTriggerId" identifies a single trigger; two or more of them cannot be 'or'ed together.
   virtual void deleteEventTrigger(EventTriggerId eventTriggerId) = 0;
 
   virtual void triggerEvent(EventTriggerId eventTriggerId, void* clientData = NULL) = 0;
@@ -157,6 +158,13 @@ public:
   }
   void turnOffBackgroundReadHandling(int socketNum) { disableBackgroundHandling(socketNum); }
 
+  // The time at which the current iteration of the event loop began - from a monotonic clock (which, unlike
+  // the 'wall clock', doesn't jump when the system's time is changed) - and the 'wall clock' time at that moment.
+  // Schedulers that sample these once per iteration make them cheap enough to use for every incoming packet;
+  // the default implementations just read the clocks:
+  virtual struct timeval loopTime();
+  virtual struct timeval loopWallClockTime();
+
   virtual void internalError(); // used to 'handle' a 'should not occur'-type error condition within the library.
 
 protected:
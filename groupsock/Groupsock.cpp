@@ -103,7 +103,9 @@ Groupsock::Groupsock(UsageEnvironment& env, struct in_addr const& groupAddr,
 		     Port port, u_int8_t ttl)
   : OutputSocket(env, port),
     deleteIfNoMembers(False), isSlave(False),
-    fIncomingGroupEId(groupAddr, port.num(), ttl), fDests(NULL), fTTL(ttl) {
+    fIncomingGroupEId(groupAddr, port.num(), ttl), fDests(NULL), fTTL(ttl), fReceiveTimestamps(False), fCountKernelDrops(False), fCoalescing(False),
+    fNumKernelDrops(0), fLastSegmentSize(0) {
+  fLastReceiveTime.tv_sec = fLastReceiveTime.tv_usec = 0;
   addDestination(groupAddr, port);
 
   if (!socketJoinGroup(env, socketNum(), groupAddr.s_addr)) {
@@ -131,7 +133,9 @@ Groupsock::Groupsock(UsageEnvironment& env, struct in_addr const& groupAddr,
   : OutputSocket(env, port),
     deleteIfNoMembers(False), isSlave(False),
     fIncomingGroupEId(groupAddr, sourceFilterAddr, port.num()),
-    fDests(NULL), fTTL(255) {
+    fDests(NULL), fTTL(255), fReceiveTimestamps(False), fCountKernelDrops(False), fCoalescing(False),
+    fNumKernelDrops(0), fLastSegmentSize(0) {
+  fLastReceiveTime.tv_sec = fLastReceiveTime.tv_usec = 0;
   addDestination(groupAddr, port);
 
   // First try a SSM join.  If that fails, try a regular join:
@@ -190,8 +194,9 @@ Groupsock::changeDestinationParameters(struct in_addr const& newDestAddr,
   if (newDestPort.num() != 0) {
     if (newDestPort.num() != destPortNum
 	&& IsMulticastAddress(destAddr.s_addr)) {
-      // Also bind to the new port number:
+      // Also bind to the new port number (using a new socket, which needs the old one's options):
       changePort(newDestPort);
+      restoreSocketOptions();
       // And rejoin the multicast group:
       socketJoinGroup(env(), socketNum(), destAddr.s_addr);
     }
@@ -291,6 +296,30 @@ Boolean Groupsock::output(UsageEnvironment& env, u_int8_t ttlToSend,
   return False;
 }
 
+Boolean Groupsock::enableReceiveTimestamps() {
+  fReceiveTimestamps = ::enableReceiveTimestamps(socketNum());
+  return fReceiveTimestamps;
+}
+
+Boolean Groupsock::enableKernelDropCounting() {
+  fCountKernelDrops = ::enableKernelDropCounting(socketNum());
+  return fCountKernelDrops;
+}
+
+Boolean Groupsock::enableReceiveCoalescing() {
+  fCoalescing = ::enableReceiveCoalescing(socketNum());
+  return fCoalescing;
+}
+
+void Groupsock::restoreSocketOptions() {
+  if (fReceiveTimestamps) enableReceiveTimestamps();
+  if (fCountKernelDrops) {
+    enableKernelDropCounting();
+    fNumKernelDrops = 0; // the new socket's count starts again
+  }
+  if (fCoalescing) enableReceiveCoalescing();
+}
+
 Boolean Groupsock::handleRead(unsigned char* buffer, unsigned bufferMaxSize,
 			      unsigned& bytesRead,
 			      struct sockaddr_in& fromAddress) {
@@ -300,8 +329,9 @@ Boolean Groupsock::handleRead(unsigned char* buffer, unsigned bufferMaxSize,
   bytesRead = 0;
 
   int maxBytesToRead = bufferMaxSize - TunnelEncapsulationTrailerMaxSize;
-  int numBytes = readSocket(env(), socketNum(),
-			    buffer, maxBytesToRead, fromAddress);
+  int numBytes = fReceiveTimestamps || fCountKernelDrops || fCoalescing
+    ? readSocket(env(), socketNum(), buffer, maxBytesToRead, fromAddress, fLastReceiveTime, fNumKernelDrops, fLastSegmentSize)
+    : readSocket(env(), socketNum(), buffer, maxBytesToRead, fromAddress);
   if (numBytes < 0) {
     if (DebugLevel >= 0) { // this is a fatal error
       env().setResultMsg("Groupsock read failed: ",
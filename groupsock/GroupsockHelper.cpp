@@ -27,6 +27,7 @@ extern "C" int initializeWinsockIfNecessary();
 #include <stdarg.h>
 #include <time.h>
 #include <fcntl.h>
+#include <netinet/udp.h> // for "UDP_GRO" (if the OS has it)
 #define initializeWinsockIfNecessary() 1
 #endif
 #include <stdio.h>
@@ -264,13 +265,69 @@ int setupStreamSocket(UsageEnvironment& env,
   return newSocket;
 }
 
-int readSocket(UsageEnvironment& env,
-	       int socket, unsigned char* buffer, unsigned bufferSize,
-	       struct sockaddr_in& fromAddress) {
-  SOCKLEN_T addressSize = sizeof fromAddress;
-  int bytesRead = recvfrom(socket, (char*)buffer, bufferSize, 0,
-			   (struct sockaddr*)&fromAddress,
-			   &addressSize);
+static int readSocket1(UsageEnvironment& env,
+		      int socket, unsigned char* buffer, unsigned bufferSize,
+		      struct sockaddr_in& fromAddress, struct timeval* timeReceived,
+		      u_int32_t* numKernelDrops, unsigned* segmentSize) {
+  int bytesRead;
+#ifdef SO_TIMESTAMPNS
+  if (timeReceived != NULL) {
+    // Use "recvmsg()", to also get the datagram's arrival time (as an ancillary "SCM_TIMESTAMPNS" message),
+    // the socket's drop count (as an ancillary "SO_RXQ_OVFL" message), and - if several datagrams have been
+    // coalesced - their size (as an ancillary "UDP_GRO" message):
+    struct iovec iov;
+    iov.iov_base = buffer;
+    iov.iov_len = bufferSize;
+    union {
+      struct cmsghdr align;
+      char buf[CMSG_SPACE(sizeof (struct timespec)) + CMSG_SPACE(sizeof (u_int32_t)) + CMSG_SPACE(sizeof (int))];
+    } control;
+    struct msghdr msg;
+    memset(&msg, 0, sizeof msg);
+    msg.msg_name = &fromAddress;
+    msg.msg_namelen = sizeof fromAddress;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof control.buf;
+
+    timeReceived->tv_sec = timeReceived->tv_usec = 0; // unless we find a timestamp
+    if (segmentSize != NULL) *segmentSize = 0; // unless the datagrams were coalesced
+    bytesRead = recvmsg(socket, &msg, 0);
+    if (bytesRead >= 0) {
+      for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+#ifdef UDP_GRO
+	if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO && segmentSize != NULL) {
+	  int gsoSize;
+	  memcpy(&gsoSize, CMSG_DATA(cmsg), sizeof gsoSize);
+	  *segmentSize = gsoSize > 0 && gsoSize < bytesRead ? (unsigned)gsoSize : 0;
+	  continue;
+	}
+#endif
+	if (cmsg->cmsg_level != SOL_SOCKET) continue;
+	if (cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+	  struct timespec ts;
+	  memcpy(&ts, CMSG_DATA(cmsg), sizeof ts);
+	  timeReceived->tv_sec = ts.tv_sec;
+	  timeReceived->tv_usec = ts.tv_nsec/1000;
+#ifdef SO_RXQ_OVFL
+	} else if (cmsg->cmsg_type == SO_RXQ_OVFL && numKernelDrops != NULL) {
+	  memcpy(numKernelDrops, CMSG_DATA(cmsg), sizeof (u_int32_t));
+#endif
+	}
+      }
+    }
+  } else
+#else
+  if (timeReceived != NULL) timeReceived->tv_sec = timeReceived->tv_usec = 0; // we can't get timestamps
+  if (segmentSize != NULL) *segmentSize = 0;
+#endif
+  {
+    SOCKLEN_T addressSize = sizeof fromAddress;
+    bytesRead = recvfrom(socket, (char*)buffer, bufferSize, 0,
+			 (struct sockaddr*)&fromAddress,
+			 &addressSize);
+  }
   if (bytesRead < 0) {
     //##### HACK to work around bugs in Linux and Windows:
     int err = env.getErrno();
@@ -300,6 +357,19 @@ int readSocket(UsageEnvironment& env,
   return bytesRead;
 }
 
+int readSocket(UsageEnvironment& env,
+	       int socket, unsigned char* buffer, unsigned bufferSize,
+	       struct sockaddr_in& fromAddress) {
+  return readSocket1(env, socket, buffer, bufferSize, fromAddress, NULL, NULL, NULL);
+}
+
+int readSocket(UsageEnvironment& env,
+	       int socket, unsigned char* buffer, unsigned bufferSize,
+	       struct sockaddr_in& fromAddress, struct timeval& timeReceived,
+	       u_int32_t& numKernelDrops, unsigned& segmentSize) {
+  return readSocket1(env, socket, buffer, bufferSize, fromAddress, &timeReceived, &numKernelDrops, &segmentSize);
+}
+
 Boolean writeSocket(UsageEnvironment& env,
 		    int socket, struct in_addr address, Port port,
 		    u_int8_t ttlArg,
@@ -401,6 +471,42 @@ unsigned increaseReceiveBufferTo(UsageEnvironment& env,
   return increaseBufferTo(env, SO_RCVBUF, socket, requestedSize);
 }
 
+Boolean enableReceiveTimestamps(int socket) {
+#ifdef SO_TIMESTAMPNS
+  int enable = 1;
+  return setsockopt(socket, SOL_SOCKET, SO_TIMESTAMPNS, (const char*)&enable, sizeof enable) == 0;
+#else
+  return False;
+#endif
+}
+
+Boolean enableKernelDropCounting(int socket) {
+#ifdef SO_RXQ_OVFL
+  int enable = 1;
+  return setsockopt(socket, SOL_SOCKET, SO_RXQ_OVFL, (const char*)&enable, sizeof enable) == 0;
+#else
+  return False;
+#endif
+}
+
+Boolean enableReceiveCoalescing(int socket) {
+#if defined(UDP_GRO) && defined(SO_TIMESTAMPNS) // (we use "recvmsg()" only if we have the latter)
+  int enable = 1;
+  return setsockopt(socket, SOL_UDP, UDP_GRO, (const char*)&enable, sizeof enable) == 0;
+#else
+  return False;
+#endif
+}
+
+static void receiveOnlyJoinedGroups(int socket) {
+  // Several sockets (perhaps in different processes) may be bound to the same port (using "SO_REUSEPORT"), each
+  // joined to a different group.  By default, Linux would deliver each group's packets to all of them:
+#ifdef IP_MULTICAST_ALL
+  int multicastAll = 0;
+  setsockopt(socket, IPPROTO_IP, IP_MULTICAST_ALL, (const char*)&multicastAll, sizeof multicastAll);
+#endif
+}
+
 Boolean socketJoinGroup(UsageEnvironment& env, int socket,
 			netAddressBits groupAddress){
   if (!IsMulticastAddress(groupAddress)) return True; // ignore this case
@@ -421,6 +527,7 @@ Boolean socketJoinGroup(UsageEnvironment& env, int socket,
     }
 #endif
   }
+  receiveOnlyJoinedGroups(socket);
 
   return True;
 }
@@ -483,6 +590,7 @@ Boolean socketJoinGroupSSM(UsageEnvironment& env, int socket,
     socketErr(env, "setsockopt(IP_ADD_SOURCE_MEMBERSHIP) error: ");
     return False;
   }
+  receiveOnlyJoinedGroups(socket);
 
   return True;
 }
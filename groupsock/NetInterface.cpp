@@ -103,9 +103,9 @@ Boolean Socket::changePort(Port newPort) {
     return False;
   }
 
-  if (fSocketNum != oldSocketNum) { // the socket number has changed, so move any event handling for it:
-    fEnv.taskScheduler().moveSocketHandling(oldSocketNum, fSocketNum);
-  }
+  // Move any event handling for the socket - even if its number hasn't changed, because closing the old socket
+  // will have removed it from the kernel's interest set (for an "epoll()"-based scheduler), so it must be re-added:
+  fEnv.taskScheduler().moveSocketHandling(oldSocketNum, fSocketNum);
   return True;
 }
 
@@ -116,6 +116,16 @@ public:
 
   void multicastSendOnly(); // send, but don't receive any multicast packets
 
+  Boolean enableReceiveTimestamps(); // asks the kernel to timestamp each incoming packet (if it can)
+  struct timeval const& lastReceiveTime() const { return fLastReceiveTime; }
+      // the kernel's ('wall clock') timestamp of the packet that was read most recently; zero if unknown
+  Boolean enableKernelDropCounting(); // asks the kernel to report how many incoming packets it has dropped
+  u_int32_t numKernelDrops() const { return fNumKernelDrops; }
+      // the number of packets that the kernel has dropped (because our receive buffer was full), as of the last read
+  Boolean enableReceiveCoalescing(); // lets the kernel coalesce incoming packets (see "readSocket()")
+  unsigned lastSegmentSize() const { return fLastSegmentSize; }
+      // the size of each of the packets that were coalesced into the most recent read; 0 if there was just one
+
   Boolean output(UsageEnvironment& env, u_int8_t ttl,
 		 unsigned char* buffer, unsigned bufferSize,
 		 DirectedNetInterface* interfaceNotToFwdBackTo = NULL);
@@ -143,6 +153,7 @@ public: // redefined virtual functions
 			     struct sockaddr_in& fromAddress);
 
 private:
+  void restoreSocketOptions(); // after our socket has been replaced (by "changePort()")
   int outputToAllMembersExcept(DirectedNetInterface* exceptInterface,
 			       u_int8_t ttlToFwd,
 			       unsigned char* data, unsigned size,
@@ -153,6 +164,10 @@ private:
   destRecord* fDests;
   u_int8_t fTTL;
   DirectedNetInterfaceSet fMembers;
+  Boolean fReceiveTimestamps, fCountKernelDrops, fCoalescing; // if any is set, we read using "recvmsg()"
+  struct timeval fLastReceiveTime;
+  u_int32_t fNumKernelDrops;
+  unsigned fLastSegmentSize;
 };
 
 UsageEnvironment& operator<<(UsageEnvironment& s, const Groupsock& g);
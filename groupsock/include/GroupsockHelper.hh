@@ -32,6 +32,17 @@ int setupStreamSocket(UsageEnvironment& env,
 int readSocket(UsageEnvironment& env,
 	       int socket, unsigned char* buffer, unsigned bufferSize,
 	       struct sockaddr_in& fromAddress);
+int readSocket(UsageEnvironment& env,
+	       int socket, unsigned char* buffer, unsigned bufferSize,
+	       struct sockaddr_in& fromAddress, struct timeval& timeReceived,
+	       u_int32_t& numKernelDrops, unsigned& segmentSize);
+    // also returns the kernel's ('wall clock') timestamp of the datagram's arrival - if the socket has had
+    // "enableReceiveTimestamps()" called on it - or else a zero "timeReceived".  If the socket has had
+    // "enableKernelDropCounting()" called on it, "numKernelDrops" is updated to the total number of
+    // datagrams that the kernel has dropped (because the socket's receive buffer was full).  If the
+    // socket has had "enableReceiveCoalescing()" called on it, then "buffer" may hold several datagrams
+    // (from the same sender), back-to-back; each of them - except perhaps the last, which may be shorter -
+    // is "segmentSize" bytes long.  (Otherwise, "segmentSize" is 0.)
 
 Boolean writeSocket(UsageEnvironment& env,
 		    int socket, struct in_addr address, Port port,
@@ -49,6 +60,12 @@ unsigned increaseSendBufferTo(UsageEnvironment& env,
 unsigned increaseReceiveBufferTo(UsageEnvironment& env,
 				 int socket, unsigned requestedSize);
 
+Boolean enableReceiveTimestamps(int socket); // returns False if the OS can't timestamp incoming datagrams
+Boolean enableKernelDropCounting(int socket); // returns False if the OS can't count them
+Boolean enableReceiveCoalescing(int socket);
+    // lets the kernel coalesce incoming datagrams (Linux's "UDP_GRO"); returns False if it can't.
+    // Note that the socket must then be read with a buffer that's big enough for any coalesced datagrams (64 KB).
+
 Boolean makeSocketNonBlocking(int sock);
 Boolean makeSocketBlocking(int sock);
 
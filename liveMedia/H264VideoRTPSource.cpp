@@ -56,12 +56,44 @@ H264VideoRTPSource
 		     unsigned char rtpPayloadFormat,
 		     unsigned rtpTimestampFrequency)
   : MultiFramedRTPSource(env, RTPgs, rtpPayloadFormat, rtpTimestampFrequency,
-			 new H264BufferedPacketFactory) {
+			 new H264BufferedPacketFactory),
+    fFilterMode(FILTER_NONE), fGOPInterval(1), fGOPCount(0),
+    fDroppingCurrentNALUnit(False),
+    fNumFilteredPackets(0) {
 }
 
 H264VideoRTPSource::~H264VideoRTPSource() {
 }
 
+void H264VideoRTPSource::setFrameFilter(FrameFilterMode mode, unsigned gopInterval) {
+  fFilterMode = mode;
+  fGOPInterval = gopInterval == 0 ? 1 : gopInterval;
+  fGOPCount = 0;
+  fGOPBoundaryDetector.reset();
+  fDroppingCurrentNALUnit = False;
+}
+
+static Boolean isKeyNALUnitType(unsigned char nalUnitType) {
+  return nalUnitType == 5/*IDR*/ || nalUnitType == 7/*SPS*/ || nalUnitType == 8/*PPS*/;
+}
+
+Boolean H264VideoRTPSource
+::filterOutNALUnit(unsigned char nalUnitType, Boolean beginsNALUnit, unsigned rtpTimestamp) {
+  if (!beginsNALUnit) return fDroppingCurrentNALUnit;
+
+  Boolean isKey = isKeyNALUnitType(nalUnitType);
+  if (fGOPBoundaryDetector.beginsGOP(nalUnitType, rtpTimestamp)) ++fGOPCount;
+
+  // Nothing is delivered before the first GOP, because it couldn't be decoded:
+  Boolean inWantedGOP = fGOPCount > 0 && (fGOPCount-1)%fGOPInterval == 0;
+  if (fFilterMode == FILTER_KEYFRAMES) {
+    fDroppingCurrentNALUnit = !(isKey && inWantedGOP);
+  } else {
+    fDroppingCurrentNALUnit = !inWantedGOP;
+  }
+  return fDroppingCurrentNALUnit;
+}
+
 Boolean H264VideoRTPSource
 ::processSpecialHeader(BufferedPacket* packet,
                        unsigned& resultSpecialHeaderSize) {
@@ -111,6 +143,30 @@ Boolean H264VideoRTPSource
   }
   }
 
+  if (fFilterMode != FILTER_NONE) {
+    // Decide - from the NAL unit type(s) that this packet carries - whether to drop it.
+    // A dropped packet is rejected here, before any of its data gets copied:
+    unsigned char nalUnitType = fCurPacketNALUnitType;
+    Boolean beginsNALUnit = True;
+    if (fCurPacketNALUnitType == 28 || fCurPacketNALUnitType == 29) {
+      if (packetSize < 2) return False;
+      nalUnitType = headerStart[1]&0x1F; // the reconstructed (or FU header) type
+      beginsNALUnit = fCurrentPacketBeginsFrame;
+    } else if (fCurPacketNALUnitType == 24) {
+      // STAP-A: The packet is 'key' if any of its aggregated NAL units is:
+      for (unsigned i = 1; i + 2 < packetSize; ) {
+	unsigned naluSize = (headerStart[i]<<8)|headerStart[i+1];
+	nalUnitType = headerStart[i+2]&0x1F;
+	if (isKeyNALUnitType(nalUnitType)) break;
+	i += 2 + naluSize;
+      }
+    }
+    if (filterOutNALUnit(nalUnitType, beginsNALUnit, packet->rtpTimestamp())) {
+      ++fNumFilteredPackets;
+      return False;
+    }
+  }
+
   resultSpecialHeaderSize = expectedHeaderSize;
   return True;
 }
@@ -119,6 +175,41 @@ char const* H264VideoRTPSource::MIMEtype() const {
   return "video/H264";
 }
 
+
+////////// H264GOPBoundaryDetector //////////
+
+H264GOPBoundaryDetector::H264GOPBoundaryDetector() {
+  reset();
+}
+
+void H264GOPBoundaryDetector::reset() {
+  fState = NOT_IN_KEY_RUN;
+  fIDRTimestamp = 0;
+}
+
+Boolean H264GOPBoundaryDetector::beginsGOP(unsigned char nalUnitType, unsigned rtpTimestamp) {
+  switch (nalUnitType) {
+  case 7: case 8: { // SPS or PPS
+    Boolean begins = fState != IN_PARAMETER_SETS;
+    fState = IN_PARAMETER_SETS;
+    return begins;
+  }
+  case 5: { // IDR slice
+    Boolean begins = fState == NOT_IN_KEY_RUN || (fState == IN_IDR_PICTURE && rtpTimestamp != fIDRTimestamp);
+    fState = IN_IDR_PICTURE;
+    fIDRTimestamp = rtpTimestamp;
+    return begins;
+  }
+  case 1: case 2: case 3: case 4: { // a non-IDR slice (or slice data partition)
+    fState = NOT_IN_KEY_RUN;
+    return False;
+  }
+  default: { // SEI, AUD, filler data, etc.
+    return False;
+  }
+  }
+}
+
 SPropRecord* parseSPropParameterSets(char const* sPropParameterSetsStr,
                                      // result parameter:
                                      unsigned& numSPropRecords) {
@@ -570,7 +570,11 @@ unsigned H264VideoStreamParser::parse() {
       // Skip over any input bytes that precede the first 0x00000001:
       u_int32_t first4Bytes;
       while ((first4Bytes = test4Bytes()) != 0x00000001) {
-	get1Byte(); setParseState(); // ensures that we progress over bad data
+	// Skip (in bulk) up to - but not including - a possible leading zero of the next start code:
+	unsigned numBytes;
+	(void)bytesBeforeStartCode(numBytes);
+	if (numBytes > 1) skipBytes(numBytes-1); else get1Byte();
+	setParseState(); // ensures that we progress over bad data
       }
       skipBytes(4); // skip this initial code
       
@@ -619,8 +623,16 @@ unsigned H264VideoStreamParser::parse() {
       }
       while (next4Bytes != 0x00000001 && (next4Bytes&0xFFFFFF00) != 0x00000100) {
 	// We save at least some of "next4Bytes".
-	if ((unsigned)(next4Bytes&0xFF) > 1) {
-	  // Common case: 0x00000001 or 0x000001 definitely doesn't begin anywhere in "next4Bytes", so we save all of it:
+	// Common case: Use the start code scanner to save, in bulk, all already-read data up until the
+	// next 0x000001 (but not a zero byte before it, which would make it a 4-byte 0x00000001):
+	unsigned numBytes;
+	u_int8_t const* from = bytesBeforeStartCode(numBytes);
+	if (numBytes > 0 && from[numBytes-1] == 0) --numBytes;
+	if (numBytes > 0) {
+	  saveBytes(from, numBytes);
+	  skipBytes(numBytes);
+	} else if ((unsigned)(next4Bytes&0xFF) > 1) {
+	  // 0x00000001 or 0x000001 definitely doesn't begin anywhere in "next4Bytes", so we save all of it:
 	  save4Bytes(next4Bytes);
 	  skipBytes(4);
 	} else {
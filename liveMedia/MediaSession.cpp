@@ -214,6 +214,7 @@ Boolean MediaSession::initializeWithSDP(char const* sdpDescription) {
       if (subsession->parseSDPAttribute_source_filter(sdpLine)) continue;
       if (subsession->parseSDPAttribute_x_dimensions(sdpLine)) continue;
       if (subsession->parseSDPAttribute_framerate(sdpLine)) continue;
+      if (subsession->parseSDPAttribute_extmap(sdpLine)) continue;
 
       // (Later, check for malformed lines, and other valid SDP lines#####)
     }
@@ -577,7 +578,7 @@ MediaSubsession::MediaSubsession(MediaSession& parent)
   : serverPortNum(0), sink(NULL), miscPtr(NULL),
     fParent(parent), fNext(NULL),
     fConnectionEndpointName(NULL),
-    fClientPortNum(0), fRTPPayloadFormat(0xFF),
+    fClientPortNum(0), fRTPPayloadFormat(0xFF), fFECPayloadFormat(0xFF),
     fSavedSDPLines(NULL), fMediumName(NULL), fCodecName(NULL), fProtocolName(NULL),
     fRTPTimestampFrequency(0), fControlPath(NULL),
     fSourceFilterAddr(parent.sourceFilterAddr()), fBandwidth(0),
@@ -594,6 +595,7 @@ MediaSubsession::MediaSubsession(MediaSession& parent)
     fRTPSource(NULL), fRTCPInstance(NULL), fReadSource(NULL), fReceiveRawMP3ADUs(False),
     fSessionId(NULL) {
   rtpInfo.seqNum = 0; rtpInfo.timestamp = 0; rtpInfo.infoIsNew = False;
+  memset(fHeaderExtensionIds, 0, sizeof fHeaderExtensionIds);
 }
 
 MediaSubsession::~MediaSubsession() {
@@ -774,6 +776,15 @@ Boolean MediaSubsession::initiate(int useSpecialRTPoffset) {
       break;
     }
 
+    // Tell the RTP source about any header extensions that it should parse:
+    if (fRTPSource != NULL) {
+      for (unsigned type = 0; type < RTPHeaderExtensions::NUM_REGISTERED_TYPES; ++type) {
+	if (fHeaderExtensionIds[type] != 0) {
+	  fRTPSource->registerHeaderExtension(fHeaderExtensionIds[type], (RTPHeaderExtensions::Type)type);
+	}
+      }
+    }
+
     // Finally, create our RTCP instance. (It starts running automatically)
     if (fRTPSource != NULL && fRTCPSocket != NULL) {
       // If bandwidth is specified, use it and add 5% for RTCP overhead.
@@ -944,17 +955,20 @@ Boolean MediaSubsession::parseSDPAttribute_rtpmap(char const* sdpLine) {
       || sscanf(sdpLine, "a=rtpmap: %u %s",
 		&rtpmapPayloadFormat, codecName) == 2) {
     parseSuccess = True;
+    // (First, make sure the codec name is upper case)
+    {
+      Locale l("POSIX");
+      for (char* p = codecName; *p != '\0'; ++p) *p = toupper(*p);
+    }
     if (rtpmapPayloadFormat == fRTPPayloadFormat) {
       // This "rtpmap" matches our payload format, so set our
       // codec name and timestamp frequency:
-      // (First, make sure the codec name is upper case)
-      {
-	Locale l("POSIX");
-	for (char* p = codecName; *p != '\0'; ++p) *p = toupper(*p);
-      }
       delete[] fCodecName; fCodecName = strDup(codecName);
       fRTPTimestampFrequency = rtpTimestampFrequency;
       fNumChannels = numChannels;
+    } else if (strcmp(codecName, "ULPFEC") == 0) {
+      // Another payload format, which carries FEC packets (RFC 5109) for our media:
+      fFECPayloadFormat = rtpmapPayloadFormat;
     }
   }
   delete[] codecName;
@@ -962,6 +976,23 @@ Boolean MediaSubsession::parseSDPAttribute_rtpmap(char const* sdpLine) {
   return parseSuccess;
 }
 
+Boolean MediaSubsession::parseSDPAttribute_extmap(char const* sdpLine) {
+  // Check for a "a=extmap:<id>[/<direction>] <URI> [<extension attributes>]" line (RFC 8285):
+  Boolean parseSuccess = False;
+
+  unsigned id;
+  char* uri = strDupSize(sdpLine); // ensures we have enough space
+  if (sscanf(sdpLine, "a=extmap: %u/%*s %s", &id, uri) == 2
+      || sscanf(sdpLine, "a=extmap: %u %s", &id, uri) == 2) {
+    parseSuccess = True;
+    RTPHeaderExtensions::Type type = RTPHeaderExtensions::lookupURI(uri);
+    if (type != RTPHeaderExtensions::NONE && id > 0 && id < 256) fHeaderExtensionIds[type] = id;
+  }
+  delete[] uri;
+
+  return parseSuccess;
+}
+
 Boolean MediaSubsession::parseSDPAttribute_control(char const* sdpLine) {
   // Check for a "a=control:<control-path>" line:
   Boolean parseSuccess = False;
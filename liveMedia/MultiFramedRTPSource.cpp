@@ -21,7 +21,9 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 
 #include "MultiFramedRTPSource.hh"
 #include "GroupsockHelper.hh"
+#include "ULPFECDecoder.hh"
 #include <string.h>
+#include <new>
 
 ////////// ReorderingPacketBuffer definition //////////
 
@@ -33,10 +35,18 @@ public:
 
   BufferedPacket* getFreePacket(MultiFramedRTPSource* ourSource);
   Boolean storePacket(BufferedPacket* bPacket);
-  BufferedPacket* getNextCompletedPacket(Boolean& packetLossPreceded);
+  unsigned takeNewGap(u_int16_t& firstMissingSeqNo);
+      // the number of packets found to be missing by the most recent "storePacket()" (if any)
+  BufferedPacket* getNextCompletedPacket(Boolean& packetLossPreceded, struct timeval const& timeNow);
+      // "timeNow" is on the same (monotonic) clock as the packets' "timeReceived()"
   void releaseUsedPacket(BufferedPacket* packet);
+  void detachUsedPacket(BufferedPacket* packet);
+      // like "releaseUsedPacket()", except that the packet is handed over to the caller (which must
+      // later give it back by calling "recyclePacket()"), rather than being freed
+  void recyclePacket(BufferedPacket* packet);
   void freePacket(BufferedPacket* packet) {
     if (packet != fSavedPacket) {
+      accountFor(-(int)packet->packetSize());
       delete packet;
     } else {
       fSavedPacketFree = True;
@@ -44,12 +54,58 @@ public:
   }
   Boolean isEmpty() const { return fHeadPacket == NULL; }
 
-  void setThresholdTime(unsigned uSeconds) { fThresholdTime = uSeconds; }
+  void setThresholdTime(unsigned uSeconds) { fThresholdTime = uSeconds; fAdaptiveThreshold = False; }
+  void setAdaptiveThreshold(unsigned minUSeconds, unsigned maxUSeconds);
+  Boolean adaptiveThreshold() const { return fAdaptiveThreshold; }
+  unsigned thresholdTime() const { return fThresholdTime; }
+  void noteJitter(unsigned jitterUSeconds, struct timeval const& timeNow) {
+    fJitterUSeconds = jitterUSeconds;
+    updateThreshold(timeNow);
+  }
   void resetHaveSeenFirstPacket() { fHaveSeenFirstPacket = False; }
 
+  void setPacketSize(unsigned packetSize, unsigned maxPacketSize) {
+    fPacketSize = packetSize;
+    fMaxPacketSize = maxPacketSize > packetSize ? maxPacketSize : packetSize;
+  }
+  unsigned packetSize() const { return fPacketSize; }
+  Boolean growPacketSize(BufferedPacket* packetInProgress);
+      // doubles the size of new packets (if permitted), and also grows "packetInProgress" (if not NULL)
+  void setMemoryFunc(RTPSource::BufferMemoryFunc* func, void* clientData) {
+    fMemoryFunc = func; fMemoryFuncClientData = clientData;
+  }
+
+  void accountForOtherBuffer(int numBytesDelta) { // for our source's buffers that aren't packets
+    if (fMemoryFunc != NULL && numBytesDelta != 0) (*fMemoryFunc)(fMemoryFuncClientData, numBytesDelta);
+  }
+
+private:
+  void accountFor(int numBytesDelta) {
+    fNumBufferBytes += numBytesDelta;
+    if (fMemoryFunc != NULL && numBytesDelta != 0) (*fMemoryFunc)(fMemoryFuncClientData, numBytesDelta);
+  }
+  BufferedPacket* newPacket(MultiFramedRTPSource* ourSource);
+  Boolean resizePacket(BufferedPacket* packet, unsigned newPacketSize);
+  void noteReorderDelay(unsigned uSeconds, struct timeval const& timeNow);
+  void updateThreshold(struct timeval const& timeNow);
+
 private:
   BufferedPacketFactory* fPacketFactory;
+  unsigned fPacketSize, fMaxPacketSize; // for newly-used packets
+  RTPSource::BufferMemoryFunc* fMemoryFunc;
+  void* fMemoryFuncClientData;
+  unsigned fNumBufferBytes; // in all of the packets that we've allocated
   unsigned fThresholdTime; // uSeconds
+  // Used (only) for an adaptive threshold:
+  Boolean fAdaptiveThreshold;
+  unsigned fMinThresholdTime, fMaxThresholdTime; // uSeconds
+  unsigned fJitterUSeconds; // the stream's interarrival jitter
+  unsigned fReorderDelay; // uSeconds: a (decaying) peak of how long we've needed to wait for out-of-order packets
+  struct timeval fReorderDelayDecayTime;
+  unsigned short fSkippedSeqNoBegin, fSkippedSeqNoEnd; // the packets that we most recently gave up on
+  unsigned short fNewGapSeqNo; // the first of the packets that "storePacket()" found to be missing
+  unsigned fNewGapSize;
+  struct timeval fSkipTime; // when we gave up on them
   Boolean fHaveSeenFirstPacket; // used to set initial "fNextExpectedSeqNo"
   unsigned short fNextExpectedSeqNo;
   BufferedPacket* fHeadPacket;
@@ -57,22 +113,35 @@ private:
   BufferedPacket* fSavedPacket;
       // to avoid calling new/free in the common case
   Boolean fSavedPacketFree;
+  BufferedPacket* fSparePackets; // recycled packets, to avoid calling new/free when packets are held for a while
+  unsigned fNumSparePackets;
 };
 
 
 ////////// MultiFramedRTPSource implementation //////////
 
+#define COALESCED_BUFFER_SIZE 65536 // enough for the largest (coalesced) datagram
+
 MultiFramedRTPSource
 ::MultiFramedRTPSource(UsageEnvironment& env, Groupsock* RTPgs,
 		       unsigned char rtpPayloadFormat,
 		       unsigned rtpTimestampFrequency,
 		       BufferedPacketFactory* packetFactory)
-  : RTPSource(env, RTPgs, rtpPayloadFormat, rtpTimestampFrequency) {
+  : RTPSource(env, RTPgs, rtpPayloadFormat, rtpTimestampFrequency),
+    fScatterDelivery(False), fChunks(NULL), fNumChunks(0), fMaxNumChunks(0),
+    fHeldPackets(NULL), fLastChunkPacket(NULL), fCoalescedBuffer(NULL),
+    fFECDecoder(NULL), fFECPayloadFormat(0), fFECBufferBytes(0), fPacketLossBeforeRepairPacket(False),
+    fHaveTimingBase(False), fNextFrameIsDiscontinuity(False), fLastFrameRTPTimestamp(0), fExtendedRTPTimestamp(0),
+    fPTSOffset(0), fMaxPTS(0), fFrameDuration(0), fCurFramePTS(0), fCurFrameIsDiscontinuity(False) {
   reset();
   fReorderingBuffer = new ReorderingPacketBuffer(packetFactory);
+  memset(fHeaderExtensionTypes, RTPHeaderExtensions::NONE, sizeof fHeaderExtensionTypes);
+  fCurFrameHeaderExtensions.clear();
 
   // Try to use a big receive buffer for RTP:
   increaseReceiveBufferTo(env, RTPgs->socketNum(), 50*1024);
+  // and to have the kernel timestamp each packet's arrival (for jitter calculations):
+  RTPgs->enableReceiveTimestamps();
 }
 
 void MultiFramedRTPSource::reset() {
@@ -82,11 +151,55 @@ void MultiFramedRTPSource::reset() {
   fPacketReadInProgress = NULL;
   fNeedDelivery = False;
   fPacketLossInFragmentedFrame = False;
+  fPacketLossBeforeRepairPacket = False;
 }
 
 MultiFramedRTPSource::~MultiFramedRTPSource() {
   fRTPInterface.stopNetworkReading();
+  releaseFrameChunks();
+  if (fCoalescedBuffer != NULL) fReorderingBuffer->accountForOtherBuffer(-COALESCED_BUFFER_SIZE);
+  fReorderingBuffer->accountForOtherBuffer(-(int)fFECBufferBytes);
   delete fReorderingBuffer;
+  delete[] fChunks;
+  delete[] fCoalescedBuffer;
+  delete fFECDecoder;
+}
+
+Boolean MultiFramedRTPSource::enableReceiveCoalescing() {
+  if (fCoalescedBuffer != NULL) return True; // already enabled
+  if (!RTPgs()->enableReceiveCoalescing()) return False;
+
+  fCoalescedBuffer = new unsigned char[COALESCED_BUFFER_SIZE];
+  fReorderingBuffer->accountForOtherBuffer(COALESCED_BUFFER_SIZE);
+  return True;
+}
+
+void MultiFramedRTPSource::enableFEC(unsigned char fecPayloadFormat) {
+  if (fFECDecoder == NULL) fFECDecoder = new ULPFECDecoder(recoveredPacketHandler, this);
+  fFECPayloadFormat = fecPayloadFormat;
+}
+
+unsigned MultiFramedRTPSource::numFECRecoveredPackets() const {
+  return fFECDecoder == NULL ? 0 : fFECDecoder->numRecoveredPackets();
+}
+
+void MultiFramedRTPSource
+::recoveredPacketHandler(void* clientData, unsigned char const* packet, unsigned packetSize) {
+  ((MultiFramedRTPSource*)clientData)->recoveredPacketHandler1(packet, packetSize);
+}
+
+void MultiFramedRTPSource::recoveredPacketHandler1(unsigned char const* packet, unsigned packetSize) {
+  // Handle the recovered packet as if it had just arrived:
+  BufferedPacket* bPacket = fReorderingBuffer->getFreePacket(this);
+  Boolean fits;
+  while (!(fits = bPacket->fillInData(packet, packetSize)) && fReorderingBuffer->growPacketSize(bPacket)) {}
+  if (!fits || !processIncomingPacket(bPacket)) fReorderingBuffer->freePacket(bPacket);
+}
+
+void MultiFramedRTPSource::accountForFECBuffers() {
+  unsigned numBytes = fFECDecoder->numBufferBytes();
+  fReorderingBuffer->accountForOtherBuffer((int)(numBytes - fFECBufferBytes));
+  fFECBufferBytes = numBytes;
 }
 
 Boolean MultiFramedRTPSource
@@ -106,6 +219,7 @@ Boolean MultiFramedRTPSource
 
 void MultiFramedRTPSource::doStopGettingFrames() {
   fRTPInterface.stopNetworkReading();
+  releaseFrameChunks();
   fReorderingBuffer->reset();
   reset();
 }
@@ -122,18 +236,66 @@ void MultiFramedRTPSource::doGetNextFrame() {
   fSavedTo = fTo;
   fSavedMaxSize = fMaxSize;
   fFrameSize = 0; // for now
+  fCurFrameHeaderExtensions.clear();
+  releaseFrameChunks(); // our caller is done with the previous frame
   fNeedDelivery = True;
   doGetNextFrame1();
 }
 
+void MultiFramedRTPSource::addChunk(unsigned char* data, unsigned size) {
+  if (size == 0) return;
+
+  if (fNumChunks > 0 && fChunks[fNumChunks-1].data + fChunks[fNumChunks-1].size == data) {
+    // This data follows on directly from the previous chunk (e.g., it came from the same packet):
+    fChunks[fNumChunks-1].size += size;
+    return;
+  }
+
+  if (fNumChunks == fMaxNumChunks) {
+    unsigned newMaxNumChunks = fMaxNumChunks == 0 ? 16 : 2*fMaxNumChunks;
+    Chunk* newChunks = new Chunk[newMaxNumChunks];
+    for (unsigned i = 0; i < fNumChunks; ++i) newChunks[i] = fChunks[i];
+    delete[] fChunks;
+    fChunks = newChunks;
+    fMaxNumChunks = newMaxNumChunks;
+  }
+  fChunks[fNumChunks].data = data;
+  fChunks[fNumChunks].size = size;
+  ++fNumChunks;
+}
+
+void MultiFramedRTPSource::releaseFrameChunks() {
+  while (fHeldPackets != NULL) {
+    BufferedPacket* packet = fHeldPackets;
+    fHeldPackets = packet->nextPacket();
+    packet->nextPacket() = NULL;
+    fReorderingBuffer->recyclePacket(packet);
+  }
+  fNumChunks = 0;
+  fLastChunkPacket = NULL;
+}
+
 void MultiFramedRTPSource::doGetNextFrame1() {
   while (fNeedDelivery) {
     // If we already have packet data available, then deliver it now.
     Boolean packetLossPrecededThis;
     BufferedPacket* nextPacket
-      = fReorderingBuffer->getNextCompletedPacket(packetLossPrecededThis);
+      = fReorderingBuffer->getNextCompletedPacket(packetLossPrecededThis,
+						  envir().taskScheduler().loopTime());
     if (nextPacket == NULL) break;
 
+    if (nextPacket->isRepairPacket()) {
+      // A FEC packet (that shared our sequence numbers); it has nothing to deliver, but any loss before it is
+      // loss before the next media packet.  (Unless it was the very first packet; then nothing was lost.)
+      if (packetLossPrecededThis && !nextPacket->isFirstPacket()) fPacketLossBeforeRepairPacket = True;
+      fReorderingBuffer->releaseUsedPacket(nextPacket);
+      continue;
+    }
+    if (fPacketLossBeforeRepairPacket) {
+      packetLossPrecededThis = True;
+      fPacketLossBeforeRepairPacket = False;
+    }
+
     fNeedDelivery = False;
 
     if (nextPacket->useCount() == 0) {
@@ -141,10 +303,11 @@ void MultiFramedRTPSource::doGetNextFrame1() {
       // that needs to be processed:
       unsigned specialHeaderSize;
       if (!processSpecialHeader(nextPacket, specialHeaderSize)) {
-	// Something's wrong with the header; reject the packet:
+	// Something's wrong with the header (or the packet was filtered out); reject the packet,
+	// and go on to any other packet that's already queued:
 	fReorderingBuffer->releaseUsedPacket(nextPacket);
 	fNeedDelivery = True;
-	break;
+	continue;
       }
       nextPacket->skip(specialHeaderSize);
     }
@@ -152,15 +315,24 @@ void MultiFramedRTPSource::doGetNextFrame1() {
     // Check whether we're part of a multi-packet frame, and whether
     // there was packet loss that would render this packet unusable:
     if (fCurrentPacketBeginsFrame) {
+      if (packetLossPrecededThis && !fPacketLossInFragmentedFrame && !nextPacket->isFirstPacket()) {
+	// We've given up on (at least the end of) the previous frame:
+	if (fFrameLossHandler != NULL) (*fFrameLossHandler)(fLossHandlerClientData, fLastReceivedSSRC);
+      }
       if (packetLossPrecededThis || fPacketLossInFragmentedFrame) {
 	// We didn't get all of the previous frame.
 	// Forget any data that we used from it:
 	fTo = fSavedTo; fMaxSize = fSavedMaxSize;
 	fFrameSize = 0;
+	fCurFrameHeaderExtensions.clear();
+	releaseFrameChunks();
       }
       fPacketLossInFragmentedFrame = False;
     } else if (packetLossPrecededThis) {
       // We're in a multi-packet frame, with preceding packet loss
+      if (!fPacketLossInFragmentedFrame && fFrameLossHandler != NULL) {
+	(*fFrameLossHandler)(fLossHandlerClientData, fLastReceivedSSRC);
+      }
       fPacketLossInFragmentedFrame = True;
     }
     if (fPacketLossInFragmentedFrame) {
@@ -171,20 +343,44 @@ void MultiFramedRTPSource::doGetNextFrame1() {
     }
 
     // The packet is usable. Deliver all or part of it to our caller:
+    if (nextPacket->isFirstPacket() && nextPacket->useCount() == 0) fNextFrameIsDiscontinuity = True;
+    fCurFrameHeaderExtensions.merge(nextPacket->headerExtensions());
     unsigned frameSize;
-    nextPacket->use(fTo, fMaxSize, frameSize, fNumTruncatedBytes,
-		    fCurPacketRTPSeqNum, fCurPacketRTPTimestamp,
-		    fPresentationTime, fCurPacketHasBeenSynchronizedUsingRTCP,
-		    fCurPacketMarkerBit);
+    if (fScatterDelivery) {
+      // Refer to the data where it lies, rather than copying it:
+      unsigned char* framePtr;
+      nextPacket->useInPlace(framePtr, frameSize,
+			     fCurPacketRTPSeqNum, fCurPacketRTPTimestamp,
+			     fPresentationTime, fCurPacketHasBeenSynchronizedUsingRTCP,
+			     fCurPacketMarkerBit);
+      if (frameSize > 0) {
+	addChunk(framePtr, frameSize);
+	fLastChunkPacket = nextPacket;
+      }
+      fNumTruncatedBytes = 0;
+    } else {
+      nextPacket->use(fTo, fMaxSize, frameSize, fNumTruncatedBytes,
+		      fCurPacketRTPSeqNum, fCurPacketRTPTimestamp,
+		      fPresentationTime, fCurPacketHasBeenSynchronizedUsingRTCP,
+		      fCurPacketMarkerBit);
+    }
     fFrameSize += frameSize;
 
     if (!nextPacket->hasUsableData()) {
-      // We're completely done with this packet now
-      fReorderingBuffer->releaseUsedPacket(nextPacket);
+      // We're completely done with this packet now (unless our caller's chunks still refer to it):
+      if (nextPacket == fLastChunkPacket) {
+	fReorderingBuffer->detachUsedPacket(nextPacket);
+	nextPacket->nextPacket() = fHeldPackets;
+	fHeldPackets = nextPacket;
+	fLastChunkPacket = NULL;
+      } else {
+	fReorderingBuffer->releaseUsedPacket(nextPacket);
+      }
     }
 
     if (fCurrentPacketCompletesFrame) {
       // We have all the data that the client wants.
+      updateFrameTiming();
       if (fNumTruncatedBytes > 0) {
 	envir() << "MultiFramedRTPSource::doGetNextFrame1(): The total received frame size exceeds the client's buffer size ("
 		<< fSavedMaxSize << ").  "
@@ -204,17 +400,155 @@ void MultiFramedRTPSource::doGetNextFrame1() {
     } else {
       // This packet contained fragmented data, and does not complete
       // the data that the client wants.  Keep getting data:
-      fTo += frameSize; fMaxSize -= frameSize;
+      if (!fScatterDelivery) { fTo += frameSize; fMaxSize -= frameSize; }
       fNeedDelivery = True;
     }
   }
 }
 
+#define MAX_TIMESTAMP_JUMP 10 // seconds; a larger jump (either way) between successive frames is a discontinuity
+
+void MultiFramedRTPSource::updateFrameTiming() {
+  u_int32_t rtpTimestamp = fCurPacketRTPTimestamp;
+  Boolean isDiscontinuity = fNextFrameIsDiscontinuity || !fHaveTimingBase;
+  fNextFrameIsDiscontinuity = False;
+
+  if (!fHaveTimingBase || isDiscontinuity) {
+    // A new SSRC (or the very first frame): Begin a new extended timestamp:
+    fExtendedRTPTimestamp = rtpTimestamp;
+  } else {
+    int delta = (int)(rtpTimestamp - fLastFrameRTPTimestamp); // (this handles wraparound)
+    fExtendedRTPTimestamp += (int64_t)delta;
+
+    unsigned maxJump = MAX_TIMESTAMP_JUMP*timestampFrequency();
+    if ((unsigned)(delta < 0 ? -delta : delta) > maxJump) {
+      isDiscontinuity = True;
+    } else if (delta > 0) {
+      fFrameDuration = (u_int32_t)delta;
+    }
+  }
+  fLastFrameRTPTimestamp = rtpTimestamp;
+
+  // Our presentation time is the extended timestamp plus an offset that's chosen (at each discontinuity) so that the
+  // presentation time continues from where it was:
+  if (!fHaveTimingBase) {
+    fPTSOffset = -fExtendedRTPTimestamp; // so that we start from 0
+    fMaxPTS = 0;
+    fHaveTimingBase = True;
+  } else if (isDiscontinuity) {
+    fPTSOffset = fMaxPTS + (fFrameDuration > 0 ? fFrameDuration : 1) - fExtendedRTPTimestamp;
+  }
+  u_int64_t pts = fExtendedRTPTimestamp + fPTSOffset;
+  if ((int64_t)(pts - fMaxPTS) > 0) fMaxPTS = pts;
+
+  // Convert "pts" to microseconds (in two parts, to avoid overflow):
+  unsigned frequency = timestampFrequency();
+  if (frequency == 0 || (int64_t)pts < 0) {
+    fCurFramePTS = 0;
+  } else {
+    fCurFramePTS = (pts/frequency)*1000000 + ((pts%frequency)*1000000)/frequency;
+  }
+  fCurFrameIsDiscontinuity = isDiscontinuity;
+}
+
 void MultiFramedRTPSource
 ::setPacketReorderingThresholdTime(unsigned uSeconds) {
   fReorderingBuffer->setThresholdTime(uSeconds);
 }
 
+void MultiFramedRTPSource
+::setAdaptivePacketReorderingThreshold(unsigned minUSeconds, unsigned maxUSeconds) {
+  fReorderingBuffer->setAdaptiveThreshold(minUSeconds, maxUSeconds);
+}
+
+unsigned MultiFramedRTPSource::packetReorderingThresholdTime() const {
+  return fReorderingBuffer->thresholdTime();
+}
+
+void MultiFramedRTPSource
+::setPacketBufferSize(unsigned packetBufferSize, unsigned maxPacketBufferSize) {
+  if (packetBufferSize == 0) return; // sanity check
+  fReorderingBuffer->setPacketSize(packetBufferSize, maxPacketBufferSize);
+}
+
+unsigned MultiFramedRTPSource::packetBufferSize() const {
+  return fReorderingBuffer->packetSize();
+}
+
+void MultiFramedRTPSource::setBufferMemoryFunc(BufferMemoryFunc* func, void* clientData) {
+  fReorderingBuffer->setMemoryFunc(func, clientData);
+}
+
+void MultiFramedRTPSource::registerHeaderExtension(unsigned char id, RTPHeaderExtensions::Type type) {
+  fHeaderExtensionTypes[id] = type;
+}
+
+#define RTP_HDREXT_ONE_BYTE_PROFILE 0xBEDE // RFC 8285, section 4.2
+#define RTP_HDREXT_TWO_BYTE_PROFILE 0x1000 // RFC 8285, section 4.3 (the low 4 bits are 'appbits')
+#define RTP_HDREXT_ONVIF_REPLAY_PROFILE 0xABAC // ONVIF Streaming Specification, section 6.3
+
+static inline u_int32_t get4Bytes(unsigned char const* p) { return (p[0]<<24)|(p[1]<<16)|(p[2]<<8)|p[3]; }
+
+void MultiFramedRTPSource
+::parseHeaderExtension(unsigned profile, unsigned char const* data, unsigned size, RTPHeaderExtensions& result) {
+  if (profile == RTP_HDREXT_ONVIF_REPLAY_PROFILE) {
+    if (size < 12) return;
+    result.onvifNTPTime = ((u_int64_t)get4Bytes(data)<<32)|get4Bytes(&data[4]);
+    result.onvifFlags = data[8]&(RTPHeaderExtensions::ONVIF_CLEAN_POINT|RTPHeaderExtensions::ONVIF_END
+				 |RTPHeaderExtensions::ONVIF_DISCONTINUITY);
+    result.onvifCSeq = data[9];
+    result.fPresent |= 1<<RTPHeaderExtensions::ONVIF_REPLAY;
+    return;
+  }
+
+  Boolean isTwoByte;
+  if (profile == RTP_HDREXT_ONE_BYTE_PROFILE) {
+    isTwoByte = False;
+  } else if ((profile&0xFFF0) == RTP_HDREXT_TWO_BYTE_PROFILE) {
+    isTwoByte = True;
+  } else {
+    return; // an extension that we don't understand
+  }
+
+  // Look at each extension element:
+  unsigned i = 0;
+  while (i < size) {
+    if (data[i] == 0) { ++i; continue; } // padding
+
+    unsigned id, length;
+    if (isTwoByte) {
+      if (i + 2 > size) break;
+      id = data[i]; length = data[i+1];
+      i += 2;
+    } else {
+      id = data[i]>>4; length = (data[i]&0x0F) + 1;
+      if (id == 15) break; // reserved; stop parsing
+      ++i;
+    }
+    if (i + length > size) break;
+
+    unsigned char const* element = &data[i];
+    switch (fHeaderExtensionTypes[id]) {
+      case RTPHeaderExtensions::ABS_SEND_TIME: {
+	if (length < 3) break;
+	result.absSendTime = (element[0]<<16)|(element[1]<<8)|element[2];
+	result.fPresent |= 1<<RTPHeaderExtensions::ABS_SEND_TIME;
+	break;
+      }
+      case RTPHeaderExtensions::ABS_CAPTURE_TIME: {
+	if (length < 8) break; // (We ignore the optional 'estimated capture clock offset' that may follow)
+	result.absCaptureTime = ((u_int64_t)get4Bytes(element)<<32)|get4Bytes(&element[4]);
+	result.fPresent |= 1<<RTPHeaderExtensions::ABS_CAPTURE_TIME;
+	break;
+      }
+      default: {
+	break; // an element that we weren't asked to parse
+      }
+    }
+    i += length;
+  }
+}
+
 #define ADVANCE(n) do { bPacket->skip(n); } while (0)
 
 void MultiFramedRTPSource::networkReadHandler(MultiFramedRTPSource* source, int /*mask*/) {
@@ -222,22 +556,29 @@ void MultiFramedRTPSource::networkReadHandler(MultiFramedRTPSource* source, int
 }
 
 void MultiFramedRTPSource::networkReadHandler1() {
+  if (fCoalescedBuffer != NULL && fRTPInterface.nextTCPReadStreamSocketNum() < 0) {
+    // We're reading datagrams, several of which the kernel may have coalesced:
+    readCoalescedPackets();
+    return;
+  }
+
   BufferedPacket* bPacket = fPacketReadInProgress;
   if (bPacket == NULL) {
     // Normal case: Get a free BufferedPacket descriptor to hold the new network packet:
     bPacket = fReorderingBuffer->getFreePacket(this);
   }
 
-  // Read the network packet, and perform sanity checks on the RTP header:
+  // Read the network packet, and process it:
   Boolean readSuccess = False;
   do {
     Boolean packetReadWasIncomplete = fPacketReadInProgress != NULL;
     if (!bPacket->fillInData(fRTPInterface, packetReadWasIncomplete)) {
       if (bPacket->bytesAvailable() == 0) {
-	    envir() << "MultiFramedRTPSource error: Hit limit when reading incoming packet over TCP. Increase \"MAX_PACKET_SIZE\"\n";
+	    envir() << "MultiFramedRTPSource error: Hit limit when reading incoming packet over TCP. Increase the packet buffer size (see \"setPacketBufferSize()\")\n";
       }
       fFrameSize = 0;
       fNumTruncatedBytes = 0;
+      releaseFrameChunks();
       //fPresentationTime = 0;
       fDurationInMicroseconds = 0;
       afterGetting(this);
@@ -245,102 +586,204 @@ void MultiFramedRTPSource::networkReadHandler1() {
       return;
     }
     if (packetReadWasIncomplete) {
-      // We need additional read(s) before we can process the incoming packet:
+      // We need additional read(s) before we can process the incoming packet.  (If we're reading
+      // over TCP, and the packet has already filled our buffer, then make room for the rest of it:)
+      if (bPacket->bytesAvailable() == 0) fReorderingBuffer->growPacketSize(bPacket);
       fPacketReadInProgress = bPacket;
       return;
     } else {
       fPacketReadInProgress = NULL;
     }
+    // A datagram that exactly filled our buffer was probably truncated; use larger buffers from now on:
+    if (bPacket->bytesAvailable() == 0) fReorderingBuffer->growPacketSize(NULL);
+    readSuccess = processIncomingPacket(bPacket);
+  } while (0);
+  if (!readSuccess) fReorderingBuffer->freePacket(bPacket);
+
+  doGetNextFrame1();
+  // If we didn't get proper data this time, we'll get another chance
+}
+
+void MultiFramedRTPSource::readCoalescedPackets() {
+  unsigned bytesRead;
+  struct sockaddr_in fromAddress;
+  Boolean packetReadWasIncomplete; // (not for datagrams)
+  if (!fRTPInterface.handleRead(fCoalescedBuffer, COALESCED_BUFFER_SIZE, bytesRead, fromAddress,
+				packetReadWasIncomplete)) {
+    fFrameSize = 0;
+    fNumTruncatedBytes = 0;
+    releaseFrameChunks();
+    fDurationInMicroseconds = 0;
+    afterGetting(this);
+    return;
+  }
+
+  // Split what we read into its datagrams, each of which is copied into its own packet:
+  unsigned segmentSize = fRTPInterface.lastSegmentSize();
+  if (segmentSize == 0) segmentSize = bytesRead; // it's just one datagram
+  for (unsigned offset = 0; offset < bytesRead; offset += segmentSize) {
+    unsigned size = bytesRead - offset;
+    if (size > segmentSize) size = segmentSize;
+
+    BufferedPacket* bPacket = fReorderingBuffer->getFreePacket(this);
+    Boolean fits;
+    while (!(fits = bPacket->fillInData(&fCoalescedBuffer[offset], size)) && fReorderingBuffer->growPacketSize(bPacket)) {}
+    if (!fits || !processIncomingPacket(bPacket)) fReorderingBuffer->freePacket(bPacket);
+  }
+
+  doGetNextFrame1();
+}
+
+Boolean MultiFramedRTPSource::processIncomingPacket(BufferedPacket* bPacket) {
+  // Perform sanity checks on the RTP header, then store the packet:
 #ifdef TEST_LOSS
-    setPacketReorderingThresholdTime(0);
-       // don't wait for 'lost' packets to arrive out-of-order later
-    if ((our_random()%10) == 0) break; // simulate 10% packet loss
+  setPacketReorderingThresholdTime(0);
+     // don't wait for 'lost' packets to arrive out-of-order later
+  if ((our_random()%10) == 0) return False; // simulate 10% packet loss
 #endif
 
-    // Check for the 12-byte RTP header:
-    if (bPacket->dataSize() < 12) break;
-    unsigned rtpHdr = ntohl(*(u_int32_t*)(bPacket->data())); ADVANCE(4);
-    Boolean rtpMarkerBit = (rtpHdr&0x00800000) != 0;
-    unsigned rtpTimestamp = ntohl(*(u_int32_t*)(bPacket->data()));ADVANCE(4);
-    unsigned rtpSSRC = ntohl(*(u_int32_t*)(bPacket->data())); ADVANCE(4);
-
-    // Check the RTP version number (it should be 2):
-    if ((rtpHdr&0xC0000000) != 0x80000000) break;
-
-    // Skip over any CSRC identifiers in the header:
-    unsigned cc = (rtpHdr>>24)&0xF;
-    if (bPacket->dataSize() < cc) break;
-    ADVANCE(cc*4);
-
-    // Check for (& ignore) any RTP header extension
-    if (rtpHdr&0x10000000) {
-      if (bPacket->dataSize() < 4) break;
-      unsigned extHdr = ntohl(*(u_int32_t*)(bPacket->data())); ADVANCE(4);
-      unsigned remExtSize = 4*(extHdr&0xFFFF);
-      if (bPacket->dataSize() < remExtSize) break;
-      ADVANCE(remExtSize);
-    }
+  // Check for the 12-byte RTP header:
+  if (bPacket->dataSize() < 12) return False;
+  unsigned char* packetStart = bPacket->data(); // (for FEC, which needs the whole packet)
+  unsigned packetSize = bPacket->dataSize();
+  unsigned rtpHdr = ntohl(*(u_int32_t*)(bPacket->data())); ADVANCE(4);
+  Boolean rtpMarkerBit = (rtpHdr&0x00800000) != 0;
+  unsigned rtpTimestamp = ntohl(*(u_int32_t*)(bPacket->data()));ADVANCE(4);
+  unsigned rtpSSRC = ntohl(*(u_int32_t*)(bPacket->data())); ADVANCE(4);
+
+  // Check the RTP version number (it should be 2):
+  if ((rtpHdr&0xC0000000) != 0x80000000) return False;
+
+  // Skip over any CSRC identifiers in the header:
+  unsigned cc = (rtpHdr>>24)&0xF;
+  if (bPacket->dataSize() < cc) return False;
+  ADVANCE(cc*4);
+
+  // Check for any RTP header extension (parsing the parts of it that we understand)
+  if (rtpHdr&0x10000000) {
+    if (bPacket->dataSize() < 4) return False;
+    unsigned extHdr = ntohl(*(u_int32_t*)(bPacket->data())); ADVANCE(4);
+    unsigned remExtSize = 4*(extHdr&0xFFFF);
+    if (bPacket->dataSize() < remExtSize) return False;
+    parseHeaderExtension(extHdr>>16, bPacket->data(), remExtSize, bPacket->headerExtensions());
+    ADVANCE(remExtSize);
+  }
 
-    // Discard any padding bytes:
-    if (rtpHdr&0x20000000) {
-      if (bPacket->dataSize() == 0) break;
-      unsigned numPaddingBytes
+  // Discard any padding bytes:
+  if (rtpHdr&0x20000000) {
+    if (bPacket->dataSize() == 0) return False;
+    unsigned numPaddingBytes
 	= (unsigned)(bPacket->data())[bPacket->dataSize()-1];
-      if (bPacket->dataSize() < numPaddingBytes) break;
-      bPacket->removePadding(numPaddingBytes);
-    }
-    // Check the Payload Type.
-    if ((unsigned char)((rtpHdr&0x007F0000)>>16)
-	!= rtpPayloadFormat()) {
-      break;
-    }
-
-    // The rest of the packet is the usable data.  Record and save it:
+    if (bPacket->dataSize() < numPaddingBytes) return False;
+    bPacket->removePadding(numPaddingBytes);
+  }
+  // Check the Payload Type.
+  unsigned char payloadType = (unsigned char)((rtpHdr&0x007F0000)>>16);
+  Boolean isRepairPacket = False;
+  if (fFECDecoder != NULL && payloadType == fFECPayloadFormat && payloadType != rtpPayloadFormat()) {
     if (rtpSSRC != fLastReceivedSSRC) {
-      // The SSRC of incoming packets has changed.  Unfortunately we don't yet handle streams that contain multiple SSRCs,
-      // but we can handle a single-SSRC stream where the SSRC changes occasionally:
-      fLastReceivedSSRC = rtpSSRC;
-      fReorderingBuffer->resetHaveSeenFirstPacket();
+      // The FEC packets have their own SSRC (and sequence numbers), so all we do is use them for recovery:
+      fFECDecoder->noteFECPacket(packetStart, packetSize);
+      accountForFECBuffers();
+      return False;
     }
-    unsigned short rtpSeqNo = (unsigned short)(rtpHdr&0xFFFF);
-    Boolean usableInJitterCalculation
-      = packetIsUsableInJitterCalculation((bPacket->data()),
+    // The FEC packets share our sequence numbers, so - although they carry no media - they must be stored,
+    // lest they look like lost packets:
+    isRepairPacket = True;
+  } else if (payloadType != rtpPayloadFormat()) {
+    return False;
+  }
+
+  // The rest of the packet is the usable data.  Record and save it:
+  if (rtpSSRC != fLastReceivedSSRC) {
+    // The SSRC of incoming packets has changed.  Unfortunately we don't yet handle streams that contain multiple SSRCs,
+    // but we can handle a single-SSRC stream where the SSRC changes occasionally:
+    fLastReceivedSSRC = rtpSSRC;
+    fReorderingBuffer->resetHaveSeenFirstPacket();
+  }
+  unsigned short rtpSeqNo = (unsigned short)(rtpHdr&0xFFFF);
+  Boolean usableInJitterCalculation
+    = !isRepairPacket && packetIsUsableInJitterCalculation((bPacket->data()),
 						  bPacket->dataSize());
-    struct timeval presentationTime; // computed by:
-    Boolean hasBeenSyncedUsingRTCP; // computed by:
-    receptionStatsDB()
-      .noteIncomingPacket(rtpSSRC, rtpSeqNo, rtpTimestamp,
+  // The packet's arrival time: the kernel's timestamp if we have one, otherwise the time at
+  // which this iteration of the event loop began:
+  struct timeval timeReceived = fRTPInterface.lastReceiveTime();
+  if (timeReceived.tv_sec == 0 && timeReceived.tv_usec == 0) {
+    timeReceived = envir().taskScheduler().loopWallClockTime();
+  }
+  struct timeval presentationTime; // computed by:
+  Boolean hasBeenSyncedUsingRTCP; // computed by:
+  receptionStatsDB()
+    .noteIncomingPacket(rtpSSRC, rtpSeqNo, rtpTimestamp,
 			  timestampFrequency(),
 			  usableInJitterCalculation, presentationTime,
-			  hasBeenSyncedUsingRTCP, bPacket->dataSize());
+			  hasBeenSyncedUsingRTCP, bPacket->dataSize(), &timeReceived);
+  if (fReorderingBuffer->adaptiveThreshold() && (rtpSeqNo&0xF) == 0) {
+    // Every so often, tell our reordering buffer the stream's current jitter (converted from RTP timestamp units):
+    RTPReceptionStats* stats = receptionStatsDB().lookup(rtpSSRC);
+    if (stats != NULL && timestampFrequency() != 0) {
+      fReorderingBuffer->noteJitter((unsigned)(((u_int64_t)stats->jitter()*1000000)/timestampFrequency()),
+				    envir().taskScheduler().loopTime());
+    }
+  }
 
-    // Fill in the rest of the packet descriptor, and store it:
-    struct timeval timeNow;
-    gettimeofday(&timeNow, NULL);
-    bPacket->assignMiscParams(rtpSeqNo, rtpTimestamp, presentationTime,
+  // Fill in the rest of the packet descriptor, and store it.  (For reordering, the packet's
+  // reception time is taken from the loop's monotonic clock, which is immune to clock changes:)
+  bPacket->assignMiscParams(rtpSeqNo, rtpTimestamp, presentationTime,
 			      hasBeenSyncedUsingRTCP, rtpMarkerBit,
-			      timeNow);
-    if (!fReorderingBuffer->storePacket(bPacket)) break;
+			      envir().taskScheduler().loopTime());
+  if (fFECDecoder != NULL && !isRepairPacket) {
+    // Note the packet for FEC (first, so that any earlier packets that it lets us recover get stored before it):
+    fFECDecoder->noteMediaPacket(packetStart, packetSize);
+    accountForFECBuffers();
+  }
+  if (isRepairPacket) {
+    bPacket->skip(bPacket->dataSize());
+    bPacket->isRepairPacket() = True;
+  }
+  if (!fReorderingBuffer->storePacket(bPacket)) return False;
+  if (isRepairPacket) {
+    fFECDecoder->noteFECPacket(packetStart, packetSize);
+    accountForFECBuffers();
+  }
 
-    readSuccess = True;
-  } while (0);
-  if (!readSuccess) fReorderingBuffer->freePacket(bPacket);
+  // If this packet revealed a gap (before it), then report it - unless we won't wait for the missing packets anyway:
+  u_int16_t firstMissingSeqNo;
+  unsigned numMissing = fReorderingBuffer->takeNewGap(firstMissingSeqNo);
+  if (numMissing > 0 && fPacketLossHandler != NULL && fReorderingBuffer->thresholdTime() > 0) {
+    (*fPacketLossHandler)(fLossHandlerClientData, rtpSSRC, firstMissingSeqNo, numMissing);
+  }
 
-  doGetNextFrame1();
-  // If we didn't get proper data this time, we'll get another chance
+  return True;
 }
 
 
 ////////// BufferedPacket and BufferedPacketFactory implementation /////
 
-#define MAX_PACKET_SIZE 20000
+#define MAX_PACKET_SIZE 20000 // the default; see "MultiFramedRTPSource::setPacketBufferSize()"
+#define MAX_GROWN_PACKET_SIZE 65536 // the most that an RTP packet (even over TCP) can need
 
+// (The buffer is allocated - at the size chosen by our "ReorderingPacketBuffer" - when the packet is first used.)
 BufferedPacket::BufferedPacket()
-  : fPacketSize(MAX_PACKET_SIZE),
-    fBuf(new unsigned char[MAX_PACKET_SIZE]),
+  : fPacketSize(0), fBuf(NULL), fHead(0), fTail(0),
     fNextPacket(NULL) {
 }
 
+Boolean BufferedPacket::setPacketSize(unsigned newPacketSize) {
+  if (newPacketSize == fPacketSize) return True;
+
+  unsigned char* newBuf = new (std::nothrow) unsigned char[newPacketSize];
+  if (newBuf == NULL) return False; // (the caller can carry on with the old size)
+  if (fTail > newPacketSize) fTail = newPacketSize;
+  if (fHead > fTail) fHead = fTail;
+  if (fBuf != NULL) memmove(newBuf, fBuf, fTail);
+
+  delete[] fBuf;
+  fBuf = newBuf;
+  fPacketSize = newPacketSize;
+  return True;
+}
+
 BufferedPacket::~BufferedPacket() {
   delete fNextPacket;
   delete[] fBuf;
@@ -350,6 +793,8 @@ void BufferedPacket::reset() {
   fHead = fTail = 0;
   fUseCount = 0;
   fIsFirstPacket = False; // by default
+  fIsRepairPacket = False;
+  fHeaderExtensions.clear();
 }
 
 // The following function has been deprecated:
@@ -390,6 +835,15 @@ Boolean BufferedPacket::fillInData(RTPInterface& rtpInterface, Boolean& packetRe
   return True;
 }
 
+Boolean BufferedPacket::fillInData(unsigned char const* data, unsigned dataSize) {
+  reset();
+  if (dataSize > fPacketSize) return False;
+
+  memmove(fBuf, data, dataSize);
+  fTail = dataSize;
+  return True;
+}
+
 void BufferedPacket
 ::assignMiscParams(unsigned short rtpSeqNo, unsigned rtpTimestamp,
 		   struct timeval presentationTime,
@@ -425,14 +879,10 @@ void BufferedPacket::use(unsigned char* to, unsigned toSize,
 			 struct timeval& presentationTime,
 			 Boolean& hasBeenSyncedUsingRTCP,
 			 Boolean& rtpMarkerBit) {
-  // added by kofera.deng on 20151119 
-  if (rtpMarkerBit) fHead = 0;
-
-  unsigned char* origFramePtr = &fBuf[fHead];
-  unsigned char* newFramePtr = origFramePtr; // may change in the call below
-  unsigned frameSize, frameDurationInMicroseconds;
-  getNextEnclosedFrameParameters(newFramePtr, fTail - fHead,
-				 frameSize, frameDurationInMicroseconds);
+  unsigned char* framePtr;
+  unsigned frameSize;
+  useInPlace(framePtr, frameSize, rtpSeqNo, rtpTimestamp, presentationTime,
+	     hasBeenSyncedUsingRTCP, rtpMarkerBit);
   if (frameSize > toSize) {
     bytesTruncated += frameSize - toSize;
     bytesUsed = toSize;
@@ -441,8 +891,23 @@ void BufferedPacket::use(unsigned char* to, unsigned toSize,
     bytesUsed = frameSize;
   }
 
-  memmove(to, newFramePtr, bytesUsed);
-  fHead += (newFramePtr - origFramePtr) + frameSize;
+  memmove(to, framePtr, bytesUsed);
+}
+
+void BufferedPacket::useInPlace(unsigned char*& framePtr, unsigned& frameSize,
+				unsigned short& rtpSeqNo, unsigned& rtpTimestamp,
+				struct timeval& presentationTime,
+				Boolean& hasBeenSyncedUsingRTCP,
+				Boolean& rtpMarkerBit) {
+  // added by kofera.deng on 20151119 
+  if (rtpMarkerBit) fHead = 0;
+
+  unsigned char* origFramePtr = &fBuf[fHead];
+  framePtr = origFramePtr; // may change in the call below
+  unsigned frameDurationInMicroseconds;
+  getNextEnclosedFrameParameters(framePtr, fTail - fHead,
+				 frameSize, frameDurationInMicroseconds);
+  fHead += (framePtr - origFramePtr) + frameSize;
   ++fUseCount;
 
   rtpSeqNo = fRTPSeqNo;
@@ -475,11 +940,18 @@ BufferedPacket* BufferedPacketFactory
 
 ReorderingPacketBuffer
 ::ReorderingPacketBuffer(BufferedPacketFactory* packetFactory)
-  : fThresholdTime(100000) /* default reordering threshold: 100 ms */,
-    fHaveSeenFirstPacket(False), fHeadPacket(NULL), fTailPacket(NULL), fSavedPacket(NULL), fSavedPacketFree(True) {
+  : fPacketSize(MAX_PACKET_SIZE), fMaxPacketSize(MAX_PACKET_SIZE),
+    fMemoryFunc(NULL), fMemoryFuncClientData(NULL), fNumBufferBytes(0),
+    fThresholdTime(100000) /* default reordering threshold: 100 ms */,
+    fAdaptiveThreshold(False), fMinThresholdTime(0), fMaxThresholdTime(0), fJitterUSeconds(0), fReorderDelay(0),
+    fSkippedSeqNoBegin(0), fSkippedSeqNoEnd(0), fNewGapSeqNo(0), fNewGapSize(0),
+    fHaveSeenFirstPacket(False), fHeadPacket(NULL), fTailPacket(NULL), fSavedPacket(NULL), fSavedPacketFree(True),
+    fSparePackets(NULL), fNumSparePackets(0) {
   fPacketFactory = (packetFactory == NULL)
     ? (new BufferedPacketFactory)
     : packetFactory;
+  fReorderDelayDecayTime.tv_sec = fReorderDelayDecayTime.tv_usec = 0;
+  fSkipTime.tv_sec = fSkipTime.tv_usec = 0;
 }
 
 ReorderingPacketBuffer::~ReorderingPacketBuffer() {
@@ -490,22 +962,107 @@ ReorderingPacketBuffer::~ReorderingPacketBuffer() {
 void ReorderingPacketBuffer::reset() {
   if (fSavedPacketFree) delete fSavedPacket; // because fSavedPacket is not in the list
   delete fHeadPacket; // will also delete fSavedPacket if it's in the list
+  delete fSparePackets;
+  accountFor(-(int)fNumBufferBytes);
   resetHaveSeenFirstPacket();
-  fHeadPacket = fTailPacket = fSavedPacket = NULL;
+  fHeadPacket = fTailPacket = fSavedPacket = fSparePackets = NULL;
+  fNumSparePackets = 0;
 }
 
 BufferedPacket* ReorderingPacketBuffer::getFreePacket(MultiFramedRTPSource* ourSource) {
-  if (fSavedPacket == NULL) { // we're being called for the first time
-    fSavedPacket = fPacketFactory->createNewPacket(ourSource);
+  if (fSavedPacket == NULL) { // we're being called for the first time (or "fSavedPacket" was detached)
+    fSavedPacket = newPacket(ourSource);
     fSavedPacketFree = True;
   }
 
+  BufferedPacket* packet;
   if (fSavedPacketFree == True) {
     fSavedPacketFree = False;
-    return fSavedPacket;
+    packet = fSavedPacket;
   } else {
-    return fPacketFactory->createNewPacket(ourSource);
+    packet = newPacket(ourSource);
+  }
+
+  // A free packet holds no data, so it can be (re)sized to the current packet size:
+  resizePacket(packet, fPacketSize);
+  return packet;
+}
+
+BufferedPacket* ReorderingPacketBuffer::newPacket(MultiFramedRTPSource* ourSource) {
+  if (fSparePackets == NULL) return fPacketFactory->createNewPacket(ourSource);
+
+  BufferedPacket* packet = fSparePackets;
+  fSparePackets = packet->nextPacket();
+  packet->nextPacket() = NULL;
+  --fNumSparePackets;
+  return packet;
+}
+
+#define MAX_NUM_SPARE_PACKETS 16
+
+void ReorderingPacketBuffer::recyclePacket(BufferedPacket* packet) {
+  if (fNumSparePackets >= MAX_NUM_SPARE_PACKETS) {
+    accountFor(-(int)packet->packetSize());
+    delete packet;
+    return;
+  }
+
+  packet->nextPacket() = fSparePackets;
+  fSparePackets = packet;
+  ++fNumSparePackets;
+}
+
+Boolean ReorderingPacketBuffer::resizePacket(BufferedPacket* packet, unsigned newPacketSize) {
+  unsigned oldPacketSize = packet->packetSize();
+  if (newPacketSize == oldPacketSize) return True;
+  if (!packet->setPacketSize(newPacketSize)) return False;
+
+  accountFor((int)newPacketSize - (int)oldPacketSize);
+  return True;
+}
+
+Boolean ReorderingPacketBuffer::growPacketSize(BufferedPacket* packetInProgress) {
+  if (fPacketSize >= fMaxPacketSize) return False; // we're not allowed to grow (any more)
+
+  unsigned newPacketSize = fPacketSize*2;
+  if (newPacketSize > fMaxPacketSize) newPacketSize = fMaxPacketSize;
+  if (newPacketSize > MAX_GROWN_PACKET_SIZE) newPacketSize = MAX_GROWN_PACKET_SIZE;
+  if (newPacketSize <= fPacketSize) return False;
+  fPacketSize = newPacketSize;
+
+  return packetInProgress == NULL || resizePacket(packetInProgress, newPacketSize);
+}
+
+void ReorderingPacketBuffer::setAdaptiveThreshold(unsigned minUSeconds, unsigned maxUSeconds) {
+  fAdaptiveThreshold = True;
+  fMinThresholdTime = minUSeconds;
+  fMaxThresholdTime = maxUSeconds > minUSeconds ? maxUSeconds : minUSeconds;
+  fReorderDelay = 0;
+  fThresholdTime = fMinThresholdTime; // until we know more about the stream
+}
+
+void ReorderingPacketBuffer::noteReorderDelay(unsigned uSeconds, struct timeval const& timeNow) {
+  if (uSeconds > fReorderDelay) fReorderDelay = uSeconds;
+  updateThreshold(timeNow);
+}
+
+void ReorderingPacketBuffer::updateThreshold(struct timeval const& timeNow) {
+  // Let the peak reordering delay decay (by 1/4 each second), so that we go back to a short wait once reordering stops:
+  if (timeNow.tv_sec > fReorderDelayDecayTime.tv_sec
+      || (timeNow.tv_sec == fReorderDelayDecayTime.tv_sec && timeNow.tv_usec >= fReorderDelayDecayTime.tv_usec)) {
+    fReorderDelay -= fReorderDelay/4;
+    fReorderDelayDecayTime = timeNow;
+    ++fReorderDelayDecayTime.tv_sec;
   }
+
+  // Wait long enough for packets that are delayed by ordinary jitter, and for (somewhat more than) the reordering
+  // that we've seen recently:
+  unsigned threshold = 4*fJitterUSeconds;
+  if (fReorderDelay + fReorderDelay/2 > threshold) threshold = fReorderDelay + fReorderDelay/2;
+
+  if (threshold < fMinThresholdTime) threshold = fMinThresholdTime;
+  else if (threshold > fMaxThresholdTime) threshold = fMaxThresholdTime;
+  fThresholdTime = threshold;
 }
 
 Boolean ReorderingPacketBuffer::storePacket(BufferedPacket* bPacket) {
@@ -519,10 +1076,22 @@ Boolean ReorderingPacketBuffer::storePacket(BufferedPacket* bPacket) {
 
   // Ignore this packet if its sequence number is less than the one
   // that we're looking for (in this case, it's been excessively delayed).
-  if (seqNumLT(rtpSeqNo, fNextExpectedSeqNo)) return False;
+  if (seqNumLT(rtpSeqNo, fNextExpectedSeqNo)) {
+    if (fAdaptiveThreshold && !seqNumLT(rtpSeqNo, fSkippedSeqNoBegin) && seqNumLT(rtpSeqNo, fSkippedSeqNoEnd)) {
+      // We gave up on this packet too soon.  Note how long we would have needed to wait for it:
+      struct timeval const& timeReceived = bPacket->timeReceived();
+      int uSecondsLate = (timeReceived.tv_sec - fSkipTime.tv_sec)*1000000 + (timeReceived.tv_usec - fSkipTime.tv_usec);
+      if (uSecondsLate > 0) noteReorderDelay(fThresholdTime + uSecondsLate, timeReceived);
+    }
+    return False;
+  }
 
   if (fTailPacket == NULL) {
     // Common case: There are no packets in the queue; this will be the first one:
+    if (rtpSeqNo != fNextExpectedSeqNo) {
+      fNewGapSeqNo = fNextExpectedSeqNo;
+      fNewGapSize = (u_int16_t)(rtpSeqNo - fNextExpectedSeqNo);
+    }
     bPacket->nextPacket() = NULL;
     fHeadPacket = fTailPacket = bPacket;
     return True;
@@ -530,6 +1099,10 @@ Boolean ReorderingPacketBuffer::storePacket(BufferedPacket* bPacket) {
 
   if (seqNumLT(fTailPacket->rtpSeqNo(), rtpSeqNo)) {
     // The next-most common case: There are packets already in the queue; this packet arrived in order => put it at the tail:
+    if (rtpSeqNo != (u_int16_t)(fTailPacket->rtpSeqNo() + 1)) {
+      fNewGapSeqNo = fTailPacket->rtpSeqNo() + 1;
+      fNewGapSize = (u_int16_t)(rtpSeqNo - fNewGapSeqNo);
+    }
     bPacket->nextPacket() = NULL;
     fTailPacket->nextPacket() = bPacket;
     fTailPacket = bPacket;
@@ -555,6 +1128,21 @@ Boolean ReorderingPacketBuffer::storePacket(BufferedPacket* bPacket) {
     afterPtr = afterPtr->nextPacket();
   }
 
+  if (fAdaptiveThreshold) {
+    // Note how long this packet kept us waiting - since the arrival of the first packet that followed it:
+    struct timeval const& timeReceived = bPacket->timeReceived();
+    struct timeval firstFollowerTime = afterPtr->timeReceived();
+    for (BufferedPacket* p = afterPtr->nextPacket(); p != NULL; p = p->nextPacket()) {
+      if (p->timeReceived().tv_sec < firstFollowerTime.tv_sec
+	  || (p->timeReceived().tv_sec == firstFollowerTime.tv_sec && p->timeReceived().tv_usec < firstFollowerTime.tv_usec)) {
+	firstFollowerTime = p->timeReceived();
+      }
+    }
+    int uSecondsLate
+      = (timeReceived.tv_sec - firstFollowerTime.tv_sec)*1000000 + (timeReceived.tv_usec - firstFollowerTime.tv_usec);
+    if (uSecondsLate > 0) noteReorderDelay(uSecondsLate, timeReceived);
+  }
+
   // Link our new packet between "beforePtr" and "afterPtr":
   bPacket->nextPacket() = afterPtr;
   if (beforePtr == NULL) {
@@ -566,6 +1154,13 @@ Boolean ReorderingPacketBuffer::storePacket(BufferedPacket* bPacket) {
   return True;
 }
 
+unsigned ReorderingPacketBuffer::takeNewGap(u_int16_t& firstMissingSeqNo) {
+  unsigned gapSize = fNewGapSize;
+  firstMissingSeqNo = fNewGapSeqNo;
+  fNewGapSize = 0;
+  return gapSize;
+}
+
 void ReorderingPacketBuffer::releaseUsedPacket(BufferedPacket* packet) {
   // ASSERT: packet == fHeadPacket
   // ASSERT: fNextExpectedSeqNo == packet->rtpSeqNo()
@@ -580,8 +1175,21 @@ void ReorderingPacketBuffer::releaseUsedPacket(BufferedPacket* packet) {
   freePacket(packet);
 }
 
+void ReorderingPacketBuffer::detachUsedPacket(BufferedPacket* packet) {
+  // ASSERT: packet == fHeadPacket
+  ++fNextExpectedSeqNo; // because we're finished with this packet now
+
+  fHeadPacket = fHeadPacket->nextPacket();
+  if (!fHeadPacket) {
+    fTailPacket = NULL;
+  }
+  packet->nextPacket() = NULL;
+
+  if (packet == fSavedPacket) fSavedPacket = NULL; // the caller now owns it; we'll get another
+}
+
 BufferedPacket* ReorderingPacketBuffer
-::getNextCompletedPacket(Boolean& packetLossPreceded) {
+::getNextCompletedPacket(Boolean& packetLossPreceded, struct timeval const& timeNow) {
   if (fHeadPacket == NULL) return NULL;
 
   // Check whether the next packet we want is already at the head
@@ -600,14 +1208,17 @@ BufferedPacket* ReorderingPacketBuffer
   if (fThresholdTime == 0) {
     timeThresholdHasBeenExceeded = True; // optimization
   } else {
-    struct timeval timeNow;
-    gettimeofday(&timeNow, NULL);
     unsigned uSecondsSinceReceived
       = (timeNow.tv_sec - fHeadPacket->timeReceived().tv_sec)*1000000
       + (timeNow.tv_usec - fHeadPacket->timeReceived().tv_usec);
     timeThresholdHasBeenExceeded = uSecondsSinceReceived > fThresholdTime;
   }
   if (timeThresholdHasBeenExceeded) {
+    // Remember which packets we're giving up on (in case they arrive later):
+    fSkippedSeqNoBegin = fNextExpectedSeqNo;
+    fSkippedSeqNoEnd = fHeadPacket->rtpSeqNo();
+    fSkipTime = timeNow;
+
     fNextExpectedSeqNo = fHeadPacket->rtpSeqNo();
         // we've given up on earlier packets now
     packetLossPreceded = True;
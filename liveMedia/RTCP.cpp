@@ -132,7 +132,10 @@ RTCPInstance::RTCPInstance(UsageEnvironment& env, Groupsock* RTCPgs,
     fByeHandlerTask(NULL), fByeHandlerClientData(NULL),
     fSRHandlerTask(NULL), fSRHandlerClientData(NULL),
     fRRHandlerTask(NULL), fRRHandlerClientData(NULL),
-    fSpecificRRHandlerTable(NULL) {
+    fSpecificRRHandlerTable(NULL),
+    fFeedbackTypes(0), fFeedbackTokens(0), fFIRSeqNum(0) {
+  fFeedbackTokenTime.tv_sec = fFeedbackTokenTime.tv_usec = 0;
+  fLastKeyFrameRequestTime.tv_sec = fLastKeyFrameRequestTime.tv_usec = 0;
 #ifdef DEBUG
   fprintf(stderr, "RTCPInstance[%p]::RTCPInstance()\n", this);
 #endif
@@ -177,8 +180,9 @@ RTCPInstance::~RTCPInstance() {
 #ifdef DEBUG
   fprintf(stderr, "RTCPInstance[%p]::~RTCPInstance()\n", this);
 #endif
-  // Turn off background read handling:
+  // Turn off background read handling, and any feedback from our source:
   fRTCPInterface.stopNetworkReading();
+  enableFeedback(0);
 
   // Begin by sending a BYE.  We have to do this immediately, without
   // 'reconsideration', because "this" is going away.
@@ -651,6 +655,109 @@ void RTCPInstance::sendBYE() {
   sendBuiltPacket();
 }
 
+#define MAX_FEEDBACK_TOKENS 10 // the largest burst of feedback packets
+#define FEEDBACK_TOKEN_INTERVAL 20000 // uSeconds; i.e., (on average) no more than 50 feedback packets per second
+#define MAX_NACKED_PACKETS 64 // for a larger gap, a retransmission would take too long; wait for the frame to be lost
+#define MIN_KEY_FRAME_REQUEST_INTERVAL 500000 // uSeconds; to give the sender time to produce the key frame
+
+void RTCPInstance::enableFeedback(unsigned feedbackTypes) {
+  if (fSource == NULL) return; // feedback is only for receivers
+  fFeedbackTypes = feedbackTypes;
+
+  RTPSource* source = (RTPSource*)fSource; // (we change only its loss handlers)
+  if (feedbackTypes == 0) {
+    source->setLossHandlers(NULL, NULL, NULL);
+  } else {
+    source->setLossHandlers(packetLossHandler, frameLossHandler, this);
+    fFeedbackTokens = MAX_FEEDBACK_TOKENS;
+  }
+}
+
+void RTCPInstance::sendNACK(u_int32_t mediaSSRC, u_int16_t firstSeqNum, unsigned numPackets) {
+  // Each 'FCI' entry covers a packet id, and (with a bitmask) the 16 packets that follow it:
+  unsigned numFCIWords = (numPackets + 16)/17;
+
+  addReport(); // a feedback packet is part of a compound RTCP packet, beginning with a report
+  addSDES();
+  addFeedbackPrefix(RTCP_PT_RTPFB, RTCP_RTPFB_NACK, mediaSSRC, numFCIWords);
+  u_int16_t seqNum = firstSeqNum;
+  while (numPackets > 0) {
+    unsigned numInBitmask = numPackets - 1 < 16 ? numPackets - 1 : 16;
+    u_int16_t bitmask = numInBitmask == 16 ? 0xFFFF : (u_int16_t)((1<<numInBitmask) - 1);
+    fOutBuf->enqueueWord((seqNum<<16) | bitmask);
+
+    seqNum += 1 + numInBitmask;
+    numPackets -= 1 + numInBitmask;
+  }
+  sendBuiltPacket();
+}
+
+void RTCPInstance::sendPLI(u_int32_t mediaSSRC) {
+  addReport();
+  addSDES();
+  addFeedbackPrefix(RTCP_PT_PSFB, RTCP_PSFB_PLI, mediaSSRC, 0);
+  sendBuiltPacket();
+}
+
+void RTCPInstance::sendFIR(u_int32_t mediaSSRC) {
+  addReport();
+  addSDES();
+  addFeedbackPrefix(RTCP_PT_PSFB, RTCP_PSFB_FIR, 0 /* (the media SSRC is in the FCI instead) */, 2);
+  fOutBuf->enqueueWord(mediaSSRC);
+  fOutBuf->enqueueWord(((unsigned)fFIRSeqNum++)<<24); // a new request
+  sendBuiltPacket();
+}
+
+Boolean RTCPInstance::takeFeedbackToken() {
+  struct timeval timeNow = envir().taskScheduler().loopTime();
+  int uSecondsSinceTopUp = (timeNow.tv_sec - fFeedbackTokenTime.tv_sec)*1000000
+    + (timeNow.tv_usec - fFeedbackTokenTime.tv_usec);
+  if (fFeedbackTokenTime.tv_sec == 0 || uSecondsSinceTopUp >= FEEDBACK_TOKEN_INTERVAL*MAX_FEEDBACK_TOKENS) {
+    fFeedbackTokens = MAX_FEEDBACK_TOKENS;
+    fFeedbackTokenTime = timeNow;
+  } else if (uSecondsSinceTopUp >= FEEDBACK_TOKEN_INTERVAL) {
+    unsigned numNewTokens = uSecondsSinceTopUp/FEEDBACK_TOKEN_INTERVAL;
+    fFeedbackTokens += numNewTokens;
+    if (fFeedbackTokens > MAX_FEEDBACK_TOKENS) fFeedbackTokens = MAX_FEEDBACK_TOKENS;
+    unsigned uSecondsUsed = numNewTokens*FEEDBACK_TOKEN_INTERVAL;
+    fFeedbackTokenTime.tv_sec += uSecondsUsed/1000000;
+    fFeedbackTokenTime.tv_usec += uSecondsUsed%1000000;
+    if (fFeedbackTokenTime.tv_usec >= 1000000) {
+      fFeedbackTokenTime.tv_usec -= 1000000;
+      ++fFeedbackTokenTime.tv_sec;
+    }
+  }
+
+  if (fFeedbackTokens == 0) return False;
+  --fFeedbackTokens;
+  return True;
+}
+
+void RTCPInstance::packetLossHandler(void* clientData, u_int32_t SSRC, u_int16_t firstSeqNum, unsigned numPackets) {
+  RTCPInstance* instance = (RTCPInstance*)clientData;
+  if ((instance->fFeedbackTypes&FEEDBACK_NACK) == 0 || numPackets > MAX_NACKED_PACKETS) return;
+  if (!instance->takeFeedbackToken()) return;
+
+  instance->sendNACK(SSRC, firstSeqNum, numPackets);
+}
+
+void RTCPInstance::frameLossHandler(void* clientData, u_int32_t SSRC) {
+  RTCPInstance* instance = (RTCPInstance*)clientData;
+  if ((instance->fFeedbackTypes&(FEEDBACK_PLI|FEEDBACK_FIR)) == 0) return;
+
+  // Don't ask for another key frame while the sender is (probably) still sending the one we asked for:
+  struct timeval timeNow = instance->envir().taskScheduler().loopTime();
+  struct timeval& lastRequestTime = instance->fLastKeyFrameRequestTime;
+  if (lastRequestTime.tv_sec != 0
+      && (timeNow.tv_sec - lastRequestTime.tv_sec)*1000000 + (timeNow.tv_usec - lastRequestTime.tv_usec)
+         < MIN_KEY_FRAME_REQUEST_INTERVAL) return;
+  if (!instance->takeFeedbackToken()) return;
+  lastRequestTime = timeNow;
+
+  if (instance->fFeedbackTypes&FEEDBACK_PLI) instance->sendPLI(SSRC);
+  if (instance->fFeedbackTypes&FEEDBACK_FIR) instance->sendFIR(SSRC); // (for senders that don't handle "PLI"s)
+}
+
 void RTCPInstance::sendBuiltPacket() {
 #ifdef DEBUG
   fprintf(stderr, "sending RTCP packet\n");
@@ -891,6 +998,18 @@ void RTCPInstance::addBYE() {
   }
 }
 
+void RTCPInstance::addFeedbackPrefix(unsigned char packetType, unsigned char fmt, u_int32_t mediaSSRC,
+				     unsigned numFCIWords) {
+  unsigned rtcpHdr = 0x80000000; // version 2, no padding
+  rtcpHdr |= (fmt<<24);
+  rtcpHdr |= (packetType<<16);
+  rtcpHdr |= (2 + numFCIWords); // the sender's and the media source's SSRCs, then the 'FCI'
+  fOutBuf->enqueueWord(rtcpHdr);
+
+  fOutBuf->enqueueWord(fSource->SSRC());
+  fOutBuf->enqueueWord(mediaSSRC);
+}
+
 void RTCPInstance::schedule(double nextTime) {
   fNextReportTime = nextTime;
 
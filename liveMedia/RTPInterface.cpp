@@ -110,7 +110,7 @@ RTPInterface::RTPInterface(Medium* owner, Groupsock* gs)
   : fOwner(owner), fGS(gs),
     fTCPStreams(NULL),
     fNextTCPReadSize(0), fNextTCPReadStreamSocketNum(-1),
-    fNextTCPReadStreamChannelId(0xFF), fReadHandlerProc(NULL),
+    fNextTCPReadStreamChannelId(0xFF), fLastReadWasFromTCP(False), fReadHandlerProc(NULL),
     fAuxReadHandlerFunc(NULL), fAuxReadHandlerClientData(NULL) {
   // Make the socket non-blocking, even though it will be read from only asynchronously, when packets arrive.
   // The reason for this is that, in some OSs, reads on a blocking socket can (allegedly) sometimes block,
@@ -220,10 +220,20 @@ void RTPInterface
   }
 }
 
+struct timeval RTPInterface::lastReceiveTime() const {
+  if (fLastReadWasFromTCP) {
+    struct timeval unknown;
+    unknown.tv_sec = unknown.tv_usec = 0;
+    return unknown;
+  }
+  return fGS->lastReceiveTime();
+}
+
 Boolean RTPInterface::handleRead(unsigned char* buffer, unsigned bufferMaxSize,
 				 unsigned& bytesRead, struct sockaddr_in& fromAddress, Boolean& packetReadWasIncomplete) {
   packetReadWasIncomplete = False; // by default
   Boolean readSuccess;
+  fLastReadWasFromTCP = fNextTCPReadStreamSocketNum >= 0;
   if (fNextTCPReadStreamSocketNum < 0) {
     // Normal case: read from the (datagram) 'groupsock':
     readSuccess = fGS->handleRead(buffer, bufferMaxSize, bytesRead, fromAddress);
@@ -20,6 +20,7 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 
 #include "RTPSource.hh"
 #include "GroupsockHelper.hh"
+#include <string.h>
 
 ////////// RTPSource //////////
 
@@ -54,15 +55,39 @@ RTPSource::RTPSource(UsageEnvironment& env, Groupsock* RTPgs,
   : FramedSource(env),
     fRTPInterface(this, RTPgs), fCurPacketMarkerBit(false),
     fCurPacketHasBeenSynchronizedUsingRTCP(False), fLastReceivedSSRC(0),
+    fPacketLossHandler(NULL), fFrameLossHandler(NULL), fLossHandlerClientData(NULL),
     fRTPPayloadFormat(rtpPayloadFormat), fTimestampFrequency(rtpTimestampFrequency),
     fSSRC(our_random32()), fEnableRTCPReports(True) {
   fReceptionStatsDB = new RTPReceptionStatsDB();
 }
 
+void RTPSource::setLossHandlers(PacketLossHandler* packetLossHandler, FrameLossHandler* frameLossHandler,
+				void* clientData) {
+  fPacketLossHandler = packetLossHandler;
+  fFrameLossHandler = frameLossHandler;
+  fLossHandlerClientData = clientData;
+}
+
 RTPSource::~RTPSource() {
   delete fReceptionStatsDB;
 }
 
+void RTPSource::setPacketBufferSize(unsigned /*packetBufferSize*/, unsigned /*maxPacketBufferSize*/) {
+  // default implementation: do nothing
+}
+
+unsigned RTPSource::packetBufferSize() const {
+  return 0; // default implementation
+}
+
+void RTPSource::setBufferMemoryFunc(BufferMemoryFunc* /*func*/, void* /*clientData*/) {
+  // default implementation: do nothing
+}
+
+void RTPSource::registerHeaderExtension(unsigned char /*id*/, RTPHeaderExtensions::Type /*type*/) {
+  // default implementation: do nothing
+}
+
 void RTPSource::getAttributes() const {
   envir().setResultMsg(""); // Fix later to get attributes from  header #####
 }
@@ -102,7 +127,7 @@ void RTPReceptionStatsDB
 		     Boolean useForJitterCalculation,
 		     struct timeval& resultPresentationTime,
 		     Boolean& resultHasBeenSyncedUsingRTCP,
-		     unsigned packetSize) {
+		     unsigned packetSize, struct timeval const* timeReceived) {
   ++fTotNumPacketsReceived;
   RTPReceptionStats* stats = lookup(SSRC);
   if (stats == NULL) {
@@ -120,7 +145,7 @@ void RTPReceptionStatsDB
   stats->noteIncomingPacket(seqNum, rtpTimestamp, timestampFrequency,
 			    useForJitterCalculation,
 			    resultPresentationTime,
-			    resultHasBeenSyncedUsingRTCP, packetSize);
+			    resultHasBeenSyncedUsingRTCP, packetSize, timeReceived);
 }
 
 void RTPReceptionStatsDB
@@ -231,7 +256,7 @@ void RTPReceptionStats
 		     Boolean useForJitterCalculation,
 		     struct timeval& resultPresentationTime,
 		     Boolean& resultHasBeenSyncedUsingRTCP,
-		     unsigned packetSize) {
+		     unsigned packetSize, struct timeval const* timeReceived) {
   if (!fHaveSeenInitialSequenceNumber) initSeqNum(seqNum);
 
   ++fNumPacketsReceivedSinceLastReset;
@@ -273,9 +298,13 @@ void RTPReceptionStats
     }
   }
 
-  // Record the inter-packet delay
+  // Record the inter-packet delay (using the packet's arrival time, if we were given it)
   struct timeval timeNow;
-  gettimeofday(&timeNow, NULL);
+  if (timeReceived != NULL) {
+    timeNow = *timeReceived;
+  } else {
+    gettimeofday(&timeNow, NULL);
+  }
   if (fLastPacketReceptionTime.tv_sec != 0
       || fLastPacketReceptionTime.tv_usec != 0) {
     unsigned gap
@@ -393,6 +422,30 @@ void RTPReceptionStats::reset() {
   fLastResetExtSeqNumReceived = fHighestExtSeqNumReceived;
 }
 
+
+
+////////// RTPHeaderExtensions //////////
+
+RTPHeaderExtensions::Type RTPHeaderExtensions::lookupURI(char const* uri) {
+  if (strcmp(uri, "http://www.webrtc.org/experiments/rtp-hdrext/abs-send-time") == 0) return ABS_SEND_TIME;
+  if (strcmp(uri, "http://www.webrtc.org/experiments/rtp-hdrext/abs-capture-time") == 0) return ABS_CAPTURE_TIME;
+  return NONE;
+}
+
+void RTPHeaderExtensions::merge(RTPHeaderExtensions const& from) {
+  unsigned newElements = from.fPresent&~fPresent;
+  if (newElements == 0) return; // common case
+
+  if (newElements&(1<<ABS_SEND_TIME)) absSendTime = from.absSendTime;
+  if (newElements&(1<<ABS_CAPTURE_TIME)) absCaptureTime = from.absCaptureTime;
+  if (newElements&(1<<ONVIF_REPLAY)) {
+    onvifNTPTime = from.onvifNTPTime;
+    onvifFlags = from.onvifFlags;
+    onvifCSeq = from.onvifCSeq;
+  }
+  fPresent |= newElements;
+}
+
 Boolean seqNumLT(u_int16_t s1, u_int16_t s2) {
   // a 'less-than' on 16-bit sequence numbers
   int diff = s2-s1;
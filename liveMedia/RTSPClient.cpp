@@ -304,7 +304,8 @@ RTSPClient::RTSPClient(UsageEnvironment& env, char const* rtspURL,
     fLastSessionId(NULL), fSessionTimeoutParameter(0), fSessionCookieCounter(0), fHTTPTunnelingConnectionIsPending(False) {
   setBaseURL(rtspURL);
 
-  fResponseBuffer = new char[responseBufferSize+1];
+  fResponseBufferSize = fMaxResponseBufferSize = responseBufferSize;
+  fResponseBuffer = new char[fResponseBufferSize+1];
   resetResponseBuffer();
 
   // Set the "User-Agent:" header to use in each request:
@@ -363,7 +364,38 @@ void RTSPClient::resetTCPSockets() {
 
 void RTSPClient::resetResponseBuffer() {
   fResponseBytesAlreadySeen = 0;
-  fResponseBufferBytesLeft = responseBufferSize;
+  fResponseBufferBytesLeft = fResponseBufferSize;
+}
+
+Boolean RTSPClient::setResponseBufferSize(unsigned initialSize, unsigned maxSize) {
+  if (initialSize == 0 || fResponseBytesAlreadySeen > 0) return False;
+
+  if (initialSize != fResponseBufferSize) {
+    delete[] fResponseBuffer;
+    fResponseBufferSize = initialSize;
+    fResponseBuffer = new char[fResponseBufferSize+1];
+    resetResponseBuffer();
+  }
+  fMaxResponseBufferSize = maxSize > initialSize ? maxSize : initialSize;
+  return True;
+}
+
+Boolean RTSPClient::growResponseBuffer(unsigned minSize, unsigned numNewBytes) {
+  // Returns True iff the buffer is now at least "minSize" bytes (keeping the data that's already in it):
+  if (minSize <= fResponseBufferSize) return True;
+  if (minSize > fMaxResponseBufferSize) return False;
+
+  unsigned newSize = fResponseBufferSize;
+  while (newSize < minSize) newSize *= 2;
+  if (newSize > fMaxResponseBufferSize) newSize = fMaxResponseBufferSize;
+
+  char* newBuffer = new char[newSize+1];
+  memmove(newBuffer, fResponseBuffer, fResponseBytesAlreadySeen + numNewBytes);
+  delete[] fResponseBuffer;
+  fResponseBuffer = newBuffer;
+  fResponseBufferBytesLeft += newSize - fResponseBufferSize;
+  fResponseBufferSize = newSize;
+  return True;
 }
 
 void RTSPClient::setBaseURL(char const* url) {
@@ -998,7 +1030,7 @@ Boolean RTSPClient::parseRTPInfoParams(char const*& paramsStr, u_int16_t& seqNum
 
 Boolean RTSPClient::handleSETUPResponse(MediaSubsession& subsession, char const* sessionParamsStr, char const* transportParamsStr,
                                         Boolean streamUsingTCP) {
-  char* sessionId = new char[responseBufferSize]; // ensures we have enough space
+  char* sessionId = new char[fResponseBufferSize]; // ensures we have enough space
   Boolean success = False;
   do {
     // Check for a session id:
@@ -1405,7 +1437,10 @@ void RTSPClient::handleResponseBytes(int newBytesRead) {
       if (newBytesRead >= 0 && (unsigned)newBytesRead < fResponseBufferBytesLeft) break; // data was read OK; process it below
 
       if (newBytesRead >= (int)fResponseBufferBytesLeft) {
-          // We filled up our response buffer.  Treat this as an error (for the first response handler):
+          // We filled up our response buffer.  If it's allowed to grow, then do so (keeping the bytes that we just read), and carry on:
+          if (growResponseBuffer(fResponseBufferSize+1, newBytesRead)) break;
+
+          // Otherwise, treat this as an error (for the first response handler):
           envir().setResultMsg("RTSP response was truncated. Increase \"RTSPClient::responseBufferSize\"");
       }
 
@@ -1474,7 +1509,7 @@ void RTSPClient::handleResponseBytes(int newBytesRead) {
     unsigned numBodyBytes = 0;
     responseSuccess = False;
     do {
-      headerDataCopy = new char[responseBufferSize];
+      headerDataCopy = new char[fResponseBufferSize];
       strncpy(headerDataCopy, fResponseBuffer, fResponseBytesAlreadySeen);
       headerDataCopy[fResponseBytesAlreadySeen] = '\0';
       
@@ -1564,11 +1599,12 @@ void RTSPClient::handleResponseBytes(int newBytesRead) {
       if (contentLength > numBodyBytes) {
 	// We need to read more data.  First, make sure we have enough space for it:
 	unsigned numExtraBytesNeeded = contentLength - numBodyBytes;
-	unsigned remainingBufferSize = responseBufferSize - fResponseBytesAlreadySeen;
-	if (numExtraBytesNeeded > remainingBufferSize) {
+	unsigned remainingBufferSize = fResponseBufferSize - fResponseBytesAlreadySeen;
+	if (numExtraBytesNeeded > remainingBufferSize
+	    && !growResponseBuffer(fResponseBytesAlreadySeen + numExtraBytesNeeded)) {
 	  char tmpBuf[200];
 	  sprintf(tmpBuf, "Response buffer size (%d) is too small for \"Content-Length:\" %d (need a buffer size of >= %d bytes\n",
-		  responseBufferSize, contentLength, fResponseBytesAlreadySeen + numExtraBytesNeeded);
+		  fResponseBufferSize, contentLength, fResponseBytesAlreadySeen + numExtraBytesNeeded);
 	  envir().setResultMsg(tmpBuf);
 	  break;
 	}
@@ -1653,7 +1689,7 @@ void RTSPClient::handleResponseBytes(int newBytesRead) {
       
       memmove(fResponseBuffer, responseEnd, numExtraBytesAfterResponse);
       fResponseBytesAlreadySeen = numExtraBytesAfterResponse;
-      fResponseBufferBytesLeft = responseBufferSize - numExtraBytesAfterResponse;
+      fResponseBufferBytesLeft = fResponseBufferSize - numExtraBytesAfterResponse;
       fResponseBuffer[numExtraBytesAfterResponse] = '\0';
     } else {
       resetResponseBuffer();
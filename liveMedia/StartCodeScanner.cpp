@@ -0,0 +1,99 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 2.1 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2013 Live Networks, Inc.  All rights reserved.
+// A fast search for "00 00 01" start codes (as used by H.264, H.265 and MPEG video)
+// Implementation
+
+#include "StartCodeScanner.hh"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define START_CODE_SCANNER_USE_SIMD 1
+#include <immintrin.h>
+#endif
+
+static unsigned findStartCodeScalar(unsigned char const* data, unsigned size, unsigned i) {
+  // Look at every 3rd byte; a start code must have a zero at one of the two positions that precede a "1":
+  while (i + 2 < size) {
+    if (data[i+2] > 1) {
+      i += 3;
+    } else if (data[i+2] == 1) {
+      if (data[i] == 0 && data[i+1] == 0) return i;
+      i += 3;
+    } else { // data[i+2] == 0
+      ++i;
+    }
+  }
+  return size;
+}
+
+#ifdef START_CODE_SCANNER_USE_SIMD
+// In each kernel, bit j of the mask is set iff "data[i+j], data[i+j+1], data[i+j+2]" is "00 00 01".
+
+__attribute__((target("sse2")))
+static unsigned findStartCodeSSE2(unsigned char const* data, unsigned size) {
+  __m128i const zero = _mm_setzero_si128();
+  __m128i const one = _mm_set1_epi8(1);
+  unsigned i = 0;
+  for (; i + 18 <= size; i += 16) {
+    __m128i b0 = _mm_loadu_si128((__m128i const*)(data + i));
+    __m128i b1 = _mm_loadu_si128((__m128i const*)(data + i + 1));
+    __m128i b2 = _mm_loadu_si128((__m128i const*)(data + i + 2));
+    __m128i match = _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(b0, zero), _mm_cmpeq_epi8(b1, zero)),
+				  _mm_cmpeq_epi8(b2, one));
+    unsigned mask = (unsigned)_mm_movemask_epi8(match);
+    if (mask != 0) return i + __builtin_ctz(mask);
+  }
+  return findStartCodeScalar(data, size, i);
+}
+
+__attribute__((target("avx2")))
+static unsigned findStartCodeAVX2(unsigned char const* data, unsigned size) {
+  __m256i const zero = _mm256_setzero_si256();
+  __m256i const one = _mm256_set1_epi8(1);
+  unsigned i = 0;
+  for (; i + 34 <= size; i += 32) {
+    __m256i b0 = _mm256_loadu_si256((__m256i const*)(data + i));
+    __m256i b1 = _mm256_loadu_si256((__m256i const*)(data + i + 1));
+    __m256i b2 = _mm256_loadu_si256((__m256i const*)(data + i + 2));
+    __m256i match = _mm256_and_si256(_mm256_and_si256(_mm256_cmpeq_epi8(b0, zero), _mm256_cmpeq_epi8(b1, zero)),
+				     _mm256_cmpeq_epi8(b2, one));
+    unsigned mask = (unsigned)_mm256_movemask_epi8(match);
+    if (mask != 0) return i + __builtin_ctz(mask);
+  }
+  return findStartCodeScalar(data, size, i);
+}
+#endif
+
+static unsigned findStartCodeDefault(unsigned char const* data, unsigned size) {
+  return findStartCodeScalar(data, size, 0);
+}
+
+typedef unsigned (FindStartCodeFunc)(unsigned char const* data, unsigned size);
+
+static FindStartCodeFunc* chooseFindStartCode() {
+#ifdef START_CODE_SCANNER_USE_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return findStartCodeAVX2;
+  if (__builtin_cpu_supports("sse2")) return findStartCodeSSE2;
+#endif
+  return findStartCodeDefault;
+}
+
+unsigned findStartCode(unsigned char const* data, unsigned size) {
+  static FindStartCodeFunc* findStartCodeImpl = chooseFindStartCode();
+  return (*findStartCodeImpl)(data, size);
+}
@@ -0,0 +1,292 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 2.1 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2013 Live Networks, Inc.  All rights reserved.
+// A decoder for RTP forward error correction packets (RFC 5109 "ULPFEC"), used by "MultiFramedRTPSource"
+// to recover missing media packets.
+// Implementation
+
+#include "ULPFECDecoder.hh"
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define USE_X86_XOR
+#include <immintrin.h>
+#endif
+
+////////// XOR kernels //////////
+
+// Recovery is a XOR of several packets, which is where nearly all of our time is spent:
+typedef void (XorFunc)(unsigned char* to, unsigned char const* from, unsigned numBytes);
+
+static void xorBytesScalar(unsigned char* to, unsigned char const* from, unsigned numBytes) {
+  while (numBytes >= sizeof (u_int32_t)) {
+    u_int32_t a, b;
+    memcpy(&a, to, sizeof a); memcpy(&b, from, sizeof b);
+    a ^= b;
+    memcpy(to, &a, sizeof a);
+    to += sizeof a; from += sizeof b; numBytes -= sizeof a;
+  }
+  while (numBytes-- > 0) *to++ ^= *from++;
+}
+
+#ifdef USE_X86_XOR
+__attribute__((target("sse2")))
+static void xorBytesSSE2(unsigned char* to, unsigned char const* from, unsigned numBytes) {
+  while (numBytes >= 16) {
+    __m128i a = _mm_loadu_si128((__m128i const*)to);
+    __m128i b = _mm_loadu_si128((__m128i const*)from);
+    _mm_storeu_si128((__m128i*)to, _mm_xor_si128(a, b));
+    to += 16; from += 16; numBytes -= 16;
+  }
+  xorBytesScalar(to, from, numBytes);
+}
+
+__attribute__((target("avx2")))
+static void xorBytesAVX2(unsigned char* to, unsigned char const* from, unsigned numBytes) {
+  while (numBytes >= 32) {
+    __m256i a = _mm256_loadu_si256((__m256i const*)to);
+    __m256i b = _mm256_loadu_si256((__m256i const*)from);
+    _mm256_storeu_si256((__m256i*)to, _mm256_xor_si256(a, b));
+    to += 32; from += 32; numBytes -= 32;
+  }
+  xorBytesSSE2(to, from, numBytes);
+}
+#endif
+
+static XorFunc* chooseXorFunc() {
+#ifdef USE_X86_XOR
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return xorBytesAVX2;
+  if (__builtin_cpu_supports("sse2")) return xorBytesSSE2;
+#endif
+  return xorBytesScalar;
+}
+
+static XorFunc* const xorBytes = chooseXorFunc();
+
+
+////////// ULPFECDecoder implementation //////////
+
+#define NUM_SAVED_MEDIA_PACKETS 64 // a power of 2; more than the 48 packets that a FEC packet can protect
+#define NUM_SAVED_FEC_PACKETS 16
+#define MAX_SAVED_PACKET_SIZE 16384 // larger packets aren't saved (so can't be recovered, or used for recovery)
+
+#define FEC_HEADER_SIZE 10
+#define FEC_LEVEL_HEADER_SIZE(longMask) ((longMask) ? 8 : 4)
+
+static inline u_int16_t get2Bytes(unsigned char const* p) { return (p[0]<<8)|p[1]; }
+static inline u_int32_t get4Bytes(unsigned char const* p) { return (p[0]<<24)|(p[1]<<16)|(p[2]<<8)|p[3]; }
+static inline Boolean seqNumLT16(u_int16_t s1, u_int16_t s2) { return (u_int16_t)(s2 - s1) - 1 < 0x7FFF; }
+
+ULPFECDecoder::ULPFECDecoder(RecoveredPacketHandler* handler, void* clientData)
+  : fHandler(handler), fHandlerClientData(clientData),
+    fNextFECPacketIndex(0), fNumSavedFECPackets(0), fRecoveryBuffer(NULL), fRecoveryBufferSize(0),
+    fNumRecoveredPackets(0), fNumBufferBytes(0), fIsRecovering(False) {
+  fMediaPackets = new SavedPacket[NUM_SAVED_MEDIA_PACKETS];
+  memset(fMediaPackets, 0, NUM_SAVED_MEDIA_PACKETS*sizeof (SavedPacket));
+  fFECPackets = new SavedPacket[NUM_SAVED_FEC_PACKETS];
+  memset(fFECPackets, 0, NUM_SAVED_FEC_PACKETS*sizeof (SavedPacket));
+}
+
+ULPFECDecoder::~ULPFECDecoder() {
+  for (unsigned i = 0; i < NUM_SAVED_MEDIA_PACKETS; ++i) delete[] fMediaPackets[i].data;
+  for (unsigned i = 0; i < NUM_SAVED_FEC_PACKETS; ++i) delete[] fFECPackets[i].data;
+  delete[] fMediaPackets;
+  delete[] fFECPackets;
+  delete[] fRecoveryBuffer;
+}
+
+void ULPFECDecoder::noteMediaPacket(unsigned char const* packet, unsigned packetSize) {
+  if (packetSize < 12) return;
+  u_int16_t seqNum = get2Bytes(&packet[2]);
+
+  SavedPacket& saved = fMediaPackets[seqNum%NUM_SAVED_MEDIA_PACKETS];
+  if (saved.size > 0 && saved.seqNum == seqNum) return; // we already have it (e.g., because we recovered it)
+  if (!savePacket(saved, packet, packetSize)) return;
+  saved.seqNum = seqNum;
+
+  // This packet might be the one that a saved FEC packet was waiting for:
+  if (fNumSavedFECPackets > 0 && !fIsRecovering) recoverPackets();
+}
+
+void ULPFECDecoder::noteFECPacket(unsigned char const* packet, unsigned packetSize) {
+  // Skip over the RTP header (and anything in it that we don't use):
+  if (packetSize < 12) return;
+  unsigned headerSize = 12 + 4*(packet[0]&0x0F);
+  if (packet[0]&0x10) { // there's a header extension
+    if (packetSize < headerSize + 4) return;
+    headerSize += 4 + 4*get2Bytes(&packet[headerSize+2]);
+  }
+  if (packet[0]&0x20) { // there's padding
+    unsigned numPaddingBytes = packet[packetSize-1];
+    if (packetSize < headerSize + numPaddingBytes) return;
+    packetSize -= numPaddingBytes;
+  }
+  if (packetSize < headerSize + FEC_HEADER_SIZE) return;
+  unsigned char const* fec = &packet[headerSize];
+  unsigned fecSize = packetSize - headerSize;
+
+  // Check the FEC header.  (We handle just 'level 0', which protects the first "protection length" bytes
+  // of each packet; that's what encoders send in practice.)
+  if (fec[0]&0x80) return; // the 'E' bit is reserved for future extensions
+  Boolean longMask = (fec[0]&0x40) != 0;
+  if (fecSize < FEC_HEADER_SIZE + FEC_LEVEL_HEADER_SIZE(longMask)) return;
+  unsigned protectionLength = get2Bytes(&fec[FEC_HEADER_SIZE]);
+  if (fecSize < FEC_HEADER_SIZE + FEC_LEVEL_HEADER_SIZE(longMask) + protectionLength) return;
+
+  // Usually, either nothing that this packet protects is missing (so we don't need it), or just one packet is (so
+  // we can recover it now).  Only if more are missing do we keep a copy, in case the others arrive (or are recovered):
+  SavedPacket fecPacket;
+  fecPacket.data = (unsigned char*)fec; fecPacket.size = fecSize;
+  fecPacket.SSRC = get4Bytes(&packet[8]);
+  Boolean isFinished;
+  if (tryRecovery(fecPacket, isFinished)) {
+    recoverPackets(); // because the recovered packet might help our saved FEC packets
+  } else if (!isFinished) {
+    SavedPacket& saved = fFECPackets[fNextFECPacketIndex];
+    fNextFECPacketIndex = (fNextFECPacketIndex + 1)%NUM_SAVED_FEC_PACKETS;
+    if (saved.size > 0) --fNumSavedFECPackets; // we're replacing our oldest one
+    if (savePacket(saved, fec, fecSize)) {
+      saved.SSRC = fecPacket.SSRC;
+      ++fNumSavedFECPackets;
+    }
+  }
+}
+
+Boolean ULPFECDecoder::savePacket(SavedPacket& saved, unsigned char const* packet, unsigned packetSize) {
+  if (packetSize > MAX_SAVED_PACKET_SIZE) {
+    saved.size = 0;
+    return False;
+  }
+  if (packetSize > saved.bufferSize) {
+    unsigned newBufferSize = (packetSize + 511)&~511;
+    delete[] saved.data;
+    saved.data = new unsigned char[newBufferSize];
+    fNumBufferBytes += newBufferSize - saved.bufferSize;
+    saved.bufferSize = newBufferSize;
+  }
+  memcpy(saved.data, packet, packetSize);
+  saved.size = packetSize;
+  return True;
+}
+
+ULPFECDecoder::SavedPacket* ULPFECDecoder::lookupMediaPacket(u_int16_t seqNum) {
+  SavedPacket& saved = fMediaPackets[seqNum%NUM_SAVED_MEDIA_PACKETS];
+  return saved.size > 0 && saved.seqNum == seqNum ? &saved : NULL;
+}
+
+Boolean ULPFECDecoder::tryRecovery(SavedPacket& fecPacket, Boolean& isFinished) {
+  unsigned char const* fec = fecPacket.data;
+  Boolean longMask = (fec[0]&0x40) != 0;
+  unsigned char const* levelHeader = &fec[FEC_HEADER_SIZE];
+  unsigned protectionLength = get2Bytes(levelHeader);
+  unsigned char const* mask = &levelHeader[2];
+  unsigned numMaskBits = longMask ? 48 : 16;
+  u_int16_t seqNumBase = get2Bytes(&fec[2]);
+
+  // Find the (one) missing packet:
+  unsigned numMissing = 0;
+  u_int16_t missingSeqNum = 0;
+  for (unsigned i = 0; i < numMaskBits; ++i) {
+    if ((mask[i/8]&(0x80>>(i%8))) == 0) continue;
+    u_int16_t seqNum = seqNumBase + i;
+    if (lookupMediaPacket(seqNum) != NULL) continue;
+
+    SavedPacket& slot = fMediaPackets[seqNum%NUM_SAVED_MEDIA_PACKETS];
+    if (slot.size > 0 && seqNumLT16(seqNum, slot.seqNum)) {
+      // This packet is too old for us to have it (or to recover it) any more:
+      isFinished = True;
+      return False;
+    }
+    if (++numMissing > 1) {
+      isFinished = False; // unless other packets arrive
+      return False;
+    }
+    missingSeqNum = seqNum;
+  }
+  isFinished = True;
+  if (numMissing == 0) return False;
+
+  // Recover the missing packet: its header fields, length and payload are each the XOR of the FEC packet's
+  // and the other protected packets':
+  if (fRecoveryBufferSize < 12 + protectionLength) {
+    delete[] fRecoveryBuffer;
+    fNumBufferBytes -= fRecoveryBufferSize;
+    fRecoveryBufferSize = 12 + protectionLength;
+    fRecoveryBuffer = new unsigned char[fRecoveryBufferSize];
+    fNumBufferBytes += fRecoveryBufferSize;
+  }
+  unsigned char* payload = &fRecoveryBuffer[12];
+  memcpy(payload, &levelHeader[FEC_LEVEL_HEADER_SIZE(longMask)], protectionLength);
+  unsigned char byte0 = fec[0], byte1 = fec[1];
+  u_int32_t timestamp = get4Bytes(&fec[4]);
+  unsigned length = get2Bytes(&fec[8]);
+  u_int32_t SSRC = fecPacket.SSRC;
+
+  for (unsigned i = 0; i < numMaskBits; ++i) {
+    if ((mask[i/8]&(0x80>>(i%8))) == 0) continue;
+    SavedPacket* p = lookupMediaPacket(seqNumBase + i);
+    if (p == NULL) continue; // the missing packet
+
+    byte0 ^= p->data[0];
+    byte1 ^= p->data[1];
+    timestamp ^= get4Bytes(&p->data[4]);
+    length ^= p->size - 12;
+    unsigned numBytes = p->size - 12;
+    if (numBytes > protectionLength) numBytes = protectionLength;
+    xorBytes(payload, &p->data[12], numBytes);
+    SSRC = get4Bytes(&p->data[8]); // (in case the FEC packets have their own SSRC)
+  }
+  if (length > protectionLength) return False; // (we'd need a higher FEC level for the rest of the packet)
+
+  fRecoveryBuffer[0] = 0x80|(byte0&0x3F); // RTP version 2
+  fRecoveryBuffer[1] = byte1;
+  fRecoveryBuffer[2] = missingSeqNum>>8; fRecoveryBuffer[3] = (unsigned char)missingSeqNum;
+  fRecoveryBuffer[4] = timestamp>>24; fRecoveryBuffer[5] = timestamp>>16;
+  fRecoveryBuffer[6] = timestamp>>8; fRecoveryBuffer[7] = timestamp;
+  fRecoveryBuffer[8] = SSRC>>24; fRecoveryBuffer[9] = SSRC>>16; fRecoveryBuffer[10] = SSRC>>8; fRecoveryBuffer[11] = SSRC;
+  unsigned packetSize = 12 + length;
+
+  // Save the recovered packet (so that it can be used to recover others), then hand it over:
+  SavedPacket& saved = fMediaPackets[missingSeqNum%NUM_SAVED_MEDIA_PACKETS];
+  if (savePacket(saved, fRecoveryBuffer, packetSize)) saved.seqNum = missingSeqNum;
+  ++fNumRecoveredPackets;
+
+  Boolean wasRecovering = fIsRecovering;
+  fIsRecovering = True; // because our handler will probably call "noteMediaPacket()" for this packet
+  (*fHandler)(fHandlerClientData, fRecoveryBuffer, packetSize);
+  fIsRecovering = wasRecovering;
+  return True;
+}
+
+void ULPFECDecoder::recoverPackets() {
+  Boolean madeProgress = True;
+  while (madeProgress && fNumSavedFECPackets > 0) {
+    madeProgress = False;
+    for (unsigned i = 0; i < NUM_SAVED_FEC_PACKETS; ++i) {
+      SavedPacket& fecPacket = fFECPackets[i];
+      if (fecPacket.size == 0) continue;
+
+      Boolean isFinished;
+      if (tryRecovery(fecPacket, isFinished)) madeProgress = True;
+      if (isFinished) {
+	fecPacket.size = 0;
+	--fNumSavedFECPackets;
+      }
+    }
+  }
+}
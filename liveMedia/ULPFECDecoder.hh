@@ -0,0 +1,77 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 2.1 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2013 Live Networks, Inc.  All rights reserved.
+// A decoder for RTP forward error correction packets (RFC 5109 "ULPFEC"), used by "MultiFramedRTPSource"
+// to recover missing media packets.
+// C++ header
+
+#ifndef _ULPFEC_DECODER_HH
+#define _ULPFEC_DECODER_HH
+
+#ifndef _BOOLEAN_HH
+#include "Boolean.hh"
+#endif
+#ifndef _NET_COMMON_H
+#include "NetCommon.h"
+#endif
+
+class ULPFECDecoder {
+public:
+  typedef void (RecoveredPacketHandler)(void* clientData, unsigned char const* packet, unsigned packetSize);
+
+  ULPFECDecoder(RecoveredPacketHandler* handler, void* clientData);
+  virtual ~ULPFECDecoder();
+
+  // Each of the following is given a complete RTP packet (header included).  Any media packets that can then be
+  // recovered are passed to our handler (before these functions return):
+  void noteMediaPacket(unsigned char const* packet, unsigned packetSize);
+  void noteFECPacket(unsigned char const* packet, unsigned packetSize);
+
+  unsigned numRecoveredPackets() const { return fNumRecoveredPackets; }
+  unsigned numBufferBytes() const { return fNumBufferBytes; } // for memory accounting
+
+private:
+  struct SavedPacket {
+    unsigned char* data;
+    unsigned size; // 0 iff the packet is unused
+    unsigned bufferSize;
+    u_int16_t seqNum; // (media packets only)
+    u_int32_t SSRC; // of the packet that carried it (FEC packets only)
+  };
+
+  Boolean savePacket(SavedPacket& saved, unsigned char const* packet, unsigned packetSize);
+      // FEC packets are saved from their FEC header onwards
+  SavedPacket* lookupMediaPacket(u_int16_t seqNum);
+  Boolean tryRecovery(SavedPacket& fecPacket, Boolean& isFinished);
+      // returns True iff a packet was recovered; sets "isFinished" if the FEC packet is of no further use
+  void recoverPackets(); // using our saved FEC packets, for as long as we can
+
+private:
+  RecoveredPacketHandler* fHandler;
+  void* fHandlerClientData;
+  SavedPacket* fMediaPackets; // a ring, indexed by sequence number
+  SavedPacket* fFECPackets; // those that couldn't be used yet (because more than one of their packets was missing)
+  unsigned fNextFECPacketIndex; // the one to be replaced next
+  unsigned fNumSavedFECPackets;
+  unsigned char* fRecoveryBuffer;
+  unsigned fRecoveryBufferSize;
+  unsigned fNumRecoveredPackets;
+  unsigned fNumBufferBytes;
+  Boolean fIsRecovering;
+};
+
+#endif
@@ -25,6 +25,24 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "MultiFramedRTPSource.hh"
 #endif
 
+// Finds where each GOP begins, in a sequence of H.264 NAL units.  A GOP begins with a run of 'key' NAL units:
+// parameter sets (SPS, PPS), then the slice(s) of an IDR picture.  So a GOP begins at a parameter set that
+// follows a non-key slice (or an IDR picture), or at an IDR slice that's not preceded by parameter sets, nor
+// by another slice of the same IDR picture (i.e., with the same RTP timestamp).  Other NAL units - SEI, AUD,
+// filler data, etc. - can appear anywhere in (or before) the run, so they're ignored.
+class H264GOPBoundaryDetector {
+public:
+  H264GOPBoundaryDetector();
+
+  void reset();
+  Boolean beginsGOP(unsigned char nalUnitType, unsigned rtpTimestamp);
+      // Called for each NAL unit, in order; returns True iff it begins a new GOP
+
+private:
+  enum { NOT_IN_KEY_RUN, IN_PARAMETER_SETS, IN_IDR_PICTURE } fState;
+  unsigned fIDRTimestamp; // of the IDR picture, if "fState == IN_IDR_PICTURE"
+};
+
 class H264VideoRTPSource: public MultiFramedRTPSource {
 public:
   static H264VideoRTPSource*
@@ -32,6 +50,18 @@ public:
 	    unsigned char rtpPayloadFormat,
 	    unsigned rtpTimestampFrequency = 90000);
 
+  // Optional filtering of incoming NAL units, applied before reassembly,
+  // so that dropped NAL units are never copied to the downstream object:
+  enum FrameFilterMode {
+    FILTER_NONE = 0,      // deliver every NAL unit (the default)
+    FILTER_KEYFRAMES = 1, // deliver only SPS, PPS and IDR NAL units
+    FILTER_GOPS = 2       // deliver complete GOPs (see "gopInterval" below)
+  };
+  void setFrameFilter(FrameFilterMode mode, unsigned gopInterval = 1);
+      // "gopInterval" N > 1 keeps only every Nth GOP (in either mode)
+  FrameFilterMode frameFilterMode() const { return fFilterMode; }
+  unsigned numFilteredPackets() const { return fNumFilteredPackets; }
+
 protected:
   H264VideoRTPSource(UsageEnvironment& env, Groupsock* RTPgs,
 			 unsigned char rtpPayloadFormat,
@@ -46,9 +76,19 @@ protected:
                                        unsigned& resultSpecialHeaderSize);
   virtual char const* MIMEtype() const;
 
+private:
+  Boolean filterOutNALUnit(unsigned char nalUnitType, Boolean beginsNALUnit, unsigned rtpTimestamp);
+
 private:
   friend class H264BufferedPacket;
   unsigned char fCurPacketNALUnitType;
+
+  FrameFilterMode fFilterMode;
+  unsigned fGOPInterval;
+  unsigned fGOPCount; // number of GOPs seen since the filter was set
+  H264GOPBoundaryDetector fGOPBoundaryDetector;
+  Boolean fDroppingCurrentNALUnit; // used for FU-A/FU-B continuation packets
+  unsigned fNumFilteredPackets;
 };
 
 class SPropRecord {
@@ -70,6 +70,15 @@ protected:
     *fTo++ = word>>24; *fTo++ = word>>16; *fTo++ = word>>8; *fTo++ = word;
   }
 
+  void saveBytes(u_int8_t const* from, unsigned numBytes) {
+    unsigned numBytesToSave = numBytes;
+    if (numBytesToSave > (unsigned)(fLimit - fTo)) numBytesToSave = fLimit - fTo;
+
+    memmove(fTo, from, numBytesToSave);
+    fTo += numBytesToSave;
+    fNumTruncatedBytes += numBytes - numBytesToSave;
+  }
+
   // Save data until we see a sync word (0x000001xx):
   void saveToNextCode(u_int32_t& curWord) {
     saveByte(curWord>>24);
@@ -78,6 +87,11 @@ protected:
       if ((unsigned)(curWord&0xFF) > 1) {
 	// a sync word definitely doesn't begin anywhere in "curWord"
 	save4Bytes(curWord);
+	// Then save (in bulk) any already-read data that precedes the next sync word:
+	unsigned numBytes;
+	u_int8_t const* from = bytesBeforeStartCode(numBytes);
+	saveBytes(from, numBytes);
+	skipBytes(numBytes);
 	curWord = get4Bytes();
       } else {
 	// a sync word might begin in "curWord", although not at its start
@@ -94,6 +108,9 @@ protected:
     while ((curWord&0xFFFFFF00) != 0x00000100) {
       if ((unsigned)(curWord&0xFF) > 1) {
 	// a sync word definitely doesn't begin anywhere in "curWord"
+	unsigned numBytes;
+	(void)bytesBeforeStartCode(numBytes);
+	skipBytes(numBytes);
 	curWord = get4Bytes();
       } else {
 	// a sync word might begin in "curWord", although not at its start
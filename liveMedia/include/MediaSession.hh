@@ -158,6 +158,8 @@ public:
 
   unsigned short clientPortNum() const { return fClientPortNum; }
   unsigned char rtpPayloadFormat() const { return fRTPPayloadFormat; }
+  unsigned char fecPayloadFormat() const { return fFECPayloadFormat; }
+      // from an "a=rtpmap:<fmt> ulpfec/..." line; 0xFF if none
   char const* savedSDPLines() const { return fSavedSDPLines; }
   char const* mediumName() const { return fMediumName; }
   char const* codecName() const { return fCodecName; }
@@ -289,6 +291,7 @@ protected:
   Boolean parseSDPAttribute_source_filter(char const* sdpLine);
   Boolean parseSDPAttribute_x_dimensions(char const* sdpLine);
   Boolean parseSDPAttribute_framerate(char const* sdpLine);
+  Boolean parseSDPAttribute_extmap(char const* sdpLine);
 
   virtual Boolean createSourceObjects(int useSpecialRTPoffset);
     // create "fRTPSource" and "fReadSource" member objects, after we've been initialized via SDP
@@ -303,6 +306,8 @@ protected:
   unsigned short fClientPortNum; // in host byte order
       // This field is also set by initiate()
   unsigned char fRTPPayloadFormat;
+  unsigned char fFECPayloadFormat;
+  unsigned char fHeaderExtensionIds[RTPHeaderExtensions::NUM_REGISTERED_TYPES]; // from "a=extmap:" lines; 0 if none
   char* fSavedSDPLines;
   char* fMediumName;
   char* fCodecName;
@@ -30,6 +30,57 @@ class BufferedPacket; // forward
 class BufferedPacketFactory; // forward
 
 class MultiFramedRTPSource: public RTPSource {
+public:
+  // Scatter-gather delivery: Rather than copying each frame into the caller's buffer (and truncating
+  // it if it doesn't fit), the frame is assembled as a list of references to the payloads of the
+  // packets that carried it, so its size is unbounded, and reassembly copies nothing.  The caller's
+  // buffer is left untouched ("fFrameSize" is still the frame's total size), and the chunks remain
+  // valid until the next call to "getNextFrame()" or "stopGettingFrames()":
+  struct Chunk {
+    unsigned char* data;
+    unsigned size;
+  };
+  void setScatterDelivery(Boolean scatterDelivery) { fScatterDelivery = scatterDelivery; }
+  Boolean scatterDelivery() const { return fScatterDelivery; }
+  Chunk const* curFrameChunks(unsigned& numChunks) const {
+    numChunks = fNumChunks;
+    return fChunks;
+  }
+
+  // Receive coalescing (for high-bitrate streams over UDP): Lets the kernel coalesce runs of incoming
+  // packets (Linux's "UDP_GRO"), so that one read can fetch many packets.  Must be called before the
+  // first packet is read.  Returns False (and changes nothing) if the OS can't do this:
+  Boolean enableReceiveCoalescing();
+
+  // Instead of a fixed time to wait for a missing packet (see "setPacketReorderingThresholdTime()"), wait for
+  // a time that's derived from the stream's interarrival jitter, and from how late out-of-order packets have
+  // actually been arriving - kept within the given bounds.  (Calling "setPacketReorderingThresholdTime()"
+  // goes back to a fixed threshold.)
+  void setAdaptivePacketReorderingThreshold(unsigned minUSeconds, unsigned maxUSeconds);
+  unsigned packetReorderingThresholdTime() const; // the threshold that's currently in use
+
+  // Forward error correction (RFC 5109 "ULPFEC"): Packets with the given payload type carry FEC data, from which
+  // missing media packets are recovered (without having to wait for a retransmission).  The FEC packets may either
+  // share our SSRC (and sequence number space), or have their own.  Must be called before the first packet is read:
+  void enableFEC(unsigned char fecPayloadFormat);
+  unsigned numFECRecoveredPackets() const;
+
+  // The header extensions of the current frame's packets.  (If several packets of the frame carry
+  // the same extension element, then it's taken from the first of them.)
+  RTPHeaderExtensions const& curFrameHeaderExtensions() const { return fCurFrameHeaderExtensions; }
+
+  // The current frame's RTP timestamp, extended to 64 bits (i.e., with wraparounds undone).  This restarts
+  // (from the new 32-bit timestamp) if the stream's SSRC changes:
+  u_int64_t curFrameExtendedRTPTimestamp() const { return fExtendedRTPTimestamp; }
+  // The current frame's presentation time, in microseconds since the first frame.  Unlike "fPresentationTime",
+  // this is derived only from RTP timestamps (so it doesn't jump when RTCP synchronization begins), and it never
+  // jumps backwards (or far forwards): a SSRC change, or a jump in the RTP timestamps, is instead flagged as a
+  // discontinuity, and the presentation time continues from (one frame after) the latest one so far.  (Frame
+  // reordering - e.g., B-frames - still shows, as small backwards steps.)
+  u_int64_t curFramePTS() const { return fCurFramePTS; }
+  Boolean curFrameIsDiscontinuity() const { return fCurFrameIsDiscontinuity; }
+      // True for the first frame, and for the first frame after each SSRC change or timestamp jump
+
 protected:
   MultiFramedRTPSource(UsageEnvironment& env, Groupsock* RTPgs,
 		       unsigned char rtpPayloadFormat,
@@ -59,10 +110,23 @@ private:
   // redefined virtual functions:
   virtual void doGetNextFrame();
   virtual void setPacketReorderingThresholdTime(unsigned uSeconds);
+  virtual void setPacketBufferSize(unsigned packetBufferSize, unsigned maxPacketBufferSize);
+  virtual unsigned packetBufferSize() const;
+  virtual void setBufferMemoryFunc(BufferMemoryFunc* func, void* clientData);
+  virtual void registerHeaderExtension(unsigned char id, RTPHeaderExtensions::Type type);
 
 private:
   void reset();
   void doGetNextFrame1();
+  void readCoalescedPackets();
+  Boolean processIncomingPacket(BufferedPacket* bPacket); // returns False if the packet was not stored
+  void addChunk(unsigned char* data, unsigned size);
+  void releaseFrameChunks(); // gives the packets that the current chunks refer to back to "fReorderingBuffer"
+  static void recoveredPacketHandler(void* clientData, unsigned char const* packet, unsigned packetSize);
+  void recoveredPacketHandler1(unsigned char const* packet, unsigned packetSize);
+  void accountForFECBuffers();
+  void updateFrameTiming(); // sets the above, for a frame that's about to be delivered
+  void parseHeaderExtension(unsigned profile, unsigned char const* data, unsigned size, RTPHeaderExtensions& result);
 
   static void networkReadHandler(MultiFramedRTPSource* source, int /*mask*/);
   void networkReadHandler1();
@@ -76,6 +140,35 @@ private:
 
   // A buffer to (optionally) hold incoming pkts that have been reorderered
   class ReorderingPacketBuffer* fReorderingBuffer;
+
+  // Scatter-gather delivery:
+  Boolean fScatterDelivery;
+  Chunk* fChunks;
+  unsigned fNumChunks, fMaxNumChunks;
+  BufferedPacket* fHeldPackets; // the (otherwise finished with) packets that "fChunks" refer to
+  BufferedPacket* fLastChunkPacket; // the packet that the most recent chunk came from
+
+  unsigned char* fCoalescedBuffer; // non-NULL iff receive coalescing is enabled
+
+  // Forward error correction:
+  class ULPFECDecoder* fFECDecoder; // non-NULL iff FEC is enabled
+  unsigned char fFECPayloadFormat;
+  unsigned fFECBufferBytes; // how much of the decoder's memory we've accounted for
+  Boolean fPacketLossBeforeRepairPacket;
+
+  unsigned char fHeaderExtensionTypes[256]; // indexed by extension element ID
+  RTPHeaderExtensions fCurFrameHeaderExtensions;
+
+  // Frame timing:
+  Boolean fHaveTimingBase;
+  Boolean fNextFrameIsDiscontinuity; // because its packet began a new SSRC
+  u_int32_t fLastFrameRTPTimestamp;
+  u_int64_t fExtendedRTPTimestamp;
+  u_int64_t fPTSOffset; // added to the extended timestamp to get the presentation time (in timestamp units)
+  u_int64_t fMaxPTS; // in timestamp units
+  u_int32_t fFrameDuration; // in timestamp units (the most recent forward step between frames)
+  u_int64_t fCurFramePTS; // in microseconds
+  Boolean fCurFrameIsDiscontinuity;
 };
 
 
@@ -92,6 +185,7 @@ public:
   unsigned useCount() const { return fUseCount; }
 
   Boolean fillInData(RTPInterface& rtpInterface, Boolean& packetReadWasIncomplete);
+  Boolean fillInData(unsigned char const* data, unsigned dataSize); // returns False if the data doesn't fit
   void assignMiscParams(unsigned short rtpSeqNo, unsigned rtpTimestamp,
 			struct timeval presentationTime,
 			Boolean hasBeenSyncedUsingRTCP,
@@ -104,16 +198,29 @@ public:
 	   unsigned short& rtpSeqNo, unsigned& rtpTimestamp,
 	   struct timeval& presentationTime,
 	   Boolean& hasBeenSyncedUsingRTCP, Boolean& rtpMarkerBit);
+  void useInPlace(unsigned char*& framePtr, unsigned& frameSize,
+		  unsigned short& rtpSeqNo, unsigned& rtpTimestamp,
+		  struct timeval& presentationTime,
+		  Boolean& hasBeenSyncedUsingRTCP, Boolean& rtpMarkerBit);
+      // like "use()", but (rather than copying the frame) returns where it lies in our buffer
 
   BufferedPacket*& nextPacket() { return fNextPacket; }
 
+  unsigned packetSize() const { return fPacketSize; }
+  Boolean setPacketSize(unsigned newPacketSize);
+      // (re)allocates the buffer, keeping any data that's already in it (up to the new size)
+
   unsigned short rtpSeqNo() const { return fRTPSeqNo; }
+  unsigned rtpTimestamp() const { return fRTPTimestamp; }
   struct timeval const& timeReceived() const { return fTimeReceived; }
 
   unsigned char* data() const { return &fBuf[fHead]; }
   unsigned dataSize() const { return fTail-fHead; }
   Boolean rtpMarkerBit() const { return fRTPMarkerBit; }
   Boolean& isFirstPacket() { return fIsFirstPacket; }
+  Boolean& isRepairPacket() { return fIsRepairPacket; }
+      // a FEC packet, stored (with no data) only so that its sequence number doesn't look like a lost packet
+  RTPHeaderExtensions& headerExtensions() { return fHeaderExtensions; }
   unsigned bytesAvailable() const { return fPacketSize - fTail; }
 
 protected:
@@ -141,6 +248,8 @@ private:
   Boolean fHasBeenSyncedUsingRTCP;
   Boolean fRTPMarkerBit;
   Boolean fIsFirstPacket;
+  Boolean fIsRepairPacket;
+  RTPHeaderExtensions fHeaderExtensions;
   struct timeval fTimeReceived;
 };
 
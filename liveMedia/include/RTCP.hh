@@ -83,6 +83,16 @@ public:
 
   Groupsock* RTCPgs() const { return fRTCPInterface.gs(); }
 
+  // RTCP feedback (RFC 4585 and RFC 5104), for receivers.  Once enabled, our source tells us about its packet
+  // loss, and we send generic "NACK"s for missing packets (so that a retransmission can still arrive in time),
+  // and "PLI"s and/or "FIR"s when a frame has been lost (so that the sender soon sends a key frame).  These are
+  // rate-limited, and sent only when there's loss:
+  enum { FEEDBACK_NACK = 0x1, FEEDBACK_PLI = 0x2, FEEDBACK_FIR = 0x4 };
+  void enableFeedback(unsigned feedbackTypes); // a bitmask of the above; 0 turns feedback off again
+  void sendNACK(u_int32_t mediaSSRC, u_int16_t firstSeqNum, unsigned numPackets);
+  void sendPLI(u_int32_t mediaSSRC);
+  void sendFIR(u_int32_t mediaSSRC);
+
   void setStreamSocket(int sockNum, unsigned char streamChannelId);
   void addStreamSocket(int sockNum, unsigned char streamChannelId);
   void removeStreamSocket(int sockNum, unsigned char streamChannelId) {
@@ -118,6 +128,11 @@ private:
         void enqueueReportBlock(RTPReceptionStats* receptionStats);
   void addSDES();
   void addBYE();
+  void addFeedbackPrefix(unsigned char packetType, unsigned char fmt, u_int32_t mediaSSRC, unsigned numFCIWords);
+
+  static void packetLossHandler(void* clientData, u_int32_t SSRC, u_int16_t firstSeqNum, unsigned numPackets);
+  static void frameLossHandler(void* clientData, u_int32_t SSRC);
+  Boolean takeFeedbackToken(); // rate-limits our feedback
 
   void sendBuiltPacket();
 
@@ -165,6 +180,12 @@ private:
   void* fRRHandlerClientData;
   AddressPortLookupTable* fSpecificRRHandlerTable;
 
+  unsigned fFeedbackTypes;
+  unsigned fFeedbackTokens; // for the rate limit on feedback packets
+  struct timeval fFeedbackTokenTime; // when "fFeedbackTokens" was last topped up
+  struct timeval fLastKeyFrameRequestTime;
+  u_int8_t fFIRSeqNum;
+
 public: // because this stuff is used by an external "C" function
   void schedule(double nextTime);
   void reschedule(double nextTime);
@@ -185,6 +206,13 @@ const unsigned char RTCP_PT_RR = 201;
 const unsigned char RTCP_PT_SDES = 202;
 const unsigned char RTCP_PT_BYE = 203;
 const unsigned char RTCP_PT_APP = 204;
+const unsigned char RTCP_PT_RTPFB = 205; // transport-layer feedback (RFC 4585)
+const unsigned char RTCP_PT_PSFB = 206; // payload-specific feedback (RFC 4585)
+
+// Feedback message types ("FMT"s):
+const unsigned char RTCP_RTPFB_NACK = 1;
+const unsigned char RTCP_PSFB_PLI = 1;
+const unsigned char RTCP_PSFB_FIR = 4; // (RFC 5104)
 
 // SDES tags:
 const unsigned char RTCP_SDES_END = 0;
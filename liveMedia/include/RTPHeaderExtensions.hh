@@ -0,0 +1,63 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 2.1 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2013 Live Networks, Inc.  All rights reserved.
+// The (per-packet) contents of RTP header extensions that we understand:
+// RFC 8285 one-byte and two-byte extension elements, and the ONVIF replay extension
+// C++ header
+
+#ifndef _RTP_HEADER_EXTENSIONS_HH
+#define _RTP_HEADER_EXTENSIONS_HH
+
+#ifndef _BOOLEAN_HH
+#include "Boolean.hh"
+#endif
+#ifndef _NET_COMMON_H
+#include "NetCommon.h"
+#endif
+
+class RTPHeaderExtensions {
+public:
+  // The extension elements that we parse.  (RFC 8285 elements are identified by an ID that's
+  // negotiated in SDP - "a=extmap:<ID> <URI>" - and must be registered with the source;
+  // see "RTPSource::registerHeaderExtension()"):
+  enum Type {
+    NONE = 0,
+    ABS_SEND_TIME, // "http://www.webrtc.org/experiments/rtp-hdrext/abs-send-time"
+    ABS_CAPTURE_TIME, // "http://www.webrtc.org/experiments/rtp-hdrext/abs-capture-time"
+    NUM_REGISTERED_TYPES,
+    ONVIF_REPLAY = NUM_REGISTERED_TYPES // (not negotiated; identified by its 0xABAC 'profile')
+  };
+  static Type lookupURI(char const* uri); // returns NONE if we don't understand it
+
+  // ONVIF replay flags:
+  enum { ONVIF_CLEAN_POINT = 0x80, ONVIF_END = 0x40, ONVIF_DISCONTINUITY = 0x20 };
+
+  Boolean has(Type type) const { return (fPresent&(1<<type)) != 0; }
+  void clear() { fPresent = 0; }
+  void merge(RTPHeaderExtensions const& from);
+      // sets each element that's present in "from", but not (yet) in us
+
+public:
+  unsigned fPresent; // a bitmask of (1<<Type)
+  u_int32_t absSendTime; // seconds, in 6.18 fixed point (24 bits)
+  u_int64_t absCaptureTime; // seconds, in NTP 32.32 fixed point
+  u_int64_t onvifNTPTime; // seconds, in NTP 32.32 fixed point
+  u_int8_t onvifFlags; // a combination of ONVIF_CLEAN_POINT, ONVIF_END and ONVIF_DISCONTINUITY
+  u_int8_t onvifCSeq; // the low 8 bits of the RTSP "CSeq" of the "PLAY" request that began the replay
+};
+
+#endif
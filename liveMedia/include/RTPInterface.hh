@@ -69,6 +69,11 @@ public:
                            handlerProc);
   Boolean handleRead(unsigned char* buffer, unsigned bufferMaxSize,
 		     unsigned& bytesRead, struct sockaddr_in& fromAddress, Boolean& packetReadWasIncomplete);
+  struct timeval lastReceiveTime() const;
+      // the kernel's ('wall clock') arrival time of the packet that was just read (by "handleRead()"), if known;
+      // zero otherwise (e.g., for packets read from a TCP connection)
+  unsigned lastSegmentSize() const { return fLastReadWasFromTCP ? 0 : fGS->lastSegmentSize(); }
+      // for a read of several (kernel-coalesced) datagrams: the size of each; 0 otherwise
   void stopNetworkReading();
 
   UsageEnvironment& envir() const { return fOwner->envir(); }
@@ -99,6 +104,7 @@ private:
     // how much data (if any) is available to be read from the TCP stream
   int fNextTCPReadStreamSocketNum;
   unsigned char fNextTCPReadStreamChannelId;
+  Boolean fLastReadWasFromTCP;
   TaskScheduler::BackgroundHandlerProc* fReadHandlerProc; // if any
 
   AuxHandlerFunc* fAuxReadHandlerFunc;
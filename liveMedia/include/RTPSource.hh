@@ -27,6 +27,9 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #ifndef _RTP_INTERFACE_HH
 #include "RTPInterface.hh"
 #endif
+#ifndef _RTP_HEADER_EXTENSIONS_HH
+#include "RTPHeaderExtensions.hh"
+#endif
 
 class RTPReceptionStatsDB; // forward
 
@@ -46,6 +49,29 @@ public:
 
   virtual void setPacketReorderingThresholdTime(unsigned uSeconds) = 0;
 
+  // Control over the size of the buffers that incoming packets are read into.  (These have no
+  // effect for sources that don't buffer packets.)  If "maxPacketBufferSize" is larger than
+  // "packetBufferSize", the buffers grow (by doubling, up to that size) whenever a packet fills one.
+  virtual void setPacketBufferSize(unsigned packetBufferSize, unsigned maxPacketBufferSize = 0);
+  virtual unsigned packetBufferSize() const;
+
+  // An (optional) function that's told each time the source allocates (positive "numBytesDelta")
+  // or frees (negative "numBytesDelta") packet buffer memory - e.g., for global memory accounting:
+  typedef void (BufferMemoryFunc)(void* clientData, int numBytesDelta);
+  virtual void setBufferMemoryFunc(BufferMemoryFunc* func, void* clientData);
+
+  // Optional handlers that are told about packet loss - e.g., so that it can be reported using RTCP feedback
+  // (see "RTCPInstance::enableFeedback()").  (Only sources that reorder incoming packets call these.)
+  typedef void (PacketLossHandler)(void* clientData, u_int32_t SSRC, u_int16_t firstSeqNum, unsigned numPackets);
+      // called when packets are found to be missing (while they could still be used, if they arrive late)
+  typedef void (FrameLossHandler)(void* clientData, u_int32_t SSRC);
+      // called when a frame has been given up on, because some of its packets were lost
+  void setLossHandlers(PacketLossHandler* packetLossHandler, FrameLossHandler* frameLossHandler, void* clientData);
+
+  // Tells the source which RFC 8285 header extension elements to parse (by their "a=extmap" ID).  (Sources
+  // that don't buffer incoming packets ignore header extensions.)
+  virtual void registerHeaderExtension(unsigned char id, RTPHeaderExtensions::Type type);
+
   // used by RTCP:
   u_int32_t SSRC() const { return fSSRC; }
       // Note: This is *our* SSRC, not the SSRC in incoming RTP packets.
@@ -95,6 +121,9 @@ protected:
   Boolean fCurPacketMarkerBit;
   Boolean fCurPacketHasBeenSynchronizedUsingRTCP;
   u_int32_t fLastReceivedSSRC;
+  PacketLossHandler* fPacketLossHandler;
+  FrameLossHandler* fFrameLossHandler;
+  void* fLossHandlerClientData;
 
 private:
   // redefined virtual functions:
@@ -143,7 +172,8 @@ public:
 			  Boolean useForJitterCalculation,
 			  struct timeval& resultPresentationTime,
 			  Boolean& resultHasBeenSyncedUsingRTCP,
-			  unsigned packetSize /* payload only */);
+			  unsigned packetSize /* payload only */,
+			  struct timeval const* timeReceived = NULL /* 'wall clock' time; NULL means 'now' */);
 
   // The following is called whenever a RTCP SR packet is received:
   void noteIncomingSR(u_int32_t SSRC,
@@ -220,7 +250,8 @@ private:
 			  Boolean useForJitterCalculation,
 			  struct timeval& resultPresentationTime,
 			  Boolean& resultHasBeenSyncedUsingRTCP,
-			  unsigned packetSize /* payload only */);
+			  unsigned packetSize /* payload only */,
+			  struct timeval const* timeReceived);
   void noteIncomingSR(u_int32_t ntpTimestampMSW, u_int32_t ntpTimestampLSW,
 		      u_int32_t rtpTimestamp);
   void init(u_int32_t SSRC);
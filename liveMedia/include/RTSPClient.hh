@@ -163,7 +163,13 @@ public:
 
   char const* url() const { return fBaseURL; }
 
-  static unsigned responseBufferSize;
+  static unsigned responseBufferSize; // the default (initial and maximum) size of each client's response buffer
+
+  Boolean setResponseBufferSize(unsigned initialSize, unsigned maxSize = 0);
+      // Sets this client's response buffer size.  If "maxSize" is larger than "initialSize", then the buffer
+      // grows (by doubling, up to "maxSize") when a response doesn't fit, rather than the response failing.
+      // Returns False (and does nothing) if a response is currently being received.
+  unsigned curResponseBufferSize() const { return fResponseBufferSize; }
 
 public: // Some compilers complain if this is "private:"
   // The state of a request-in-progress:
@@ -239,6 +245,8 @@ private:
 
   void resetTCPSockets();
   void resetResponseBuffer();
+  Boolean growResponseBuffer(unsigned minSize, unsigned numNewBytes = 0);
+      // keeps the "fResponseBytesAlreadySeen" bytes, plus any "numNewBytes" just read after them
   int openConnection(); // -1: failure; 0: pending; 1: success
   int connectToServer(int socketNum, portNumBits remotePortNum); // used to implement "openConnection()"; result values are the same
   char* createAuthenticatorString(char const* cmd, char const* url);
@@ -297,6 +305,7 @@ private:
   char* fLastSessionId;
   unsigned fSessionTimeoutParameter; // optionally set in response "Session:" headers
   char* fResponseBuffer;
+  unsigned fResponseBufferSize, fMaxResponseBufferSize;
   unsigned fResponseBytesAlreadySeen, fResponseBufferBytesLeft;
   RequestQueue fRequestsAwaitingConnection, fRequestsAwaitingHTTPTunneling, fRequestsAwaitingResponse;
 
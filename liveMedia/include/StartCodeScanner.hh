@@ -0,0 +1,29 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 2.1 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2013 Live Networks, Inc.  All rights reserved.
+// A fast search for "00 00 01" start codes (as used by H.264, H.265 and MPEG video)
+// C++ header
+
+#ifndef _START_CODE_SCANNER_HH
+#define _START_CODE_SCANNER_HH
+
+// Returns the offset of the first "00 00 01" sequence within the "size" bytes at "data",
+// or "size" if there is none.  Uses SSE2 or AVX2 (chosen at run time) when available,
+// falling back to a scalar search otherwise.
+unsigned findStartCode(unsigned char const* data, unsigned size);
+
+#endif
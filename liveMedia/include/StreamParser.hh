@@ -24,6 +24,9 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #ifndef _FRAMED_SOURCE_HH
 #include "FramedSource.hh"
 #endif
+#ifndef _START_CODE_SCANNER_HH
+#include "StartCodeScanner.hh"
+#endif
 
 class StreamParser {
 public:
@@ -93,6 +96,22 @@ protected: // we're a virtual base class
     fCurParserIndex += numBytes;
   }
 
+  // Searches - in bulk - the input that's already been read (without reading any more) for a
+  // "00 00 01" start code.  Returns the current parse position, and sets "numBytes" to the number
+  // of bytes from there that definitely precede the next start code:
+  unsigned char const* bytesBeforeStartCode(unsigned& numBytes) {
+    unsigned numValidBytes = fTotNumValidBytes - fCurParserIndex;
+    unsigned char const* ptr = nextToParse();
+    unsigned offset = findStartCode(ptr, numValidBytes);
+    if (offset < numValidBytes) {
+      numBytes = offset;
+    } else {
+      // A start code might still begin within the final 2 bytes:
+      numBytes = numValidBytes > 2 ? numValidBytes - 2 : 0;
+    }
+    return ptr;
+  }
+
   void skipBits(unsigned numBits);
   unsigned getBits(unsigned numBits);
       // numBits <= 32; returns data into low-order bits of result